@@ -0,0 +1,171 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/**
+ * @file hailo_arena.hpp
+ * @authors Hailo
+ **/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Bump allocator for the HailoObjects of a single frame.
+ * Objects are carved out of large blocks instead of being allocated one by one,
+ * so a frame with hundreds of detections costs a handful of heap allocations.
+ * Every block counts the allocations it still serves, a block is returned to the heap
+ * in one go when the arena moved past it and all of its objects were released.
+ * This keeps objects that outlive their frame (e.g. held by a tracker or a gallery) valid,
+ * they only pin the block they were allocated from.
+ */
+class HailoObjectArena
+{
+private:
+    struct Block
+    {
+        std::atomic<std::size_t> refs; // Live allocations + 1 while it is the current block of the arena
+        std::size_t capacity;
+        std::size_t used;
+    };
+    // Every allocation is prefixed by a pointer to its block, padded to keep the object aligned
+    static constexpr std::size_t ALIGNMENT = alignof(std::max_align_t);
+    static constexpr std::size_t HEADER_SIZE = (sizeof(Block *) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    static constexpr std::size_t DATA_OFFSET = (sizeof(Block) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    std::size_t m_block_size;
+    Block *m_block;
+    std::mutex m_mutex;
+    std::size_t m_allocations;
+    std::size_t m_bytes;
+
+    static std::atomic<uint64_t> &total_allocations_counter()
+    {
+        static std::atomic<uint64_t> counter(0);
+        return counter;
+    }
+    static std::atomic<uint64_t> &total_blocks_counter()
+    {
+        static std::atomic<uint64_t> counter(0);
+        return counter;
+    }
+
+    static void release_block(Block *block)
+    {
+        if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            block->~Block();
+            ::operator delete(block);
+        }
+    }
+
+    Block *new_block(std::size_t min_capacity)
+    {
+        std::size_t capacity = std::max(m_block_size, min_capacity);
+        Block *block = new (::operator new(DATA_OFFSET + capacity)) Block();
+        block->refs.store(1, std::memory_order_relaxed);
+        block->capacity = capacity;
+        block->used = 0;
+        total_blocks_counter().fetch_add(1, std::memory_order_relaxed);
+        return block;
+    }
+
+public:
+    static constexpr std::size_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+
+    HailoObjectArena(std::size_t block_size = DEFAULT_BLOCK_SIZE) : m_block_size(block_size), m_block(nullptr),
+                                                                   m_allocations(0), m_bytes(0){};
+    ~HailoObjectArena()
+    {
+        if (m_block != nullptr)
+            release_block(m_block);
+    }
+    HailoObjectArena(const HailoObjectArena &) = delete;
+    HailoObjectArena &operator=(const HailoObjectArena &) = delete;
+
+    void *allocate(std::size_t size)
+    {
+        std::size_t needed = HEADER_SIZE + (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_block == nullptr || m_block->used + needed > m_block->capacity)
+        {
+            if (m_block != nullptr)
+                release_block(m_block);
+            m_block = new_block(needed);
+        }
+        char *ptr = reinterpret_cast<char *>(m_block) + DATA_OFFSET + m_block->used;
+        m_block->used += needed;
+        m_block->refs.fetch_add(1, std::memory_order_relaxed);
+        *reinterpret_cast<Block **>(ptr) = m_block;
+        m_allocations++;
+        m_bytes += needed;
+        total_allocations_counter().fetch_add(1, std::memory_order_relaxed);
+        return ptr + HEADER_SIZE;
+    }
+
+    /**
+     * @brief Releases an allocation, may be called after the arena itself was destroyed.
+     */
+    static void deallocate(void *ptr)
+    {
+        release_block(*reinterpret_cast<Block **>(static_cast<char *>(ptr) - HEADER_SIZE));
+    }
+
+    // Profiling counters
+    std::size_t allocations()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_allocations;
+    }
+    std::size_t bytes_allocated()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_bytes;
+    }
+    static uint64_t total_allocations() { return total_allocations_counter().load(std::memory_order_relaxed); }
+    static uint64_t total_blocks() { return total_blocks_counter().load(std::memory_order_relaxed); }
+};
+using HailoObjectArenaPtr = std::shared_ptr<HailoObjectArena>;
+
+/**
+ * @brief STL allocator over a HailoObjectArena, used with std::allocate_shared
+ * so the object and its shared_ptr control block share one arena allocation.
+ */
+template <typename T>
+class HailoArenaAllocator
+{
+public:
+    using value_type = T;
+    HailoObjectArena *arena;
+
+    HailoArenaAllocator(HailoObjectArena *arena) : arena(arena){};
+    template <typename U>
+    HailoArenaAllocator(const HailoArenaAllocator<U> &other) : arena(other.arena){};
+
+    T *allocate(std::size_t n) { return static_cast<T *>(arena->allocate(n * sizeof(T))); }
+    void deallocate(T *ptr, std::size_t) { HailoObjectArena::deallocate(ptr); }
+
+    template <typename U>
+    bool operator==(const HailoArenaAllocator<U> &other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const HailoArenaAllocator<U> &other) const { return arena != other.arena; }
+};
+
+/**
+ * @brief Creates a HailoObject in an arena, or on the heap when there is no arena.
+ */
+template <typename T, typename... Args>
+inline std::shared_ptr<T> make_hailo_object(HailoObjectArena *arena, Args &&...args)
+{
+    if (arena == nullptr)
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    return std::allocate_shared<T>(HailoArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
@@ -0,0 +1,129 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/**
+ * @file hailo_label.hpp
+ * @authors Hailo
+ **/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+ * @brief An interned label (or classification type) string.
+ * Labels are stored once in a process wide table and objects only hold a pointer to the entry
+ * and its id, so copying a label costs no allocation.
+ * Ids are only meaningful inside the table that assigned them, compare labels with ==.
+ * The table is bounded, once it is full new strings are held by the label itself instead.
+ */
+class HailoLabel
+{
+public:
+    static constexpr uint32_t NOT_INTERNED = UINT32_MAX;
+    static constexpr std::size_t MAX_INTERNED_LABELS = 1 << 16;
+
+private:
+    struct Table
+    {
+        std::shared_mutex mutex;
+        std::deque<std::string> labels; // A deque keeps the addresses of existing entries stable
+        std::unordered_map<std::string_view, uint32_t> ids;
+    };
+
+    static Table &table()
+    {
+        static Table *table = []
+        {
+            // Never destroyed, labels may be used by objects released at exit
+            Table *new_table = new Table();
+            new_table->labels.emplace_back("");
+            new_table->ids.emplace(new_table->labels.back(), 0);
+            return new_table;
+        }();
+        return *table;
+    }
+
+    const std::string *m_str;
+    uint32_t m_id;
+    std::shared_ptr<const std::string> m_owned; // Only set for labels that did not fit in the table
+
+public:
+    /**
+     * @brief Construct the empty label.
+     */
+    HailoLabel() : m_str(&table().labels.front()), m_id(0){};
+
+    /**
+     * @brief Intern a label.
+     *
+     * @param label The label string, copied into the table the first time it is seen.
+     */
+    explicit HailoLabel(const std::string &label)
+    {
+        Table &labels_table = table();
+        {
+            std::shared_lock<std::shared_mutex> lock(labels_table.mutex);
+            auto it = labels_table.ids.find(label);
+            if (it != labels_table.ids.end())
+            {
+                m_id = it->second;
+                m_str = &labels_table.labels[m_id];
+                return;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(labels_table.mutex);
+        auto it = labels_table.ids.find(label);
+        if (it != labels_table.ids.end())
+        {
+            m_id = it->second;
+            m_str = &labels_table.labels[m_id];
+        }
+        else if (labels_table.labels.size() < MAX_INTERNED_LABELS)
+        {
+            m_id = labels_table.labels.size();
+            labels_table.labels.emplace_back(label);
+            m_str = &labels_table.labels.back();
+            labels_table.ids.emplace(*m_str, m_id);
+        }
+        else
+        {
+            m_owned = std::make_shared<const std::string>(label);
+            m_str = m_owned.get();
+            m_id = NOT_INTERNED;
+        }
+    }
+
+    /**
+     * @brief Intern every label of a labels map (e.g. common::coco_eighty).
+     *
+     * @return std::map<uint8_t, HailoLabel> The interned labels by class id.
+     */
+    static std::map<uint8_t, HailoLabel> intern(const std::map<uint8_t, std::string> &labels)
+    {
+        std::map<uint8_t, HailoLabel> interned;
+        for (auto &label : labels)
+            interned.emplace(label.first, HailoLabel(label.second));
+        return interned;
+    }
+
+    const std::string &str() const { return *m_str; }
+    std::string_view view() const { return *m_str; }
+    uint32_t id() const { return m_id; }
+
+    bool operator==(const HailoLabel &other) const
+    {
+        // Same entry is the common case, different shared objects may hold separate tables
+        return m_str == other.m_str || *m_str == *other.m_str;
+    }
+    bool operator!=(const HailoLabel &other) const { return !(*this == other); }
+};
@@ -10,13 +10,17 @@
 #pragma once
 
 #include "hailo_tensors.hpp"
+#include "hailo_arena.hpp"
+#include "hailo_label.hpp"
 #include <map>
 #include <algorithm>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include <atomic>
 #include <mutex>
+#include <thread>
 
 #define CLAMP(x, low, high) (((x) > (high)) ? (high) : (((x) < (low)) ? (low) : (x)))
 #define CLIP(x) (CLAMP(x, 0, 255))
@@ -154,21 +158,46 @@ public:
     const float ymax() const { return m_ymin + m_height; }
 };
 
+/**
+ * @brief A minimal spin lock for the containers of a HailoMainObject.
+ * Lives inside the object (no allocation) and is cheap to take when uncontended,
+ * which is the common case. Copies start unlocked.
+ */
+class HailoSpinLock
+{
+private:
+    std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+
+public:
+    HailoSpinLock(){};
+    HailoSpinLock(const HailoSpinLock &){};
+    HailoSpinLock &operator=(const HailoSpinLock &) { return *this; };
+
+    void lock()
+    {
+        while (m_flag.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+    void unlock()
+    {
+        m_flag.clear(std::memory_order_release);
+    }
+};
+
 /**
  * @brief Represents an object that is a usable output after postprocessing.
  * An abstract class for all objects to inherit from.
+ *
+ * The fields of objects are plain members, they are written while the object is built
+ * and read afterwards. Like the buffer that carries them, the objects of a frame are
+ * accessed by one element at a time, so only the sub-object and tensor containers of
+ * main objects (which elements may fill from helper threads) are guarded.
  */
 class HailoObject
 {
-protected:
-    std::shared_ptr<std::mutex> mutex;
-
 public:
     // Constructor
-    HailoObject()
-    {
-        mutex = std::make_shared<std::mutex>();
-    };
+    HailoObject(){};
     // Destructor
     virtual ~HailoObject() = default;
     HailoObject &operator=(const HailoObject &other) = default;
@@ -195,18 +224,49 @@ class HailoMainObject : public HailoObject, public std::enable_shared_from_this<
 protected:
     std::vector<HailoObjectPtr> m_sub_objects;
     std::map<std::string, HailoTensorPtr> m_tensors;
+    HailoSpinLock m_lock;        // Guards m_sub_objects and m_tensors
+    HailoObjectArenaPtr m_arena; // Arena of the frame this object belongs to, may be null
 
 public:
-    HailoMainObject()
-    {
-        mutex = std::make_shared<std::mutex>();
-    };
+    HailoMainObject(){};
     virtual ~HailoMainObject() = default;
     HailoMainObject(HailoMainObject &&other) noexcept : HailoObject(other), m_sub_objects(std::move(other.m_sub_objects)){};
     HailoMainObject(const HailoMainObject &other) : HailoObject(other), m_sub_objects(other.m_sub_objects){};
     HailoMainObject &operator=(const HailoMainObject &other) = default;
     HailoMainObject &operator=(HailoMainObject &&other) noexcept = default;
 
+    /**
+     * @brief Set the arena that objects created for this main object are allocated from.
+     *
+     * @param arena HailoObjectArenaPtr, usually the arena of the frame.
+     */
+    void set_arena(HailoObjectArenaPtr arena)
+    {
+        m_arena = std::move(arena);
+    }
+
+    /**
+     * @brief Get the arena of this main object.
+     *
+     * @return HailoObjectArenaPtr - null when objects are allocated on the heap.
+     */
+    HailoObjectArenaPtr get_arena()
+    {
+        return m_arena;
+    }
+
+    /**
+     * @brief Create an object to attach to this main object, allocated from its arena if it has one.
+     *        Use instead of std::make_shared in postprocesses.
+     *
+     * @return std::shared_ptr<T> The new object.
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make_object(Args &&...args)
+    {
+        return make_hailo_object<T>(m_arena.get(), std::forward<Args>(args)...);
+    }
+
     /**
      * @brief Add an object to the main object.
      *
@@ -214,7 +274,7 @@ public:
      */
     void add_object(HailoObjectPtr obj)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         m_sub_objects.emplace_back(obj);
     };
 
@@ -225,7 +285,7 @@ public:
      */
     void add_tensor(HailoTensorPtr tensor)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         m_tensors.emplace(tensor->name(), tensor);
     };
 
@@ -237,7 +297,7 @@ public:
      */
     void remove_object(HailoObjectPtr obj)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         m_sub_objects.erase(std::remove(m_sub_objects.begin(), m_sub_objects.end(), obj), m_sub_objects.end());
     };
 
@@ -249,10 +309,33 @@ public:
      */
     void remove_object(uint index)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         m_sub_objects.erase(m_sub_objects.begin() + index);
     };
 
+    /**
+     * @brief Remove several HailoObjects from the MainObject in a single pass
+     *
+     * @param objs  -  std::vector<HailoObjectPtr>
+     *        The objects to remove
+     */
+    template <typename T>
+    void remove_objects(const std::vector<std::shared_ptr<T>> &objs)
+    {
+        if (objs.empty())
+            return;
+        std::vector<const HailoObject *> to_remove;
+        to_remove.reserve(objs.size());
+        for (auto &obj : objs)
+            to_remove.push_back(obj.get());
+        std::sort(to_remove.begin(), to_remove.end());
+        std::lock_guard<HailoSpinLock> lock(m_lock);
+        m_sub_objects.erase(std::remove_if(m_sub_objects.begin(), m_sub_objects.end(),
+                                           [&to_remove](const HailoObjectPtr &obj)
+                                           { return std::binary_search(to_remove.begin(), to_remove.end(), obj.get()); }),
+                            m_sub_objects.end());
+    };
+
     /**
      * @brief Get a tensor from this main object.
      *
@@ -261,7 +344,7 @@ public:
      */
     HailoTensorPtr get_tensor(std::string name)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         auto itr = m_tensors.find(name);
         if (itr == m_tensors.end())
         {
@@ -278,6 +361,7 @@ public:
      */
     bool has_tensors()
     {
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         return !m_tensors.empty();
     };
 
@@ -288,7 +372,7 @@ public:
      */
     std::vector<HailoTensorPtr> get_tensors()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         std::vector<HailoTensorPtr> _tensors;
         _tensors.reserve(m_tensors.size());
         for (auto &tensor_pair : m_tensors)
@@ -315,7 +399,7 @@ public:
      */
     void clear_tensors()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         m_tensors.clear();
     }
 
@@ -326,7 +410,7 @@ public:
      */
     std::vector<HailoObjectPtr> get_objects()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         return m_sub_objects;
     }
 
@@ -338,7 +422,7 @@ public:
      */
     std::vector<HailoObjectPtr> get_objects_typed(hailo_object_t type)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        std::lock_guard<HailoSpinLock> lock(m_lock);
         std::vector<HailoObjectPtr> filtered_subobjects;
         for (auto &obj : m_sub_objects)
         {
@@ -357,10 +441,7 @@ public:
      */
     void remove_objects_typed(hailo_object_t type)
     {
-        for (auto obj : this->get_objects_typed(type))
-        {
-            this->remove_object(obj);
-        }
+        this->remove_objects(this->get_objects_typed(type));
     }
 };
 using HailoMainObjectPtr = std::shared_ptr<HailoMainObject>;
@@ -404,6 +485,9 @@ public:
         {
             possible_roi->set_scaling_bbox(this->get_bbox());
             possible_roi->set_stream_id(this->get_stream_id());
+            // Sub objects of this roi are allocated from the same frame arena
+            if (nullptr == possible_roi->m_arena)
+                possible_roi->m_arena = m_arena;
         }
         HailoMainObject::add_object(obj);
     };
@@ -426,7 +510,6 @@ public:
      */
     HailoBBox &get_bbox()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_bbox;
     }
 
@@ -437,7 +520,6 @@ public:
      */
     void set_bbox(HailoBBox bbox)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_bbox = std::move(bbox);
     }
 
@@ -448,7 +530,6 @@ public:
      */
     HailoBBox &get_scaling_bbox()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_scaling_bbox;
     }
 
@@ -459,7 +540,6 @@ public:
      */
     void set_scaling_bbox(HailoBBox bbox)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         float new_xmin = (m_scaling_bbox.xmin() * bbox.width()) + bbox.xmin();
         float new_ymin = (m_scaling_bbox.ymin() * bbox.height()) + bbox.ymin();
         float new_width = m_scaling_bbox.width() * bbox.width();
@@ -474,7 +554,6 @@ public:
      */
     void clear_scaling_bbox()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_scaling_bbox = HailoBBox(0.0, 0.0, 1.0, 1.0);
     }
 
@@ -485,7 +564,6 @@ public:
      */
     std::string get_stream_id()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_stream_id;
     }
 
@@ -496,7 +574,6 @@ public:
      */
     void set_stream_id(std::string stream_id)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_stream_id = std::move(stream_id);
     }
 };
@@ -578,9 +655,9 @@ using HailoTileROIPtr = std::shared_ptr<HailoTileROI>;
 class HailoDetection : public HailoROI
 {
 protected:
-    float m_confidence;  // Confidence of the detection.
-    std::string m_label; // The label of detection, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
-    int m_class_id;      // Class id, initialized to -1 if missing.
+    float m_confidence; // Confidence of the detection.
+    HailoLabel m_label; // The label of detection, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
+    int m_class_id;     // Class id, initialized to -1 if missing.
 public:
     /**
      * @brief Construct a new New Hailo Detection object
@@ -600,6 +677,16 @@ public:
      * @param confidence The confidence of the detection.
      */
     HailoDetection(HailoBBox bbox, int class_id, const std::string &label, float confidence) : HailoROI(bbox), m_confidence(assure_normal(confidence)), m_label(label), m_class_id(class_id){};
+    /**
+     * @brief Construct a new New Hailo Detection object from an already interned label.
+     *        Preferred in postprocesses, copying the label costs no allocation.
+     *
+     * @param bbox HailoBBox - a bounding box representing the region of interest in the frame.
+     * @param class_id The detection's class id, if theres any.
+     * @param label HailoLabel what the detection is.
+     * @param confidence The confidence of the detection.
+     */
+    HailoDetection(HailoBBox bbox, int class_id, HailoLabel label, float confidence) : HailoROI(bbox), m_confidence(assure_normal(confidence)), m_label(label), m_class_id(class_id){};
 
     // Move constructor
     HailoDetection(HailoDetection &&other) noexcept : HailoROI(other),
@@ -609,7 +696,7 @@ public:
     // Copy constructor
     HailoDetection(const HailoDetection &other) : HailoROI(other),
                                                   m_confidence(assure_normal(other.m_confidence)),
-                                                  m_label(std::move(other.m_label)),
+                                                  m_label(other.m_label),
                                                   m_class_id(other.m_class_id){};
     virtual ~HailoDetection() = default;
 
@@ -650,13 +737,11 @@ public:
 
     virtual hailo_object_t get_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return HAILO_DETECTION;
     }
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return std::make_shared<HailoDetection>(*this);
     }
 
@@ -664,27 +749,30 @@ public:
 
     float get_confidence()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_confidence;
     }
     void set_confidence(float conf)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_confidence = conf;
     }
     std::string get_label()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        return m_label.str();
+    }
+    const HailoLabel &get_interned_label()
+    {
         return m_label;
     }
     void set_label(std::string label)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        m_label = HailoLabel(label);
+    }
+    void set_label(HailoLabel label)
+    {
         m_label = label;
     }
     int get_class_id()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_class_id;
     }
 };
@@ -697,10 +785,10 @@ using HailoDetectionPtr = std::shared_ptr<HailoDetection>;
 class HailoClassification : public HailoObject
 {
 protected:
-    float m_confidence;                // Confidence of the classification.
-    std::string m_classification_type; // Type of labeling, e.g. "age", "gender", "color", etc...
-    std::string m_label;               // The label of classification, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
-    int m_class_id;                    // Class id, initialized to -1 if missing.
+    float m_confidence;               // Confidence of the classification.
+    HailoLabel m_classification_type; // Type of labeling, e.g. "age", "gender", "color", etc...
+    HailoLabel m_label;               // The label of classification, e.g. "Horse", "Monkey", "Tiger" for type "Animals".
+    int m_class_id;                   // Class id, initialized to -1 if missing.
 public:
     /**
      * @brief Construct a new Hailo Classification object
@@ -734,6 +822,19 @@ public:
                         int class_id,
                         std::string label,
                         float confidence) : m_confidence(assure_normal(confidence)), m_classification_type(classification_type), m_label(label), m_class_id(class_id){};
+
+    /**
+     * @brief Construct a new Hailo Classification object from already interned strings.
+     *
+     * @param classification_type The type of classification.
+     * @param class_id Class ID of the classification result.
+     * @param label classification result.
+     * @param confidence confidence of classification result.
+     */
+    HailoClassification(HailoLabel classification_type,
+                        int class_id,
+                        HailoLabel label,
+                        float confidence) : m_confidence(assure_normal(confidence)), m_classification_type(classification_type), m_label(label), m_class_id(class_id){};
     // Move Constructor
     HailoClassification(HailoClassification &&other) : m_confidence(assure_normal(other.m_confidence)),
                                                        m_classification_type(std::move(other.m_classification_type)),
@@ -772,13 +873,11 @@ public:
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return std::make_shared<HailoClassification>(*this);
     }
 
     virtual hailo_object_t get_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return HAILO_CLASSIFICATION;
     }
 
@@ -786,22 +885,26 @@ public:
 
     float get_confidence()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_confidence;
     }
     std::string get_label()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        return m_label.str();
+    }
+    const HailoLabel &get_interned_label()
+    {
         return m_label;
     }
     std::string get_classification_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
+        return m_classification_type.str();
+    }
+    const HailoLabel &get_interned_classification_type()
+    {
         return m_classification_type;
     }
     int get_class_id()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_class_id;
     }
 };
@@ -861,7 +964,6 @@ public:
      */
     void add_point(HailoPoint point)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_points.emplace_back(point);
     };
 
@@ -872,14 +974,12 @@ public:
      */
     void set_points(std::vector<HailoPoint> points)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_points.clear();
         m_points = std::move(points);
     };
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return std::make_shared<HailoLandmarks>(*this);
     }
 
@@ -887,7 +987,6 @@ public:
 
     std::vector<HailoPoint> get_points()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_points;
     }
     float get_threshold()
@@ -937,7 +1036,6 @@ public:
 
     std::shared_ptr<HailoObject> clone()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return std::make_shared<HailoUniqueID>(*this);
     }
 
@@ -1127,38 +1225,31 @@ public:
 
     virtual hailo_object_t get_type()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return HAILO_USER_META;
     }
 
     float get_user_float()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_user_float;
     }
     std::string get_user_string()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_user_string;
     }
     int get_user_int()
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         return m_user_int;
     }
     void set_user_float(float user_float)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_user_float = user_float;
     }
     void set_user_string(std::string user_string)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_user_string = user_string;
     }
     void set_user_int(int user_int)
     {
-        std::lock_guard<std::mutex> lock(*mutex);
         m_user_int = user_int;
     }
 };
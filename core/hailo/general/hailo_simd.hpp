@@ -0,0 +1,327 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define HAILO_SIMD_AVX2
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAILO_SIMD_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAILO_SIMD_NEON
+#endif
+
+/**
+ * @brief Small set of float kernels shared by the hot paths of the plugins,
+ *        postprocesses and trackers.
+ *        The instruction set is chosen at compile time (AVX2+FMA, SSE2 or NEON),
+ *        with a scalar fallback for any other target.
+ */
+namespace hailo_simd
+{
+#if defined(HAILO_SIMD_AVX2)
+    inline float horizontal_sum(__m256 v)
+    {
+        __m128 low = _mm256_castps256_ps128(v);
+        __m128 high = _mm256_extractf128_ps(v, 1);
+        low = _mm_add_ps(low, high);
+        __m128 shuf = _mm_movehdup_ps(low);
+        __m128 sums = _mm_add_ps(low, shuf);
+        shuf = _mm_movehl_ps(shuf, sums);
+        sums = _mm_add_ss(sums, shuf);
+        return _mm_cvtss_f32(sums);
+    }
+#elif defined(HAILO_SIMD_SSE2)
+    inline float horizontal_sum(__m128 v)
+    {
+        __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(v, shuf);
+        shuf = _mm_movehl_ps(shuf, sums);
+        sums = _mm_add_ss(sums, shuf);
+        return _mm_cvtss_f32(sums);
+    }
+#elif defined(HAILO_SIMD_NEON)
+    inline float horizontal_sum(float32x4_t v)
+    {
+        float32x2_t sum = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+        return vget_lane_f32(vpadd_f32(sum, sum), 0);
+    }
+#endif
+
+    /**
+     * @brief Dot product of two float vectors of length n.
+     */
+    inline float dot(const float *a, const float *b, std::size_t n)
+    {
+        std::size_t i = 0;
+        float result = 0.0f;
+#if defined(HAILO_SIMD_AVX2)
+        __m256 acc = _mm256_setzero_ps();
+        for (; i + 8 <= n; i += 8)
+            acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+        result = horizontal_sum(acc);
+#elif defined(HAILO_SIMD_SSE2)
+        __m128 acc = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4)
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        result = horizontal_sum(acc);
+#elif defined(HAILO_SIMD_NEON)
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        for (; i + 4 <= n; i += 4)
+            acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+        result = horizontal_sum(acc);
+#endif
+        for (; i < n; i++)
+            result += a[i] * b[i];
+        return result;
+    }
+
+    /**
+     * @brief Matrix-vector product: out[r] = dot(matrix[r], vec) for every row
+     *        of a row-major (rows x n) matrix.
+     *        Rows are processed in blocks of four so each load of vec is shared.
+     */
+    inline void gemv(const float *matrix, std::size_t rows, std::size_t n, const float *vec, float *out)
+    {
+        std::size_t r = 0;
+#if defined(HAILO_SIMD_AVX2)
+        for (; r + 4 <= rows; r += 4)
+        {
+            const float *r0 = matrix + r * n;
+            const float *r1 = r0 + n;
+            const float *r2 = r1 + n;
+            const float *r3 = r2 + n;
+            __m256 acc0 = _mm256_setzero_ps();
+            __m256 acc1 = _mm256_setzero_ps();
+            __m256 acc2 = _mm256_setzero_ps();
+            __m256 acc3 = _mm256_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 8 <= n; i += 8)
+            {
+                __m256 v = _mm256_loadu_ps(vec + i);
+                acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(r0 + i), v, acc0);
+                acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(r1 + i), v, acc1);
+                acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(r2 + i), v, acc2);
+                acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(r3 + i), v, acc3);
+            }
+            float s0 = horizontal_sum(acc0), s1 = horizontal_sum(acc1);
+            float s2 = horizontal_sum(acc2), s3 = horizontal_sum(acc3);
+            for (; i < n; i++)
+            {
+                s0 += r0[i] * vec[i];
+                s1 += r1[i] * vec[i];
+                s2 += r2[i] * vec[i];
+                s3 += r3[i] * vec[i];
+            }
+            out[r] = s0;
+            out[r + 1] = s1;
+            out[r + 2] = s2;
+            out[r + 3] = s3;
+        }
+#elif defined(HAILO_SIMD_SSE2) || defined(HAILO_SIMD_NEON)
+        for (; r + 4 <= rows; r += 4)
+        {
+            const float *r0 = matrix + r * n;
+            const float *r1 = r0 + n;
+            const float *r2 = r1 + n;
+            const float *r3 = r2 + n;
+#if defined(HAILO_SIMD_SSE2)
+            __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+            __m128 acc2 = _mm_setzero_ps(), acc3 = _mm_setzero_ps();
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                __m128 v = _mm_loadu_ps(vec + i);
+                acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(r0 + i), v));
+                acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(r1 + i), v));
+                acc2 = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(r2 + i), v));
+                acc3 = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(r3 + i), v));
+            }
+#else
+            float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+            float32x4_t acc2 = vdupq_n_f32(0.0f), acc3 = vdupq_n_f32(0.0f);
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                float32x4_t v = vld1q_f32(vec + i);
+                acc0 = vmlaq_f32(acc0, vld1q_f32(r0 + i), v);
+                acc1 = vmlaq_f32(acc1, vld1q_f32(r1 + i), v);
+                acc2 = vmlaq_f32(acc2, vld1q_f32(r2 + i), v);
+                acc3 = vmlaq_f32(acc3, vld1q_f32(r3 + i), v);
+            }
+#endif
+            float s0 = horizontal_sum(acc0), s1 = horizontal_sum(acc1);
+            float s2 = horizontal_sum(acc2), s3 = horizontal_sum(acc3);
+            for (; i < n; i++)
+            {
+                s0 += r0[i] * vec[i];
+                s1 += r1[i] * vec[i];
+                s2 += r2[i] * vec[i];
+                s3 += r3[i] * vec[i];
+            }
+            out[r] = s0;
+            out[r + 1] = s1;
+            out[r + 2] = s2;
+            out[r + 3] = s3;
+        }
+#endif
+        for (; r < rows; r++)
+            out[r] = dot(matrix + r * n, vec, n);
+    }
+
+    //-------------------------------
+    // LANE-WISE OPERATIONS
+    //-------------------------------
+    // vfloat is the widest float vector of the target (VFLOAT_WIDTH lanes).
+    // The same operations are overloaded for plain float, so a kernel written as a
+    // template over the lane type handles both the vector body and the scalar tail.
+    inline float add(float a, float b) { return a + b; }
+    inline float sub(float a, float b) { return a - b; }
+    inline float mul(float a, float b) { return a * b; }
+    inline float div(float a, float b) { return a / b; }
+    inline float min(float a, float b) { return std::min(a, b); }
+    inline float max(float a, float b) { return std::max(a, b); }
+    template <typename V>
+    V load(const float *p);
+    template <typename V>
+    V set1(float value);
+    template <>
+    inline float load<float>(const float *p) { return *p; }
+    template <>
+    inline float set1<float>(float value) { return value; }
+    inline void store(float *p, float v) { *p = v; }
+    inline bool any_ge(float a, float b) { return a >= b; }
+    inline float horizontal_sum(float v) { return v; }
+
+#if defined(HAILO_SIMD_AVX2)
+    using vfloat = __m256;
+    static constexpr std::size_t VFLOAT_WIDTH = 8;
+    inline vfloat add(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+    inline vfloat sub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+    inline vfloat mul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+    inline vfloat div(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+    inline vfloat min(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+    inline vfloat max(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+    template <>
+    inline vfloat load<vfloat>(const float *p) { return _mm256_loadu_ps(p); }
+    template <>
+    inline vfloat set1<vfloat>(float value) { return _mm256_set1_ps(value); }
+    inline void store(float *p, vfloat v) { _mm256_storeu_ps(p, v); }
+    inline bool any_ge(vfloat a, vfloat b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ)) != 0; }
+#elif defined(HAILO_SIMD_SSE2)
+    using vfloat = __m128;
+    static constexpr std::size_t VFLOAT_WIDTH = 4;
+    inline vfloat add(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+    inline vfloat sub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+    inline vfloat mul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+    inline vfloat div(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+    inline vfloat min(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+    inline vfloat max(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+    template <>
+    inline vfloat load<vfloat>(const float *p) { return _mm_loadu_ps(p); }
+    template <>
+    inline vfloat set1<vfloat>(float value) { return _mm_set1_ps(value); }
+    inline void store(float *p, vfloat v) { _mm_storeu_ps(p, v); }
+    inline bool any_ge(vfloat a, vfloat b) { return _mm_movemask_ps(_mm_cmpge_ps(a, b)) != 0; }
+#elif defined(HAILO_SIMD_NEON) && defined(__aarch64__)
+    using vfloat = float32x4_t;
+    static constexpr std::size_t VFLOAT_WIDTH = 4;
+    inline vfloat add(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+    inline vfloat sub(vfloat a, vfloat b) { return vsubq_f32(a, b); }
+    inline vfloat mul(vfloat a, vfloat b) { return vmulq_f32(a, b); }
+    inline vfloat div(vfloat a, vfloat b) { return vdivq_f32(a, b); }
+    inline vfloat min(vfloat a, vfloat b) { return vminq_f32(a, b); }
+    inline vfloat max(vfloat a, vfloat b) { return vmaxq_f32(a, b); }
+    template <>
+    inline vfloat load<vfloat>(const float *p) { return vld1q_f32(p); }
+    template <>
+    inline vfloat set1<vfloat>(float value) { return vdupq_n_f32(value); }
+    inline void store(float *p, vfloat v) { vst1q_f32(p, v); }
+    inline bool any_ge(vfloat a, vfloat b) { return vmaxvq_u32(vcgeq_f32(a, b)) != 0; }
+#else
+    // No vector division on this target (e.g. armv7 NEON), lanes are plain floats
+    using vfloat = float;
+    static constexpr std::size_t VFLOAT_WIDTH = 1;
+#endif
+
+    //-------------------------------
+    // DISTANCE MATRICES
+    //-------------------------------
+    /**
+     * @brief Squared euclidean distances between ROWS rows of a and COLS rows of b (both with stride n),
+     *        written to out with a row stride of out_stride.
+     *        Each loaded row of a and b is used for several distances, kept in registers.
+     */
+    template <std::size_t ROWS, std::size_t COLS>
+    inline void squared_distance_tile(const float *a, const float *b, std::size_t n, float *out, std::size_t out_stride)
+    {
+        vfloat acc[ROWS][COLS];
+        for (std::size_t r = 0; r < ROWS; r++)
+            for (std::size_t c = 0; c < COLS; c++)
+                acc[r][c] = set1<vfloat>(0.0f);
+
+        std::size_t k = 0;
+        for (; k + VFLOAT_WIDTH <= n; k += VFLOAT_WIDTH)
+        {
+            vfloat b_lanes[COLS];
+            for (std::size_t c = 0; c < COLS; c++)
+                b_lanes[c] = load<vfloat>(b + c * n + k);
+            for (std::size_t r = 0; r < ROWS; r++)
+            {
+                vfloat a_lanes = load<vfloat>(a + r * n + k);
+                for (std::size_t c = 0; c < COLS; c++)
+                {
+                    vfloat diff = sub(a_lanes, b_lanes[c]);
+                    acc[r][c] = add(acc[r][c], mul(diff, diff));
+                }
+            }
+        }
+
+        for (std::size_t r = 0; r < ROWS; r++)
+        {
+            for (std::size_t c = 0; c < COLS; c++)
+            {
+                float sum = horizontal_sum(acc[r][c]);
+                for (std::size_t tail = k; tail < n; tail++)
+                {
+                    float diff = a[r * n + tail] - b[c * n + tail];
+                    sum += diff * diff;
+                }
+                out[r * out_stride + c] = sum;
+            }
+        }
+    }
+
+    /**
+     * @brief Squared euclidean distance between every row of a (a_rows x n) and every row of b (b_rows x n),
+     *        both row-major. out is row-major (a_rows x b_rows).
+     *        Computed in 4x2 tiles, GEMM style, over blocks of b rows small enough to stay in cache
+     *        while every row of a passes over them.
+     */
+    inline void squared_distances(const float *a, std::size_t a_rows, const float *b, std::size_t b_rows, std::size_t n, float *out)
+    {
+        constexpr std::size_t B_BLOCK = 64;
+        for (std::size_t block = 0; block < b_rows; block += B_BLOCK)
+        {
+            const std::size_t block_end = std::min(block + B_BLOCK, b_rows);
+            std::size_t i = 0;
+            for (; i + 4 <= a_rows; i += 4)
+            {
+                std::size_t j = block;
+                for (; j + 2 <= block_end; j += 2)
+                    squared_distance_tile<4, 2>(a + i * n, b + j * n, n, out + i * b_rows + j, b_rows);
+                for (; j < block_end; j++)
+                    squared_distance_tile<4, 1>(a + i * n, b + j * n, n, out + i * b_rows + j, b_rows);
+            }
+            for (; i < a_rows; i++)
+                for (std::size_t j = block; j < block_end; j++)
+                    squared_distance_tile<1, 1>(a + i * n, b + j * n, n, out + i * b_rows + j, b_rows);
+        }
+    }
+} // namespace hailo_simd
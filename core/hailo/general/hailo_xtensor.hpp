@@ -77,6 +77,6 @@ namespace hailo_common
             }
         }
         // Add HailoLandmarks pointer to the detection.
-        detection.add_object(std::make_shared<HailoLandmarks>(landmarks_type, points, threshold, pairs));
+        detection.add_object(detection.make_object<HailoLandmarks>(landmarks_type, points, threshold, pairs));
     }
 }
@@ -5,6 +5,9 @@
 #pragma once
 
 #include <iostream>
+#include <string>
+
+#include "nms.hpp"
 
 #include "rapidjson/document.h"
 #include "rapidjson/stringbuffer.h"
@@ -56,4 +59,35 @@ namespace common
         }
         return false;
     }
-}
\ No newline at end of file
+
+    /**
+     * @brief parse the optional nms keys of a config file ("nms_method", "nms_sigma", "nms_score_threshold").
+     *        "nms_method" is one of "hard", "soft_linear", "soft_gaussian" or "diou".
+     *
+     * @param config const rapidjson::Value & the parsed json config
+     * @param nms_config NmsConfig holding the defaults (and the iou threshold) of the postprocess
+     * @return NmsConfig the defaults, overridden by the keys found in the config.
+     */
+    inline NmsConfig parse_nms_config(const rapidjson::Value &config, NmsConfig nms_config)
+    {
+        if (config.HasMember("nms_method"))
+        {
+            std::string method = config["nms_method"].GetString();
+            if (method == "hard")
+                nms_config.method = NMS_HARD;
+            else if (method == "soft_linear")
+                nms_config.method = NMS_SOFT_LINEAR;
+            else if (method == "soft_gaussian")
+                nms_config.method = NMS_SOFT_GAUSSIAN;
+            else if (method == "diou")
+                nms_config.method = NMS_DIOU;
+            else
+                throw std::runtime_error("nms_method should be hard, soft_linear, soft_gaussian or diou");
+        }
+        if (config.HasMember("nms_sigma"))
+            nms_config.sigma = config["nms_sigma"].GetFloat();
+        if (config.HasMember("nms_score_threshold"))
+            nms_config.score_thr = config["nms_score_threshold"].GetFloat();
+        return nms_config;
+    }
+}
@@ -4,12 +4,17 @@
  **/
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
+#include "hailo_simd.hpp"
 namespace common
 {
 
-    float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2)
+    inline float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2)
     {
         // Calculate IOU between two detection boxes
         const float width_of_overlap_area = std::min(box_1.xmax(), box_2.xmax()) - std::max(box_1.xmin(), box_2.xmin());
@@ -24,6 +29,387 @@ namespace common
         return area_of_overlap / (box_1_area + box_2_area - area_of_overlap);
     }
 
+    /**
+     * @brief Flat structure-of-arrays buffer of NMS candidates.
+     *        Postprocesses push raw boxes here and build HailoDetection objects
+     *        only for the candidates that survive nms_indices.
+     */
+    struct DetectionCandidates
+    {
+        std::vector<float> xmin;
+        std::vector<float> ymin;
+        std::vector<float> xmax;
+        std::vector<float> ymax;
+        std::vector<float> width;
+        std::vector<float> height;
+        std::vector<float> score;
+        std::vector<int> class_id;
+
+        std::size_t size() const { return score.size(); }
+        bool empty() const { return score.empty(); }
+
+        void reserve(std::size_t n)
+        {
+            for (auto *v : {&xmin, &ymin, &xmax, &ymax, &width, &height, &score})
+                v->reserve(n);
+            class_id.reserve(n);
+        }
+
+        void clear()
+        {
+            for (auto *v : {&xmin, &ymin, &xmax, &ymax, &width, &height, &score})
+                v->clear();
+            class_id.clear();
+        }
+
+        void push_back(float box_xmin, float box_ymin, float box_width, float box_height, int box_class_id, float box_score)
+        {
+            xmin.push_back(box_xmin);
+            ymin.push_back(box_ymin);
+            width.push_back(box_width);
+            height.push_back(box_height);
+            // Same arithmetic as HailoBBox::xmax()/ymax(), so the IOU matches iou_calc
+            xmax.push_back(box_xmin + box_width);
+            ymax.push_back(box_ymin + box_height);
+            class_id.push_back(box_class_id);
+            score.push_back(box_score);
+        }
+
+        void push_back(HailoDetection &detection)
+        {
+            HailoBBox bbox = detection.get_bbox();
+            push_back(bbox.xmin(), bbox.ymin(), bbox.width(), bbox.height(), detection.get_class_id(), detection.get_confidence());
+        }
+
+        HailoBBox bbox(std::size_t index) const
+        {
+            return HailoBBox(xmin[index], ymin[index], width[index], height[index]);
+        }
+    };
+
+    typedef enum
+    {
+        NMS_HARD,          // Greedy IOU suppression
+        NMS_SOFT_LINEAR,   // Soft-NMS, scores decayed by (1 - IOU) above the IOU threshold
+        NMS_SOFT_GAUSSIAN, // Soft-NMS, scores decayed by exp(-IOU^2 / sigma)
+        NMS_DIOU,          // Greedy suppression by distance-IOU (IOU minus normalized center distance)
+    } nms_method_t;
+
+    /**
+     * @brief Selects and tunes the NMS variant applied by a postprocess.
+     */
+    struct NmsConfig
+    {
+        nms_method_t method;
+        float iou_thr;
+        float sigma;     // Gaussian Soft-NMS only
+        float score_thr; // Soft-NMS only, decayed boxes under this score are dropped
+        bool cross_classes;
+
+        explicit NmsConfig(float iou_threshold = 0.45f, nms_method_t nms_method = NMS_HARD) : method(nms_method), iou_thr(iou_threshold),
+                                                                                            sigma(0.5f), score_thr(0.001f), cross_classes(false){};
+    };
+
+    /**
+     * @brief Boxes of one class bucket, stored as SoA for the IOU kernels.
+     */
+    struct BoxesSoA
+    {
+        std::vector<float> xmin;
+        std::vector<float> ymin;
+        std::vector<float> xmax;
+        std::vector<float> ymax;
+        std::vector<float> area;
+
+        std::size_t size() const { return area.size(); }
+
+        void clear()
+        {
+            for (auto *v : {&xmin, &ymin, &xmax, &ymax, &area})
+                v->clear();
+        }
+
+        void push_back(const DetectionCandidates &candidates, std::size_t index)
+        {
+            xmin.push_back(candidates.xmin[index]);
+            ymin.push_back(candidates.ymin[index]);
+            xmax.push_back(candidates.xmax[index]);
+            ymax.push_back(candidates.ymax[index]);
+            // Same arithmetic as iou_calc
+            area.push_back((candidates.ymax[index] - candidates.ymin[index]) * (candidates.xmax[index] - candidates.xmin[index]));
+        }
+
+        // Removes a box in O(1) by moving the last box into its place
+        void swap_remove(std::size_t index)
+        {
+            for (auto *v : {&xmin, &ymin, &xmax, &ymax, &area})
+            {
+                (*v)[index] = v->back();
+                v->pop_back();
+            }
+        }
+    };
+
+    /**
+     * @brief IOU (or DIOU) of one box against the boxes [i, i + lanes) of a BoxesSoA.
+     *        Written over the lane type, so it runs as a SIMD kernel for hailo_simd::vfloat
+     *        and as the scalar tail for float.
+     */
+    template <bool DIOU, typename V>
+    inline V overlap_lanes(const BoxesSoA &boxes, std::size_t i, V bx1, V by1, V bx2, V by2, V barea)
+    {
+        using namespace hailo_simd;
+        const V zero = set1<V>(0.0f);
+        const V kx1 = load<V>(&boxes.xmin[i]);
+        const V ky1 = load<V>(&boxes.ymin[i]);
+        const V kx2 = load<V>(&boxes.xmax[i]);
+        const V ky2 = load<V>(&boxes.ymax[i]);
+        const V w = max(sub(min(kx2, bx2), max(kx1, bx1)), zero);
+        const V h = max(sub(min(ky2, by2), max(ky1, by1)), zero);
+        const V overlap = mul(w, h);
+        V iou = div(overlap, sub(add(load<V>(&boxes.area[i]), barea), overlap));
+        if (DIOU)
+        {
+            // Penalize by the squared center distance over the squared diagonal of the enclosing box
+            const V cw = sub(max(kx2, bx2), min(kx1, bx1));
+            const V ch = sub(max(ky2, by2), min(ky1, by1));
+            const V dx = sub(add(kx1, kx2), add(bx1, bx2));
+            const V dy = sub(add(ky1, ky2), add(by1, by2));
+            const V distance = mul(set1<V>(0.25f), add(mul(dx, dx), mul(dy, dy)));
+            iou = sub(iou, div(distance, add(add(mul(cw, cw), mul(ch, ch)), set1<V>(1e-9f))));
+        }
+        return iou;
+    }
+
+    /**
+     * @brief Checks whether a candidate overlaps any of the boxes with (D)IOU >= iou_thr.
+     *        Returns as soon as one vector of boxes overlaps.
+     */
+    template <bool DIOU>
+    inline bool overlaps_any(const BoxesSoA &boxes, const DetectionCandidates &candidates, std::size_t index, float iou_thr)
+    {
+        using namespace hailo_simd;
+        const float bx1 = candidates.xmin[index], by1 = candidates.ymin[index];
+        const float bx2 = candidates.xmax[index], by2 = candidates.ymax[index];
+        const float barea = (by2 - by1) * (bx2 - bx1);
+        std::size_t n = boxes.size();
+        std::size_t i = 0;
+        if (VFLOAT_WIDTH > 1)
+        {
+            const vfloat vbx1 = set1<vfloat>(bx1), vby1 = set1<vfloat>(by1);
+            const vfloat vbx2 = set1<vfloat>(bx2), vby2 = set1<vfloat>(by2);
+            const vfloat vbarea = set1<vfloat>(barea), thr = set1<vfloat>(iou_thr);
+            for (; i + VFLOAT_WIDTH <= n; i += VFLOAT_WIDTH)
+            {
+                if (any_ge(overlap_lanes<DIOU>(boxes, i, vbx1, vby1, vbx2, vby2, vbarea), thr))
+                    return true;
+            }
+        }
+        for (; i < n; i++)
+        {
+            if (overlap_lanes<DIOU, float>(boxes, i, bx1, by1, bx2, by2, barea) >= iou_thr)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Computes the IOU of box 'index' of 'boxes' against all of them into out.
+     */
+    inline void overlaps(const BoxesSoA &boxes, std::size_t index, float *out)
+    {
+        using namespace hailo_simd;
+        const float bx1 = boxes.xmin[index], by1 = boxes.ymin[index];
+        const float bx2 = boxes.xmax[index], by2 = boxes.ymax[index];
+        const float barea = boxes.area[index];
+        std::size_t n = boxes.size();
+        std::size_t i = 0;
+        if (VFLOAT_WIDTH > 1)
+        {
+            const vfloat vbx1 = set1<vfloat>(bx1), vby1 = set1<vfloat>(by1);
+            const vfloat vbx2 = set1<vfloat>(bx2), vby2 = set1<vfloat>(by2);
+            const vfloat vbarea = set1<vfloat>(barea);
+            for (; i + VFLOAT_WIDTH <= n; i += VFLOAT_WIDTH)
+                store(out + i, overlap_lanes<false>(boxes, i, vbx1, vby1, vbx2, vby2, vbarea));
+        }
+        for (; i < n; i++)
+            out[i] = overlap_lanes<false, float>(boxes, i, bx1, by1, bx2, by2, barea);
+    }
+
+    /**
+     * @brief Sorts the non zero score candidates into class buckets (unless cross classes),
+     *        by descending score inside each bucket.
+     */
+    inline std::vector<std::size_t> bucket_by_class(const DetectionCandidates &candidates, bool should_nms_cross_classes)
+    {
+        std::vector<std::size_t> order;
+        order.reserve(candidates.size());
+        for (std::size_t i = 0; i < candidates.size(); i++)
+        {
+            // Zero confidence marks a suppressed detection
+            if (candidates.score[i] != 0.0f)
+                order.push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(),
+                         [&candidates, should_nms_cross_classes](std::size_t a, std::size_t b)
+                         {
+                             if (!should_nms_cross_classes && candidates.class_id[a] != candidates.class_id[b])
+                                 return candidates.class_id[a] < candidates.class_id[b];
+                             return candidates.score[a] > candidates.score[b];
+                         });
+        return order;
+    }
+
+    inline bool bucket_starts(const DetectionCandidates &candidates, const std::vector<std::size_t> &order,
+                              std::size_t i, bool should_nms_cross_classes)
+    {
+        return i == 0 || (!should_nms_cross_classes && candidates.class_id[order[i]] != candidates.class_id[order[i - 1]]);
+    }
+
+    /**
+     * @brief Merges the survivors of all the class buckets to a single descending score order.
+     */
+    inline void sort_survivors(const DetectionCandidates &candidates, std::vector<std::size_t> &survivors, std::size_t max_detections)
+    {
+        std::stable_sort(survivors.begin(), survivors.end(),
+                         [&candidates](std::size_t a, std::size_t b)
+                         { return candidates.score[a] > candidates.score[b]; });
+        if (max_detections > 0 && survivors.size() > max_detections)
+            survivors.resize(max_detections);
+    }
+
+    template <bool DIOU>
+    inline std::vector<std::size_t> greedy_nms_indices(const DetectionCandidates &candidates, const float iou_thr,
+                                                       bool should_nms_cross_classes, std::size_t max_detections)
+    {
+        std::vector<std::size_t> order = bucket_by_class(candidates, should_nms_cross_classes);
+        std::vector<std::size_t> survivors;
+        BoxesSoA kept;
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            if (bucket_starts(candidates, order, i, should_nms_cross_classes))
+                kept.clear();
+            if (!overlaps_any<DIOU>(kept, candidates, order[i], iou_thr))
+            {
+                kept.push_back(candidates, order[i]);
+                survivors.push_back(order[i]);
+            }
+        }
+        sort_survivors(candidates, survivors, max_detections);
+        return survivors;
+    }
+
+    /**
+     * @brief Soft-NMS: instead of removing the boxes overlapping a kept box, decay their scores.
+     *        The decayed scores are written back to candidates.score.
+     */
+    inline std::vector<std::size_t> soft_nms_indices(DetectionCandidates &candidates, const NmsConfig &config,
+                                                     std::size_t max_detections)
+    {
+        std::vector<std::size_t> order = bucket_by_class(candidates, config.cross_classes);
+        std::vector<std::size_t> survivors;
+        BoxesSoA remaining;
+        std::vector<std::size_t> indices;
+        std::vector<float> scores;
+        std::vector<float> ious;
+        std::size_t bucket_start = 0;
+        for (std::size_t i = 1; i <= order.size(); i++)
+        {
+            if (i < order.size() && !bucket_starts(candidates, order, i, config.cross_classes))
+                continue;
+
+            // Bucket [bucket_start, i) is complete, run Soft-NMS on it
+            remaining.clear();
+            indices.clear();
+            scores.clear();
+            for (std::size_t j = bucket_start; j < i; j++)
+            {
+                remaining.push_back(candidates, order[j]);
+                indices.push_back(order[j]);
+                scores.push_back(candidates.score[order[j]]);
+            }
+            while (!indices.empty())
+            {
+                std::size_t best = std::distance(scores.begin(), std::max_element(scores.begin(), scores.end()));
+                candidates.score[indices[best]] = scores[best];
+                survivors.push_back(indices[best]);
+
+                ious.resize(remaining.size());
+                overlaps(remaining, best, ious.data());
+                // Drop the kept box, then decay (or drop) the rest
+                for (std::size_t j = remaining.size(); j-- > 0;)
+                {
+                    if (j != best)
+                    {
+                        float iou = ious[j];
+                        if (config.method == NMS_SOFT_GAUSSIAN)
+                            scores[j] *= std::exp(-(iou * iou) / config.sigma);
+                        else if (iou > config.iou_thr)
+                            scores[j] *= 1.0f - iou;
+                        if (scores[j] >= config.score_thr)
+                            continue;
+                    }
+                    remaining.swap_remove(j);
+                    indices[j] = indices.back();
+                    indices.pop_back();
+                    scores[j] = scores.back();
+                    scores.pop_back();
+                }
+            }
+            bucket_start = i;
+        }
+        sort_survivors(candidates, survivors, max_detections);
+        return survivors;
+    }
+
+    /**
+     * @brief Perform IOU based NMS on a buffer of candidates.
+     *        Candidates are bucketed by class (unless should_nms_cross_classes) and
+     *        every bucket is suppressed greedily in descending score order,
+     *        the same result as nms() on the equivalent HailoDetection vector.
+     *
+     * @param candidates  -  DetectionCandidates
+     *        The candidates to perform NMS on.
+     *
+     * @param iou_thr  -  float
+     *        Threshold for IOU filtration
+     *
+     * @param should_nms_cross_classes  -  bool
+     *        If true, then apply NMS regardless of class differences. Default false.
+     *
+     * @param max_detections  -  std::size_t
+     *        Maximum number of survivors to return, 0 for no limit. Default 0.
+     *
+     * @return std::vector<std::size_t> Indices of the surviving candidates, by descending score.
+     */
+    inline std::vector<std::size_t> nms_indices(const DetectionCandidates &candidates, const float iou_thr,
+                                                bool should_nms_cross_classes = false, std::size_t max_detections = 0)
+    {
+        return greedy_nms_indices<false>(candidates, iou_thr, should_nms_cross_classes, max_detections);
+    }
+
+    /**
+     * @brief Perform the NMS variant selected by config on a buffer of candidates.
+     *        Soft-NMS variants update candidates.score with the decayed scores.
+     *
+     * @return std::vector<std::size_t> Indices of the surviving candidates, by descending score.
+     */
+    inline std::vector<std::size_t> nms_indices(DetectionCandidates &candidates, const NmsConfig &config,
+                                                std::size_t max_detections = 0)
+    {
+        switch (config.method)
+        {
+        case NMS_SOFT_LINEAR:
+        case NMS_SOFT_GAUSSIAN:
+            return soft_nms_indices(candidates, config, max_detections);
+        case NMS_DIOU:
+            return greedy_nms_indices<true>(candidates, config.iou_thr, config.cross_classes, max_detections);
+        case NMS_HARD:
+        default:
+            return greedy_nms_indices<false>(candidates, config.iou_thr, config.cross_classes, max_detections);
+        }
+    }
+
     /**
      * @brief Perform IOU based NMS on a vector of HailoDetection objects
      *
@@ -36,47 +422,43 @@ namespace common
      * @param should_nms_cross_classes  -  bool
      *        If true, then apply NMS regardless of class differences. Default false.
      */
-    void nms(std::vector<HailoDetection> &objects, const float iou_thr, bool should_nms_cross_classes = false)
+    inline void nms(std::vector<HailoDetection> &objects, const float iou_thr, bool should_nms_cross_classes = false)
     {
+        // Read every box once into a flat buffer instead of locking the detections
+        // on each comparison, then keep only the survivors.
+        DetectionCandidates candidates;
+        candidates.reserve(objects.size());
+        for (auto &object : objects)
+            candidates.push_back(object);
+
         std::vector<HailoDetection> objects_after_nms;
-        // The network may propose multiple detections of similar size/score,
-        // which are actually the same detection. We want to filter out the lesser
-        // detections with a simple nms.
-        std::sort(objects.begin(), objects.end(),
-                  [](HailoDetection a, HailoDetection b)
-                  { return a.get_confidence() > b.get_confidence(); });
+        std::vector<std::size_t> survivors = nms_indices(candidates, iou_thr, should_nms_cross_classes);
+        objects_after_nms.reserve(survivors.size());
+        for (std::size_t index : survivors)
+            objects_after_nms.push_back(std::move(objects[index]));
+        objects = std::move(objects_after_nms);
+    }
 
-        for (uint index = 0; index < objects.size(); index++)
-        {
-            if (objects[index].get_confidence() != 0.0f)
-            {
-                for (uint jindex = index + 1; jindex < objects.size(); jindex++)
-                {
-                    if ((should_nms_cross_classes || (objects[index].get_class_id() == objects[jindex].get_class_id())) &&
-                        objects[jindex].get_confidence() != 0.0f)
-                    {
-                        // For each detection, calculate the IOU against each following detection.
-                        float iou = iou_calc(objects[index].get_bbox(), objects[jindex].get_bbox());
-                        // If the IOU is above threshold, then we have two similar detections,
-                        // and want to delete the one.
-                        if (iou >= iou_thr)
-                        {
-                            // The detections are arranged in highest score order,
-                            // so we want to erase the latter detection.
-                            objects[jindex].set_confidence(0.0f);
-                        }
-                    }
-                }
-            }
-        }
-        for (uint index = 0; index < objects.size(); index++)
+    /**
+     * @brief Perform the NMS variant selected by config on a vector of HailoDetection objects.
+     *        Soft-NMS variants update the confidence of the surviving detections.
+     */
+    inline void nms(std::vector<HailoDetection> &objects, const NmsConfig &config)
+    {
+        DetectionCandidates candidates;
+        candidates.reserve(objects.size());
+        for (auto &object : objects)
+            candidates.push_back(object);
+
+        std::vector<HailoDetection> objects_after_nms;
+        std::vector<std::size_t> survivors = nms_indices(candidates, config);
+        objects_after_nms.reserve(survivors.size());
+        for (std::size_t index : survivors)
         {
-            if (objects[index].get_confidence() != 0.0f)
-            {
-                objects_after_nms.push_back(objects[index]);
-            }
+            objects_after_nms.push_back(std::move(objects[index]));
+            objects_after_nms.back().set_confidence(candidates.score[index]);
         }
-        objects = objects_after_nms;
+        objects = std::move(objects_after_nms);
     }
 
-}
\ No newline at end of file
+}
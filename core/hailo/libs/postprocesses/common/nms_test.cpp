@@ -0,0 +1,89 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of the NMS variants of nms.hpp on a fixed set of boxes with known overlaps:
+    0: (0, 0, 10, 10)   class 0  score 0.9
+    1: (5, 0, 10, 10)   class 0  score 0.8   IOU(0,1) = 1/3, DIOU(0,1) = 1/3 - 25/325
+    2: (1, 0, 10, 10)   class 0  score 0.7   IOU(0,2) = 9/11, IOU(1,2) = 3/7
+    3: (50, 50, 10, 10) class 0  score 0.6   no overlap
+    4: (0, 0, 10, 10)   class 1  score 0.5   same box as 0
+*/
+
+// General cpp includes
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Tappas includes
+#include "common/nms.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+static common::DetectionCandidates build_candidates()
+{
+    common::DetectionCandidates candidates;
+    candidates.push_back(0.0f, 0.0f, 10.0f, 10.0f, 0, 0.9f);
+    candidates.push_back(5.0f, 0.0f, 10.0f, 10.0f, 0, 0.8f);
+    candidates.push_back(1.0f, 0.0f, 10.0f, 10.0f, 0, 0.7f);
+    candidates.push_back(50.0f, 50.0f, 10.0f, 10.0f, 0, 0.6f);
+    candidates.push_back(0.0f, 0.0f, 10.0f, 10.0f, 1, 0.5f);
+    return candidates;
+}
+
+static void check_nms(const common::NmsConfig &config, const std::vector<std::size_t> &expected_indices,
+                      const std::vector<float> &expected_scores)
+{
+    common::DetectionCandidates candidates = build_candidates();
+    std::vector<std::size_t> survivors = common::nms_indices(candidates, config);
+    CHECK(survivors == expected_indices);
+    if (survivors != expected_indices)
+        return;
+    for (std::size_t i = 0; i < survivors.size(); i++)
+        CHECK(std::fabs(candidates.score[survivors[i]] - expected_scores[i]) < 1e-5f);
+}
+
+int main()
+{
+    common::NmsConfig config(0.45f, common::NMS_HARD);
+    check_nms(config, {0, 1, 3, 4}, {0.9f, 0.8f, 0.6f, 0.5f});
+    config.iou_thr = 0.3f;
+    check_nms(config, {0, 3, 4}, {0.9f, 0.6f, 0.5f});
+    config.iou_thr = 0.45f;
+    config.cross_classes = true;
+    check_nms(config, {0, 1, 3}, {0.9f, 0.8f, 0.6f});
+
+    // DIOU keeps box 1 at a threshold that IOU suppresses it at
+    config = common::NmsConfig(0.3f, common::NMS_DIOU);
+    check_nms(config, {0, 1, 3, 4}, {0.9f, 0.8f, 0.6f, 0.5f});
+    config.iou_thr = 0.25f;
+    check_nms(config, {0, 3, 4}, {0.9f, 0.6f, 0.5f});
+
+    // Linear: 0.8 * (1 - 1/3), then 0.7 * (1 - 9/11) * (1 - 3/7)
+    config = common::NmsConfig(0.3f, common::NMS_SOFT_LINEAR);
+    check_nms(config, {0, 3, 1, 4, 2}, {0.9f, 0.6f, 0.533333f, 0.5f, 0.0727273f});
+    config.score_thr = 0.1f;
+    check_nms(config, {0, 3, 1, 4}, {0.9f, 0.6f, 0.533333f, 0.5f});
+    // Linear decays only above the IOU threshold
+    config = common::NmsConfig(0.5f, common::NMS_SOFT_LINEAR);
+    check_nms(config, {0, 1, 3, 4, 2}, {0.9f, 0.8f, 0.6f, 0.5f, 0.127273f});
+
+    // Gaussian: 0.8 * exp(-(1/3)^2 / 0.5), then 0.7 * exp(-(9/11)^2 / 0.5) * exp(-(3/7)^2 / 0.5)
+    config = common::NmsConfig(0.3f, common::NMS_SOFT_GAUSSIAN);
+    check_nms(config, {0, 1, 3, 4, 2}, {0.9f, 0.640590f, 0.6f, 0.5f, 0.127089f});
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
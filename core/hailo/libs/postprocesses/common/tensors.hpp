@@ -4,6 +4,8 @@
 **/
 #pragma once
 
+#include <utility>
+
 #include "hailo_objects.hpp"
 #include "xtensor/xadapt.hpp"
 #include "xtensor/xarray.hpp"
@@ -13,35 +15,79 @@ namespace common
     //-------------------------------
     // COMMON TRANSFORMS
     //-------------------------------
-    template <typename T>
-    xt::xarray<float> dequantize(const xt::xarray<T> &input, const float &qp_scale, const float &qp_zp)
+    /**
+     * @brief Dequantize an expression (an xarray, an adaptor from get_xtensor_view, a view...)
+     *        into a new float xarray.
+     */
+    template <typename E>
+    xt::xarray<float> dequantize(const xt::xexpression<E> &input, const float &qp_scale, const float &qp_zp)
     {
         // Rescale the input using the given scale and zero-point
-        auto rescaled_data = (input - qp_zp) * qp_scale;
+        auto rescaled_data = (input.derived_cast() - qp_zp) * qp_scale;
         return rescaled_data;
     }
 
+    /**
+     * @brief Lazily dequantize an expression. Nothing is computed or allocated here,
+     *        each element is rescaled when it is read (or when the result is assigned to an xarray).
+     *        Prefer dequantize() when the elements are read more than once.
+     */
+    template <typename E>
+    auto dequantize_view(E &&input, float qp_scale, float qp_zp)
+    {
+        // The scalars are passed as temporaries so that the expression holds them by value
+        return (std::forward<E>(input) - float(qp_zp)) * float(qp_scale);
+    }
+
+    //-------------------------------
+    // TENSOR VIEWS
+    //-------------------------------
+    /**
+     * @brief Adapt a HailoTensorPtr to a non-owning xtensor adaptor of shape {height, width, features} (quantized).
+     *        Nothing is copied, the adaptor reads the tensor's buffer so it must not outlive it.
+     *
+     * @tparam T The type of the tensor's elements (uint8_t or uint16_t).
+     */
+    template <typename T = uint8_t>
+    auto get_xtensor_view(HailoTensorPtr &tensor)
+    {
+        // The pointer is passed as a temporary, an lvalue pointer would be held by reference
+        return xt::adapt(reinterpret_cast<T *>(tensor->data()), tensor->size(), xt::no_ownership(), tensor->shape());
+    }
+
+    /**
+     * @brief Adapt a HailoTensorPtr to a lazily dequantized expression, see get_xtensor_view and dequantize_view.
+     */
+    template <typename T = uint8_t>
+    auto get_xtensor_float_view(HailoTensorPtr &tensor)
+    {
+        auto &quant_info = tensor->vstream_info().quant_info;
+        return dequantize_view(get_xtensor_view<T>(tensor), quant_info.qp_scale, quant_info.qp_zp);
+    }
+
+    //-------------------------------
+    // OWNING TENSOR COPIES
+    //-------------------------------
+    // These copy the whole tensor, prefer the views above unless an owning xarray is needed.
     xt::xarray<uint8_t> get_xtensor(HailoTensorPtr &tensor)
     {
         // Adapt a HailoTensorPtr to an xarray (quantized)
-        xt::xarray<uint8_t> xtensor = xt::adapt(tensor->data(), tensor->size(), xt::no_ownership(), tensor->shape());
+        xt::xarray<uint8_t> xtensor = get_xtensor_view(tensor);
         return xtensor;
     }
 
     xt::xarray<uint16_t> get_xtensor_uint16(HailoTensorPtr &tensor)
     {
         // Adapt a HailoTensorPtr to an xarray (quantized)
-        uint16_t *data = (uint16_t *)(tensor->data());
-        xt::xarray<uint16_t> xtensor = xt::adapt(data, tensor->size(), xt::no_ownership(), tensor->shape());
+        xt::xarray<uint16_t> xtensor = get_xtensor_view<uint16_t>(tensor);
         return xtensor;
     }
 
     xt::xarray<float> get_xtensor_float(HailoTensorPtr &tensor)
     {
-        // Adapt a HailoTensorPtr to an xarray (quantized)
+        // Dequantize straight from the tensor's buffer, without an intermediate quantized copy
         auto vstream_info = tensor->vstream_info();
-        xt::xarray<uint8_t> xtensor = get_xtensor(tensor);
-        return dequantize(xtensor, vstream_info.quant_info.qp_scale, vstream_info.quant_info.qp_zp);
+        return dequantize(get_xtensor_view(tensor), vstream_info.quant_info.qp_scale, vstream_info.quant_info.qp_zp);
     }
     /**
      * @brief Get the only the tensors (vector) from a map of string->tensor.
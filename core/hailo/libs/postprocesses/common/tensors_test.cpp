@@ -0,0 +1,144 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of the tensor views of tensors.hpp on a 2x3x4 tensor over a local buffer:
+  get_xtensor_view reads the tensor's buffer without a copy (uint8_t and uint16_t), dequantize_view and
+  get_xtensor_float_view rescale when read and outlive the scale and zero point they were given,
+  and dequantize of a view or a transposed view matches the owning get_xtensor_float.
+*/
+
+// General cpp includes
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+
+// Tappas includes
+#include "common/tensors.hpp"
+#include "xtensor/xmanipulation.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+#define HEIGHT (2)
+#define WIDTH (3)
+#define FEATURES (4)
+#define QP_SCALE (0.5f)
+#define QP_ZP (10.0f)
+
+static HailoTensorPtr make_tensor(uint8_t *data)
+{
+    hailo_vstream_info_t vstream_info;
+    std::memset(&vstream_info, 0, sizeof(vstream_info));
+    std::strncpy(vstream_info.name, "tensors_test/output", sizeof(vstream_info.name) - 1);
+    vstream_info.shape.height = HEIGHT;
+    vstream_info.shape.width = WIDTH;
+    vstream_info.shape.features = FEATURES;
+    vstream_info.quant_info.qp_scale = QP_SCALE;
+    vstream_info.quant_info.qp_zp = QP_ZP;
+    return std::make_shared<HailoTensor>(data, vstream_info);
+}
+
+static float expected_value(float quantized)
+{
+    return (quantized - QP_ZP) * QP_SCALE;
+}
+
+static void check_uint8_views()
+{
+    std::vector<uint8_t> buffer(HEIGHT * WIDTH * FEATURES);
+    for (size_t i = 0; i < buffer.size(); i++)
+        buffer[i] = i * 7 % 256;
+    HailoTensorPtr tensor = make_tensor(buffer.data());
+
+    auto view = common::get_xtensor_view(tensor);
+    static_assert(std::is_same<typename decltype(view)::value_type, uint8_t>::value, "uint8_t view by default");
+    CHECK(view.data() == buffer.data());
+    CHECK(view.dimension() == 3);
+    CHECK(view.shape(0) == HEIGHT && view.shape(1) == WIDTH && view.shape(2) == FEATURES);
+    CHECK(view(1, 2, 3) == tensor->get(1, 2, 3));
+
+    xt::xarray<uint8_t> copy = common::get_xtensor(tensor);
+    xt::xarray<float> float_copy = common::get_xtensor_float(tensor);
+    CHECK(copy == view);
+
+    // The owning copies keep the values of when they were made, views read the buffer
+    auto float_view = common::get_xtensor_float_view(tensor);
+    static_assert(std::is_same<typename decltype(float_view)::value_type, float>::value, "float values");
+    CHECK(float_view(1, 2, 3) == expected_value(buffer[23]));
+    buffer[23] = 200;
+    CHECK(view(1, 2, 3) == 200);
+    CHECK(float_view(1, 2, 3) == expected_value(200));
+    CHECK(copy(1, 2, 3) == 23 * 7 % 256);
+    CHECK(float_copy(1, 2, 3) == expected_value(23 * 7 % 256));
+    buffer[23] = 23 * 7 % 256;
+
+    // dequantize of the view, and of a transposed view, without a quantized copy in between
+    xt::xarray<float> dequantized = common::dequantize(view, QP_SCALE, QP_ZP);
+    CHECK(dequantized == float_copy);
+    xt::xarray<float> transposed = common::dequantize(xt::transpose(view), QP_SCALE, QP_ZP);
+    CHECK(transposed.shape(0) == FEATURES && transposed.shape(2) == HEIGHT);
+    CHECK(transposed == xt::transpose(float_copy));
+    xt::xarray<float> lazy = float_view;
+    CHECK(lazy == float_copy);
+}
+
+static void check_uint16_views()
+{
+    std::vector<uint16_t> buffer(HEIGHT * WIDTH * FEATURES);
+    for (size_t i = 0; i < buffer.size(); i++)
+        buffer[i] = 1000 + i * 1111;
+    HailoTensorPtr tensor = make_tensor(reinterpret_cast<uint8_t *>(buffer.data()));
+
+    auto view = common::get_xtensor_view<uint16_t>(tensor);
+    static_assert(std::is_same<typename decltype(view)::value_type, uint16_t>::value, "uint16_t view");
+    CHECK(view.data() == buffer.data());
+    CHECK(view(1, 0, 2) == tensor->get_uint16(1, 0, 2));
+    CHECK(common::get_xtensor_uint16(tensor) == view);
+
+    // As fast_depth reads it: dequantized straight into a vector
+    auto float_view = common::get_xtensor_float_view<uint16_t>(tensor);
+    std::vector<float> data(float_view.begin(), float_view.end());
+    CHECK(data.size() == buffer.size());
+    for (size_t i = 0; i < data.size(); i++)
+        CHECK(data[i] == expected_value(buffer[i]));
+}
+
+// The expression holds the scale and zero point by value, the arguments may be gone when it is read
+static auto dequantize_with_temporaries(HailoTensorPtr &tensor)
+{
+    float qp_scale = QP_SCALE;
+    float qp_zp = QP_ZP;
+    return common::dequantize_view(common::get_xtensor_view(tensor), qp_scale, qp_zp);
+}
+
+static void check_dequantize_view_lifetime()
+{
+    std::vector<uint8_t> buffer(HEIGHT * WIDTH * FEATURES, 42);
+    HailoTensorPtr tensor = make_tensor(buffer.data());
+    auto dequantized = dequantize_with_temporaries(tensor);
+    for (float value : dequantized)
+        CHECK(value == expected_value(42));
+}
+
+int main()
+{
+    check_uint8_views();
+    check_uint16_views();
+    check_dequantize_view_lifetime();
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -77,6 +77,7 @@ FaceDetectionParams *init(const std::string config_path, const std::string funct
     std::vector<std::vector<int>> anchor_min_size;
     float score_threshold;
     float iou_threshold;
+    common::NmsConfig nms_config;
     int num_branches;
     if (!fs::exists(config_path))
     {
@@ -91,6 +92,7 @@ FaceDetectionParams *init(const std::string config_path, const std::string funct
             num_branches = anchor_min_size.size();
             score_threshold = 0.7;
             iou_threshold = 0.4;
+            nms_config = common::NmsConfig(iou_threshold);
         }
         else if (function_name.std::string::compare("retinaface") == 0)
         {
@@ -102,6 +104,7 @@ FaceDetectionParams *init(const std::string config_path, const std::string funct
             num_branches = anchor_min_size.size();
             score_threshold = 0.4;
             iou_threshold = 0.4;
+            nms_config = common::NmsConfig(iou_threshold);
         }
         else
         {
@@ -156,6 +159,18 @@ FaceDetectionParams *init(const std::string config_path, const std::string funct
             },
             "iou_threshold": {
                 "type": "number"
+            },
+            "nms_method": {
+                "type": "string",
+                "enum": ["hard", "soft_linear", "soft_gaussian", "diou"]
+            },
+            "nms_sigma": {
+                "type": "number",
+                "exclusiveMinimum": true,
+                "minimum": 0
+            },
+            "nms_score_threshold": {
+                "type": "number"
             }
         }
     })"""";
@@ -204,6 +219,7 @@ FaceDetectionParams *init(const std::string config_path, const std::string funct
             image_height = doc_config_json["image_height"].GetInt();
             score_threshold = doc_config_json["score_threshold"].GetFloat();
             iou_threshold = doc_config_json["iou_threshold"].GetFloat();
+            nms_config = common::parse_nms_config(doc_config_json, common::NmsConfig(iou_threshold));
             num_branches = anchor_min_size.size();
         }
         else
@@ -217,7 +233,7 @@ FaceDetectionParams *init(const std::string config_path, const std::string funct
     anchors = get_anchors(anchor_min_size, anchor_steps, image_width, image_height);
     // Using the anchors, create a multiplier that will be used against the tensor results.
     const xt::xarray<float> anchors_multiplier = anchor_variance(0) * xt::view(anchors, xt::all(), xt::range(2, _));
-    FaceDetectionParams *params = new FaceDetectionParams(anchors, anchors_multiplier, anchor_variance, anchor_min_size, score_threshold, iou_threshold, num_branches);
+    FaceDetectionParams *params = new FaceDetectionParams(anchors, anchors_multiplier, anchor_variance, anchor_min_size, score_threshold, iou_threshold, nms_config, num_branches);
     return params;
 }
 
@@ -383,7 +399,7 @@ std::vector<HailoDetection> face_detection_postprocess(std::vector<HailoTensorPt
                                                        const xt::xarray<float> &anchors_multiplier,
                                                        const xt::xarray<float> &anchor_variance,
                                                        const float score_threshold,
-                                                       const float iou_threshold,
+                                                       const common::NmsConfig &nms_config,
                                                        const int num_branches,
                                                        const int total_classes,
                                                        const bool requires_softmax,
@@ -410,28 +426,28 @@ std::vector<HailoDetection> face_detection_postprocess(std::vector<HailoTensorPt
     for (uint i = 0; i < tensors.size(); ++i)
     {
         // While we're here, adapt the tensor into an xarray of float (dequantized).
-        xt::xarray<uint8_t> xdata = common::get_xtensor(tensors[i]);
+        auto xdata = common::get_xtensor_view(tensors[i]);
         xt::xarray<float> xdata_rescaled = common::dequantize(xdata, tensors[i]->vstream_info().quant_info.qp_scale, tensors[i]->vstream_info().quant_info.qp_zp);
         // output layers are paired: boxes:classes:landmarks, boxes:classes:landmarks, boxes:classes:landmarks, etc...
         if (i % outputs_per_branch == 0)
         {
             auto num_boxes = (int)xdata_rescaled.shape(0) * (int)xdata_rescaled.shape(1) * ((int)xdata_rescaled.shape(2) / 4);
-            auto xdata_reshaped = xt::reshape_view(xdata_rescaled, {1, num_boxes, 4}); // Resize to be by the 4 parameters for a box
-            box_layers.emplace_back(std::move(xdata_reshaped));
+            xdata_rescaled.reshape({1, num_boxes, 4}); // Resize to be by the 4 parameters for a box
+            box_layers.emplace_back(std::move(xdata_rescaled));
             boxes_reshaped_size += num_boxes;
         }
         else if (i % outputs_per_branch == 1)
         {
             auto num_classes = (int)xdata_rescaled.shape(0) * (int)xdata_rescaled.shape(1) * ((int)xdata_rescaled.shape(2) / total_classes);
-            auto xdata_reshaped = xt::reshape_view(xdata_rescaled, {1, num_classes, total_classes}); // Resize to be by the total_classes available classes
-            class_layers.emplace_back(std::move(xdata_reshaped));
+            xdata_rescaled.reshape({1, num_classes, total_classes}); // Resize to be by the total_classes available classes
+            class_layers.emplace_back(std::move(xdata_rescaled));
             classes_reshaped_size += num_classes;
         }
         else
         {
             auto num_landmarks = (int)xdata_rescaled.shape(0) * (int)xdata_rescaled.shape(1) * ((int)xdata_rescaled.shape(2) / 10);
-            auto xdata_reshaped = xt::reshape_view(xdata_rescaled, {1, num_landmarks, 10}); // Resize to be by the (x,y) for each of the 5 landmarks (2*5=10)
-            landmarks_layers.emplace_back(std::move(xdata_reshaped));
+            xdata_rescaled.reshape({1, num_landmarks, 10}); // Resize to be by the (x,y) for each of the 5 landmarks (2*5=10)
+            landmarks_layers.emplace_back(std::move(xdata_rescaled));
             landmarks_reshaped_size += num_landmarks;
         }
     }
@@ -504,7 +520,7 @@ std::vector<HailoDetection> face_detection_postprocess(std::vector<HailoTensorPt
                       network);
 
     // // Perform nms to throw out similar detections
-    common::nms(objects, iou_threshold);
+    common::nms(objects, nms_config);
 
     return objects;
 }
@@ -534,7 +550,7 @@ void retinaface(HailoROIPtr roi, void *params_void_ptr)
 
     // Extract the detection objects using the given parameters.
     std::vector<HailoDetection> detections = face_detection_postprocess(tensors, params->anchors, params->anchors_multiplier, params->anchor_variance,
-                                                                        params->score_threshold, params->iou_threshold, params->num_branches,
+                                                                        params->score_threshold, params->nms_config, params->num_branches,
                                                                         2, true, RETINAFACE);
 
     // Update the frame with the found detections.
@@ -565,7 +581,7 @@ std::vector<HailoDetection> lightface_post(std::vector<HailoTensorPtr> &tensors,
 
     // Extract the detection objects using the given parameters.
     detections = face_detection_postprocess(tensors, params->anchors, params->anchors_multiplier, params->anchor_variance,
-                                            params->score_threshold, params->iou_threshold, params->num_branches,
+                                            params->score_threshold, params->nms_config, params->num_branches,
                                             2, true, LIGHTFACE);
 
     return detections;
@@ -6,6 +6,7 @@
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
 #include "xtensor/xarray.hpp"
+#include "common/nms.hpp"
 
 class FaceDetectionParams
 {
@@ -16,6 +17,7 @@ public:
     std::vector<std::vector<int>> anchor_min_size;
     float score_threshold;
     float iou_threshold;
+    common::NmsConfig nms_config;
     int num_branches;
 
     FaceDetectionParams(xt::xarray<float> anchors,
@@ -24,6 +26,7 @@ public:
     std::vector<std::vector<int>> anchor_min_size,
     float score_threshold,
     float iou_threshold,
+    common::NmsConfig nms_config,
     int num_branches) {
         this->anchors = anchors;
         this->anchors_multiplier =anchors_multiplier;
@@ -31,6 +34,7 @@ public:
         this->anchor_min_size = anchor_min_size;
         this->score_threshold = score_threshold;
         this->iou_threshold = iou_threshold;
+        this->nms_config = nms_config;
         this->num_branches = num_branches;
     }
 };
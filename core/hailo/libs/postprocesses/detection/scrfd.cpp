@@ -71,6 +71,7 @@ ScrfdParams *init(const std::string config_path, const std::string function_name
     std::vector<std::vector<int>> anchor_min_size;
     float score_threshold;
     float iou_threshold;
+    common::NmsConfig nms_config;
     int num_branches;
     if (!fs::exists(config_path))
     {
@@ -85,6 +86,7 @@ ScrfdParams *init(const std::string config_path, const std::string function_name
             num_branches = anchor_min_size.size();
             score_threshold = 0.4;
             iou_threshold = 0.4;
+            nms_config = common::NmsConfig(iou_threshold);
         }
         else
         {
@@ -139,6 +141,18 @@ ScrfdParams *init(const std::string config_path, const std::string function_name
             },
             "iou_threshold": {
                 "type": "number"
+            },
+            "nms_method": {
+                "type": "string",
+                "enum": ["hard", "soft_linear", "soft_gaussian", "diou"]
+            },
+            "nms_sigma": {
+                "type": "number",
+                "exclusiveMinimum": true,
+                "minimum": 0
+            },
+            "nms_score_threshold": {
+                "type": "number"
             }
         }
     })"""";
@@ -187,6 +201,7 @@ ScrfdParams *init(const std::string config_path, const std::string function_name
             image_height = doc_config_json["image_height"].GetInt();
             score_threshold = doc_config_json["score_threshold"].GetFloat();
             iou_threshold = doc_config_json["iou_threshold"].GetFloat();
+            nms_config = common::parse_nms_config(doc_config_json, common::NmsConfig(iou_threshold));
             num_branches = anchor_min_size.size();
         }
         else
@@ -199,7 +214,7 @@ ScrfdParams *init(const std::string config_path, const std::string function_name
     xt::xarray<float> anchors;
     anchors = get_anchors_scrfd(anchor_min_size, anchor_steps, image_width, image_height);
     // Using the anchors, create a multiplier that will be used against the tensor results.
-    ScrfdParams *params = new ScrfdParams(anchors, anchor_variance, anchor_min_size, score_threshold, iou_threshold, num_branches);
+    ScrfdParams *params = new ScrfdParams(anchors, anchor_variance, anchor_min_size, score_threshold, iou_threshold, nms_config, num_branches);
     return params;
 }
 
@@ -404,7 +419,7 @@ void encode_detections(std::vector<HailoDetection> &objects,
 std::vector<HailoDetection> face_detection_postprocess(std::map<std::string, HailoTensorPtr> &tensors_by_name,
                                                        const xt::xarray<float> &anchors,
                                                        const float score_threshold,
-                                                       const float iou_threshold,
+                                                       const common::NmsConfig &nms_config,
                                                        const int num_branches,
                                                        const int total_classes)
 {
@@ -421,19 +436,19 @@ std::vector<HailoDetection> face_detection_postprocess(std::map<std::string, Hai
     for (uint i = 0; i < BOXES.size(); ++i)
     {
         // Extract the boxes
-        xt::xarray<uint8_t> xdata_boxes = common::get_xtensor(tensors_by_name[BOXES[i]]);
+        auto xdata_boxes = common::get_xtensor_view(tensors_by_name[BOXES[i]]);
         auto num_boxes = (int)xdata_boxes.shape(0) * (int)xdata_boxes.shape(1) * ((int)xdata_boxes.shape(2) / 4);
         auto xdata_boxes_reshaped = xt::reshape_view(xdata_boxes, {num_boxes, 4}); // Resize to be by the 4 parameters for a box
         box_layers_quant.emplace_back(std::move(xdata_boxes_reshaped));
 
         // Extract the classes
-        xt::xarray<uint8_t> xdata_classes = common::get_xtensor(tensors_by_name[CLASSES[i]]);
+        auto xdata_classes = common::get_xtensor_view(tensors_by_name[CLASSES[i]]);
         auto num_classes = (int)xdata_classes.shape(0) * (int)xdata_classes.shape(1) * ((int)xdata_classes.shape(2) / total_classes);
         auto xdata_classes_reshaped = xt::reshape_view(xdata_classes, {num_classes, total_classes}); // Resize to be by the total_classes available classes
         class_layers_quant.emplace_back(std::move(xdata_classes_reshaped));
 
         // Extract the landmarks
-        xt::xarray<uint8_t> xdata_landmarks = common::get_xtensor(tensors_by_name[LANDMARKS[i]]);
+        auto xdata_landmarks = common::get_xtensor_view(tensors_by_name[LANDMARKS[i]]);
         auto num_landmarks = (int)xdata_landmarks.shape(0) * (int)xdata_landmarks.shape(1) * ((int)xdata_landmarks.shape(2) / 10);
         auto xdata_landmarks_reshaped = xt::reshape_view(xdata_landmarks, {num_landmarks, 10}); // Resize to be by the (x,y) for each of the 5 landmarks (2*5=10)
         landmarks_layers_quant.emplace_back(std::move(xdata_landmarks_reshaped));
@@ -462,7 +477,7 @@ std::vector<HailoDetection> face_detection_postprocess(std::map<std::string, Hai
                       std::get<2>(boxes_and_landmarks));
 
     // // Perform nms to throw out similar detections
-    common::nms(objects, iou_threshold);
+    common::nms(objects, nms_config);
 
     return objects;
 }
@@ -502,7 +517,7 @@ void scrfd(HailoROIPtr roi, void *params_void_ptr)
 
     // Extract the detection objects using the given parameters.
     std::vector<HailoDetection> detections = face_detection_postprocess(tensors_by_name, params->anchors,
-                                                                        params->score_threshold, params->iou_threshold,
+                                                                        params->score_threshold, params->nms_config,
                                                                         params->num_branches, 1);
 
     // Update the frame with the found detections.
@@ -6,6 +6,7 @@
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
 #include "xtensor/xarray.hpp"
+#include "common/nms.hpp"
 
 class ScrfdParams
 {
@@ -15,6 +16,7 @@ public:
     std::vector<std::vector<int>> anchor_min_size;
     float score_threshold;
     float iou_threshold;
+    common::NmsConfig nms_config;
     int num_branches;
 
     ScrfdParams(xt::xarray<float> anchors,
@@ -22,12 +24,14 @@ public:
     std::vector<std::vector<int>> anchor_min_size,
     float score_threshold,
     float iou_threshold,
+    common::NmsConfig nms_config,
     int num_branches) {
         this->anchors = anchors;
         this->anchor_variance = anchor_variance;
         this->anchor_min_size = anchor_min_size;
         this->score_threshold = score_threshold;
         this->iou_threshold = iou_threshold;
+        this->nms_config = nms_config;
         this->num_branches = num_branches;
     }
 };
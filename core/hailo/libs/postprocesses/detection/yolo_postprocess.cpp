@@ -32,34 +32,37 @@ protected:
     std::vector<std::shared_ptr<YoloOutputLayer>> _layers;
     uint _max_boxes;
     float _detection_thr;
-    float _iou_thr;
+    common::NmsConfig _nms_config;
     uint m_image_width;
     uint m_image_height;
-    std::map<uint8_t, std::string> m_dataset;
+    const std::map<uint8_t, HailoLabel> &m_labels; // Interned by init, detections only copy the label
 
 public:
     virtual ~YoloPost() = default;
-    YoloPost(std::map<uint8_t, std::string> dataset,
+    YoloPost(const std::map<uint8_t, HailoLabel> &labels,
              float detection_threshold,
-             float iou_threshold,
+             const common::NmsConfig &nms_config,
              uint max_boxes)
         : _max_boxes(max_boxes), _detection_thr(detection_threshold),
-          _iou_thr(iou_threshold), m_dataset(dataset){};
+          _nms_config(nms_config), m_labels(labels){};
 
     std::vector<HailoDetection> decode()
     {
-        std::vector<HailoDetection> objects;
-        objects.reserve(_max_boxes);
+        common::DetectionCandidates candidates;
+        candidates.reserve(_max_boxes);
         for (auto layer : _layers)
         {
-            extract_boxes(layer, objects);
+            extract_boxes(layer, candidates);
         }
-        common::nms(objects, _iou_thr);
-        if (objects.size() > _max_boxes)
+        // Build detections only for the boxes that survive the nms
+        std::vector<HailoDetection> objects;
+        std::vector<std::size_t> survivors = common::nms_indices(candidates, _nms_config, _max_boxes);
+        objects.reserve(survivors.size());
+        for (std::size_t index : survivors)
         {
-            HailoBBox bbox(0, 0, 1, 1);
-            HailoDetection empty_detection(bbox, "None", 0.0);
-            objects.resize(_max_boxes, empty_detection);
+            int class_id = candidates.class_id[index];
+            auto label = m_labels.find(class_id);
+            objects.emplace_back(candidates.bbox(index), class_id, label != m_labels.end() ? label->second : HailoLabel(), candidates.score[index]);
         }
 
         return objects;
@@ -75,14 +78,14 @@ public:
      *
      * @param[in] image_size Network's input image width/height.
      * @param[in] thr Postprocess threshold.
-     * @param[out] objects Reference to vector of detections.
+     * @param[out] candidates Reference to the nms candidates buffer.
      */
     void extract_boxes(std::shared_ptr<YoloOutputLayer> layer,
-                       std::vector<HailoDetection> &objects);
+                       common::DetectionCandidates &candidates);
 };
 
 void YoloPost::extract_boxes(std::shared_ptr<YoloOutputLayer> layer,
-                             std::vector<HailoDetection> &objects)
+                             common::DetectionCandidates &candidates)
 {
     uint class_id = 0;
     float x, y, h, w, confidence, class_confidence = 0.0f;
@@ -106,7 +109,7 @@ void YoloPost::extract_boxes(std::shared_ptr<YoloOutputLayer> layer,
                     // Get the top left corner of the object.
                     xmin = (x - (w / 2.0f));
                     ymin = (y - (h / 2.0f));
-                    objects.push_back(HailoDetection(HailoBBox(xmin, ymin, w, h), class_id, m_dataset[class_id], confidence));
+                    candidates.push_back(xmin, ymin, w, h, class_id, confidence);
                 }
             }
         }
@@ -117,7 +120,7 @@ class Yolov5 : public YoloPost
 {
 public:
     Yolov5(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
+        : YoloPost(params->interned_labels, params->detection_threshold, params->nms_config, params->max_boxes), _tensors(roi->get_tensors())
     {
         if (_tensors.size() > 0)
         {
@@ -148,7 +151,7 @@ class Yolov3 : public YoloPost
 {
 public:
     Yolov3(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
+        : YoloPost(params->interned_labels, params->detection_threshold, params->nms_config, params->max_boxes), _tensors(roi->get_tensors())
     {
         if (_tensors.size() > 0)
         {
@@ -178,7 +181,7 @@ class TinyYolov4LicensePlates : public YoloPost
 {
 public:
     TinyYolov4LicensePlates(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _tensors(roi->get_tensors())
+        : YoloPost(params->interned_labels, params->detection_threshold, params->nms_config, params->max_boxes), _tensors(roi->get_tensors())
     {
         if (_tensors.size() > 0)
         {
@@ -209,7 +212,7 @@ class Yolov4 : public YoloPost
 {
 public:
     Yolov4(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _roi(roi)
+        : YoloPost(params->interned_labels, params->detection_threshold, params->nms_config, params->max_boxes), _roi(roi)
     {
         if (_roi->has_tensors())
         {
@@ -247,7 +250,7 @@ class YoloX : public YoloPost
 {
 public:
     YoloX(HailoROIPtr roi, YoloParams *params)
-        : YoloPost(params->labels, params->detection_threshold, params->iou_threshold, params->max_boxes), _roi(roi)
+        : YoloPost(params->interned_labels, params->detection_threshold, params->nms_config, params->max_boxes), _roi(roi)
     {
         if (_roi->has_tensors())
         {
@@ -300,7 +303,7 @@ void yolov5_no_faces(HailoROIPtr roi, void *params_void_ptr)
     for (auto &det : detections)
     {
         if (det.get_label() == "person")
-            hailo_common::add_object(roi, std::make_shared<HailoDetection>(det));
+            hailo_common::add_object(roi, roi->make_object<HailoDetection>(det));
     }
 }
 
@@ -456,6 +459,7 @@ YoloParams *init(const std::string config_path, const std::string function_name)
             std::cerr << function_name << " network doesn't have default parameters, run might fail" << std::endl;
             params = new YoloParams;
         }
+        params->intern_labels();
         return params;
     }
     else
@@ -499,6 +503,20 @@ YoloParams *init(const std::string config_path, const std::string function_name)
             "items": {
                 "type": "string"
                 }
+            },
+            "nms_method": {
+            "type": "string",
+            "enum": ["hard", "soft_linear", "soft_gaussian", "diou"]
+            },
+            "nms_sigma": {
+            "type": "number",
+            "exclusiveMinimum": true,
+            "minimum": 0
+            },
+            "nms_score_threshold": {
+            "type": "number",
+            "minimum": 0,
+            "maximum": 1
             }
         },
         "required": [
@@ -553,6 +571,7 @@ YoloParams *init(const std::string config_path, const std::string function_name)
             params->output_activation = doc_config_json["output_activation"].GetString();
             params->label_offset = doc_config_json["label_offset"].GetInt();
             params->max_boxes = doc_config_json["max_boxes"].GetInt();
+            params->nms_config = common::parse_nms_config(doc_config_json, common::NmsConfig(params->iou_threshold));
             if (params->output_activation != "sigmoid" && params->output_activation != "none")
             {
                 std::ostringstream oss;
@@ -563,6 +582,7 @@ YoloParams *init(const std::string config_path, const std::string function_name)
         }
         fclose(fp);
     }
+    params->intern_labels();
     return params;
 }
 void YoloParams::check_params_logic(uint num_classes_tensors)
@@ -6,6 +6,7 @@
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
 #include "yolo_output.hpp"
+#include "common/nms.hpp"
 #include "common/labels/coco_eighty.hpp"
 
 __BEGIN_DECLS
@@ -16,13 +17,16 @@ public:
     float iou_threshold;
     float detection_threshold;
     std::map<std::uint8_t, std::string> labels;
+    std::map<std::uint8_t, HailoLabel> interned_labels; // labels interned once by init, shared by all the frames
     uint num_classes;
     uint max_boxes;
     std::vector<std::vector<int>> anchors_vec;
     std::string output_activation; // can be "none" or "sigmoid"
     int label_offset;
-    YoloParams() : iou_threshold(0.45f), detection_threshold(0.3f), output_activation("none"), label_offset(1) {}
+    common::NmsConfig nms_config;
+    YoloParams() : iou_threshold(0.45f), detection_threshold(0.3f), output_activation("none"), label_offset(1), nms_config(0.45f) {}
     void check_params_logic(uint num_classes_tensors);
+    void intern_labels() { interned_labels = HailoLabel::intern(labels); }
 };
 
 class Yolov3Params : public YoloParams
@@ -150,8 +150,8 @@ xt::xarray<float> BFM(xt::xarray<float> bfm_params_xarray)
 
 xt::xarray<float> calc_bfm_params_xarray(HailoTensorPtr bfm_params)
 {
-    xt::xarray<uint8_t> bfm_params_xarray = common::get_xtensor(bfm_params);
-    xt::xarray<uint8_t> flatten_bfm_params = xt::flatten(bfm_params_xarray);
+    auto bfm_params_xarray = common::get_xtensor_view(bfm_params);
+    auto flatten_bfm_params = xt::flatten(bfm_params_xarray);
     auto qp_zp = bfm_params->vstream_info().quant_info.qp_zp;
     auto qp_scale = bfm_params->vstream_info().quant_info.qp_scale;
     xt::xarray<float> bfm_params_dequantize = common::dequantize(flatten_bfm_params, qp_scale, qp_zp);
@@ -195,7 +195,7 @@ void facial_landmark(HailoROIPtr roi)
         {
             points.emplace_back(HailoPoint(landmarks(i, 0), landmarks(i, 1)));
         }
-        roi->add_object(std::make_shared<HailoLandmarks>("landmarks", points));
+        roi->add_object(roi->make_object<HailoLandmarks>("landmarks", points));
     }
 }
 
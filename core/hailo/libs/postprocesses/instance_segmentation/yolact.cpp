@@ -370,28 +370,28 @@ std::vector<HailoDetection> instance_segmentation_post(std::map<std::string, Hai
     std::vector<HailoDetection> objects; // The detection meta we will eventually return
 
     // tensors gathering
-    xt::xarray<float, xt::layout_type::row_major> proto = common::dequantize(common::get_xtensor(tensors[PROTO_LAYER]), tensors[PROTO_LAYER]->vstream_info().quant_info.qp_scale, tensors[PROTO_LAYER]->vstream_info().quant_info.qp_zp);
+    xt::xarray<float, xt::layout_type::row_major> proto = common::dequantize(common::get_xtensor_view(tensors[PROTO_LAYER]), tensors[PROTO_LAYER]->vstream_info().quant_info.qp_scale, tensors[PROTO_LAYER]->vstream_info().quant_info.qp_zp);
 
     // Set 0
-    auto bbox_0 = common::dequantize(common::get_xtensor(tensors[BBOX_0]), tensors[BBOX_0]->vstream_info().quant_info.qp_scale, tensors[BBOX_0]->vstream_info().quant_info.qp_zp);
-    auto mask_0 = common::dequantize(common::get_xtensor(tensors[MASK_0]), tensors[MASK_0]->vstream_info().quant_info.qp_scale, tensors[MASK_0]->vstream_info().quant_info.qp_zp);
-    auto conf_0 = common::dequantize(common::get_xtensor(tensors[CONF_0]), tensors[CONF_0]->vstream_info().quant_info.qp_scale, tensors[CONF_0]->vstream_info().quant_info.qp_zp);
+    auto bbox_0 = common::dequantize(common::get_xtensor_view(tensors[BBOX_0]), tensors[BBOX_0]->vstream_info().quant_info.qp_scale, tensors[BBOX_0]->vstream_info().quant_info.qp_zp);
+    auto mask_0 = common::dequantize(common::get_xtensor_view(tensors[MASK_0]), tensors[MASK_0]->vstream_info().quant_info.qp_scale, tensors[MASK_0]->vstream_info().quant_info.qp_zp);
+    auto conf_0 = common::dequantize(common::get_xtensor_view(tensors[CONF_0]), tensors[CONF_0]->vstream_info().quant_info.qp_scale, tensors[CONF_0]->vstream_info().quant_info.qp_zp);
     // Set 1
-    auto bbox_1 = common::dequantize(common::get_xtensor(tensors[BBOX_1]), tensors[BBOX_1]->vstream_info().quant_info.qp_scale, tensors[BBOX_1]->vstream_info().quant_info.qp_zp);
-    auto mask_1 = common::dequantize(common::get_xtensor(tensors[MASK_1]), tensors[MASK_1]->vstream_info().quant_info.qp_scale, tensors[MASK_1]->vstream_info().quant_info.qp_zp);
-    auto conf_1 = common::dequantize(common::get_xtensor(tensors[CONF_1]), tensors[CONF_1]->vstream_info().quant_info.qp_scale, tensors[CONF_1]->vstream_info().quant_info.qp_zp);
+    auto bbox_1 = common::dequantize(common::get_xtensor_view(tensors[BBOX_1]), tensors[BBOX_1]->vstream_info().quant_info.qp_scale, tensors[BBOX_1]->vstream_info().quant_info.qp_zp);
+    auto mask_1 = common::dequantize(common::get_xtensor_view(tensors[MASK_1]), tensors[MASK_1]->vstream_info().quant_info.qp_scale, tensors[MASK_1]->vstream_info().quant_info.qp_zp);
+    auto conf_1 = common::dequantize(common::get_xtensor_view(tensors[CONF_1]), tensors[CONF_1]->vstream_info().quant_info.qp_scale, tensors[CONF_1]->vstream_info().quant_info.qp_zp);
     // Set 2
-    auto bbox_2 = common::dequantize(common::get_xtensor(tensors[BBOX_2]), tensors[BBOX_2]->vstream_info().quant_info.qp_scale, tensors[BBOX_2]->vstream_info().quant_info.qp_zp);
-    auto mask_2 = common::dequantize(common::get_xtensor(tensors[MASK_2]), tensors[MASK_2]->vstream_info().quant_info.qp_scale, tensors[MASK_2]->vstream_info().quant_info.qp_zp);
-    auto conf_2 = common::dequantize(common::get_xtensor(tensors[CONF_2]), tensors[CONF_2]->vstream_info().quant_info.qp_scale, tensors[CONF_2]->vstream_info().quant_info.qp_zp);
+    auto bbox_2 = common::dequantize(common::get_xtensor_view(tensors[BBOX_2]), tensors[BBOX_2]->vstream_info().quant_info.qp_scale, tensors[BBOX_2]->vstream_info().quant_info.qp_zp);
+    auto mask_2 = common::dequantize(common::get_xtensor_view(tensors[MASK_2]), tensors[MASK_2]->vstream_info().quant_info.qp_scale, tensors[MASK_2]->vstream_info().quant_info.qp_zp);
+    auto conf_2 = common::dequantize(common::get_xtensor_view(tensors[CONF_2]), tensors[CONF_2]->vstream_info().quant_info.qp_scale, tensors[CONF_2]->vstream_info().quant_info.qp_zp);
     // Set 3
-    auto bbox_3 = common::dequantize(common::get_xtensor(tensors[BBOX_3]), tensors[BBOX_3]->vstream_info().quant_info.qp_scale, tensors[BBOX_3]->vstream_info().quant_info.qp_zp);
-    auto mask_3 = common::dequantize(common::get_xtensor(tensors[MASK_3]), tensors[MASK_3]->vstream_info().quant_info.qp_scale, tensors[MASK_3]->vstream_info().quant_info.qp_zp);
-    auto conf_3 = common::dequantize(common::get_xtensor(tensors[CONF_3]), tensors[CONF_3]->vstream_info().quant_info.qp_scale, tensors[CONF_3]->vstream_info().quant_info.qp_zp);
+    auto bbox_3 = common::dequantize(common::get_xtensor_view(tensors[BBOX_3]), tensors[BBOX_3]->vstream_info().quant_info.qp_scale, tensors[BBOX_3]->vstream_info().quant_info.qp_zp);
+    auto mask_3 = common::dequantize(common::get_xtensor_view(tensors[MASK_3]), tensors[MASK_3]->vstream_info().quant_info.qp_scale, tensors[MASK_3]->vstream_info().quant_info.qp_zp);
+    auto conf_3 = common::dequantize(common::get_xtensor_view(tensors[CONF_3]), tensors[CONF_3]->vstream_info().quant_info.qp_scale, tensors[CONF_3]->vstream_info().quant_info.qp_zp);
     // Set 4
-    auto bbox_4 = common::dequantize(common::get_xtensor(tensors[BBOX_4]), tensors[BBOX_4]->vstream_info().quant_info.qp_scale, tensors[BBOX_4]->vstream_info().quant_info.qp_zp);
-    auto mask_4 = common::dequantize(common::get_xtensor(tensors[MASK_4]), tensors[MASK_4]->vstream_info().quant_info.qp_scale, tensors[MASK_4]->vstream_info().quant_info.qp_zp);
-    auto conf_4 = common::dequantize(common::get_xtensor(tensors[CONF_4]), tensors[CONF_4]->vstream_info().quant_info.qp_scale, tensors[CONF_4]->vstream_info().quant_info.qp_zp);
+    auto bbox_4 = common::dequantize(common::get_xtensor_view(tensors[BBOX_4]), tensors[BBOX_4]->vstream_info().quant_info.qp_scale, tensors[BBOX_4]->vstream_info().quant_info.qp_zp);
+    auto mask_4 = common::dequantize(common::get_xtensor_view(tensors[MASK_4]), tensors[MASK_4]->vstream_info().quant_info.qp_scale, tensors[MASK_4]->vstream_info().quant_info.qp_zp);
+    auto conf_4 = common::dequantize(common::get_xtensor_view(tensors[CONF_4]), tensors[CONF_4]->vstream_info().quant_info.qp_scale, tensors[CONF_4]->vstream_info().quant_info.qp_zp);
 
     // Reshape and stack the boxes
     auto bbox_0_reshaped = xt::reshape_view(bbox_0, {(int)bbox_0.shape(0) * (int)bbox_0.shape(1) * ((int)bbox_0.shape(2) / 4), 4});
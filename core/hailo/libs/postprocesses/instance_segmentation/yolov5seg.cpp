@@ -151,7 +151,7 @@ std::vector<HailoDetection> yolov5_decoding(xt::xarray<float> &output, const int
  *  */
 std::vector<HailoDetection> post_per_branch(std::string branch_name, const int index, std::map<std::string, HailoTensorPtr> tensors, std::vector<xt::xarray<float>> anchor_list, std::vector<int> stride_list, const float iou_threshold, const float score_threshold, std::vector<xt::xarray<float>> grids, std::vector<xt::xarray<float>> anchor_grids, const int num_anchors)
 {
-    auto output = common::dequantize(common::get_xtensor_uint16(tensors[branch_name]), tensors[branch_name]->vstream_info().quant_info.qp_scale, tensors[branch_name]->vstream_info().quant_info.qp_zp);
+    auto output = common::dequantize(common::get_xtensor_view<uint16_t>(tensors[branch_name]), tensors[branch_name]->vstream_info().quant_info.qp_scale, tensors[branch_name]->vstream_info().quant_info.qp_zp);
     return yolov5_decoding(output, stride_list[index], anchor_list[index], grids[index], anchor_grids[index], num_anchors, score_threshold);
 }
 
@@ -161,7 +161,7 @@ std::vector<HailoDetection> post_per_branch(std::string branch_name, const int i
  *  */
 std::vector<HailoDetection> yolov5seg_post(auto &tensors, auto &anchor_list, auto &stride_list, const float iou_threshold, const float score_threshold, auto &grids, auto &anchor_grids, const int num_anchors)
 {
-    auto proto_tensor = common::dequantize(common::get_xtensor(tensors["yolov5n_seg/conv63"]), tensors["yolov5n_seg/conv63"]->vstream_info().quant_info.qp_scale, tensors["yolov5n_seg/conv63"]->vstream_info().quant_info.qp_zp);
+    auto proto_tensor = common::dequantize(common::get_xtensor_view(tensors["yolov5n_seg/conv63"]), tensors["yolov5n_seg/conv63"]->vstream_info().quant_info.qp_scale, tensors["yolov5n_seg/conv63"]->vstream_info().quant_info.qp_zp);
 
     // run the postprocess for each branch seperately
     std::future<std::vector<HailoDetection>> t2 = std::async(post_per_branch, "yolov5n_seg/conv48", 2, tensors, anchor_list, stride_list, iou_threshold, score_threshold, grids, anchor_grids, num_anchors);
@@ -119,7 +119,7 @@ xt::xarray<int> nd_topk(xt::xarray<float> &array, const int k)
 std::pair<xt::xarray<int>, xt::xarray<uint8_t>> top_k_centers(HailoTensorPtr scores, const int k)
 {
     // Adapt the tensor into an xarray of proper shape and size
-    auto xscores = common::get_xtensor(scores);
+    auto xscores = common::get_xtensor_view(scores);
 
     // Get the indices of the top k scoring cells
     int size = scores->size();
@@ -147,7 +147,7 @@ std::pair<xt::xarray<int>, xt::xarray<uint8_t>> top_k_centers(HailoTensorPtr sco
 std::pair<xt::xarray<int>, xt::xarray<uint8_t>> top_k_joints(HailoTensorPtr joint_scores, const int k)
 {
     // Adapt the tensor into an xarray of proper shape and size
-    auto xjoint_scores = common::get_xtensor(joint_scores);
+    auto xjoint_scores = common::get_xtensor_view(joint_scores);
     // Transpose the joints so that we lead by joint class {17, 160, 160} instead of {160, 160, 17}
     auto transposed_scores = xt::transpose(xjoint_scores, {2, 0, 1});
     // Create a reshape view that we can sort by {17, 160, 160} --> {17, 25600}
@@ -179,7 +179,7 @@ std::pair<xt::xarray<int>, xt::xarray<uint8_t>> top_k_joints(HailoTensorPtr join
 xt::xarray<uint8_t> gather_features_from_tensor(HailoTensorPtr tensor, xt::xarray<int> &indices)
 {
     // Adapt the tensor into an xarray of proper shape and size:
-    auto xtensor = common::get_xtensor(tensor);
+    auto xtensor = common::get_xtensor_view(tensor);
 
     // Extract the top k keypoints using the given indices:
     // Use a reshaped view of the given tensor so that features can be gathered
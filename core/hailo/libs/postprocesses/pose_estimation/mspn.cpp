@@ -153,8 +153,10 @@ void mspn_postprocess(HailoROIPtr roi, const float score_threshold, bool perform
 {
     std::vector<HailoDetection> objects; // The detection meta we will eventually return
     HailoTensorPtr tensor = roi->get_tensors()[0];
-    auto tensor_xarray = common::get_xtensor_float(tensor);
-    xt::xarray<float> heatmaps = xt::transpose(tensor_xarray, {2, 0, 1});
+    // Dequantize straight from the tensor's buffer into the transposed heatmaps
+    auto tensor_view = common::get_xtensor_view(tensor);
+    xt::xarray<float> heatmaps = common::dequantize(xt::transpose(tensor_view, {2, 0, 1}),
+                                                    tensor->vstream_info().quant_info.qp_scale, tensor->vstream_info().quant_info.qp_zp);
     int num_joints = heatmaps.shape()[0];
     int height = heatmaps.shape()[1];
     int width = heatmaps.shape()[2];
@@ -174,7 +176,7 @@ void mspn_postprocess(HailoROIPtr roi, const float score_threshold, bool perform
     {
         points.emplace_back(HailoPoint(preds(i, 0), preds(i, 1), preds(i, 2)));
     }
-    roi->add_object(std::make_shared<HailoLandmarks>("centerpose", points, score_threshold, centerpose_joint_pairs));
+    roi->add_object(roi->make_object<HailoLandmarks>("centerpose", points, score_threshold, centerpose_joint_pairs));
 }
 
 /**
@@ -15,7 +15,6 @@ void semantic_segmentation(HailoROIPtr roi)
     }
 
     HailoTensorPtr tensor_ptr = roi->get_tensor(output_layer_name);
-    xt::xarray<uint8_t> tensor_data = common::get_xtensor(tensor_ptr);
 
     // allocate and memcpy to a new memory so it points to the right data
     std::vector<uint8_t> data(tensor_ptr->size());
@@ -0,0 +1,62 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#include <iostream>
+#include <cstdlib>
+#include <cxxopts.hpp>
+#include "gallery/gallery_file.hpp"
+
+//******************************************************************
+// MAIN
+//******************************************************************
+/**
+ * @brief Build command line arguments.
+ *
+ * @return cxxopts::Options
+ *         The available user arguments.
+ */
+cxxopts::Options build_arg_parser()
+{
+    cxxopts::Options options("Gallery Converter", "Converts a hailogallery file between the JSON and binary formats");
+    options.add_options()
+    ("h,help", "Show this help")
+    ("i,input", "Input gallery file, the format is detected from the file", cxxopts::value<std::string>())
+    ("o,output", "Output gallery file, written in the other format", cxxopts::value<std::string>());
+    return options;
+}
+
+int main(int argc, char *argv[])
+{
+    // Parse user arguments
+    cxxopts::Options options = build_arg_parser();
+    auto result = options.parse(argc, argv);
+    if (result.count("help") || !result.count("input") || !result.count("output"))
+    {
+        std::cout << options.help() << std::endl;
+        exit(result.count("help") ? 0 : 1);
+    }
+
+    const std::string input = result["input"].as<std::string>();
+    const std::string output = result["output"].as<std::string>();
+    try
+    {
+        std::size_t count;
+        if (gallery_file::is_binary_gallery(input.c_str()))
+        {
+            count = gallery_file::binary_to_json(input.c_str(), output.c_str());
+            std::cout << "Exported " << count << " embeddings to JSON gallery " << output << std::endl;
+        }
+        else
+        {
+            count = gallery_file::json_to_binary(input.c_str(), output.c_str());
+            std::cout << "Imported " << count << " embeddings to binary gallery " << output << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Failed to convert gallery: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -119,6 +119,9 @@ GstHailoMeta *gst_buffer_add_hailo_meta(GstBuffer *buffer, HailoMainObjectPtr ma
     // https://gstreamer.freedesktop.org/data/doc/gstreamer/head/gstreamer/html/GstBuffer.html#gst-buffer-add-meta
     gst_hailo_meta = (GstHailoMeta *)gst_buffer_add_meta(buffer, GST_HAILO_META_INFO, NULL);
 
+    // Objects of this frame are allocated from one arena, released with the buffer's main object
+    if (main_object && !main_object->get_arena())
+        main_object->set_arena(std::make_shared<HailoObjectArena>());
     gst_hailo_meta->main_object = main_object;
 
     return gst_hailo_meta;
@@ -162,4 +165,18 @@ HailoROIPtr get_hailo_main_roi(GstBuffer *buffer, gboolean create_if_missing)
     }
 
     return roi;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Get the object arena of a buffer's GstHailoMeta, e.g. to read its allocation counters.
+ *
+ * @param buffer Buffer to get the arena of.
+ * @return HailoObjectArenaPtr The arena, null if the buffer has no GstHailoMeta.
+ */
+HailoObjectArenaPtr gst_buffer_get_hailo_arena(GstBuffer *buffer)
+{
+    GstHailoMeta *meta = gst_buffer_get_hailo_meta(buffer);
+    if (!meta || !meta->main_object)
+        return nullptr;
+    return meta->main_object->get_arena();
+}
@@ -43,4 +43,6 @@ GstHailoMeta *gst_buffer_get_hailo_meta(GstBuffer *b);
 
 HailoROIPtr get_hailo_main_roi(GstBuffer *buffer, gboolean create_if_missing = false);
 
+HailoObjectArenaPtr gst_buffer_get_hailo_arena(GstBuffer *buffer);
+
 G_END_DECLS
\ No newline at end of file
@@ -3,7 +3,11 @@
  * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
  **/
 
+#include <cmath>
+#include <cstring>
+#include <vector>
 #include "common/image.hpp"
+#include "hailo_simd.hpp"
 
 size_t get_size(GstCaps *caps)
 {
@@ -49,7 +53,276 @@ cv::Mat get_mat_from_gst_frame(GstVideoFrame *frame)
     return get_mat_from_video_info(&frame->info, (char *)GST_VIDEO_FRAME_PLANE_DATA(frame, 0));
 }
 
-void resize_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
+//-------------------------------
+// FUSED RESIZE KERNELS
+//-------------------------------
+// Bilinear / nearest neighbour resize of packed 8 bit rows, written straight into the destination.
+// Every byte of a destination row has its own horizontal taps, so interleaved channels with a
+// different geometry (the Y and the U,V samples of YUY2) are resized in one pass without splitting.
+// The fixed point arithmetic is the one of cv::resize INTER_LINEAR (11 bit coefficients),
+// results are within 1 of the OpenCV path (identical for nearest neighbour).
+
+#define RESIZE_COEF_BITS (11)
+#define RESIZE_COEF_SCALE (1 << RESIZE_COEF_BITS)
+
+/**
+ * Per-thread tables of the fused kernels, grown on demand so a steady stream of crops does not allocate.
+ */
+struct ResizeScratch
+{
+    std::vector<int> xofs0;      // Source byte of the left tap of every destination byte
+    std::vector<int> xofs1;      // Source byte of the right tap
+    std::vector<int16_t> alpha;  // Left and right coefficients of every destination byte
+    std::vector<int> rows;       // Two horizontally resized source rows
+};
+
+static ResizeScratch &resize_scratch(int row_bytes)
+{
+    static thread_local ResizeScratch scratch;
+    if (scratch.xofs0.size() < (size_t)row_bytes)
+    {
+        scratch.xofs0.resize(row_bytes);
+        scratch.xofs1.resize(row_bytes);
+        scratch.alpha.resize(2 * row_bytes);
+        scratch.rows.resize(2 * row_bytes);
+    }
+    return scratch;
+}
+
+/**
+ * Source sample and coefficients of a destination sample, as computed by cv::resize.
+ */
+static inline void resize_coefficients(int dst_index, double scale, int src_size, bool nearest,
+                                       int &src_index, int16_t &coef0, int16_t &coef1)
+{
+    if (nearest)
+    {
+        src_index = std::min((int)std::floor(dst_index * scale), src_size - 1);
+        coef0 = RESIZE_COEF_SCALE;
+        coef1 = 0;
+        return;
+    }
+    float fx = (float)((dst_index + 0.5) * scale - 0.5);
+    src_index = (int)std::floor(fx);
+    fx -= src_index;
+    if (src_index < 0)
+    {
+        fx = 0;
+        src_index = 0;
+    }
+    if (src_index >= src_size - 1)
+    {
+        fx = 0;
+        src_index = src_size - 1;
+    }
+    coef0 = cv::saturate_cast<int16_t>((1.f - fx) * RESIZE_COEF_SCALE);
+    coef1 = cv::saturate_cast<int16_t>(fx * RESIZE_COEF_SCALE);
+}
+
+/**
+ * Fills the horizontal taps of one channel of a packed row.
+ * Samples of the channel are src_step (dst_step) bytes apart, starting at src_offset (dst_offset).
+ */
+static void set_channel_taps(ResizeScratch &scratch, bool nearest,
+                             int src_offset, int src_step, int src_samples,
+                             int dst_offset, int dst_step, int dst_samples)
+{
+    // The inverse of the inverse scale, like cv::resize, so a nearest neighbour lands on the same sample
+    double scale = 1. / ((double)dst_samples / src_samples);
+    for (int dx = 0; dx < dst_samples; dx++)
+    {
+        int sx;
+        int j = dst_offset + dx * dst_step;
+        resize_coefficients(dx, scale, src_samples, nearest, sx, scratch.alpha[2 * j], scratch.alpha[2 * j + 1]);
+        scratch.xofs0[j] = src_offset + sx * src_step;
+        scratch.xofs1[j] = src_offset + std::min(sx + 1, src_samples - 1) * src_step;
+    }
+}
+
+static void resize_row_horizontal(const ResizeScratch &scratch, const uint8_t *src, int *dst, int row_bytes)
+{
+    const int *xofs0 = scratch.xofs0.data();
+    const int *xofs1 = scratch.xofs1.data();
+    const int16_t *alpha = scratch.alpha.data();
+    for (int j = 0; j < row_bytes; j++)
+        dst[j] = src[xofs0[j]] * alpha[2 * j] + src[xofs1[j]] * alpha[2 * j + 1];
+}
+
+/**
+ * Blends two horizontally resized rows into a destination row,
+ * with the rounding of OpenCV's vectorized INTER_LINEAR path.
+ */
+static void resize_row_vertical(const int *row0, const int *row1, int16_t beta0, int16_t beta1, uint8_t *dst, int row_bytes)
+{
+    int x = 0;
+#if defined(HAILO_SIMD_AVX2)
+    __m256i vbeta0 = _mm256_set1_epi16(beta0);
+    __m256i vbeta1 = _mm256_set1_epi16(beta1);
+    __m256i delta = _mm256_set1_epi16(2);
+    for (; x + 16 <= row_bytes; x += 16)
+    {
+        __m256i s0 = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i *)(row0 + x)), 4),
+                                        _mm256_srai_epi32(_mm256_loadu_si256((const __m256i *)(row0 + x + 8)), 4));
+        __m256i s1 = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_loadu_si256((const __m256i *)(row1 + x)), 4),
+                                        _mm256_srai_epi32(_mm256_loadu_si256((const __m256i *)(row1 + x + 8)), 4));
+        // packs works on 128 bit lanes, restore the element order
+        s0 = _mm256_permute4x64_epi64(s0, 0xD8);
+        s1 = _mm256_permute4x64_epi64(s1, 0xD8);
+        __m256i sum = _mm256_add_epi16(_mm256_mulhi_epi16(s0, vbeta0), _mm256_mulhi_epi16(s1, vbeta1));
+        sum = _mm256_srai_epi16(_mm256_add_epi16(sum, delta), 2);
+        __m128i out = _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        _mm_storeu_si128((__m128i *)(dst + x), out);
+    }
+#elif defined(HAILO_SIMD_SSE2)
+    __m128i vbeta0 = _mm_set1_epi16(beta0);
+    __m128i vbeta1 = _mm_set1_epi16(beta1);
+    __m128i delta = _mm_set1_epi16(2);
+    for (; x + 8 <= row_bytes; x += 8)
+    {
+        __m128i s0 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i *)(row0 + x)), 4),
+                                     _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(row0 + x + 4)), 4));
+        __m128i s1 = _mm_packs_epi32(_mm_srai_epi32(_mm_loadu_si128((const __m128i *)(row1 + x)), 4),
+                                     _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(row1 + x + 4)), 4));
+        __m128i sum = _mm_add_epi16(_mm_mulhi_epi16(s0, vbeta0), _mm_mulhi_epi16(s1, vbeta1));
+        sum = _mm_srai_epi16(_mm_add_epi16(sum, delta), 2);
+        _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(sum, sum));
+    }
+#elif defined(HAILO_SIMD_NEON)
+    int16x4_t vbeta0 = vdup_n_s16(beta0);
+    int16x4_t vbeta1 = vdup_n_s16(beta1);
+    for (; x + 8 <= row_bytes; x += 8)
+    {
+        int16x4_t s0_low = vshrn_n_s32(vld1q_s32(row0 + x), 4);
+        int16x4_t s0_high = vshrn_n_s32(vld1q_s32(row0 + x + 4), 4);
+        int16x4_t s1_low = vshrn_n_s32(vld1q_s32(row1 + x), 4);
+        int16x4_t s1_high = vshrn_n_s32(vld1q_s32(row1 + x + 4), 4);
+        int16x4_t sum_low = vadd_s16(vshrn_n_s32(vmull_s16(s0_low, vbeta0), 16), vshrn_n_s32(vmull_s16(s1_low, vbeta1), 16));
+        int16x4_t sum_high = vadd_s16(vshrn_n_s32(vmull_s16(s0_high, vbeta0), 16), vshrn_n_s32(vmull_s16(s1_high, vbeta1), 16));
+        vst1_u8(dst + x, vqmovun_s16(vrshrq_n_s16(vcombine_s16(sum_low, sum_high), 2)));
+    }
+#endif
+    for (; x < row_bytes; x++)
+    {
+        int sum = (((row0[x] >> 4) * beta0) >> 16) + (((row1[x] >> 4) * beta1) >> 16);
+        dst[x] = cv::saturate_cast<uint8_t>((sum + 2) >> 2);
+    }
+}
+
+/**
+ * Resizes the rows of a packed plane, the horizontal taps must be set for every byte of a destination row.
+ * Each source row is resized horizontally once, and shared by consecutive destination rows.
+ */
+static void resize_packed_rows(ResizeScratch &scratch, bool nearest,
+                               const uint8_t *src, int src_stride, int src_rows,
+                               uint8_t *dst, int dst_stride, int dst_rows, int row_bytes)
+{
+    int *rows[2] = {scratch.rows.data(), scratch.rows.data() + row_bytes};
+    int cached[2] = {-1, -1};
+    double scale = 1. / ((double)dst_rows / src_rows);
+    for (int dy = 0; dy < dst_rows; dy++)
+    {
+        int sy;
+        int16_t beta0, beta1;
+        resize_coefficients(dy, scale, src_rows, nearest, sy, beta0, beta1);
+        int sy_next = std::min(sy + 1, src_rows - 1);
+        // Consecutive source rows always land in different slots
+        for (int row : {sy, sy_next})
+        {
+            int slot = row & 1;
+            if (cached[slot] != row)
+            {
+                resize_row_horizontal(scratch, src + (size_t)row * src_stride, rows[slot], row_bytes);
+                cached[slot] = row;
+            }
+        }
+        resize_row_vertical(rows[sy & 1], rows[sy_next & 1], beta0, beta1, dst + (size_t)dy * dst_stride, row_bytes);
+    }
+}
+
+/**
+ * Fills the rows of a packed plane with a repeating pixel (pixel_size bytes).
+ */
+static void fill_packed_rows(uint8_t *dst, int dst_stride, int rows, int row_bytes, const uint8_t *pixel, int pixel_size)
+{
+    for (int y = 0; y < rows; y++)
+    {
+        uint8_t *row = dst + (size_t)y * dst_stride;
+        if (pixel_size == 1)
+            memset(row, pixel[0], row_bytes);
+        else
+            for (int x = 0; x < row_bytes; x++)
+                row[x] = pixel[x % pixel_size];
+    }
+}
+
+/**
+ * Resizes a plane of `channels` interleaved 8 bit channels (1 for Y, 2 for UV).
+ */
+static void resize_plane(const uint8_t *src, int src_stride, int src_width, int src_height,
+                         uint8_t *dst, int dst_stride, int dst_width, int dst_height,
+                         int channels, bool nearest)
+{
+    if (src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0)
+        return;
+    int row_bytes = dst_width * channels;
+    ResizeScratch &scratch = resize_scratch(row_bytes);
+    for (int c = 0; c < channels; c++)
+        set_channel_taps(scratch, nearest, c, channels, src_width, c, channels, dst_width);
+    resize_packed_rows(scratch, nearest, src, src_stride, src_height, dst, dst_stride, dst_height, row_bytes);
+}
+
+/**
+ * Letterbox geometry of resize_letterbox_rgb: the size of the resized image and its offset in the destination.
+ */
+static HailoBBox letterbox_geometry(int src_width, int src_height, int dst_width, int dst_height,
+                                    int &new_width, int &new_height, int &left, int &top)
+{
+    float ratio = std::min(float(dst_height) / src_height, float(dst_width) / src_width);
+    new_width = std::round(src_width * ratio);
+    new_height = std::round(src_height * ratio);
+
+    float middle_point_width = (dst_width - new_width) / 2;
+    float middle_point_height = (dst_height - new_height) / 2;
+    top = std::round(middle_point_height - 0.1);
+    left = std::round(middle_point_width - 0.1);
+
+    return HailoBBox(-(left / float(new_width)),               // x-offset
+                     -(top / float(new_height)),               // y-offset
+                     1.0 / (new_width / float(dst_width)),     // width factor
+                     1.0 / (new_height / float(dst_height)));  // height factor
+}
+
+/**
+ * Letterbox resize of a plane: the border is filled with the color pixel, the image is resized into the middle.
+ */
+static HailoBBox resize_letterbox_plane(const uint8_t *src, int src_stride, int src_width, int src_height,
+                                        uint8_t *dst, int dst_stride, int dst_width, int dst_height,
+                                        int channels, const uint8_t *color, bool nearest)
+{
+    int new_width, new_height, left, top;
+    HailoBBox letterboxed_scale = letterbox_geometry(src_width, src_height, dst_width, dst_height, new_width, new_height, left, top);
+    int bottom = dst_height - new_height - top;
+    int right = dst_width - new_width - left;
+
+    fill_packed_rows(dst, dst_stride, top, dst_width * channels, color, channels);
+    fill_packed_rows(dst + (size_t)(top + new_height) * dst_stride, dst_stride, bottom, dst_width * channels, color, channels);
+    for (int y = top; y < top + new_height; y++)
+    {
+        uint8_t *row = dst + (size_t)y * dst_stride;
+        fill_packed_rows(row, dst_stride, 1, left * channels, color, channels);
+        fill_packed_rows(row + (left + new_width) * channels, dst_stride, 1, right * channels, color, channels);
+    }
+    resize_plane(src, src_stride, src_width, src_height,
+                 dst + (size_t)top * dst_stride + left * channels, dst_stride, new_width, new_height, channels, nearest);
+    return letterboxed_scale;
+}
+
+static inline bool has_fused_kernel(int interpolation)
+{
+    return interpolation == cv::INTER_LINEAR || interpolation == cv::INTER_NEAREST;
+}
+
+void resize_yuy2_opencv(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
 {
     // Split the yuy2 channels into Y U Y V
     std::vector<cv::Mat> channels(4);
@@ -82,7 +355,7 @@ void resize_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolati
     resized_y_channels_2_split.release();
 }
 
-void resize_nv12(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
+void resize_nv12_opencv(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
 {
     // Split the nv12 mat into Y and UV mats
     uint width = cropped_image.cols;
@@ -100,6 +373,45 @@ void resize_nv12(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolati
     cv::resize(uv_mat, resized_uv_channels, cv::Size(resize_width / 2, resize_height / 3), 0, 0, interpolation);
 }
 
+void resize_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
+{
+    if (!has_fused_kernel(interpolation) || resized_image.empty())
+    {
+        resize_yuy2_opencv(cropped_image, resized_image, interpolation);
+        return;
+    }
+    // A YUY2 macro pixel (Y0 U Y1 V) holds 2 pixels, the Y samples and the U,V samples are resized with their own taps
+    bool nearest = interpolation == cv::INTER_NEAREST;
+    int row_bytes = resized_image.cols * 4;
+    ResizeScratch &scratch = resize_scratch(row_bytes);
+    set_channel_taps(scratch, nearest, 0, 2, cropped_image.cols * 2, 0, 2, resized_image.cols * 2);
+    set_channel_taps(scratch, nearest, 1, 4, cropped_image.cols, 1, 4, resized_image.cols);
+    set_channel_taps(scratch, nearest, 3, 4, cropped_image.cols, 3, 4, resized_image.cols);
+    resize_packed_rows(scratch, nearest, cropped_image.data, cropped_image.step, cropped_image.rows,
+                       resized_image.data, resized_image.step, resized_image.rows, row_bytes);
+}
+
+void resize_nv12(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation)
+{
+    if (!has_fused_kernel(interpolation))
+    {
+        resize_nv12_opencv(cropped_image, resized_image, interpolation);
+        return;
+    }
+    bool nearest = interpolation == cv::INTER_NEAREST;
+    uint width = cropped_image.cols;
+    uint height = cropped_image.rows;
+    uint resize_width = resized_image.cols;
+    uint resize_height = resized_image.rows;
+    const uint8_t *uv_src = cropped_image.data + ((height * 2 / 3) * width);
+    uint8_t *uv_dst = resized_image.data + ((resize_height * 2 / 3) * resize_width);
+
+    resize_plane(cropped_image.data, cropped_image.step, width, height * 2 / 3,
+                 resized_image.data, resize_width, resize_width, resize_height * 2 / 3, 1, nearest);
+    resize_plane(uv_src, cropped_image.step, width / 2, height / 3,
+                 uv_dst, resize_width, resize_width / 2, resize_height / 3, 2, nearest);
+}
+
 HailoBBox resize_letterbox_rgb(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation)
 {
     cv::Mat tmp;
@@ -129,7 +441,7 @@ HailoBBox resize_letterbox_rgb(cv::Mat &cropped_image, cv::Mat &resized_image, c
     return letterboxed_scale;
 }
 
-HailoBBox resize_letterbox_nv12(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation)
+HailoBBox resize_letterbox_nv12_opencv(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation)
 {
     // Convert the color to YUV pixel format
     uint y = RGB2Y(color[0], color[1], color[2]);
@@ -157,6 +469,33 @@ HailoBBox resize_letterbox_nv12(cv::Mat &cropped_image, cv::Mat &resized_image,
     return letterboxed_scale;
 }
 
+HailoBBox resize_letterbox_nv12(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation)
+{
+    if (!has_fused_kernel(interpolation))
+        return resize_letterbox_nv12_opencv(cropped_image, resized_image, color, interpolation);
+
+    bool nearest = interpolation == cv::INTER_NEAREST;
+    // Convert the color to YUV pixel format
+    uint8_t y_color = RGB2Y(color[0], color[1], color[2]);
+    uint8_t uv_color[2] = {(uint8_t)RGB2U(color[0], color[1], color[2]), (uint8_t)RGB2V(color[0], color[1], color[2])};
+
+    uint width = cropped_image.cols;
+    uint height = cropped_image.rows;
+    uint resize_width = resized_image.cols;
+    uint resize_height = resized_image.rows;
+    const uint8_t *uv_src = cropped_image.data + ((height * 2 / 3) * width);
+    uint8_t *uv_dst = resized_image.data + ((resize_height * 2 / 3) * resize_width);
+
+    // Letterbox the Y and UV planes separately, straight into the resized image
+    HailoBBox letterboxed_scale = resize_letterbox_plane(cropped_image.data, cropped_image.step, width, height * 2 / 3,
+                                                         resized_image.data, resize_width, resize_width, resize_height * 2 / 3,
+                                                         1, &y_color, nearest);
+    resize_letterbox_plane(uv_src, cropped_image.step, width / 2, height / 3,
+                           uv_dst, resize_width, resize_width / 2, resize_height / 3,
+                           2, uv_color, nearest);
+    return letterboxed_scale;
+}
+
 std::shared_ptr<HailoMat> get_mat_by_format(GstBuffer *buffer, GstVideoInfo *info, GstMapInfo *map, int line_thickness, int font_thickness)
 {
     std::shared_ptr<HailoMat> hmat = nullptr;
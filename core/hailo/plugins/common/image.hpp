@@ -57,6 +57,8 @@ cv::Mat get_mat_from_gst_frame(GstVideoFrame *frame);
 
 /**
  * @brief Resizes a YUY2 image (4 channel cv::Mat)
+ *        Bilinear and nearest neighbour run a fused kernel that writes straight into resized_image,
+ *        other interpolations go through cv::resize.
  *
  * @param cropped_image - cv::Mat &
  *        The cropped image to resize
@@ -74,6 +76,8 @@ void resize_yuy2(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolati
 
 /**
  * @brief Resizes a NV12 image (1 channel cv::Mat)
+ *        Bilinear and nearest neighbour run a fused kernel that writes straight into resized_image,
+ *        other interpolations go through cv::resize.
  *
  * @param cropped_image - cv::Mat &
  *        The cropped image to resize
@@ -111,6 +115,8 @@ HailoBBox resize_letterbox_rgb(cv::Mat &cropped_image, cv::Mat &resized_image, c
 
 /**
  * @brief Resize an NV12 image using Letterbox strategy
+ *        Bilinear and nearest neighbour run a fused kernel that writes straight into resized_image,
+ *        other interpolations go through cv::resize.
  *
  * @param cropped_image - cv::Mat &
  *        The cropped image to resize
@@ -128,6 +134,14 @@ HailoBBox resize_letterbox_rgb(cv::Mat &cropped_image, cv::Mat &resized_image, c
  *        (bilinear, nearest neighbors, etc...)
  */
 HailoBBox resize_letterbox_nv12(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation = cv::INTER_LINEAR);
+
+/**
+ * @brief cv::resize implementations of resize_yuy2, resize_nv12 and resize_letterbox_nv12.
+ *        Used for the interpolations without a fused kernel, and as the reference of the fused kernels.
+ */
+void resize_yuy2_opencv(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation = cv::INTER_LINEAR);
+void resize_nv12_opencv(cv::Mat &cropped_image, cv::Mat &resized_image, int interpolation = cv::INTER_LINEAR);
+HailoBBox resize_letterbox_nv12_opencv(cv::Mat &cropped_image, cv::Mat &resized_image, cv::Scalar color, int interpolation = cv::INTER_LINEAR);
 __END_DECLS
 
 std::shared_ptr<HailoMat> get_mat_by_format(GstBuffer *buffer, GstVideoInfo *info, GstMapInfo *map, int line_thickness = 1, int font_thickness = 1);
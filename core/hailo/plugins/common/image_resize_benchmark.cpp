@@ -0,0 +1,74 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Time per frame of the fused YUY2 / NV12 resize kernels of image.cpp against their cv::resize implementations,
+  resizing a 1080p frame to a network input.
+  Usage: image_resize_benchmark [iterations]
+*/
+
+// General cpp includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+// Tappas includes
+#include "common/image.hpp"
+
+static double time_us(int iterations, const std::function<void()> &resize)
+{
+    resize(); // Warm up the scratch tables
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        resize();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static void report(const char *name, int iterations, const std::function<void()> &fused, const std::function<void()> &opencv)
+{
+    double fused_us = time_us(iterations, fused);
+    double opencv_us = time_us(iterations, opencv);
+    std::printf("%-28s %10.1f %10.1f %8.2fx\n", name, fused_us, opencv_us, opencv_us / fused_us);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    cv::RNG rng(1234);
+    cv::Scalar color(114, 114, 114);
+
+    cv::Mat yuy2(1080, 960, CV_8UC4);
+    rng.fill(yuy2, cv::RNG::UNIFORM, 0, 256);
+    cv::Mat yuy2_resized(640, 320, CV_8UC4);
+    cv::Mat nv12(1080 * 3 / 2, 1920, CV_8UC1);
+    rng.fill(nv12, cv::RNG::UNIFORM, 0, 256);
+    cv::Mat nv12_resized(640 * 3 / 2, 640, CV_8UC1);
+
+    std::printf("%-28s %10s %10s %9s\n", "1920x1080 -> 640x640", "fused us", "opencv us", "speedup");
+    for (int interpolation : {cv::INTER_LINEAR, cv::INTER_NEAREST})
+    {
+        const char *suffix = interpolation == cv::INTER_LINEAR ? "linear" : "nearest";
+        char name[64];
+        std::snprintf(name, sizeof(name), "yuy2 %s", suffix);
+        report(name, iterations,
+               [&]
+               { resize_yuy2(yuy2, yuy2_resized, interpolation); },
+               [&]
+               { resize_yuy2_opencv(yuy2, yuy2_resized, interpolation); });
+        std::snprintf(name, sizeof(name), "nv12 %s", suffix);
+        report(name, iterations,
+               [&]
+               { resize_nv12(nv12, nv12_resized, interpolation); },
+               [&]
+               { resize_nv12_opencv(nv12, nv12_resized, interpolation); });
+        std::snprintf(name, sizeof(name), "letterbox nv12 %s", suffix);
+        report(name, iterations,
+               [&]
+               { resize_letterbox_nv12(nv12, nv12_resized, color, interpolation); },
+               [&]
+               { resize_letterbox_nv12_opencv(nv12, nv12_resized, color, interpolation); });
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of the fused YUY2 / NV12 resize kernels of image.cpp against their cv::resize implementations
+  on random frames, at odd sizes: every sample must be within 1 of OpenCV.
+*/
+
+// General cpp includes
+#include <iostream>
+
+// Tappas includes
+#include "common/image.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+static cv::RNG rng(1234);
+
+static cv::Mat random_mat(int rows, int cols, int type)
+{
+    cv::Mat mat(rows, cols, type);
+    rng.fill(mat, cv::RNG::UNIFORM, 0, 256);
+    return mat;
+}
+
+static double max_difference(const cv::Mat &a, const cv::Mat &b)
+{
+    return cv::norm(a.reshape(1), b.reshape(1), cv::NORM_INF);
+}
+
+// The fused kernels round like the vectorized OpenCV path, the C and HAL paths may differ by 1
+static const double MAX_ERROR = 1.0;
+
+// Sizes are in macro pixels (2 pixels each)
+static void check_yuy2(int src_cols, int src_rows, int dst_cols, int dst_rows, int interpolation)
+{
+    cv::Mat src = random_mat(src_rows, src_cols, CV_8UC4);
+    cv::Mat fused(dst_rows, dst_cols, CV_8UC4);
+    cv::Mat reference(dst_rows, dst_cols, CV_8UC4);
+    resize_yuy2(src, fused, interpolation);
+    resize_yuy2_opencv(src, reference, interpolation);
+    double difference = max_difference(fused, reference);
+    if (difference > MAX_ERROR)
+        std::cerr << "yuy2 " << src_cols << "x" << src_rows << " -> " << dst_cols << "x" << dst_rows
+                  << " interpolation " << interpolation << ": " << difference << std::endl;
+    CHECK(difference <= MAX_ERROR);
+}
+
+// Sizes are of the Y plane, the NV12 mat holds height * 3 / 2 rows
+static void check_nv12(int src_width, int src_height, int dst_width, int dst_height, int interpolation)
+{
+    cv::Mat src = random_mat(src_height * 3 / 2, src_width, CV_8UC1);
+    cv::Mat fused(dst_height * 3 / 2, dst_width, CV_8UC1);
+    cv::Mat reference(dst_height * 3 / 2, dst_width, CV_8UC1);
+    resize_nv12(src, fused, interpolation);
+    resize_nv12_opencv(src, reference, interpolation);
+    double difference = max_difference(fused, reference);
+    if (difference > MAX_ERROR)
+        std::cerr << "nv12 " << src_width << "x" << src_height << " -> " << dst_width << "x" << dst_height
+                  << " interpolation " << interpolation << ": " << difference << std::endl;
+    CHECK(difference <= MAX_ERROR);
+}
+
+// The OpenCV letterbox pads both sides by the same amount, so the sizes are picked with an even padding
+static void check_letterbox_nv12(int src_width, int src_height, int dst_width, int dst_height, int interpolation)
+{
+    cv::Mat src = random_mat(src_height * 3 / 2, src_width, CV_8UC1);
+    cv::Mat fused(dst_height * 3 / 2, dst_width, CV_8UC1);
+    cv::Mat reference(dst_height * 3 / 2, dst_width, CV_8UC1);
+    cv::Scalar color(114, 114, 114);
+    HailoBBox fused_scale = resize_letterbox_nv12(src, fused, color, interpolation);
+    HailoBBox reference_scale = resize_letterbox_nv12_opencv(src, reference, color, interpolation);
+    double difference = max_difference(fused, reference);
+    if (difference > MAX_ERROR)
+        std::cerr << "letterbox nv12 " << src_width << "x" << src_height << " -> " << dst_width << "x" << dst_height
+                  << " interpolation " << interpolation << ": " << difference << std::endl;
+    CHECK(difference <= MAX_ERROR);
+    CHECK(fused_scale.xmin() == reference_scale.xmin() && fused_scale.ymin() == reference_scale.ymin());
+    CHECK(fused_scale.width() == reference_scale.width() && fused_scale.height() == reference_scale.height());
+}
+
+int main()
+{
+    for (int interpolation : {cv::INTER_LINEAR, cv::INTER_NEAREST})
+    {
+        check_yuy2(960, 1080, 320, 640, interpolation);
+        check_yuy2(159, 237, 67, 95, interpolation);
+        check_yuy2(33, 47, 151, 213, interpolation);
+        check_yuy2(101, 77, 101, 77, interpolation);
+
+        check_nv12(1920, 1080, 640, 360, interpolation);
+        check_nv12(317, 238, 131, 94, interpolation);
+        check_nv12(65, 48, 301, 222, interpolation);
+        check_nv12(333, 222, 333, 222, interpolation);
+
+        check_letterbox_nv12(1920, 1080, 640, 640, interpolation);
+        check_letterbox_nv12(301, 226, 155, 148, interpolation);
+    }
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -27,11 +27,18 @@ static void gst_hailoaggregator_handle_sub_frame_roi(GstHailoAggregator *hailoag
 static GstStateChangeReturn gst_hailoaggregator_change_state(GstElement *element, GstStateChange transition);
 
 #define DEFAULT_FORWARD_STICKY_EVENTS TRUE
+#define DEFAULT_MAX_FRAMES_IN_FLIGHT 1
+#define DEFAULT_FRAME_TIMEOUT 0
+// Timed out main frames remembered for dropping their late sub frames.
+#define MAX_LATE_FRAMES 64
 
 enum
 {
     PROP_0,
     PROP_FLATTEN_DETECTIONS,
+    PROP_MAX_FRAMES_IN_FLIGHT,
+    PROP_FRAME_TIMEOUT,
+    PROP_TIMED_OUT_FRAMES,
 };
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
@@ -88,6 +95,21 @@ gst_hailoaggregator_class_init(GstHailoAggregatorClass *klass)
     g_object_class_install_property(gobject_class, PROP_FLATTEN_DETECTIONS,
                                     g_param_spec_boolean("flatten-detections", "Flatten detections", "perform a 'flattening' functionality on the detection metadata when receiving each frame", false,
                                                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_MAX_FRAMES_IN_FLIGHT,
+                                    g_param_spec_uint("max-frames-in-flight", "Max frames in flight",
+                                                      "Number of main frames that can wait for their sub frames at the same time. The main pad blocks when this many frames are pending, frames are pushed in order.",
+                                                      1, G_MAXUINT, DEFAULT_MAX_FRAMES_IN_FLIGHT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_FRAME_TIMEOUT,
+                                    g_param_spec_uint("frame-timeout", "Frame timeout",
+                                                      "Time in milliseconds a main frame waits for its sub frames before it is pushed with the sub frames received so far, 0 waits forever. Sub frames that arrive later are dropped.",
+                                                      0, G_MAXUINT, DEFAULT_FRAME_TIMEOUT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_TIMED_OUT_FRAMES,
+                                    g_param_spec_uint64("timed-out-frames", "Timed out frames",
+                                                        "Number of main frames pushed before all their sub frames arrived",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
@@ -112,8 +134,15 @@ gst_hailoaggregator_init(GstHailoAggregator *hailoaggregator)
     gst_pad_use_fixed_caps(hailoaggregator->srcpad);
 
     gst_element_add_pad(GST_ELEMENT(hailoaggregator), hailoaggregator->srcpad);
-    hailoaggregator->num_of_frames = 0;
     hailoaggregator->mainframe = NULL;
+    hailoaggregator->pending_frames = std::vector<HailoAggregatorFrame>();
+    hailoaggregator->max_frames_in_flight = DEFAULT_MAX_FRAMES_IN_FLIGHT;
+    hailoaggregator->frame_timeout = DEFAULT_FRAME_TIMEOUT;
+    hailoaggregator->timed_out_frames = 0;
+    hailoaggregator->late_frames = std::vector<HailoAggregatorLateFrame>();
+    hailoaggregator->flushing = false;
+    hailoaggregator->timeout_thread = NULL;
+    hailoaggregator->timeout_thread_running = false;
 
     hailoaggregator->flatten_detections = false;
     hailoaggregator->eos_main = false;
@@ -131,6 +160,12 @@ gst_hailoaggregator_set_property(GObject *object, guint prop_id,
     case PROP_FLATTEN_DETECTIONS:
         hailoaggregator->flatten_detections = g_value_get_boolean(value);
         break;
+    case PROP_MAX_FRAMES_IN_FLIGHT:
+        hailoaggregator->max_frames_in_flight = g_value_get_uint(value);
+        break;
+    case PROP_FRAME_TIMEOUT:
+        hailoaggregator->frame_timeout = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -148,6 +183,18 @@ gst_hailoaggregator_get_property(GObject *object, guint prop_id, GValue *value,
     case PROP_FLATTEN_DETECTIONS:
         g_value_set_boolean(value, hailoaggregator->flatten_detections);
         break;
+    case PROP_MAX_FRAMES_IN_FLIGHT:
+        g_value_set_uint(value, hailoaggregator->max_frames_in_flight);
+        break;
+    case PROP_FRAME_TIMEOUT:
+        g_value_set_uint(value, hailoaggregator->frame_timeout);
+        break;
+    case PROP_TIMED_OUT_FRAMES:
+    {
+        std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+        g_value_set_uint64(value, hailoaggregator->timed_out_frames);
+        break;
+    }
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -200,6 +247,179 @@ gst_hailoaggregator_update_eos(GstHailoAggregator *hailoaggregator, GstPad *pad,
     }
 }
 
+/**
+ * Pops the pending main frames that are ready from the head of the queue, and pushes them in order.
+ * A frame is ready when all its sub frames arrived, when it waited more than frame-timeout,
+ * or when no more sub frames will come (the sub pad got eos).
+ * Called with the mutex locked, the src pad stream lock is taken before the mutex is released,
+ * so frames popped by different streaming threads are still pushed in order.
+ *
+ * @param[in] hailoaggregator   GstHailoAggregator.
+ * @param[in] lock              Lock over the mutex, locked again on return.
+ * @return The flow return of the pushes.
+ */
+static GstFlowReturn
+gst_hailoaggregator_push_ready_frames(GstHailoAggregator *hailoaggregator, std::unique_lock<std::mutex> &lock)
+{
+    GstHailoAggregatorClass *hailoaggregator_class = GST_HAILO_AGGREGATOR_GET_CLASS(hailoaggregator);
+    std::vector<HailoAggregatorFrame> ready_frames;
+    gint64 now = g_get_monotonic_time();
+
+    while (!hailoaggregator->pending_frames.empty())
+    {
+        HailoAggregatorFrame &frame = hailoaggregator->pending_frames.front();
+        bool complete = frame.num_of_frames >= frame.expected_frames;
+        bool expired = hailoaggregator->frame_timeout != 0 &&
+                       now - frame.arrival_time >= (gint64)hailoaggregator->frame_timeout * G_TIME_SPAN_MILLISECOND;
+        if (!complete && !expired && !hailoaggregator->eos_sub)
+            break;
+        if (!complete)
+        {
+            hailoaggregator->timed_out_frames++;
+            GST_WARNING_OBJECT(hailoaggregator, "Pushing frame with offset %" G_GUINT64_FORMAT " after %u of %u sub frames",
+                               frame.buffer->offset, frame.num_of_frames, frame.expected_frames);
+            // Remember the frame, so its sub frames are dropped instead of waiting for a main frame that will not come.
+            if (!hailoaggregator->eos_sub)
+            {
+                if (hailoaggregator->late_frames.size() >= MAX_LATE_FRAMES)
+                    hailoaggregator->late_frames.erase(hailoaggregator->late_frames.begin());
+                hailoaggregator->late_frames.push_back({frame.buffer->offset, frame.expected_frames - frame.num_of_frames});
+            }
+        }
+        ready_frames.push_back(frame);
+        hailoaggregator->pending_frames.erase(hailoaggregator->pending_frames.begin());
+    }
+    if (ready_frames.empty())
+        return GST_FLOW_OK;
+
+    // Release the main chain if it waits for room, and the sub frames of timed out frames.
+    hailoaggregator->cv_main.notify_all();
+    hailoaggregator->cv_sub.notify_all();
+
+    GST_PAD_STREAM_LOCK(hailoaggregator->srcpad);
+    lock.unlock();
+
+    GstFlowReturn ret = GST_FLOW_OK;
+    for (HailoAggregatorFrame &frame : ready_frames)
+    {
+        HailoROIPtr hailo_roi = get_hailo_main_roi(frame.buffer);
+        hailoaggregator_class->handle_main_roi_post_aggregation(hailoaggregator, hailo_roi);
+
+        gst_pad_sticky_events_foreach(hailoaggregator->sinkpad_main, forward_events, hailoaggregator->srcpad);
+
+        // Remove the cropping meta from the main frame.
+        if (!gst_buffer_remove_hailo_cropping_meta(frame.buffer))
+        {
+            GST_ERROR_OBJECT(hailoaggregator, "Failed to remove cropping meta from main frame");
+        }
+
+        // Push main buffer into the src pad.
+        GstFlowReturn push_ret = gst_pad_push(hailoaggregator->srcpad, frame.buffer);
+        if (ret == GST_FLOW_OK)
+            ret = push_ret;
+    }
+
+    GST_PAD_STREAM_UNLOCK(hailoaggregator->srcpad);
+    lock.lock();
+    return ret;
+}
+
+/**
+ * Waits on cv_main until main frames leave the queue, or until the oldest pending frame expires.
+ * Called with the mutex locked and at least one pending frame.
+ */
+static void
+gst_hailoaggregator_wait_main(GstHailoAggregator *hailoaggregator, std::unique_lock<std::mutex> &lock)
+{
+    if (hailoaggregator->frame_timeout == 0)
+    {
+        hailoaggregator->cv_main.wait(lock);
+        return;
+    }
+    gint64 deadline = hailoaggregator->pending_frames.front().arrival_time +
+                      (gint64)hailoaggregator->frame_timeout * G_TIME_SPAN_MILLISECOND;
+    gint64 remaining = deadline - g_get_monotonic_time();
+    if (remaining > 0)
+        hailoaggregator->cv_main.wait_for(lock, std::chrono::microseconds(remaining));
+}
+
+/**
+ * Pushes all the pending main frames, so serialized events of the main pad stay in order with them.
+ */
+static void
+gst_hailoaggregator_drain(GstHailoAggregator *hailoaggregator)
+{
+    std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
+    while (!hailoaggregator->flushing && !hailoaggregator->pending_frames.empty())
+    {
+        gst_hailoaggregator_wait_main(hailoaggregator, lock);
+        gst_hailoaggregator_push_ready_frames(hailoaggregator, lock);
+    }
+}
+
+static void
+gst_hailoaggregator_clear_pending_frames(GstHailoAggregator *hailoaggregator)
+{
+    for (HailoAggregatorFrame &frame : hailoaggregator->pending_frames)
+        gst_buffer_unref(frame.buffer);
+    std::vector<HailoAggregatorFrame>().swap(hailoaggregator->pending_frames);
+    hailoaggregator->late_frames.clear();
+}
+
+static void
+gst_hailoaggregator_set_flushing(GstHailoAggregator *hailoaggregator, bool flushing)
+{
+    std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+    hailoaggregator->flushing = flushing;
+    if (!flushing)
+        gst_hailoaggregator_clear_pending_frames(hailoaggregator);
+    // Release the chain functions waiting for frames.
+    hailoaggregator->cv_main.notify_all();
+    hailoaggregator->cv_sub.notify_all();
+    hailoaggregator->cv_timeout.notify_all();
+}
+
+/**
+ * Pushes the frames that expire while no buffers or events arrive, otherwise the last frames
+ * before a pause in the stream would wait for the next buffer. Runs only with frame-timeout.
+ */
+static void
+gst_hailoaggregator_timeout_loop(GstHailoAggregator *hailoaggregator)
+{
+    std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
+    while (hailoaggregator->timeout_thread_running)
+    {
+        if (hailoaggregator->flushing || hailoaggregator->pending_frames.empty())
+        {
+            hailoaggregator->cv_timeout.wait(lock);
+            continue;
+        }
+        gst_hailoaggregator_wait_main(hailoaggregator, lock);
+        if (!hailoaggregator->timeout_thread_running || hailoaggregator->flushing)
+            continue;
+        GstFlowReturn ret = gst_hailoaggregator_push_ready_frames(hailoaggregator, lock);
+        if (ret != GST_FLOW_OK && ret != GST_FLOW_FLUSHING)
+            GST_WARNING_OBJECT(hailoaggregator, "Pushing expired frames failed: %s", gst_flow_get_name(ret));
+    }
+}
+
+static void
+gst_hailoaggregator_stop_timeout_thread(GstHailoAggregator *hailoaggregator)
+{
+    {
+        std::lock_guard<std::mutex> lock(hailoaggregator->mutex);
+        hailoaggregator->timeout_thread_running = false;
+        hailoaggregator->cv_main.notify_all();
+        hailoaggregator->cv_timeout.notify_all();
+    }
+    if (hailoaggregator->timeout_thread != NULL)
+    {
+        hailoaggregator->timeout_thread->join();
+        delete hailoaggregator->timeout_thread;
+        hailoaggregator->timeout_thread = NULL;
+    }
+}
+
 static gboolean
 gst_hailoaggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
 {
@@ -210,6 +430,28 @@ gst_hailoaggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
 
     GST_DEBUG_OBJECT(pad, "received event %" GST_PTR_FORMAT, event);
 
+    // Pending frames are handled before taking the src pad stream lock, the mutex is always taken first.
+    if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_START)
+    {
+        gst_hailoaggregator_set_flushing(hailoaggregator, true);
+    }
+    else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP)
+    {
+        if (pad == hailoaggregator->sinkpad_main)
+            gst_hailoaggregator_set_flushing(hailoaggregator, false);
+    }
+    else if (pad == hailoaggregator->sinkpad_main && GST_EVENT_IS_SERIALIZED(event))
+    {
+        gst_hailoaggregator_drain(hailoaggregator);
+    }
+    else if (GST_EVENT_TYPE(event) == GST_EVENT_EOS)
+    {
+        // No more sub frames, push the pending frames with what they have.
+        std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
+        hailoaggregator->eos_sub = true;
+        gst_hailoaggregator_push_ready_frames(hailoaggregator, lock);
+    }
+
     if (GST_EVENT_IS_STICKY(event))
     {
         unlock = TRUE;
@@ -264,80 +506,124 @@ gst_hailoaggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
     return res;
 }
 
+/**
+ * Finds the pending main frame a sub frame belongs to: the oldest one with the same offset that still misses sub frames.
+ */
+static HailoAggregatorFrame *
+gst_hailoaggregator_find_frame(GstHailoAggregator *hailoaggregator, guint64 offset)
+{
+    for (HailoAggregatorFrame &frame : hailoaggregator->pending_frames)
+    {
+        if (frame.buffer->offset == offset && frame.num_of_frames < frame.expected_frames)
+            return &frame;
+    }
+    return NULL;
+}
+
+/**
+ * Whether the main frame of a sub frame timed out and was already pushed, so the sub frame should be dropped.
+ * Only the frames pushed incomplete are matched, offsets are not assumed to grow across sources.
+ * A late sub frame is counted against its frame, which is forgotten once all its sub frames are accounted for.
+ */
+static bool
+gst_hailoaggregator_sub_frame_is_late(GstHailoAggregator *hailoaggregator, guint64 offset)
+{
+    std::vector<HailoAggregatorLateFrame> &late_frames = hailoaggregator->late_frames;
+    for (auto it = late_frames.begin(); it != late_frames.end(); ++it)
+    {
+        if (it->offset != offset)
+            continue;
+        if (--it->missing_frames == 0)
+            late_frames.erase(it);
+        return true;
+    }
+    return false;
+}
+
 static GstFlowReturn
 gst_hailoaggregator_chain_sub(GstPad *pad, GstObject *parent, GstBuffer *buf)
 {
+    GstFlowReturn ret = GST_FLOW_OK;
     GstHailoAggregator *hailoaggregator = GST_HAILO_AGGREGATOR_CAST(parent);
     GstHailoAggregatorClass *hailoaggregator_class = GST_HAILO_AGGREGATOR_GET_CLASS(hailoaggregator);
 
     std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
 
-    // Wait until main frame is not null & the offset of main frame is not smaller.
-    if (hailoaggregator->mainframe == NULL || hailoaggregator->mainframe->offset < buf->offset)
+    // Wait until the main frame of this sub frame arrives.
+    HailoAggregatorFrame *frame = NULL;
+    gint64 deadline = g_get_monotonic_time() + (gint64)hailoaggregator->frame_timeout * G_TIME_SPAN_MILLISECOND;
+    while (!hailoaggregator->flushing)
     {
-        hailoaggregator->cv_sub.wait(lock);
+        frame = gst_hailoaggregator_find_frame(hailoaggregator, buf->offset);
+        if (frame != NULL || gst_hailoaggregator_sub_frame_is_late(hailoaggregator, buf->offset))
+            break;
+        if (hailoaggregator->frame_timeout == 0)
+        {
+            hailoaggregator->cv_sub.wait(lock);
+            continue;
+        }
+        gint64 remaining = deadline - g_get_monotonic_time();
+        if (remaining <= 0)
+            break;
+        hailoaggregator->cv_sub.wait_for(lock, std::chrono::microseconds(remaining));
     }
 
-    if (hailoaggregator->mainframe != NULL)
+    if (frame != NULL)
     {
         HailoROIPtr sub_buffer_roi = get_hailo_main_roi(buf);
+        hailoaggregator->mainframe = frame->buffer;
         hailoaggregator_class->handle_sub_frame_roi(hailoaggregator, sub_buffer_roi);
+        hailoaggregator->mainframe = NULL;
 
-        // Increase the number of received frames.
-        hailoaggregator->num_of_frames++;
-        if (hailoaggregator->num_of_frames >= hailoaggregator->expected_frames)
-        {
-            // Release the mutex in the main chain if all the frames received.
-            hailoaggregator->cv_main.notify_one();
-            hailoaggregator->num_of_frames = 0;
-        }
+        // Increase the number of received frames, and push the frames that are done.
+        frame->num_of_frames++;
+        ret = gst_hailoaggregator_push_ready_frames(hailoaggregator, lock);
+    }
+    else if (!hailoaggregator->flushing)
+    {
+        GST_DEBUG_OBJECT(hailoaggregator, "Dropping sub frame with offset %" G_GUINT64_FORMAT ", its main frame was already pushed", buf->offset);
     }
+    lock.unlock();
 
     gst_buffer_remove_hailo_meta(buf);
     gst_buffer_unref(buf);
-    return GST_FLOW_OK;
+    return ret;
 }
 
 static GstFlowReturn
 gst_hailoaggregator_chain_main(GstPad *pad, GstObject *parent, GstBuffer *buf)
 {
-    GstFlowReturn ret = GST_FLOW_ERROR;
     GstHailoAggregator *hailoaggregator = GST_HAILO_AGGREGATOR_CAST(parent);
-    GstHailoAggregatorClass *hailoaggregator_class = GST_HAILO_AGGREGATOR_GET_CLASS(hailoaggregator);
-    std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
 
-    // Get excpected frames from the main frame ROI
-    HailoROIPtr hailo_roi = get_hailo_main_roi(buf);
+    // Get excpected frames from the main frame cropping meta
+    uint expected_frames = gst_buffer_get_hailo_cropping_meta(buf)->num_of_crops;
 
-    hailoaggregator->expected_frames = gst_buffer_get_hailo_cropping_meta(buf)->num_of_crops;
+    std::unique_lock<std::mutex> lock(hailoaggregator->mutex);
 
-    if (hailoaggregator->expected_frames != 0)
+    // Wait for room in the frames in flight, frames that expire meanwhile are pushed.
+    while (!hailoaggregator->flushing && hailoaggregator->pending_frames.size() >= hailoaggregator->max_frames_in_flight)
     {
-        hailoaggregator->mainframe = buf;
-        hailoaggregator->cv_sub.notify_one();
-        hailoaggregator->cv_main.wait(lock);
-        hailoaggregator->mainframe = NULL;
+        gst_hailoaggregator_wait_main(hailoaggregator, lock);
+        gst_hailoaggregator_push_ready_frames(hailoaggregator, lock);
     }
-    lock.unlock();
-
-    hailoaggregator_class->handle_main_roi_post_aggregation(hailoaggregator, hailo_roi);
-
-    gst_pad_sticky_events_foreach(hailoaggregator->sinkpad_main, forward_events, hailoaggregator->srcpad);
-
-    // Remove the cropping meta from the main frame.
-    if (! gst_buffer_remove_hailo_cropping_meta(buf))
+    if (hailoaggregator->flushing)
     {
-        GST_ERROR_OBJECT(hailoaggregator, "Failed to remove cropping meta from main frame");
+        lock.unlock();
+        gst_buffer_unref(buf);
+        return GST_FLOW_FLUSHING;
     }
 
-    // Push main buffer into the src pad.
-    ret = gst_pad_push(hailoaggregator->srcpad, buf);
-    return ret;
+    hailoaggregator->pending_frames.push_back({buf, expected_frames, 0, g_get_monotonic_time()});
+    hailoaggregator->cv_sub.notify_all();
+    hailoaggregator->cv_timeout.notify_all();
+
+    // A frame without crops is pushed right away, unless older frames are still pending.
+    return gst_hailoaggregator_push_ready_frames(hailoaggregator, lock);
 }
 
 /**
  * Functionality to perform for each incoming sub frame.
- * Called from the chain_sub method before the releasing the mutex and the buffers.
+ * Called from the chain_sub method with the mutex locked, hailoaggregator->mainframe is the main frame of the sub frame.
  * Flatten detections from sub_buffer_roi sub to main_buffer_roi's scale.
  * Assure main_buffer_roi will contain the detections and that each detection scale and location will match the main_buffer_roi.
  * 
@@ -359,7 +645,7 @@ static void gst_hailoaggregator_handle_sub_frame_roi(GstHailoAggregator *hailoag
 
 /**
  * Functionality to perform after all frames are aggregated succesfully.
- * Called from the chain_main method before releasing the mutex and the buffers.
+ * Called in order of the main frames, right before each main frame is pushed.
  * Base implementation does nothing, derived elements can override.
  * 
  * @param[in] hailoaggregator   GstHailoAggregator.
@@ -374,12 +660,24 @@ gst_hailoaggregator_change_state(GstElement *element, GstStateChange transition)
     GstHailoAggregator *aggregator = GST_HAILO_AGGREGATOR(element);
     switch (transition)
     {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    {
+        std::lock_guard<std::mutex> lock(aggregator->mutex);
+        aggregator->flushing = false;
+        aggregator->timed_out_frames = 0;
+        if (aggregator->frame_timeout != 0)
+        {
+            aggregator->timeout_thread_running = true;
+            aggregator->timeout_thread = new std::thread(gst_hailoaggregator_timeout_loop, aggregator);
+        }
+        break;
+    }
     case GST_STATE_CHANGE_PAUSED_TO_READY:
     {
         // Unlocking both condition variables in order to finish the chain function.
         // After that the pads can be freed by the change_state of base class.
-        aggregator->cv_main.notify_all();
-        aggregator->cv_sub.notify_all();
+        gst_hailoaggregator_set_flushing(aggregator, true);
+        gst_hailoaggregator_stop_timeout_thread(aggregator);
         break;
     }
     default:
@@ -391,5 +689,13 @@ gst_hailoaggregator_change_state(GstElement *element, GstStateChange transition)
     if (ret == GST_STATE_CHANGE_FAILURE)
         return ret;
 
+    if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    {
+        // The streaming threads are stopped, release the frames that were still pending.
+        std::lock_guard<std::mutex> lock(aggregator->mutex);
+        gst_hailoaggregator_clear_pending_frames(aggregator);
+        aggregator->eos_sub = false;
+    }
+
     return ret;
 }
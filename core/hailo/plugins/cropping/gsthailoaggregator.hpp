@@ -12,6 +12,8 @@
 #include <gst/gst.h>
 #include <mutex>
 #include <condition_variable>
+#include <thread>
+#include <vector>
 
 #include "hailo_objects.hpp"
 
@@ -34,6 +36,26 @@ G_BEGIN_DECLS
 typedef struct _GstHailoAggregator GstHailoAggregator;
 typedef struct _GstHailoAggregatorClass GstHailoAggregatorClass;
 
+/**
+ * A main frame waiting for its sub frames.
+ */
+struct HailoAggregatorFrame
+{
+    GstBuffer *buffer;
+    uint expected_frames;
+    uint num_of_frames;
+    gint64 arrival_time; // Monotonic time (us) the main frame arrived at
+};
+
+/**
+ * A main frame that timed out and was pushed before all its sub frames arrived.
+ */
+struct HailoAggregatorLateFrame
+{
+    guint64 offset;
+    uint missing_frames; // Sub frames still to come, they are dropped on arrival
+};
+
 struct _GstHailoAggregator
 {
     GstElement element;
@@ -44,15 +66,22 @@ struct _GstHailoAggregator
     bool eos_main;
     GstPad *sinkpad_sub;
     bool eos_sub;
-    GstBuffer *mainframe;
-    uint num_of_frames;
-    uint expected_frames;
-    uint last_offset;
+    GstBuffer *mainframe; // The main frame of the sub frame being handled
+    std::vector<HailoAggregatorFrame> pending_frames; // Main frames in flight, in arrival order
+    guint max_frames_in_flight;
+    guint frame_timeout;
+    guint64 timed_out_frames;
+    std::vector<HailoAggregatorLateFrame> late_frames; // Timed out main frames, oldest first
+    bool flushing;
     gboolean flatten_detections;
 
     std::mutex mutex;
-    std::condition_variable cv_main;
-    std::condition_variable cv_sub;
+    std::condition_variable cv_main; // Signaled when main frames leave pending_frames
+    std::condition_variable cv_sub;  // Signaled when a main frame joins pending_frames
+
+    std::thread *timeout_thread; // Pushes expired frames while no buffers arrive, only with frame-timeout
+    bool timeout_thread_running;
+    std::condition_variable cv_timeout; // Signaled when a main frame joins pending_frames, or the thread stops
 };
 
 struct _GstHailoAggregatorClass
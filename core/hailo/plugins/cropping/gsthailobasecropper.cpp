@@ -29,6 +29,7 @@ enum
     PROP_DROP_UNCROPPED_BUFFERS,
     PROP_CROPPING_PERIOD,
     PROP_FILTER_STREAMS,
+    PROP_N_THREADS,
 };
 
 static GstStaticPadTemplate sink_factory = GST_STATIC_PAD_TEMPLATE("sink",
@@ -56,6 +57,7 @@ static gboolean gst_hailo_basecropper_sink_query(GstPad *pad,
                                                  GstObject *parent, GstQuery *query);
 static GstFlowReturn gst_hailo_basecropper_chain(GstPad *pad,
                                                  GstObject *parent, GstBuffer *buf);
+static void gst_hailo_basecropper_finalize(GObject *object);
 
 static void
 gst_hailo_basecropper_class_init(GstHailoBaseCropperClass *klass)
@@ -68,6 +70,7 @@ gst_hailo_basecropper_class_init(GstHailoBaseCropperClass *klass)
 
     gobject_class->set_property = gst_hailo_basecropper_set_property;
     gobject_class->get_property = gst_hailo_basecropper_get_property;
+    gobject_class->finalize = gst_hailo_basecropper_finalize;
 
     g_object_class_install_property(gobject_class, PROP_USE_INTERNAL_OFFSET,
                                     g_param_spec_boolean("internal-offset", "Internal Offset",
@@ -89,6 +92,11 @@ gst_hailo_basecropper_class_init(GstHailoBaseCropperClass *klass)
                                                                              "Filter stream", "",
                                                                              (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)),
                                                          (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PROP_N_THREADS,
+                                    g_param_spec_uint("n-threads", "Number of threads",
+                                                      "Number of threads to crop and resize the crops of a frame in parallel (OpenCV thread pool, set for the whole process). 1 crops serially on the streaming thread, 0 uses the OpenCV default number of threads. Crops are pushed in order either way. Default 1.",
+                                                      0, G_MAXUINT, 1,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
 
     gst_element_class_add_pad_template(gstelement_class,
                                        gst_static_pad_template_get(&src_factory));
@@ -126,6 +134,31 @@ gst_hailo_basecropper_init(GstHailoBaseCropper *hailo_basecropper)
     hailo_basecropper->stream_ids_buff_offset.clear();
     for (uint i = 0; i < GST_HAILO_CROPPER_MAX_FILTER_STREAMS; i++)
         hailo_basecropper->filter_streams[i] = "";
+    hailo_basecropper->n_threads = 1;
+    hailo_basecropper->full_image_info = gst_video_info_new();
+    hailo_basecropper->crop_image_info = gst_video_info_new();
+    hailo_basecropper->crop_pool = NULL;
+}
+
+static void
+release_crop_pool(GstHailoBaseCropper *hailo_basecropper)
+{
+    if (hailo_basecropper->crop_pool)
+    {
+        gst_buffer_pool_set_active(hailo_basecropper->crop_pool, FALSE);
+        gst_object_unref(hailo_basecropper->crop_pool);
+        hailo_basecropper->crop_pool = NULL;
+    }
+}
+
+static void
+gst_hailo_basecropper_finalize(GObject *object)
+{
+    GstHailoBaseCropper *hailo_basecropper = GST_HAILO_BASE_CROPPER(object);
+    release_crop_pool(hailo_basecropper);
+    gst_video_info_free(hailo_basecropper->full_image_info);
+    gst_video_info_free(hailo_basecropper->crop_image_info);
+    G_OBJECT_CLASS(parent_class)->finalize(object);
 }
 
 static void
@@ -197,6 +230,11 @@ gst_hailo_basecropper_set_property(GObject *object, guint prop_id,
     case PROP_FILTER_STREAMS:
         set_filter_streams(hailo_basecropper, value);
         break;
+    case PROP_N_THREADS:
+        hailo_basecropper->n_threads = g_value_get_uint(value);
+        if (hailo_basecropper->n_threads > 1)
+            cv::setNumThreads(hailo_basecropper->n_threads);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -223,12 +261,44 @@ gst_hailo_basecropper_get_property(GObject *object, guint prop_id,
     case PROP_FILTER_STREAMS:
         get_filter_streams(hailo_basecropper, value);
         break;
+    case PROP_N_THREADS:
+        g_value_set_uint(value, hailo_basecropper->n_threads);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
     }
 }
 
+/**
+ * Caches the video info of the crop caps and (re)creates the crop buffer pool for it.
+ * The pool has no maximum, crops may be held downstream (e.g. by hailoaggregator) until the whole frame is done.
+ *
+ * @param[in] hailo_basecropper      Pointer to the element.
+ * @param[in] outcaps                The negotiated caps of the crop pad.
+ * @return Upon success, returns true. Otherwise, returns false.
+ */
+static gboolean
+setup_crop_pool(GstHailoBaseCropper *hailo_basecropper, GstCaps *outcaps)
+{
+    if (!gst_video_info_from_caps(hailo_basecropper->crop_image_info, outcaps))
+        return FALSE;
+
+    release_crop_pool(hailo_basecropper);
+    GstBufferPool *pool = gst_video_buffer_pool_new();
+    GstStructure *config = gst_buffer_pool_get_config(pool);
+    gst_buffer_pool_config_set_params(config, outcaps, GST_VIDEO_INFO_SIZE(hailo_basecropper->crop_image_info), 0, 0);
+    if (!gst_buffer_pool_set_config(pool, config) || !gst_buffer_pool_set_active(pool, TRUE))
+    {
+        // Crops are still allocated one by one without the pool
+        GST_WARNING_OBJECT(hailo_basecropper, "Failed to activate crop buffer pool");
+        gst_object_unref(pool);
+        return TRUE;
+    }
+    hailo_basecropper->crop_pool = pool;
+    return TRUE;
+}
+
 /**
  * Retrieves wanted caps from downstream elements and sets them.
  *
@@ -254,6 +324,8 @@ gst_crop_scale_setcaps(GstHailoBaseCropper *hailo_basecropper)
 
     // Set The caps, unref all objects and return.
     gboolean ret = gst_pad_set_caps(hailo_basecropper->srcpad_crop, outcaps);
+    if (ret)
+        ret = setup_crop_pool(hailo_basecropper, outcaps);
     gst_query_unref(query);
     return ret;
 }
@@ -325,6 +397,7 @@ gst_hailo_basecropper_sink_event(GstPad *pad, GstObject *parent,
         GstCaps *caps;
 
         gst_event_parse_caps(event, &caps);
+        gst_video_info_from_caps(hailo_basecropper->full_image_info, caps);
 
         ret = gst_pad_set_caps(hailo_basecropper->srcpad_main, caps);
         if (!ret)
@@ -365,83 +438,35 @@ gst_hailo_basecropper_sink_event(GstPad *pad, GstObject *parent,
 }
 
 /**
- * Create a new GstBuffer, crop and resize the frame to match the crop_roi, add the buffer to the metadata.
+ * A crop of the frame in flight: the roi, its output buffer and the mat wrapping the mapped buffer.
+ */
+struct CropJob
+{
+    HailoROIPtr crop_roi;
+    GstBuffer *buffer;
+    GstMapInfo map;
+    std::shared_ptr<HailoMat> resized_image; // Null when the crop is a copy of the whole frame
+};
+
+/**
+ * Takes an output buffer for a crop, from the pool when there is one.
  *
  * @param[in] hailo_basecropper      cropping element.
- * @param[in] buf               Buffer to crop.
- * @param[in] crop_roi          Reference to a ROI Object to crop.
- * @return A new buffer, cropped and scaled for a second network.
+ * @return A new buffer sized for the crop caps.
  */
-static GstBuffer *handle_one_crop(GstHailoBaseCropper *hailo_basecropper, GstBuffer *buf, HailoROIPtr crop_roi)
+static GstBuffer *acquire_crop_buffer(GstHailoBaseCropper *hailo_basecropper)
 {
-    GstHailoBaseCropperClass *hailo_basecropperclass = GST_HAILO_BASE_CROPPER_GET_CLASS(hailo_basecropper);
-
-    GstCaps *incaps, *outcaps;
-    GstBuffer *cropped_buf = NULL;
-
-    incaps = gst_pad_get_current_caps(hailo_basecropper->sinkpad);
-    outcaps = gst_pad_get_current_caps(hailo_basecropper->srcpad_crop);
-    // Allocate new GstBuffer
-    if (!incaps || !outcaps)
-    {
-        gst_caps_unref(incaps);
-        gst_caps_unref(outcaps);
-        return cropped_buf;
-    }
-    GstVideoInfo *full_image_info = gst_video_info_new();
-    gst_video_info_from_caps(full_image_info, incaps);
-
-    GstVideoInfo *resized_image_info = gst_video_info_new();
-    gst_video_info_from_caps(resized_image_info, outcaps);
-
-    HailoBBox roi_bbox = crop_roi->get_bbox();
-    bool crop_roi_is_whole_buffer = (roi_bbox.width() == 1.0f && roi_bbox.height() == 1.0f && roi_bbox.xmin() == 0.0f && roi_bbox.ymin() == 0.0f);
-    bool input_res_equals_output_res = (full_image_info->width == resized_image_info->width && full_image_info->height == resized_image_info->height);
-    if (crop_roi_is_whole_buffer && input_res_equals_output_res)
-    {
-        GstBuffer *buffer_copy = gst_buffer_copy(buf);
-        gst_buffer_add_hailo_meta(buffer_copy, crop_roi);
-        gst_video_info_free(full_image_info);
-        gst_video_info_free(resized_image_info);
-        gst_caps_unref(incaps);
-        gst_caps_unref(outcaps);
-        return buffer_copy;
-    }
-
-    cropped_buf = gst_buffer_new_allocate(NULL, get_size(outcaps), NULL);
-
-    // get cv matrix of full image from buffer
-    GstMapInfo full_image_map;
-    gst_buffer_map(buf, &full_image_map, GST_MAP_READ);
-    std::shared_ptr<HailoMat> full_image = get_mat_by_format(buf, full_image_info, &full_image_map);
-    GstVideoFormat image_format = GST_VIDEO_INFO_FORMAT(full_image_info);
-    gst_video_info_free(full_image_info);
-
-    // get cv matrix of cropped image from buffer
-    GstMapInfo resized_image_map;
-    gst_buffer_map(cropped_buf, &resized_image_map, GST_MAP_READWRITE);
-    std::shared_ptr<HailoMat> resized_image = get_mat_by_format(cropped_buf, resized_image_info, &resized_image_map);
-    gst_video_info_free(resized_image_info);
-
-    // Crop and resize the the frame
-    cv::Mat cropped_cv_mat = full_image->crop(crop_roi);
-    cv::Mat &resized_cv_mat = resized_image->get_mat();
-    hailo_basecropperclass->resize(hailo_basecropper, cropped_cv_mat, resized_cv_mat, crop_roi, image_format);
-
-    // Add the croopped ROI to the buffer
-    gst_buffer_add_hailo_meta(cropped_buf, crop_roi);
-
-    cropped_cv_mat.release();
-    resized_cv_mat.release();
-    gst_caps_unref(incaps);
-    gst_caps_unref(outcaps);
-    gst_buffer_unmap(buf, &full_image_map);
-    gst_buffer_unmap(cropped_buf, &resized_image_map);
-    return cropped_buf;
+    GstBuffer *buffer = NULL;
+    if (hailo_basecropper->crop_pool &&
+        gst_buffer_pool_acquire_buffer(hailo_basecropper->crop_pool, &buffer, NULL) == GST_FLOW_OK)
+        return buffer;
+    return gst_buffer_new_allocate(NULL, GST_VIDEO_INFO_SIZE(hailo_basecropper->crop_image_info), NULL);
 }
 
 /**
- * Creates new crop buffers from given HailoROIs
+ * Creates new crop buffers from given HailoROIs.
+ * Output buffers are prepared on the streaming thread, then all the crops of the frame are cropped
+ * and resized (in parallel when n-threads is not 1), and finally pushed in the order of crop_rois.
  *
  * @param[in] hailo_basecropper      cropping element.
  * @param[in] buf               Buffer to crop.
@@ -450,18 +475,73 @@ static GstBuffer *handle_one_crop(GstHailoBaseCropper *hailo_basecropper, GstBuf
  */
 static gboolean handle_crops(GstHailoBaseCropper *hailo_basecropper, GstBuffer *buf, std::vector<HailoROIPtr> &crop_rois)
 {
-    for (HailoROIPtr &crop_roi : crop_rois)
+    GstHailoBaseCropperClass *hailo_basecropperclass = GST_HAILO_BASE_CROPPER_GET_CLASS(hailo_basecropper);
+    GstVideoInfo *full_image_info = hailo_basecropper->full_image_info;
+    GstVideoInfo *resized_image_info = hailo_basecropper->crop_image_info;
+    if (GST_VIDEO_INFO_FORMAT(full_image_info) == GST_VIDEO_FORMAT_UNKNOWN ||
+        GST_VIDEO_INFO_FORMAT(resized_image_info) == GST_VIDEO_FORMAT_UNKNOWN)
+    {
+        GST_WARNING_OBJECT(hailo_basecropper, "Could not crop buffer with offset %jd, caps are not negotiated", buf->offset);
+        return FALSE;
+    }
+    bool input_res_equals_output_res = (full_image_info->width == resized_image_info->width && full_image_info->height == resized_image_info->height);
+
+    // get cv matrix of full image from buffer, shared by all the crops
+    GstMapInfo full_image_map;
+    gst_buffer_map(buf, &full_image_map, GST_MAP_READ);
+    std::shared_ptr<HailoMat> full_image = get_mat_by_format(buf, full_image_info, &full_image_map);
+    GstVideoFormat image_format = GST_VIDEO_INFO_FORMAT(full_image_info);
+
+    // Prepare the output buffers
+    std::vector<CropJob> jobs(crop_rois.size());
+    for (size_t i = 0; i < crop_rois.size(); i++)
     {
-        GstBuffer *newbuf = handle_one_crop(hailo_basecropper, buf, crop_roi);
-        if (!newbuf)
+        CropJob &job = jobs[i];
+        job.crop_roi = crop_rois[i];
+        HailoBBox roi_bbox = job.crop_roi->get_bbox();
+        bool crop_roi_is_whole_buffer = (roi_bbox.width() == 1.0f && roi_bbox.height() == 1.0f && roi_bbox.xmin() == 0.0f && roi_bbox.ymin() == 0.0f);
+        if (crop_roi_is_whole_buffer && input_res_equals_output_res)
         {
-            GST_WARNING_OBJECT(hailo_basecropper, "Could not crop buffer with offset %jd", buf->offset);
-            return FALSE;
+            job.buffer = gst_buffer_copy(buf);
+            continue;
         }
-        newbuf->offset = buf->offset;
+        job.buffer = acquire_crop_buffer(hailo_basecropper);
+        gst_buffer_map(job.buffer, &job.map, GST_MAP_READWRITE);
+        job.resized_image = get_mat_by_format(job.buffer, resized_image_info, &job.map);
+    }
 
-        // Push the cropped buffer into the crop src pad.
-        gst_pad_push(hailo_basecropper->srcpad_crop, newbuf);
+    // Crop and resize the frame, one crop per stripe so uneven crop sizes balance between the threads
+    auto crop_and_resize = [&](const cv::Range &range)
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            CropJob &job = jobs[i];
+            if (!job.resized_image)
+                continue;
+            cv::Mat cropped_cv_mat = full_image->crop(job.crop_roi);
+            hailo_basecropperclass->resize(hailo_basecropper, cropped_cv_mat, job.resized_image->get_mat(), job.crop_roi, image_format);
+        }
+    };
+    if (hailo_basecropper->n_threads != 1 && jobs.size() > 1)
+        cv::parallel_for_(cv::Range(0, jobs.size()), crop_and_resize, jobs.size());
+    else
+        crop_and_resize(cv::Range(0, jobs.size()));
+    full_image.reset();
+    gst_buffer_unmap(buf, &full_image_map);
+
+    // Push the cropped buffers in order into the crop src pad.
+    for (CropJob &job : jobs)
+    {
+        if (job.resized_image)
+        {
+            job.resized_image->get_mat().release();
+            job.resized_image.reset();
+            gst_buffer_unmap(job.buffer, &job.map);
+        }
+        // Add the cropped ROI to the buffer
+        gst_buffer_add_hailo_meta(job.buffer, job.crop_roi);
+        job.buffer->offset = buf->offset;
+        gst_pad_push(hailo_basecropper->srcpad_crop, job.buffer);
     }
     return TRUE;
 }
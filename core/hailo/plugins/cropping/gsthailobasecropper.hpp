@@ -5,7 +5,7 @@
 #pragma once
 #include <map>
 #include <gst/gst.h>
-#include <gst/video/video-format.h>
+#include <gst/video/video.h>
 #include <opencv2/opencv.hpp>
 #include "hailo_objects.hpp"
 
@@ -39,6 +39,10 @@ struct _GstHailoBaseCropper
     GstPad *sinkpad, *srcpad_crop, *srcpad_main;
     std::map<std::string, int> stream_ids_buff_offset;
     const gchar *filter_streams[GST_HAILO_CROPPER_MAX_FILTER_STREAMS];
+    uint n_threads;
+    GstVideoInfo *full_image_info; // Cached from the sink caps
+    GstVideoInfo *crop_image_info; // Cached from the crop src caps
+    GstBufferPool *crop_pool;      // Output buffers of the crops
 };
 
 struct _GstHailoBaseCropperClass
@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of hailoaggregator with frames in flight and frame-timeout:
+  main frames are pushed in order whatever order their sub frames complete in,
+  a frame that misses sub frames is pushed after frame-timeout,
+  and the sub frames that arrive after it are dropped without waiting.
+*/
+
+// General cpp includes
+#include <iostream>
+
+// Gstreamer includes
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+// Tappas includes
+#include "cropping/gsthailoaggregator.hpp"
+#include "gst_hailo_cropping_meta.hpp"
+#include "gst_hailo_meta.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+#define FRAME_TIMEOUT_MS (50)
+// Scheduling slack allowed on top of frame-timeout
+#define SLACK_MS (500)
+
+struct AggregatorHarness
+{
+    GstHarness *main;
+    GstHarness *sub;
+};
+
+static AggregatorHarness aggregator_new(guint max_frames_in_flight, guint frame_timeout)
+{
+    GstElement *element = gst_element_factory_make("hailoaggregator", NULL);
+    g_object_set(element, "max-frames-in-flight", max_frames_in_flight, "frame-timeout", frame_timeout, NULL);
+    AggregatorHarness harness;
+    harness.main = gst_harness_new_with_element(element, "sink_0", "src");
+    harness.sub = gst_harness_new_with_element(element, "sink_1", NULL);
+    gst_object_unref(element);
+    gst_harness_set_src_caps_str(harness.main, "video/x-raw");
+    gst_harness_set_src_caps_str(harness.sub, "video/x-raw");
+    return harness;
+}
+
+static void aggregator_free(AggregatorHarness &harness)
+{
+    gst_harness_teardown(harness.sub);
+    gst_harness_teardown(harness.main);
+}
+
+static GstFlowReturn push_main(AggregatorHarness &harness, guint64 offset, guint crops)
+{
+    GstBuffer *buffer = gst_buffer_new();
+    GST_BUFFER_OFFSET(buffer) = offset;
+    gst_buffer_add_hailo_cropping_meta(buffer, crops);
+    get_hailo_main_roi(buffer, true);
+    return gst_harness_push(harness.main, buffer);
+}
+
+static GstFlowReturn push_sub(AggregatorHarness &harness, guint64 offset)
+{
+    GstBuffer *buffer = gst_buffer_new();
+    GST_BUFFER_OFFSET(buffer) = offset;
+    get_hailo_main_roi(buffer, true);
+    return gst_harness_push(harness.sub, buffer);
+}
+
+// Pulls a frame if one was pushed, G_MAXUINT64 otherwise
+static guint64 try_pull_offset(AggregatorHarness &harness)
+{
+    GstBuffer *buffer = gst_harness_try_pull(harness.main);
+    if (buffer == NULL)
+        return G_MAXUINT64;
+    guint64 offset = GST_BUFFER_OFFSET(buffer);
+    gst_buffer_unref(buffer);
+    return offset;
+}
+
+static guint64 timed_out_frames(AggregatorHarness &harness)
+{
+    guint64 frames;
+    g_object_get(harness.main->element, "timed-out-frames", &frames, NULL);
+    return frames;
+}
+
+static void test_reorder_window()
+{
+    AggregatorHarness harness = aggregator_new(3, 0);
+    for (guint64 offset = 0; offset < 3; offset++)
+        CHECK(push_main(harness, offset, 1) == GST_FLOW_OK);
+    CHECK(gst_harness_buffers_received(harness.main) == 0);
+
+    // The last frame completes first, it waits for the older ones
+    CHECK(push_sub(harness, 2) == GST_FLOW_OK);
+    CHECK(gst_harness_buffers_received(harness.main) == 0);
+    CHECK(push_sub(harness, 0) == GST_FLOW_OK);
+    CHECK(try_pull_offset(harness) == 0);
+    CHECK(try_pull_offset(harness) == G_MAXUINT64);
+    CHECK(push_sub(harness, 1) == GST_FLOW_OK);
+    CHECK(try_pull_offset(harness) == 1);
+    CHECK(try_pull_offset(harness) == 2);
+
+    // A frame without crops does not overtake a pending one
+    CHECK(push_main(harness, 3, 1) == GST_FLOW_OK);
+    CHECK(push_main(harness, 4, 0) == GST_FLOW_OK);
+    CHECK(try_pull_offset(harness) == G_MAXUINT64);
+    CHECK(push_sub(harness, 3) == GST_FLOW_OK);
+    CHECK(try_pull_offset(harness) == 3);
+    CHECK(try_pull_offset(harness) == 4);
+    CHECK(timed_out_frames(harness) == 0);
+    aggregator_free(harness);
+}
+
+static void test_frame_timeout_and_late_sub_frames()
+{
+    AggregatorHarness harness = aggregator_new(2, FRAME_TIMEOUT_MS);
+
+    // One of two sub frames arrives, the timeout thread pushes the frame without waiting for more buffers
+    gint64 start = g_get_monotonic_time();
+    CHECK(push_main(harness, 10, 2) == GST_FLOW_OK);
+    CHECK(push_sub(harness, 10) == GST_FLOW_OK);
+    GstBuffer *buffer = gst_harness_pull(harness.main);
+    gint64 latency = g_get_monotonic_time() - start;
+    CHECK(buffer != NULL && GST_BUFFER_OFFSET(buffer) == 10);
+    if (buffer != NULL)
+        gst_buffer_unref(buffer);
+    CHECK(latency >= FRAME_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND);
+    CHECK(latency < (FRAME_TIMEOUT_MS + SLACK_MS) * G_TIME_SPAN_MILLISECOND);
+    CHECK(timed_out_frames(harness) == 1);
+    std::cout << "timed out frame pushed after " << latency / 1000.0 << " ms (frame-timeout " << FRAME_TIMEOUT_MS << " ms)" << std::endl;
+
+    // The missing sub frame is late, it is dropped right away
+    start = g_get_monotonic_time();
+    CHECK(push_sub(harness, 10) == GST_FLOW_OK);
+    gint64 late_wait = g_get_monotonic_time() - start;
+    CHECK(late_wait < FRAME_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND);
+    CHECK(try_pull_offset(harness) == G_MAXUINT64);
+    std::cout << "late sub frame dropped after " << late_wait / 1000.0 << " ms" << std::endl;
+
+    // All the sub frames of the frame are accounted for, one more is an unknown frame and waits frame-timeout
+    start = g_get_monotonic_time();
+    CHECK(push_sub(harness, 10) == GST_FLOW_OK);
+    CHECK(g_get_monotonic_time() - start >= FRAME_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND);
+    CHECK(try_pull_offset(harness) == G_MAXUINT64);
+
+    // The stream goes on, a complete frame is pushed right away
+    start = g_get_monotonic_time();
+    CHECK(push_main(harness, 11, 1) == GST_FLOW_OK);
+    CHECK(push_sub(harness, 11) == GST_FLOW_OK);
+    CHECK(try_pull_offset(harness) == 11);
+    std::cout << "complete frame pushed after " << (g_get_monotonic_time() - start) / 1000.0 << " ms" << std::endl;
+    CHECK(timed_out_frames(harness) == 1);
+    aggregator_free(harness);
+}
+
+int main(int argc, char **argv)
+{
+    gst_init(&argc, &argv);
+    gst_element_register(NULL, "hailoaggregator", GST_RANK_NONE, GST_TYPE_HAILO_AGGREGATOR);
+
+    test_reorder_window();
+    test_frame_timeout_and_late_sub_frames();
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
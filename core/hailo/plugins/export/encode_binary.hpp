@@ -0,0 +1,349 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+// General cpp includes
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Tappas includes
+#include "hailo_objects.hpp"
+
+/**
+ * Compact binary encoding of a HailoROI, an alternative to the JSON encoding of encode_json.hpp
+ * that is written straight into a reusable byte buffer, without building a document first.
+ *
+ * Message layout (all fields little-endian, no padding):
+ *   char[4]   magic "HROI"
+ *   uint16    version (1)
+ *   uint16    reserved (0)
+ *   uint64    timestamp, milliseconds since epoch
+ *   uint64    buffer offset
+ *   bbox      bbox of the HailoROI
+ *   objects   sub objects of the HailoROI
+ *
+ *   bbox    := float32 xmin, ymin, width, height
+ *   string  := uint32 length, length bytes (no terminator)
+ *   objects := uint32 count, count * object
+ *   object  := uint8 hailo_object_t, uint32 body length, body
+ *     HAILO_CLASSIFICATION:  string classification_type, string label, int32 class_id, float32 confidence
+ *     HAILO_DETECTION:       bbox, float32 confidence, int32 class_id, string label, objects
+ *     HAILO_LANDMARKS:       string landmarks_type, float32 threshold, uint32 n (points), 3n * float32 (x, y, confidence per point), uint32 m, m * (int32, int32)
+ *     HAILO_TILE:            bbox, uint32 index, uint32 layer, uint32 mode, float32 overlap_x_axis, overlap_y_axis, objects
+ *     HAILO_UNIQUE_ID:       int32 unique_id, int32 mode
+ *     HAILO_MATRIX:          uint32 width, height, features, uint32 n, n * float32
+ *     HAILO_DEPTH_MASK:      int32 width, height, float32 transparency, uint32 n, n * float32
+ *     HAILO_CLASS_MASK:      int32 width, height, float32 transparency, uint32 n, n * uint8
+ *     HAILO_CONF_CLASS_MASK: int32 width, height, float32 transparency, int32 class_id, uint32 n, n * float32
+ * A decoder skips the objects of types it does not know by their body length.
+ */
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "The binary metadata encoding assumes a little-endian host");
+
+namespace encode_binary
+{
+    static const char MAGIC[4] = {'H', 'R', 'O', 'I'};
+    static const uint16_t VERSION = 1;
+
+    /**
+     * @brief Appends encoded fields to a byte buffer.
+     */
+    class Writer
+    {
+    private:
+        std::vector<uint8_t> &m_data;
+
+    public:
+        Writer(std::vector<uint8_t> &data) : m_data(data){};
+
+        void put_bytes(const void *bytes, size_t size)
+        {
+            const uint8_t *begin = static_cast<const uint8_t *>(bytes);
+            m_data.insert(m_data.end(), begin, begin + size);
+        }
+
+        template <typename T>
+        void put(T value)
+        {
+            put_bytes(&value, sizeof(T));
+        }
+
+        void put_string(const std::string &str)
+        {
+            put<uint32_t>(str.size());
+            put_bytes(str.data(), str.size());
+        }
+
+        template <typename T>
+        void put_array(const std::vector<T> &values)
+        {
+            put<uint32_t>(values.size());
+            put_bytes(values.data(), values.size() * sizeof(T));
+        }
+
+        void put_bbox(const HailoBBox &bbox)
+        {
+            float fields[4] = {bbox.xmin(), bbox.ymin(), bbox.width(), bbox.height()};
+            put_bytes(fields, sizeof(fields));
+        }
+
+        size_t position()
+        {
+            return m_data.size();
+        }
+
+        /**
+         * @brief Overwrite a uint32 field that was written earlier, e.g. a count or a length.
+         */
+        void patch(size_t position, uint32_t value)
+        {
+            std::memcpy(m_data.data() + position, &value, sizeof(value));
+        }
+
+        /**
+         * @brief Start an object, its body length is filled by end_object.
+         * @return The position of the body length field.
+         */
+        size_t begin_object(hailo_object_t type)
+        {
+            put<uint8_t>(type);
+            size_t length_position = m_data.size();
+            put<uint32_t>(0);
+            return length_position;
+        }
+
+        void end_object(size_t length_position)
+        {
+            patch(length_position, m_data.size() - length_position - sizeof(uint32_t));
+        }
+    };
+
+    void encode_hailo_objects(Writer &writer, HailoROIPtr roi);
+
+    template <class T>
+    void encode_mask_header(Writer &writer, T mask)
+    {
+        writer.put<int32_t>(mask->get_width());
+        writer.put<int32_t>(mask->get_height());
+        writer.put<float>(mask->get_transparency());
+    }
+
+    /**
+     * @brief Encode a single object.
+     * @return false if the type of the object has no binary encoding and nothing was written.
+     */
+    inline bool encode_object(Writer &writer, HailoObjectPtr obj)
+    {
+        switch (obj->get_type())
+        {
+        case HAILO_CLASSIFICATION:
+        {
+            HailoClassificationPtr classification = std::dynamic_pointer_cast<HailoClassification>(obj);
+            size_t object = writer.begin_object(HAILO_CLASSIFICATION);
+            writer.put_string(classification->get_interned_classification_type().str());
+            writer.put_string(classification->get_interned_label().str());
+            writer.put<int32_t>(classification->get_class_id());
+            writer.put<float>(classification->get_confidence());
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_DETECTION:
+        {
+            HailoDetectionPtr detection = std::dynamic_pointer_cast<HailoDetection>(obj);
+            size_t object = writer.begin_object(HAILO_DETECTION);
+            writer.put_bbox(detection->get_bbox());
+            writer.put<float>(detection->get_confidence());
+            writer.put<int32_t>(detection->get_class_id());
+            writer.put_string(detection->get_interned_label().str());
+            encode_hailo_objects(writer, detection);
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_LANDMARKS:
+        {
+            HailoLandmarksPtr landmarks = std::dynamic_pointer_cast<HailoLandmarks>(obj);
+            size_t object = writer.begin_object(HAILO_LANDMARKS);
+            writer.put_string(landmarks->get_landmarks_type());
+            writer.put<float>(landmarks->get_threshold());
+            std::vector<HailoPoint> points = landmarks->get_points();
+            writer.put<uint32_t>(points.size());
+            for (HailoPoint &point : points)
+            {
+                writer.put<float>(point.x());
+                writer.put<float>(point.y());
+                writer.put<float>(point.confidence());
+            }
+            std::vector<std::pair<int, int>> pairs = landmarks->get_pairs();
+            writer.put<uint32_t>(pairs.size());
+            for (auto &pair : pairs)
+            {
+                writer.put<int32_t>(pair.first);
+                writer.put<int32_t>(pair.second);
+            }
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_TILE:
+        {
+            HailoTileROIPtr tile = std::dynamic_pointer_cast<HailoTileROI>(obj);
+            size_t object = writer.begin_object(HAILO_TILE);
+            writer.put_bbox(tile->get_bbox());
+            writer.put<uint32_t>(tile->get_index());
+            writer.put<uint32_t>(tile->get_layer());
+            writer.put<uint32_t>(tile->get_mode());
+            writer.put<float>(tile->get_overlap_x_axis());
+            writer.put<float>(tile->get_overlap_y_axis());
+            encode_hailo_objects(writer, tile);
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_UNIQUE_ID:
+        {
+            HailoUniqueIDPtr id = std::dynamic_pointer_cast<HailoUniqueID>(obj);
+            size_t object = writer.begin_object(HAILO_UNIQUE_ID);
+            writer.put<int32_t>(id->get_id());
+            writer.put<int32_t>(id->get_mode());
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_MATRIX:
+        {
+            HailoMatrixPtr matrix = std::dynamic_pointer_cast<HailoMatrix>(obj);
+            size_t object = writer.begin_object(HAILO_MATRIX);
+            writer.put<uint32_t>(matrix->width());
+            writer.put<uint32_t>(matrix->height());
+            writer.put<uint32_t>(matrix->features());
+            writer.put_array(matrix->get_data());
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_DEPTH_MASK:
+        {
+            HailoDepthMaskPtr mask = std::dynamic_pointer_cast<HailoDepthMask>(obj);
+            size_t object = writer.begin_object(HAILO_DEPTH_MASK);
+            encode_mask_header(writer, mask);
+            writer.put_array(mask->get_data());
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_CLASS_MASK:
+        {
+            HailoClassMaskPtr mask = std::dynamic_pointer_cast<HailoClassMask>(obj);
+            size_t object = writer.begin_object(HAILO_CLASS_MASK);
+            encode_mask_header(writer, mask);
+            writer.put_array(mask->get_data());
+            writer.end_object(object);
+            break;
+        }
+        case HAILO_CONF_CLASS_MASK:
+        {
+            HailoConfClassMaskPtr mask = std::dynamic_pointer_cast<HailoConfClassMask>(obj);
+            size_t object = writer.begin_object(HAILO_CONF_CLASS_MASK);
+            encode_mask_header(writer, mask);
+            writer.put<int32_t>(mask->get_class_id());
+            writer.put_array(mask->get_data());
+            writer.end_object(object);
+            break;
+        }
+        default:
+            return false;
+        }
+        return true;
+    }
+
+    inline void encode_hailo_objects(Writer &writer, HailoROIPtr roi)
+    {
+        std::vector<HailoObjectPtr> objects = roi->get_objects();
+        // The count is patched at the end, since objects of other types (e.g. HailoUserMeta) are not encoded.
+        size_t count_position = writer.position();
+        writer.put<uint32_t>(0);
+        uint32_t count = 0;
+        for (HailoObjectPtr &obj : objects)
+        {
+            if (encode_object(writer, obj))
+                count++;
+        }
+        writer.patch(count_position, count);
+    }
+
+    /**
+     * @brief Encode a HailoROI and its sub objects into a byte buffer.
+     *
+     * @param data The buffer, the message is appended to it.
+     * @param roi The HailoROI.
+     * @param timestamp Milliseconds since epoch.
+     * @param buffer_offset Number of the buffer in the stream.
+     */
+    inline void encode_hailo_roi(std::vector<uint8_t> &data, HailoROIPtr roi, uint64_t timestamp, uint64_t buffer_offset)
+    {
+        Writer writer(data);
+        writer.put_bytes(MAGIC, sizeof(MAGIC));
+        writer.put<uint16_t>(VERSION);
+        writer.put<uint16_t>(0);
+        writer.put<uint64_t>(timestamp);
+        writer.put<uint64_t>(buffer_offset);
+        writer.put_bbox(roi->get_bbox());
+        encode_hailo_objects(writer, roi);
+    }
+
+    /**
+     * @brief A pool of byte buffers for messages that are handed to zmq without a copy.
+     *        A buffer goes back to the pool when zmq releases the message, keeping its capacity,
+     *        so in steady state encoding allocates nothing.
+     */
+    class MessagePool
+    {
+    public:
+        struct Block
+        {
+            MessagePool *pool;
+            std::vector<uint8_t> data;
+        };
+
+    private:
+        std::mutex m_mutex;
+        std::vector<Block *> m_free;
+
+    public:
+        ~MessagePool()
+        {
+            for (Block *block : m_free)
+                delete block;
+        }
+
+        Block *acquire()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_free.empty())
+                {
+                    Block *block = m_free.back();
+                    m_free.pop_back();
+                    block->data.clear();
+                    return block;
+                }
+            }
+            return new Block{this, {}};
+        }
+
+        void release(Block *block)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_free.push_back(block);
+        }
+
+        /**
+         * @brief Free function for zmq_msg_init_data / zmq::message_t, hint is the Block.
+         *        Called from the zmq I/O thread once the message is sent.
+         */
+        static void free_block(void * /*data*/, void *hint)
+        {
+            Block *block = static_cast<Block *>(hint);
+            block->pool->release(block);
+        }
+    };
+}
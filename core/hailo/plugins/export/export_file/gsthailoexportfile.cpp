@@ -7,9 +7,11 @@
 #include "hailo/hailort.h"
 #include <chrono>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 #include <gst/video/video.h>
 #include <gst/gst.h>
+#include <glib/gstdio.h>
 
 #define RAPIDJSON_HAS_STDSTRING 1
 #include "rapidjson/document.h"
@@ -46,8 +48,32 @@ enum
 {
     PROP_0,
     PROP_FIlE_PATH,
+    PROP_FORMAT,
+    PROP_QUEUE_SIZE,
+    PROP_MAX_FILE_SIZE,
+    PROP_MAX_FILE_DURATION,
+    PROP_COMPRESS,
+    PROP_RECORDS_DROPPED,
 };
 
+#define GST_TYPE_HAILO_EXPORT_FILE_FORMAT (gst_hailoexportfile_format_get_type())
+static GType
+gst_hailoexportfile_format_get_type(void)
+{
+    static GType exportfile_format = 0;
+    static const GEnumValue hailoexportfile_formats[] = {
+        {GST_HAILO_EXPORT_FILE_FORMAT_JSON, "JSON array of all the frames", "json"},
+        {GST_HAILO_EXPORT_FILE_FORMAT_JSONL, "JSON Lines, a line per frame written by a background thread", "jsonl"},
+        {0, NULL, NULL},
+    };
+    if (!exportfile_format)
+    {
+        exportfile_format =
+            g_enum_register_static("GstHailoExportFileFormat", hailoexportfile_formats);
+    }
+    return exportfile_format;
+}
+
 static void
 gst_hailoexportfile_class_init(GstHailoExportFileClass *klass)
 {
@@ -55,7 +81,7 @@ gst_hailoexportfile_class_init(GstHailoExportFileClass *klass)
     GstBaseTransformClass *base_transform_class =
         GST_BASE_TRANSFORM_CLASS(klass);
 
-    const char *description = "Exports HailoObjects in JSON format to a file."
+    const char *description = "Exports HailoObjects in JSON or JSON Lines format to a file."
                               "\n\t\t\t   "
                               "Encodes classes contained by HailoROI objects to JSON.";
     /* Setting up pads and setting metadata should be moved to
@@ -79,6 +105,37 @@ gst_hailoexportfile_class_init(GstHailoExportFileClass *klass)
                                     g_param_spec_string("location", "Path to export file.",
                                                         "Location of the JSON file to save", "hailo_meta.json",
                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_FORMAT,
+                                    g_param_spec_enum("format", "File format",
+                                                      "json rewrites the end of a single JSON array on every frame, "
+                                                      "jsonl appends a line per frame from a background thread and supports rotation",
+                                                      GST_TYPE_HAILO_EXPORT_FILE_FORMAT, GST_HAILO_EXPORT_FILE_FORMAT_JSON,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_QUEUE_SIZE,
+                                    g_param_spec_uint("queue-size", "Queue size",
+                                                      "jsonl: maximum number of records waiting for the writer thread, records beyond it are dropped",
+                                                      1, G_MAXUINT, 256,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_MAX_FILE_SIZE,
+                                    g_param_spec_uint64("max-file-size", "Max file size",
+                                                        "jsonl: rotate the file once it reaches this many bytes, 0 disables",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_MAX_FILE_DURATION,
+                                    g_param_spec_uint("max-file-duration", "Max file duration",
+                                                      "jsonl: rotate the file once it is open for this many seconds, 0 disables",
+                                                      0, G_MAXUINT, 0,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_COMPRESS,
+                                    g_param_spec_boolean("compress", "Compress",
+                                                         "jsonl: compress rotated files with gzip",
+                                                         FALSE,
+                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_RECORDS_DROPPED,
+                                    g_param_spec_uint64("records-dropped", "Records dropped",
+                                                        "jsonl: number of records dropped so far because the queue was full or they could not be written",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 
     gobject_class->dispose = gst_hailoexportfile_dispose;
     gobject_class->finalize = gst_hailoexportfile_finalize;
@@ -92,6 +149,18 @@ gst_hailoexportfile_init(GstHailoExportFile *hailoexportfile)
 {
     hailoexportfile->file_path = g_strdup("hailo_meta.json");
     hailoexportfile->buffer_offset = 0;
+    hailoexportfile->format = GST_HAILO_EXPORT_FILE_FORMAT_JSON;
+    hailoexportfile->queue_size = 256;
+    hailoexportfile->max_file_size = 0;
+    hailoexportfile->max_file_duration = 0;
+    hailoexportfile->compress = FALSE;
+    hailoexportfile->records_dropped = 0;
+    hailoexportfile->writer = nullptr;
+    hailoexportfile->queue = new std::deque<std::string>();
+    hailoexportfile->stopping = false;
+    hailoexportfile->file_size = 0;
+    hailoexportfile->file_start_time = 0;
+    hailoexportfile->file_index = 0;
 }
 
 void gst_hailoexportfile_set_property(GObject *object, guint property_id,
@@ -106,6 +175,21 @@ void gst_hailoexportfile_set_property(GObject *object, guint property_id,
     case PROP_FIlE_PATH:
         hailoexportfile->file_path = g_strdup(g_value_get_string(value));
         break;
+    case PROP_FORMAT:
+        hailoexportfile->format = (GstHailoExportFileFormat)g_value_get_enum(value);
+        break;
+    case PROP_QUEUE_SIZE:
+        hailoexportfile->queue_size = g_value_get_uint(value);
+        break;
+    case PROP_MAX_FILE_SIZE:
+        hailoexportfile->max_file_size = g_value_get_uint64(value);
+        break;
+    case PROP_MAX_FILE_DURATION:
+        hailoexportfile->max_file_duration = g_value_get_uint(value);
+        break;
+    case PROP_COMPRESS:
+        hailoexportfile->compress = g_value_get_boolean(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -124,6 +208,27 @@ void gst_hailoexportfile_get_property(GObject *object, guint property_id,
     case PROP_FIlE_PATH:
         g_value_set_string(value, hailoexportfile->file_path);
         break;
+    case PROP_FORMAT:
+        g_value_set_enum(value, (gint)hailoexportfile->format);
+        break;
+    case PROP_QUEUE_SIZE:
+        g_value_set_uint(value, hailoexportfile->queue_size);
+        break;
+    case PROP_MAX_FILE_SIZE:
+        g_value_set_uint64(value, hailoexportfile->max_file_size);
+        break;
+    case PROP_MAX_FILE_DURATION:
+        g_value_set_uint(value, hailoexportfile->max_file_duration);
+        break;
+    case PROP_COMPRESS:
+        g_value_set_boolean(value, hailoexportfile->compress);
+        break;
+    case PROP_RECORDS_DROPPED:
+    {
+        std::lock_guard<std::mutex> lock(hailoexportfile->mutex);
+        g_value_set_uint64(value, hailoexportfile->records_dropped);
+        break;
+    }
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -146,16 +251,199 @@ void gst_hailoexportfile_finalize(GObject *object)
     GST_DEBUG_OBJECT(hailoexportfile, "finalize");
 
     /* clean up object here */
+    delete hailoexportfile->queue;
+    hailoexportfile->queue = nullptr;
 
     G_OBJECT_CLASS(gst_hailoexportfile_parent_class)->finalize(object);
 }
 
+/**
+ * @brief Compress a rotated file with gzip, which replaces it with <path>.gz.
+ *        gzip runs in the background, so neither the streaming thread nor the writer thread waits for it.
+ */
+static void
+gst_hailoexportfile_compress_file(GstHailoExportFile *hailoexportfile, const gchar *path)
+{
+    gchar *argv[] = {(gchar *)"gzip", (gchar *)"-f", (gchar *)path, NULL};
+    GError *error = NULL;
+    // Without G_SPAWN_DO_NOT_REAP_CHILD glib reaps gzip on its own, no main loop is needed
+    if (!g_spawn_async(NULL, argv, NULL, (GSpawnFlags)(G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL),
+                       NULL, NULL, NULL, &error))
+    {
+        GST_WARNING_OBJECT(hailoexportfile, "Failed to compress %s: %s", path, error->message);
+        g_error_free(error);
+    }
+}
+
+static gboolean
+gst_hailoexportfile_open_file(GstHailoExportFile *hailoexportfile)
+{
+    hailoexportfile->json_file = fopen(hailoexportfile->file_path, "w");
+    if (!hailoexportfile->json_file)
+    {
+        GST_ELEMENT_ERROR(hailoexportfile, RESOURCE, OPEN_WRITE,
+                          ("Could not open file \"%s\" for writing.", hailoexportfile->file_path), GST_ERROR_SYSTEM);
+        return FALSE;
+    }
+    hailoexportfile->file_size = 0;
+    hailoexportfile->file_start_time = g_get_monotonic_time();
+    return TRUE;
+}
+
+/**
+ * @brief Find the highest index of the rotated files of location, <location>.<index> or <location>.<index>.gz,
+ *        so a new run continues the numbering instead of overwriting the files of earlier runs.
+ */
+static guint
+gst_hailoexportfile_last_file_index(GstHailoExportFile *hailoexportfile)
+{
+    gchar *dir_name = g_path_get_dirname(hailoexportfile->file_path);
+    gchar *base_name = g_path_get_basename(hailoexportfile->file_path);
+    gsize base_length = strlen(base_name);
+    guint last_index = 0;
+
+    GDir *dir = g_dir_open(dir_name, 0, NULL);
+    if (dir)
+    {
+        const gchar *name;
+        while ((name = g_dir_read_name(dir)) != NULL)
+        {
+            if (strncmp(name, base_name, base_length) != 0 || name[base_length] != '.')
+                continue;
+            const gchar *index_str = name + base_length + 1;
+            gchar *end = NULL;
+            guint64 index = g_ascii_strtoull(index_str, &end, 10);
+            if (end == index_str || (*end != '\0' && strcmp(end, ".gz") != 0) || index > G_MAXUINT)
+                continue;
+            last_index = MAX(last_index, (guint)index);
+        }
+        g_dir_close(dir);
+    }
+
+    g_free(base_name);
+    g_free(dir_name);
+    return last_index;
+}
+
+/**
+ * @brief Move the current file to <location>.<index> (compressed if requested).
+ */
+static gboolean
+gst_hailoexportfile_move_to_next_index(GstHailoExportFile *hailoexportfile)
+{
+    gchar *rotated_path = g_strdup_printf("%s.%u", hailoexportfile->file_path, ++hailoexportfile->file_index);
+    gboolean moved = std::rename(hailoexportfile->file_path, rotated_path) == 0;
+    if (!moved)
+        GST_ELEMENT_ERROR(hailoexportfile, RESOURCE, WRITE,
+                          ("Could not rotate file \"%s\" to \"%s\".", hailoexportfile->file_path, rotated_path), GST_ERROR_SYSTEM);
+    else if (hailoexportfile->compress)
+        gst_hailoexportfile_compress_file(hailoexportfile, rotated_path);
+    g_free(rotated_path);
+    return moved;
+}
+
+/**
+ * @brief Move the current file to <location>.<index> and start a new one.
+ *        A failure posts an element error, since the records that follow can not be written.
+ */
+static gboolean
+gst_hailoexportfile_rotate(GstHailoExportFile *hailoexportfile)
+{
+    fclose(hailoexportfile->json_file);
+    hailoexportfile->json_file = nullptr;
+
+    if (!gst_hailoexportfile_move_to_next_index(hailoexportfile))
+        return FALSE;
+    return gst_hailoexportfile_open_file(hailoexportfile);
+}
+
+static bool
+gst_hailoexportfile_should_rotate(GstHailoExportFile *hailoexportfile)
+{
+    if (hailoexportfile->file_size == 0)
+        return false;
+    if (hailoexportfile->max_file_size > 0 && hailoexportfile->file_size >= hailoexportfile->max_file_size)
+        return true;
+    return hailoexportfile->max_file_duration > 0 &&
+           g_get_monotonic_time() - hailoexportfile->file_start_time >= (gint64)hailoexportfile->max_file_duration * G_USEC_PER_SEC;
+}
+
+/**
+ * @brief Writer thread of the jsonl format: appends the queued records to the file and rotates it.
+ *        Takes all the queued records at once, so the file is flushed once per batch and not per record.
+ */
+static void
+gst_hailoexportfile_write_loop(GstHailoExportFile *hailoexportfile)
+{
+    std::deque<std::string> batch;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(hailoexportfile->mutex);
+            hailoexportfile->cond.wait(lock, [hailoexportfile]
+                                       { return hailoexportfile->stopping || !hailoexportfile->queue->empty(); });
+            if (hailoexportfile->queue->empty())
+                break; // Stopping, and everything was written
+            batch.swap(*hailoexportfile->queue);
+        }
+
+        guint64 failed_records = 0;
+        for (std::string &record : batch)
+        {
+            // A failed rotation posted an element error, the pipeline stops
+            if (gst_hailoexportfile_should_rotate(hailoexportfile) && !gst_hailoexportfile_rotate(hailoexportfile))
+                return;
+            size_t written = fwrite(record.data(), 1, record.size(), hailoexportfile->json_file);
+            hailoexportfile->file_size += written;
+            if (written != record.size())
+                failed_records++;
+        }
+        if (fflush(hailoexportfile->json_file) != 0 && failed_records == 0)
+            failed_records = batch.size(); // Buffered records that did not reach the file, which of them is unknown
+        batch.clear();
+
+        if (failed_records > 0)
+        {
+            // The disk may be full, later records are still tried, so the stream goes on once there is room again
+            {
+                std::lock_guard<std::mutex> lock(hailoexportfile->mutex);
+                hailoexportfile->records_dropped += failed_records;
+            }
+            GST_ELEMENT_WARNING(hailoexportfile, RESOURCE, WRITE,
+                                ("Could not write %" G_GUINT64_FORMAT " records to \"%s\".", failed_records, hailoexportfile->file_path),
+                                GST_ERROR_SYSTEM);
+            clearerr(hailoexportfile->json_file);
+        }
+    }
+}
+
 static gboolean
 gst_hailoexportfile_start(GstBaseTransform *trans)
 {
     GstHailoExportFile *hailoexportfile = GST_HAILO_EXPORT_FILE(trans);
     GST_DEBUG_OBJECT(hailoexportfile, "start");
 
+    if (hailoexportfile->format == GST_HAILO_EXPORT_FILE_FORMAT_JSONL)
+    {
+        // Rotated files of earlier runs are kept, and so is the last file of the previous run
+        hailoexportfile->file_index = 0;
+        if (hailoexportfile->max_file_size > 0 || hailoexportfile->max_file_duration > 0)
+        {
+            hailoexportfile->file_index = gst_hailoexportfile_last_file_index(hailoexportfile);
+            GStatBuf file_stat;
+            if (g_stat(hailoexportfile->file_path, &file_stat) == 0 && file_stat.st_size > 0 &&
+                !gst_hailoexportfile_move_to_next_index(hailoexportfile))
+                return FALSE;
+        }
+        // The file stays open, it is written by the writer thread only
+        if (!gst_hailoexportfile_open_file(hailoexportfile))
+            return FALSE;
+        hailoexportfile->records_dropped = 0;
+        hailoexportfile->stopping = false;
+        hailoexportfile->writer = new std::thread(gst_hailoexportfile_write_loop, hailoexportfile);
+        return TRUE;
+    }
+
     hailoexportfile->json_file = fopen(hailoexportfile->file_path, "w");
     fputs("[]", hailoexportfile->json_file);
     fclose(hailoexportfile->json_file);
@@ -169,9 +457,50 @@ gst_hailoexportfile_stop(GstBaseTransform *trans)
     GstHailoExportFile *hailoexportfile = GST_HAILO_EXPORT_FILE(trans);
     GST_DEBUG_OBJECT(hailoexportfile, "stop");
 
+    if (hailoexportfile->writer)
+    {
+        // The writer thread writes the records left in the queue before it exits
+        {
+            std::lock_guard<std::mutex> lock(hailoexportfile->mutex);
+            hailoexportfile->stopping = true;
+        }
+        hailoexportfile->cond.notify_all();
+        hailoexportfile->writer->join();
+        delete hailoexportfile->writer;
+        hailoexportfile->writer = nullptr;
+        hailoexportfile->queue->clear();
+        if (hailoexportfile->json_file)
+            fclose(hailoexportfile->json_file);
+        hailoexportfile->json_file = nullptr;
+    }
+
     return TRUE;
 }
 
+static void
+gst_hailoexportfile_queue_record(GstHailoExportFile *hailoexportfile, rapidjson::Document &encoded_roi)
+{
+    // Encode the record on the streaming thread, compact and on a single line
+    rapidjson::StringBuffer json_buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(json_buffer);
+    encoded_roi.Accept(writer);
+    std::string record(json_buffer.GetString(), json_buffer.GetSize());
+    record.push_back('\n');
+
+    {
+        std::lock_guard<std::mutex> lock(hailoexportfile->mutex);
+        // Never block the streaming thread on the disk, drop the record instead
+        if (hailoexportfile->queue->size() >= hailoexportfile->queue_size)
+        {
+            hailoexportfile->records_dropped++;
+            GST_LOG_OBJECT(hailoexportfile, "Queue is full, dropping the record of buffer %u", hailoexportfile->buffer_offset);
+            return;
+        }
+        hailoexportfile->queue->emplace_back(std::move(record));
+    }
+    hailoexportfile->cond.notify_one();
+}
+
 static GstFlowReturn
 gst_hailoexportfile_transform_ip(GstBaseTransform *trans,
                                  GstBuffer *buffer)
@@ -187,6 +516,13 @@ gst_hailoexportfile_transform_ip(GstBaseTransform *trans,
     encoded_roi.AddMember("timestamp (ms)", rapidjson::Value(timenow), encoded_roi.GetAllocator());
     encoded_roi.AddMember("buffer_offset", rapidjson::Value(hailoexportfile->buffer_offset), encoded_roi.GetAllocator());
 
+    if (hailoexportfile->format == GST_HAILO_EXPORT_FILE_FORMAT_JSONL)
+    {
+        gst_hailoexportfile_queue_record(hailoexportfile, encoded_roi);
+        hailoexportfile->buffer_offset++;
+        GST_DEBUG_OBJECT(hailoexportfile, "transform_ip");
+        return GST_FLOW_OK;
+    }
     // Open the file 
     hailoexportfile->json_file = fopen(hailoexportfile->file_path, "rb+");
 
@@ -7,7 +7,12 @@
 #include <gst/base/gstbasetransform.h>
 #include "hailo_objects.hpp"
 #include "export/encode_json.hpp"
+#include <condition_variable>
 #include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
 
 G_BEGIN_DECLS
 
@@ -17,6 +22,12 @@ G_BEGIN_DECLS
 #define GST_IS_HAILO_EXPORT_FILE(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_HAILO_EXPORT_FILE))
 #define GST_IS_HAILO_EXPORT_FILE_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_HAILO_EXPORT_FILE))
 
+typedef enum
+{
+    GST_HAILO_EXPORT_FILE_FORMAT_JSON,
+    GST_HAILO_EXPORT_FILE_FORMAT_JSONL,
+} GstHailoExportFileFormat;
+
 typedef struct _GstHailoExportFile GstHailoExportFile;
 typedef struct _GstHailoExportFileClass GstHailoExportFileClass;
 
@@ -26,6 +37,22 @@ struct _GstHailoExportFile
     gchar *file_path;
     FILE* json_file;
     uint buffer_offset;
+    GstHailoExportFileFormat format;
+
+    // JSON Lines format, records are written by the writer thread
+    guint queue_size;
+    guint64 max_file_size;
+    guint max_file_duration;
+    gboolean compress;
+    guint64 records_dropped;
+    std::thread *writer;
+    std::mutex mutex;
+    std::condition_variable cond;    // Signaled when records are queued or when stopping
+    std::deque<std::string> *queue;  // Encoded records waiting for the writer thread, guarded by mutex
+    bool stopping;
+    guint64 file_size;               // Bytes written to the current file, used by the writer thread only
+    gint64 file_start_time;          // Monotonic time (us) the current file was opened at
+    guint file_index;                // Index of the last rotated file
 };
 
 struct _GstHailoExportFileClass
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Records per second of hailoexportfile, for frames with a number of detections.
+  push: rate the streaming thread takes the frames at, written: rate until the element stopped and the file is complete.
+  For jsonl the queue holds all the frames, so nothing is dropped and the written rate is the writer thread's.
+  Usage: hailoexportfile_benchmark [frames] [detections per frame]
+*/
+
+// General cpp includes
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Gstreamer includes
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+#include <glib/gstdio.h>
+
+// Tappas includes
+#include "export/export_file/gsthailoexportfile.hpp"
+#include "gst_hailo_meta.hpp"
+
+static GstBuffer *frame_buffer(guint detections)
+{
+    GstBuffer *buffer = gst_buffer_new();
+    HailoROIPtr roi = get_hailo_main_roi(buffer, true);
+    for (guint i = 0; i < detections; i++)
+    {
+        float x = (i % 10) * 0.1f;
+        roi->add_object(std::make_shared<HailoDetection>(HailoBBox(x, x, 0.1f, 0.1f), i % 80, "person", 0.5f + (i % 50) * 0.01f));
+    }
+    return buffer;
+}
+
+static void measure(const gchar *format, const gchar *location, guint frames, guint detections)
+{
+    std::vector<GstBuffer *> buffers;
+    for (guint i = 0; i < frames; i++)
+        buffers.push_back(frame_buffer(detections));
+
+    GstElement *element = gst_element_factory_make("hailoexportfile", NULL);
+    g_object_set(element, "location", location, "queue-size", frames, NULL);
+    gst_util_set_object_arg(G_OBJECT(element), "format", format);
+    GstHarness *harness = gst_harness_new_with_element(element, "sink", "src");
+    gst_harness_set_src_caps_str(harness, "video/x-raw");
+
+    gint64 start = g_get_monotonic_time();
+    for (GstBuffer *buffer : buffers)
+        gst_harness_push(harness, buffer);
+    gint64 pushed = g_get_monotonic_time() - start;
+
+    // Stopping waits for the writer thread to write the queued records
+    gst_element_set_state(element, GST_STATE_NULL);
+    gint64 written = g_get_monotonic_time() - start;
+    guint64 dropped;
+    g_object_get(element, "records-dropped", &dropped, NULL);
+
+    gst_harness_teardown(harness);
+    gst_object_unref(element);
+    g_unlink(location);
+
+    std::printf("%-8s %14.0f %14.0f %10lu\n", format,
+                (double)frames * G_USEC_PER_SEC / pushed, (double)frames * G_USEC_PER_SEC / written, (unsigned long)dropped);
+}
+
+int main(int argc, char **argv)
+{
+    gst_init(&argc, &argv);
+    gst_element_register(NULL, "hailoexportfile", GST_RANK_NONE, GST_TYPE_HAILO_EXPORT_FILE);
+    guint frames = argc > 1 ? std::atoi(argv[1]) : 2000;
+    guint detections = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    gchar *dir = g_dir_make_tmp("hailoexportfile_XXXXXX", NULL);
+    gchar *location = g_build_filename(dir, "hailo_meta.json", NULL);
+
+    std::printf("frames %u, detections per frame %u\n", frames, detections);
+    std::printf("%-8s %14s %14s %10s\n", "format", "push rec/s", "written rec/s", "dropped");
+    measure("json", location, frames, detections);
+    measure("jsonl", location, frames, detections);
+
+    g_rmdir(dir);
+    g_free(location);
+    g_free(dir);
+    return 0;
+}
@@ -45,8 +45,27 @@ enum
 {
     PROP_0,
     PROP_ADDRESS,
+    PROP_FORMAT,
 };
 
+#define GST_TYPE_HAILO_EXPORT_ZMQ_FORMAT (gst_hailoexportzmq_format_get_type())
+static GType
+gst_hailoexportzmq_format_get_type(void)
+{
+    static GType exportzmq_format = 0;
+    static const GEnumValue hailoexportzmq_formats[] = {
+        {GST_HAILO_EXPORT_ZMQ_FORMAT_JSON, "JSON document", "json"},
+        {GST_HAILO_EXPORT_ZMQ_FORMAT_BINARY, "Compact binary encoding", "binary"},
+        {0, NULL, NULL},
+    };
+    if (!exportzmq_format)
+    {
+        exportzmq_format =
+            g_enum_register_static("GstHailoExportZMQFormat", hailoexportzmq_formats);
+    }
+    return exportzmq_format;
+}
+
 static void
 gst_hailoexportzmq_class_init(GstHailoExportZMQClass *klass)
 {
@@ -54,9 +73,9 @@ gst_hailoexportzmq_class_init(GstHailoExportZMQClass *klass)
     GstBaseTransformClass *base_transform_class =
         GST_BASE_TRANSFORM_CLASS(klass);
 
-    const char *description = "Exports HailoObjects in JSON format to a ZMQ socket."
+    const char *description = "Exports HailoObjects in JSON or binary format to a ZMQ socket."
                               "\n\t\t\t   "
-                              "Encodes classes contained by HailoROI objects to JSON.";
+                              "Encodes classes contained by HailoROI objects to JSON or to a compact binary encoding.";
     /* Setting up pads and setting metadata should be moved to
        base_class_init if you intend to subclass this class. */
     gst_element_class_add_pad_template(GST_ELEMENT_CLASS(klass),
@@ -78,6 +97,12 @@ gst_hailoexportzmq_class_init(GstHailoExportZMQClass *klass)
                                     g_param_spec_string("address", "Endpoint address.",
                                                         "Address to bind the socket to.", "tcp://*:5555",
                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_FORMAT,
+                                    g_param_spec_enum("format", "Message format",
+                                                      "Encoding of the messages. binary is encoded in a single pass and sent without a copy, "
+                                                      "hailoimportzmq detects the format of each message by itself.",
+                                                      GST_TYPE_HAILO_EXPORT_ZMQ_FORMAT, GST_HAILO_EXPORT_ZMQ_FORMAT_JSON,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
 
     gobject_class->dispose = gst_hailoexportzmq_dispose;
     gobject_class->finalize = gst_hailoexportzmq_finalize;
@@ -91,6 +116,8 @@ gst_hailoexportzmq_init(GstHailoExportZMQ *hailoexportzmq)
 {
     hailoexportzmq->address = g_strdup("tcp://*:5555");
     hailoexportzmq->buffer_offset = 0;
+    hailoexportzmq->format = GST_HAILO_EXPORT_ZMQ_FORMAT_JSON;
+    hailoexportzmq->message_pool = new encode_binary::MessagePool();
 }
 
 void gst_hailoexportzmq_set_property(GObject *object, guint property_id,
@@ -105,6 +132,9 @@ void gst_hailoexportzmq_set_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         hailoexportzmq->address = g_strdup(g_value_get_string(value));
         break;
+    case PROP_FORMAT:
+        hailoexportzmq->format = (GstHailoExportZMQFormat)g_value_get_enum(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -123,6 +153,9 @@ void gst_hailoexportzmq_get_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         g_value_set_string(value, hailoexportzmq->address);
         break;
+    case PROP_FORMAT:
+        g_value_set_enum(value, (gint)hailoexportzmq->format);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -145,6 +178,9 @@ void gst_hailoexportzmq_finalize(GObject *object)
     GST_DEBUG_OBJECT(hailoexportzmq, "finalize");
 
     /* clean up object here */
+    // The sockets are closed by now, so zmq holds none of the pooled buffers
+    delete hailoexportzmq->message_pool;
+    hailoexportzmq->message_pool = nullptr;
 
     G_OBJECT_CLASS(gst_hailoexportzmq_parent_class)->finalize(object);
 }
@@ -178,18 +214,25 @@ gst_hailoexportzmq_stop(GstBaseTransform *trans)
     return TRUE;
 }
 
-static GstFlowReturn
-gst_hailoexportzmq_transform_ip(GstBaseTransform *trans,
-                                 GstBuffer *buffer)
+static void
+gst_hailoexportzmq_send(GstHailoExportZMQ *hailoexportzmq, zmq::message_t &message)
 {
-    GstHailoExportZMQ *hailoexportzmq = GST_HAILO_EXPORT_ZMQ(trans);
+    size_t message_size = message.size();
+#if (CPPZMQ_VERSION_MAJOR >= 4 && CPPZMQ_VERSION_MINOR >= 6 && CPPZMQ_VERSION_PATCH >= 0)
+    zmq::send_result_t result = hailoexportzmq->socket->send(message, zmq::send_flags(ZMQ_DONTWAIT));
+#else
+    zmq::detail::send_result_t result = hailoexportzmq->socket->send(message, zmq::send_flags(ZMQ_DONTWAIT));
+#endif
+    if (result != message_size)
+        GST_WARNING("hailoexportzmq failed to send buffer!");
+}
 
-    // Get the roi from the current buffer and encode it to a JSON entry
-    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
+static void
+gst_hailoexportzmq_send_json(GstHailoExportZMQ *hailoexportzmq, HailoROIPtr hailo_roi, int64_t timenow)
+{
     rapidjson::Document encoded_roi = encode_json::encode_hailo_roi(hailo_roi);
 
     // Add a timestamp
-    auto timenow = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     encoded_roi.AddMember("timestamp (ms)", rapidjson::Value(timenow), encoded_roi.GetAllocator());
     encoded_roi.AddMember("buffer_offset", rapidjson::Value(hailoexportzmq->buffer_offset), encoded_roi.GetAllocator());
 
@@ -203,13 +246,34 @@ gst_hailoexportzmq_transform_ip(GstBaseTransform *trans,
     // Copy is required since zmq::message_t would only wrap the data, so if the buffer is freed/overwritten
     // while the message is sending you will get garbage data or a segfault.
     std::memcpy(json_message.data(), json_buffer.GetString(), json_buffer.GetSize()); 
-#if (CPPZMQ_VERSION_MAJOR >= 4 && CPPZMQ_VERSION_MINOR >= 6 && CPPZMQ_VERSION_PATCH >= 0)
-    zmq::send_result_t result = hailoexportzmq->socket->send(json_message, zmq::send_flags(ZMQ_DONTWAIT));
-#else
-    zmq::detail::send_result_t result = hailoexportzmq->socket->send(json_message, zmq::send_flags(ZMQ_DONTWAIT));
-#endif
-    if (result != json_message.size())
-        GST_WARNING("hailoexportzmq failed to send buffer!");
+    gst_hailoexportzmq_send(hailoexportzmq, json_message);
+}
+
+static void
+gst_hailoexportzmq_send_binary(GstHailoExportZMQ *hailoexportzmq, HailoROIPtr hailo_roi, int64_t timenow)
+{
+    // Encode straight into a pooled buffer, the message owns the block until zmq is done with it
+    // and then returns it to the pool, so no copy is needed.
+    encode_binary::MessagePool::Block *block = hailoexportzmq->message_pool->acquire();
+    encode_binary::encode_hailo_roi(block->data, hailo_roi, timenow, hailoexportzmq->buffer_offset);
+    zmq::message_t binary_message(block->data.data(), block->data.size(),
+                                  encode_binary::MessagePool::free_block, block);
+    gst_hailoexportzmq_send(hailoexportzmq, binary_message);
+}
+
+static GstFlowReturn
+gst_hailoexportzmq_transform_ip(GstBaseTransform *trans,
+                                 GstBuffer *buffer)
+{
+    GstHailoExportZMQ *hailoexportzmq = GST_HAILO_EXPORT_ZMQ(trans);
+
+    // Get the roi from the current buffer and encode it in the requested format
+    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
+    auto timenow = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    if (hailoexportzmq->format == GST_HAILO_EXPORT_ZMQ_FORMAT_BINARY)
+        gst_hailoexportzmq_send_binary(hailoexportzmq, hailo_roi, timenow);
+    else
+        gst_hailoexportzmq_send_json(hailoexportzmq, hailo_roi, timenow);
 
     hailoexportzmq->buffer_offset++;
     GST_DEBUG_OBJECT(hailoexportzmq, "transform_ip");
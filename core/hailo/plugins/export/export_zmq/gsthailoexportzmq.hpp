@@ -7,6 +7,7 @@
 #include <gst/base/gstbasetransform.h>
 #include "hailo_objects.hpp"
 #include "export/encode_json.hpp"
+#include "export/encode_binary.hpp"
 #include <cstdio>
 #include <zmq.hpp>
 
@@ -18,6 +19,12 @@ G_BEGIN_DECLS
 #define GST_IS_HAILO_EXPORT_ZMQ(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_HAILO_EXPORT_ZMQ))
 #define GST_IS_HAILO_EXPORT_ZMQ_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_HAILO_EXPORT_ZMQ))
 
+typedef enum
+{
+    GST_HAILO_EXPORT_ZMQ_FORMAT_JSON,
+    GST_HAILO_EXPORT_ZMQ_FORMAT_BINARY,
+} GstHailoExportZMQFormat;
+
 typedef struct _GstHailoExportZMQ GstHailoExportZMQ;
 typedef struct _GstHailoExportZMQClass GstHailoExportZMQClass;
 
@@ -26,6 +33,8 @@ struct _GstHailoExportZMQ
     GstBaseTransform base_hailoexportzmq;
     gchar *address;
     uint buffer_offset;
+    GstHailoExportZMQFormat format;
+    encode_binary::MessagePool *message_pool; // Buffers of binary messages, zmq returns them once sent
     zmq::context_t *context;
     zmq::socket_t *socket;
 };
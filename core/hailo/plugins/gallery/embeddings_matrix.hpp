@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "hailo_simd.hpp"
+
+/**
+ * @brief Contiguous storage and exact search of the gallery embeddings.
+ *        All embeddings of all global ids live in a single row-major float matrix,
+ *        every row is owned by one global id (by index, 0 based).
+ *        Each global id keeps the rows of its last queue_size embeddings, newest first.
+ *        When the queue is full the oldest row is overwritten in place, so the matrix
+ *        only grows when a global id is still filling up its queue.
+ */
+class EmbeddingsMatrix
+{
+private:
+    static constexpr int FREE_ROW = -1;
+
+    std::size_t m_dim;
+    std::size_t m_queue_size;
+    std::vector<float> m_data;
+    std::vector<int> m_row_owner;
+    std::vector<std::deque<std::size_t>> m_id_rows;
+    std::vector<std::size_t> m_free_rows;
+
+    // Scratch buffers, reused between searches
+    std::vector<float> m_row_scores;
+    std::vector<float> m_id_scores;
+    std::vector<std::size_t> m_order;
+
+    std::size_t allocate_row()
+    {
+        if (!m_free_rows.empty())
+        {
+            std::size_t row = m_free_rows.back();
+            m_free_rows.pop_back();
+            return row;
+        }
+        m_data.resize(m_data.size() + m_dim);
+        m_row_owner.push_back(FREE_ROW);
+        return m_row_owner.size() - 1;
+    }
+
+    void release_row(std::size_t row)
+    {
+        m_row_owner[row] = FREE_ROW;
+        m_free_rows.push_back(row);
+    }
+
+public:
+    EmbeddingsMatrix(std::size_t queue_size = 100) : m_dim(0), m_queue_size(queue_size){};
+
+    std::size_t dim() const { return m_dim; }
+    std::size_t num_ids() const { return m_id_rows.size(); }
+    std::size_t num_rows() const { return m_row_owner.size() - m_free_rows.size(); }
+    bool empty() const { return m_id_rows.empty(); }
+    const float *row(std::size_t row) const { return m_data.data() + row * m_dim; }
+    int row_owner(std::size_t row) const { return m_row_owner[row]; }
+    const std::deque<std::size_t> &id_rows(std::size_t id_index) const { return m_id_rows[id_index]; }
+
+    void set_queue_size(std::size_t queue_size) { m_queue_size = queue_size; }
+
+    /**
+     * @brief Adds an empty global id.
+     *
+     * @return std::size_t The index of the new global id.
+     */
+    std::size_t add_id()
+    {
+        m_id_rows.emplace_back();
+        return m_id_rows.size() - 1;
+    }
+
+    /**
+     * @brief Adds an embedding to the queue of a global id, dropping its oldest
+     *        embeddings if the queue is full.
+     *
+     * @return std::size_t The row the embedding was stored at.
+     */
+    std::size_t add_embedding(std::size_t id_index, const float *embedding, std::size_t size)
+    {
+        if (m_dim == 0)
+            m_dim = size;
+        if (size != m_dim)
+            throw std::runtime_error("Arrays are with different shape");
+
+        auto &rows = m_id_rows[id_index];
+        std::size_t row;
+        if (!rows.empty() && rows.size() >= m_queue_size)
+        {
+            // Reuse the oldest row of this id
+            while (rows.size() > std::max<std::size_t>(m_queue_size, 1))
+            {
+                release_row(rows.back());
+                rows.pop_back();
+            }
+            row = rows.back();
+            rows.pop_back();
+        }
+        else
+        {
+            row = allocate_row();
+        }
+        std::memcpy(m_data.data() + row * m_dim, embedding, m_dim * sizeof(float));
+        m_row_owner[row] = static_cast<int>(id_index);
+        rows.push_front(row);
+        return row;
+    }
+
+    /**
+     * @brief Computes the distance of an embedding from every global id.
+     *        The distance of a global id is 1 - max(0, max dot product over its embeddings).
+     *
+     * @return const std::vector<float>& Distance per global id index, valid until the next call.
+     */
+    const std::vector<float> &distances(const float *embedding, std::size_t size)
+    {
+        if (m_dim != 0 && size != m_dim)
+            throw std::runtime_error("Arrays are with different shape");
+
+        std::size_t rows = m_row_owner.size();
+        m_row_scores.resize(rows);
+        if (rows > 0)
+            hailo_simd::gemv(m_data.data(), rows, m_dim, embedding, m_row_scores.data());
+
+        m_id_scores.assign(m_id_rows.size(), 0.0f);
+        for (std::size_t r = 0; r < rows; r++)
+        {
+            int owner = m_row_owner[r];
+            if (owner != FREE_ROW && m_row_scores[r] > m_id_scores[owner])
+                m_id_scores[owner] = m_row_scores[r];
+        }
+        for (auto &score : m_id_scores)
+            score = 1.0f - score;
+        return m_id_scores;
+    }
+
+    /**
+     * @brief Finds the k closest global ids to an embedding.
+     *
+     * @return std::vector<std::pair<std::size_t, float>> Pairs of (global id index, distance),
+     *         sorted by ascending distance. Ties are broken by the lower index.
+     */
+    std::vector<std::pair<std::size_t, float>> top_k(const float *embedding, std::size_t size, std::size_t k)
+    {
+        const std::vector<float> &dists = distances(embedding, size);
+        k = std::min(k, dists.size());
+        std::vector<std::pair<std::size_t, float>> results;
+        results.reserve(k);
+        if (k == 1)
+        {
+            auto min_it = std::min_element(dists.begin(), dists.end());
+            results.emplace_back(std::distance(dists.begin(), min_it), *min_it);
+            return results;
+        }
+
+        m_order.resize(dists.size());
+        std::iota(m_order.begin(), m_order.end(), 0);
+        std::partial_sort(m_order.begin(), m_order.begin() + k, m_order.end(),
+                          [&dists](std::size_t a, std::size_t b)
+                          { return dists[a] < dists[b] || (dists[a] == dists[b] && a < b); });
+        for (std::size_t i = 0; i < k; i++)
+            results.emplace_back(m_order[i], dists[m_order[i]]);
+        return results;
+    }
+};
@@ -10,9 +10,11 @@
 #include <filesystem>
 #include "xtensor/xarray.hpp"
 #include "xtensor/xadapt.hpp"
-#include "xtensor/xsort.hpp"
 #include "xtensor/xio.hpp"
 #include "hailo_objects.hpp"
+#include "embeddings_matrix.hpp"
+#include "ivf_index.hpp"
+#include "gallery_file.hpp"
 #include "export/encode_json.hpp"
 #include "import/decode_json.hpp"
 
@@ -24,35 +26,28 @@
 #include "rapidjson/writer.h"
 #include "rapidjson/prettywriter.h"
 
-static xt::xarray<float> gallery_get_xtensor(HailoMatrixPtr matrix)
+typedef enum
 {
-    // Adapt a HailoTensorPtr to an xarray (quantized)
-    xt::xarray<float> xtensor = xt::adapt(matrix->get_data().data(), matrix->size(), xt::no_ownership(), matrix->shape());
-    return xt::squeeze(xtensor);
-}
+    GALLERY_INDEX_EXACT,
+    GALLERY_INDEX_IVF,
+} gallery_index_type_t;
 
-static float gallery_one_dim_dot_product(xt::xarray<float> array1, xt::xarray<float> array2)
+typedef enum
 {
-    if (array1.dimension() > 1 || array2.dimension() > 1)
-    {
-        throw std::runtime_error("One of the arrays has more than 1 dimension");
-    }
-    if (array1.shape(0) != array2.shape(0))
-    {
-        throw std::runtime_error("Arrays are with different shape");
-    }
-    return xt::sum(array1 * array2)[0];
-}
+    GALLERY_FILE_JSON,
+    GALLERY_FILE_BINARY,
+} gallery_file_format_t;
 
 class Gallery
 {
 private:
-    // Each embedding is represented by HailoMatrixPtr
-    // Each global_id has a vector of embeddings (I.e. vector of HailoMatrixPtr)
-    // of all the embeddings related to this ID.
-    // For the whole gallery there is a vector of global id's (i.e. vector of vectors of HailoMatrixPtr)
-    // where the global ID is represented by the outer vector's index.
-    std::vector<std::vector<HailoMatrixPtr>> m_embeddings;
+    // Each embedding is a row in one contiguous float matrix.
+    // Each global_id owns the rows of its last m_queue_size embeddings,
+    // where the global ID is represented by the owner index + 1.
+    EmbeddingsMatrix m_embeddings;
+    // Optional approximate index over the rows of m_embeddings
+    IvfIndex m_index;
+    gallery_index_type_t m_index_type;
     std::map<int, int> tracking_id_to_global_id;
     std::vector<std::string> m_embedding_names;
     float m_similarity_thr;
@@ -61,55 +56,66 @@ private:
     bool m_save_new_embeddings;
     char *m_json_file_path;
     bool m_load_local_embeddings;
+    gallery_file_format_t m_file_format;
+    // Background appender of the binary gallery file, shared so the Gallery stays copyable
+    std::shared_ptr<gallery_file::GalleryFileWriter> m_file_writer;
 
 public:
-    Gallery(float similarity_thr = 0.15, uint queue_size = 100) : m_similarity_thr(similarity_thr), m_queue_size(queue_size),
+    Gallery(float similarity_thr = 0.15, uint queue_size = 100) : m_embeddings(queue_size), m_index_type(GALLERY_INDEX_EXACT), m_similarity_thr(similarity_thr), m_queue_size(queue_size),
                                                                   m_json_file(nullptr), m_save_new_embeddings(false),
-                                                                  m_json_file_path(nullptr), m_load_local_embeddings(false){};
-
-    static float get_distance(std::vector<HailoMatrixPtr> embeddings_queue, HailoMatrixPtr matrix)
-    {
-        xt::xarray<float> new_embedding = gallery_get_xtensor(matrix);
-        float max_thr = 0.0f;
-        float thr;
-        for (HailoMatrixPtr embedding_mat : embeddings_queue)
-        {
-            xt::xarray<float> embedding = gallery_get_xtensor(embedding_mat);
-            thr = gallery_one_dim_dot_product(embedding, new_embedding);
-            max_thr = thr > max_thr ? thr : max_thr;
-        }
-        return 1.0f - max_thr;
-    }
+                                                                  m_json_file_path(nullptr), m_load_local_embeddings(false),
+                                                                  m_file_format(GALLERY_FILE_JSON){};
 
     xt::xarray<float> get_embeddings_distances(HailoMatrixPtr matrix)
     {
-        std::vector<float> distances;
-        for (auto embeddings_queue : m_embeddings)
-        {
-            distances.push_back(get_distance(embeddings_queue, matrix));
-        }
-        return xt::adapt(distances);
+        return xt::adapt(m_embeddings.distances(matrix->get_data().data(), matrix->size()));
     }
 
     void init_local_gallery_file(const char *file_path)
     {
-        if (!std::filesystem::exists(file_path))
+        if (this->m_file_format == GALLERY_FILE_BINARY)
         {
-            this->m_json_file = fopen(file_path, "w");
-            fputs("[]", this->m_json_file);
-            fclose(this->m_json_file);
-            this->m_json_file = nullptr;
+            this->m_file_writer = std::make_shared<gallery_file::GalleryFileWriter>(file_path);
+        }
+        else
+        {
+            gallery_file::init_json_gallery(file_path);
         }
 
         this->m_json_file_path = strdup(file_path);
         this->m_save_new_embeddings = true;
     }
 
+    void close_local_gallery_file()
+    {
+        // Joins the background writer, flushing any pending records
+        this->m_file_writer.reset();
+    }
+
+    void load_local_gallery_from_binary(const char *file_path)
+    {
+        gallery_file::MappedGalleryFile gallery(file_path);
+        this->m_json_file_path = strdup(file_path);
+        this->m_load_local_embeddings = true;
+        for (auto &record : gallery.records())
+        {
+            this->m_embedding_names.push_back(record.name);
+            uint global_id = create_new_global_id();
+            add_embedding(global_id, record.data, record.size());
+        }
+    }
+
     void load_local_gallery_from_json(const char *file_path)
     {
         if (!std::filesystem::exists(file_path))
             throw std::runtime_error("Gallery JSON file does not exist");
 
+        if (gallery_file::is_binary_gallery(file_path))
+        {
+            load_local_gallery_from_binary(file_path);
+            return;
+        }
+
         this->m_json_file = fopen(file_path, "r");
         if (this->m_json_file == nullptr)
             throw std::runtime_error("Gallery JSON file is not valid");
@@ -137,14 +143,16 @@ public:
         this->m_json_file = nullptr;
     }
 
+    void add_embedding(uint global_id, const float *data, std::size_t size)
+    {
+        std::size_t row = m_embeddings.add_embedding(global_id - 1, data, size);
+        if (m_index_type == GALLERY_INDEX_IVF)
+            m_index.update_row(m_embeddings, row);
+    }
+
     void add_embedding(uint global_id, HailoMatrixPtr matrix)
     {
-        global_id--;
-        if (m_embeddings[global_id].size() >= m_queue_size)
-        {
-            m_embeddings[global_id].pop_back();
-        }
-        m_embeddings[global_id].insert(m_embeddings[global_id].begin(), matrix);
+        add_embedding(global_id, matrix->get_data().data(), matrix->size());
     }
 
     void write_to_json_file(rapidjson::Document document)
@@ -180,23 +188,38 @@ public:
         if (this->m_save_new_embeddings)
         {
             std::string name = "Unknown" + std::to_string(global_id);
-            write_to_json_file(encode_json::encode_hailo_face_recognition_result(matrix, name.c_str()));
+            if (this->m_file_writer)
+                this->m_file_writer->push(name, matrix);
+            else
+                write_to_json_file(encode_json::encode_hailo_face_recognition_result(matrix, name.c_str()));
         }
     }
 
     uint create_new_global_id()
     {
-        std::vector<HailoMatrixPtr> queue;
-        m_embeddings.push_back(queue);
-        uint global_id = m_embeddings.size();
+        uint global_id = m_embeddings.add_id() + 1;
         return global_id;
     }
 
+    std::vector<std::pair<std::size_t, float>> search(HailoMatrixPtr matrix, uint k)
+    {
+        if (m_index_type == GALLERY_INDEX_IVF)
+            return m_index.top_k(m_embeddings, matrix->get_data().data(), matrix->size(), k);
+        return m_embeddings.top_k(matrix->get_data().data(), matrix->size(), k);
+    }
+
     std::pair<uint, float> get_closest_global_id(HailoMatrixPtr matrix)
     {
-        auto distances = get_embeddings_distances(matrix);
-        auto global_id = xt::argpartition(distances, 1, xt::xnone())[0];
-        return std::pair<uint, float>(global_id + 1, distances[global_id]);
+        auto closest = search(matrix, 1)[0];
+        return std::pair<uint, float>(closest.first + 1, closest.second);
+    }
+
+    std::vector<std::pair<uint, float>> get_closest_global_ids(HailoMatrixPtr matrix, uint k)
+    {
+        std::vector<std::pair<uint, float>> closest_ids;
+        for (auto &closest : search(matrix, k))
+            closest_ids.emplace_back(closest.first + 1, closest.second);
+        return closest_ids;
     }
 
     HailoMatrixPtr get_embedding_matrix(HailoDetectionPtr detection)
@@ -224,7 +247,7 @@ public:
             auto existing_recognitions = hailo_common::get_hailo_classifications(detection, classification_type);
             if (existing_recognitions.size() == 0 ||  existing_recognitions[0]->get_classification_type() != classification_type)
             {
-                detection->add_object(std::make_shared<HailoClassification>(classification_type, this->m_embedding_names[global_id - 1]));
+                detection->add_object(detection->make_object<HailoClassification>(classification_type, this->m_embedding_names[global_id - 1]));
             }
         }
     }
@@ -241,7 +264,7 @@ public:
         // Add global id to detection.
         auto global_ids = hailo_common::get_hailo_global_id(detection);
         if (global_ids.size() == 0)
-            detection->add_object(std::make_shared<HailoUniqueID>(global_id, GLOBAL_ID));
+            detection->add_object(detection->make_object<HailoUniqueID>(global_id, GLOBAL_ID));
     }
 
     void new_embedding_to_global_id(HailoMatrixPtr new_embedding, HailoDetectionPtr detection, const int track_id)
@@ -305,7 +328,29 @@ public:
         }
     };
     void set_similarity_threshold(float thr) { this->m_similarity_thr = thr; };
-    void set_queue_size(uint size) { m_queue_size = size; };
+    void set_queue_size(uint size)
+    {
+        m_queue_size = size;
+        m_embeddings.set_queue_size(size);
+    };
+    void set_index_type(gallery_index_type_t index_type)
+    {
+        if (index_type == GALLERY_INDEX_IVF && m_index_type != GALLERY_INDEX_IVF)
+            m_index.rebuild(m_embeddings);
+        m_index_type = index_type;
+    };
+    void set_index_nlist(uint nlist)
+    {
+        m_index.set_nlist(nlist);
+        if (m_index_type == GALLERY_INDEX_IVF)
+            m_index.rebuild(m_embeddings);
+    };
+    void set_index_nprobe(uint nprobe) { m_index.set_nprobe(nprobe); };
+    void set_file_format(gallery_file_format_t file_format) { m_file_format = file_format; };
     float get_similarity_threshold() { return m_similarity_thr; };
     uint get_queue_size() { return m_queue_size; };
+    gallery_index_type_t get_index_type() { return m_index_type; };
+    uint get_index_nlist() { return m_index.nlist(); };
+    uint get_index_nprobe() { return m_index.nprobe(); };
+    gallery_file_format_t get_file_format() { return m_file_format; };
 };
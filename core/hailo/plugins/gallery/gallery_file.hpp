@@ -0,0 +1,431 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "hailo_objects.hpp"
+#include "export/encode_json.hpp"
+#include "import/decode_json.hpp"
+
+#define RAPIDJSON_HAS_STDSTRING 1
+#include "rapidjson/document.h"
+#include "rapidjson/filereadstream.h"
+#include "rapidjson/filewritestream.h"
+#include "rapidjson/prettywriter.h"
+
+/**
+ * Binary gallery file layout (native endianness, little endian on all supported targets):
+ *
+ *   header:  char magic[4] = "HGLR" | uint32_t version
+ *   record:  uint32_t name_length | char name[name_length] |
+ *            uint32_t height | uint32_t width | uint32_t features |
+ *            float data[height * width * features]
+ *
+ * Each record is one embedding (one global id) and records are only ever appended,
+ * so saving a new identity never rewrites the existing file.
+ */
+namespace gallery_file
+{
+    static const char GALLERY_MAGIC[4] = {'H', 'G', 'L', 'R'};
+    static const uint32_t GALLERY_VERSION = 1;
+
+    struct GalleryRecord
+    {
+        std::string name;
+        uint32_t height;
+        uint32_t width;
+        uint32_t features;
+        const float *data;
+        std::size_t size() const { return (std::size_t)height * width * features; }
+    };
+
+    inline bool is_binary_gallery(const char *file_path)
+    {
+        char magic[sizeof(GALLERY_MAGIC)] = {0};
+        FILE *file = fopen(file_path, "rb");
+        if (file == nullptr)
+            return false;
+        std::size_t read = fread(magic, 1, sizeof(magic), file);
+        fclose(file);
+        return read == sizeof(magic) && memcmp(magic, GALLERY_MAGIC, sizeof(magic)) == 0;
+    }
+
+    /**
+     * @brief Whether a file holds a JSON gallery, i.e. a JSON array.
+     */
+    inline bool is_json_gallery(const char *file_path)
+    {
+        FILE *file = fopen(file_path, "rb");
+        if (file == nullptr)
+            return false;
+        int c;
+        do
+        {
+            c = fgetc(file);
+        } while (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+        fclose(file);
+        return c == '[';
+    }
+
+    inline void write_header(FILE *file)
+    {
+        fwrite(GALLERY_MAGIC, 1, sizeof(GALLERY_MAGIC), file);
+        fwrite(&GALLERY_VERSION, sizeof(GALLERY_VERSION), 1, file);
+    }
+
+    inline void write_record(FILE *file, const std::string &name, uint32_t height, uint32_t width,
+                             uint32_t features, const float *data)
+    {
+        uint32_t name_length = name.size();
+        uint32_t dims[3] = {height, width, features};
+        fwrite(&name_length, sizeof(name_length), 1, file);
+        fwrite(name.data(), 1, name_length, file);
+        fwrite(dims, sizeof(dims), 1, file);
+        fwrite(data, sizeof(float), (std::size_t)height * width * features, file);
+    }
+
+    /**
+     * @brief Read-only memory mapping of a binary gallery file.
+     *        Record data points directly into the mapping and is valid while the object lives.
+     */
+    class MappedGalleryFile
+    {
+    private:
+        void *m_map;
+        std::size_t m_size;
+
+    public:
+        MappedGalleryFile(const char *file_path) : m_map(MAP_FAILED), m_size(0)
+        {
+            int fd = open(file_path, O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Gallery file does not exist");
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) != 0)
+            {
+                close(fd);
+                throw std::runtime_error("Gallery file is not valid");
+            }
+            m_size = file_stat.st_size;
+            if (m_size > 0)
+                m_map = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+            if (m_map == MAP_FAILED)
+                throw std::runtime_error("Failed to map gallery file");
+            madvise(m_map, m_size, MADV_SEQUENTIAL);
+
+            if (m_size < sizeof(GALLERY_MAGIC) + sizeof(uint32_t) ||
+                memcmp(m_map, GALLERY_MAGIC, sizeof(GALLERY_MAGIC)) != 0)
+                throw std::runtime_error("Gallery file is not a binary gallery");
+            uint32_t version;
+            memcpy(&version, (const char *)m_map + sizeof(GALLERY_MAGIC), sizeof(version));
+            if (version != GALLERY_VERSION)
+                throw std::runtime_error("Unsupported binary gallery version");
+        }
+        ~MappedGalleryFile()
+        {
+            if (m_map != MAP_FAILED)
+                munmap(m_map, m_size);
+        }
+        MappedGalleryFile(const MappedGalleryFile &) = delete;
+        MappedGalleryFile &operator=(const MappedGalleryFile &) = delete;
+
+    private:
+        /**
+         * @brief Walks the complete records of the file, stopping at a truncated trailing record.
+         *
+         * @return std::size_t The offset right after the last complete record.
+         */
+        std::size_t parse(std::vector<GalleryRecord> *records) const
+        {
+            const char *ptr = (const char *)m_map + sizeof(GALLERY_MAGIC) + sizeof(uint32_t);
+            const char *end = (const char *)m_map + m_size;
+            const char *complete = ptr;
+            while (ptr + sizeof(uint32_t) <= end)
+            {
+                GalleryRecord record;
+                uint32_t name_length;
+                memcpy(&name_length, ptr, sizeof(name_length));
+                ptr += sizeof(name_length);
+                if (ptr + name_length + 3 * sizeof(uint32_t) > end)
+                    break;
+                record.name.assign(ptr, name_length);
+                ptr += name_length;
+                memcpy(&record.height, ptr, sizeof(uint32_t));
+                memcpy(&record.width, ptr + sizeof(uint32_t), sizeof(uint32_t));
+                memcpy(&record.features, ptr + 2 * sizeof(uint32_t), sizeof(uint32_t));
+                ptr += 3 * sizeof(uint32_t);
+                if (ptr + record.size() * sizeof(float) > end)
+                    break;
+                record.data = (const float *)ptr;
+                ptr += record.size() * sizeof(float);
+                complete = ptr;
+                if (records != nullptr)
+                    records->push_back(std::move(record));
+            }
+            return complete - (const char *)m_map;
+        }
+
+    public:
+        /**
+         * @brief Parses all the complete records of the file.
+         *        A truncated trailing record (e.g. a crash while appending) is ignored.
+         */
+        std::vector<GalleryRecord> records() const
+        {
+            std::vector<GalleryRecord> records;
+            parse(&records);
+            return records;
+        }
+
+        /**
+         * @brief Size of the file up to the end of the last complete record.
+         */
+        std::size_t complete_size() const { return parse(nullptr); }
+    };
+
+    /**
+     * @brief Whether a file is shorter than the header and holds only a prefix of it,
+     *        i.e. it was cut while the header was written.
+     */
+    inline bool is_partial_header(const char *file_path, std::size_t file_size)
+    {
+        char header[sizeof(GALLERY_MAGIC) + sizeof(GALLERY_VERSION)];
+        memcpy(header, GALLERY_MAGIC, sizeof(GALLERY_MAGIC));
+        memcpy(header + sizeof(GALLERY_MAGIC), &GALLERY_VERSION, sizeof(GALLERY_VERSION));
+        if (file_size >= sizeof(header))
+            return false;
+        char prefix[sizeof(header)];
+        FILE *file = fopen(file_path, "rb");
+        if (file == nullptr)
+            return false;
+        std::size_t read = fread(prefix, 1, file_size, file);
+        fclose(file);
+        return read == file_size && memcmp(prefix, header, file_size) == 0;
+    }
+
+    /**
+     * @brief Creates an empty binary gallery file if it does not exist yet (or is empty).
+     *        An existing file in another format is not appended to, since that would corrupt it.
+     *        A truncated trailing record (e.g. a crash while appending) is cut off,
+     *        so the records appended next start on a record boundary.
+     */
+    inline void init_binary_gallery(const char *file_path)
+    {
+        std::size_t file_size = std::filesystem::exists(file_path) ? std::filesystem::file_size(file_path) : 0;
+        if (file_size > 0 && !is_partial_header(file_path, file_size))
+        {
+            if (!is_binary_gallery(file_path))
+                throw std::runtime_error(std::string("Gallery file ") + file_path +
+                                         " is not a binary gallery, convert it with gallery_converter or save in JSON format");
+            std::size_t complete_size;
+            {
+                MappedGalleryFile gallery(file_path); // Checks the version
+                complete_size = gallery.complete_size();
+            }
+            if (complete_size < file_size && truncate(file_path, complete_size) != 0)
+                throw std::runtime_error(std::string("Failed to truncate the partial record of gallery file ") + file_path);
+            return;
+        }
+        FILE *file = fopen(file_path, "wb");
+        if (file == nullptr)
+            throw std::runtime_error("Failed to create gallery file");
+        write_header(file);
+        fclose(file);
+    }
+
+    /**
+     * @brief Creates an empty JSON gallery file if it does not exist yet (or is empty).
+     *        An existing file in another format is not appended to, since that would corrupt it.
+     */
+    inline void init_json_gallery(const char *file_path)
+    {
+        if (std::filesystem::exists(file_path) && std::filesystem::file_size(file_path) > 0)
+        {
+            if (!is_json_gallery(file_path))
+                throw std::runtime_error(std::string("Gallery file ") + file_path +
+                                         " is not a JSON gallery, convert it with gallery_converter or save in binary format");
+            return;
+        }
+        FILE *file = fopen(file_path, "w");
+        if (file == nullptr)
+            throw std::runtime_error("Failed to create gallery file");
+        fputs("[]", file);
+        fclose(file);
+    }
+
+    /**
+     * @brief Appends records to a binary gallery file from a background thread,
+     *        so the streaming thread only pays for copying the embedding.
+     */
+    class GalleryFileWriter
+    {
+    private:
+        struct PendingRecord
+        {
+            std::string name;
+            uint32_t height;
+            uint32_t width;
+            uint32_t features;
+            std::vector<float> data;
+        };
+
+        FILE *m_file;
+        std::deque<PendingRecord> m_queue;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_running;
+        std::thread m_thread;
+
+        void run()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while (true)
+            {
+                m_cv.wait(lock, [this]
+                          { return !m_queue.empty() || !m_running; });
+                if (m_queue.empty() && !m_running)
+                    break;
+                std::deque<PendingRecord> batch;
+                batch.swap(m_queue);
+                lock.unlock();
+                for (auto &record : batch)
+                    write_record(m_file, record.name, record.height, record.width, record.features, record.data.data());
+                fflush(m_file);
+                lock.lock();
+            }
+        }
+
+    public:
+        GalleryFileWriter(const char *file_path) : m_running(true)
+        {
+            init_binary_gallery(file_path);
+            m_file = fopen(file_path, "ab");
+            if (m_file == nullptr)
+                throw std::runtime_error("Failed to open gallery file");
+            m_thread = std::thread(&GalleryFileWriter::run, this);
+        }
+        ~GalleryFileWriter()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_running = false;
+            }
+            m_cv.notify_one();
+            m_thread.join();
+            fclose(m_file);
+        }
+        GalleryFileWriter(const GalleryFileWriter &) = delete;
+        GalleryFileWriter &operator=(const GalleryFileWriter &) = delete;
+
+        void push(const std::string &name, HailoMatrixPtr matrix)
+        {
+            PendingRecord record{name, matrix->height(), matrix->width(), matrix->features(), matrix->get_data()};
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_queue.push_back(std::move(record));
+            }
+            m_cv.notify_one();
+        }
+    };
+
+    /**
+     * @brief Converts a JSON gallery (as saved by hailogallery) to the binary format.
+     *        Every embedding becomes a record named after its entry.
+     *
+     * @return std::size_t Number of records written.
+     */
+    inline std::size_t json_to_binary(const char *json_path, const char *binary_path)
+    {
+        FILE *json_file = fopen(json_path, "r");
+        if (json_file == nullptr)
+            throw std::runtime_error("Gallery JSON file does not exist");
+        char read_buffer[65536];
+        rapidjson::FileReadStream stream(json_file, read_buffer, sizeof(read_buffer));
+        rapidjson::Document document;
+        document.ParseStream(stream);
+        fclose(json_file);
+        if (document.HasParseError() || !document.IsArray())
+            throw std::runtime_error("Gallery JSON file is not valid");
+
+        FILE *binary_file = fopen(binary_path, "wb");
+        if (binary_file == nullptr)
+            throw std::runtime_error("Failed to create gallery file");
+        write_header(binary_file);
+        std::size_t count = 0;
+        for (rapidjson::Value &entry : document.GetArray())
+        {
+            if (!entry.HasMember("FaceRecognition"))
+                continue;
+            rapidjson::Value &recognition = entry["FaceRecognition"];
+            std::string name = recognition["Name"].GetString();
+            for (rapidjson::Value &embedding : recognition["Embeddings"].GetArray())
+            {
+                rapidjson::Value &matrix = embedding["HailoMatrix"];
+                std::vector<float> data;
+                for (rapidjson::Value &value : matrix["data"].GetArray())
+                    data.push_back(value.GetFloat());
+                write_record(binary_file, name, matrix["height"].GetUint(), matrix["width"].GetUint(),
+                             matrix["features"].GetUint(), data.data());
+                count++;
+            }
+        }
+        fclose(binary_file);
+        return count;
+    }
+
+    /**
+     * @brief Converts a binary gallery to the JSON format loaded by hailogallery.
+     *
+     * @return std::size_t Number of records written.
+     */
+    inline std::size_t binary_to_json(const char *binary_path, const char *json_path)
+    {
+        MappedGalleryFile gallery(binary_path);
+        rapidjson::Document document;
+        document.SetArray();
+        rapidjson::Document::AllocatorType &allocator = document.GetAllocator();
+        auto records = gallery.records();
+        for (auto &record : records)
+        {
+            auto matrix = std::make_shared<HailoMatrix>(std::vector<float>(record.data, record.data + record.size()),
+                                                        record.height, record.width, record.features);
+            rapidjson::Value embeddings(rapidjson::kArrayType);
+            rapidjson::Value embedding(rapidjson::kObjectType);
+            encode_json::encode_matrix(embedding, allocator, matrix);
+            embeddings.PushBack(embedding, allocator);
+
+            rapidjson::Value recognition(rapidjson::kObjectType);
+            recognition.AddMember("Name", rapidjson::Value(record.name, allocator), allocator);
+            recognition.AddMember("Embeddings", embeddings, allocator);
+            rapidjson::Value entry(rapidjson::kObjectType);
+            entry.AddMember("FaceRecognition", recognition, allocator);
+            document.PushBack(entry, allocator);
+        }
+
+        FILE *json_file = fopen(json_path, "w");
+        if (json_file == nullptr)
+            throw std::runtime_error("Failed to create gallery JSON file");
+        char write_buffer[65536];
+        rapidjson::FileWriteStream write_stream(json_file, write_buffer, sizeof(write_buffer));
+        rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(write_stream);
+        document.Accept(writer);
+        fclose(json_file);
+        return records.size();
+    }
+} // namespace gallery_file
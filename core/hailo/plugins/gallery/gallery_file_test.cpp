@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of the binary gallery file: records appended after a crash that left a truncated record
+  (or a truncated header) must still be loaded back.
+*/
+
+// General cpp includes
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+// Tappas includes
+#include "hailo_objects.hpp"
+#include "gallery/gallery_file.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+static const uint32_t FEATURES = 16;
+
+static void append(const std::string &path, int first, int count)
+{
+    gallery_file::GalleryFileWriter writer(path.c_str());
+    for (int i = first; i < first + count; i++)
+        writer.push("id" + std::to_string(i), std::make_shared<HailoMatrix>(std::vector<float>(FEATURES, (float)i), 1, 1, FEATURES));
+}
+
+static void check_records(const std::string &path, int count)
+{
+    gallery_file::MappedGalleryFile gallery(path.c_str());
+    auto records = gallery.records();
+    CHECK((int)records.size() == count);
+    for (int i = 0; i < (int)records.size(); i++)
+    {
+        CHECK(records[i].name == "id" + std::to_string(i));
+        CHECK(records[i].size() == FEATURES);
+        std::vector<float> data(FEATURES);
+        memcpy(data.data(), records[i].data, FEATURES * sizeof(float)); // Records are not float aligned
+        CHECK(data[0] == (float)i && data[FEATURES - 1] == (float)i);
+    }
+}
+
+static void check_no_partial_record(const std::string &path)
+{
+    gallery_file::MappedGalleryFile gallery(path.c_str());
+    CHECK(gallery.complete_size() == std::filesystem::file_size(path));
+}
+
+static void test_truncated_record(const std::string &path)
+{
+    std::filesystem::remove(path);
+    append(path, 0, 3);
+    std::size_t size = std::filesystem::file_size(path);
+    // Cut the last record in the middle of its data, then in the middle of its dimensions
+    CHECK(truncate(path.c_str(), size - 5) == 0);
+    check_records(path, 2);
+    append(path, 2, 2);
+    check_records(path, 4);
+    check_no_partial_record(path);
+
+    size = std::filesystem::file_size(path);
+    CHECK(truncate(path.c_str(), size - FEATURES * sizeof(float) - 6) == 0);
+    append(path, 3, 1);
+    check_records(path, 4);
+    check_no_partial_record(path);
+}
+
+static void test_truncated_header(const std::string &path)
+{
+    std::filesystem::remove(path);
+    append(path, 0, 0);
+    CHECK(truncate(path.c_str(), 3) == 0);
+    append(path, 0, 2);
+    check_records(path, 2);
+    check_no_partial_record(path);
+}
+
+int main()
+{
+    std::string path = (std::filesystem::temp_directory_path() / ("gallery_file_test_" + std::to_string(getpid()) + ".bin")).string();
+    test_truncated_record(path);
+    test_truncated_header(path);
+    std::filesystem::remove(path);
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -32,6 +32,10 @@ enum
     PROP_LOAD_GALLERY,
     PROP_SAVE_GALLERY,
     PROP_LOCAL_GALLERY_FILE_PATH,
+    PROP_INDEX_TYPE,
+    PROP_INDEX_NLIST,
+    PROP_INDEX_NPROBE,
+    PROP_GALLERY_FILE_FORMAT,
 };
 
 //******************************************************************
@@ -53,6 +57,42 @@ G_DEFINE_TYPE_WITH_CODE(GstHailoGallery, gst_hailo_gallery, GST_TYPE_BASE_TRANSF
                         GST_DEBUG_CATEGORY_INIT(gst_hailo_gallery_debug_category, "hailogallery", 0,
                                                 "debug category for hailogallery element"));
 
+#define GST_TYPE_HAILO_GALLERY_INDEX_TYPE (gst_hailo_gallery_index_type_get_type())
+static GType
+gst_hailo_gallery_index_type_get_type(void)
+{
+    static GType gallery_index_type = 0;
+    static const GEnumValue hailogallery_index_types[] = {
+        {GALLERY_INDEX_EXACT, "Exact search over all embeddings", "exact"},
+        {GALLERY_INDEX_IVF, "Approximate inverted file index", "ivf"},
+        {0, NULL, NULL},
+    };
+    if (!gallery_index_type)
+    {
+        gallery_index_type =
+            g_enum_register_static("GstHailoGalleryIndexType", hailogallery_index_types);
+    }
+    return gallery_index_type;
+}
+
+#define GST_TYPE_HAILO_GALLERY_FILE_FORMAT (gst_hailo_gallery_file_format_get_type())
+static GType
+gst_hailo_gallery_file_format_get_type(void)
+{
+    static GType gallery_file_format = 0;
+    static const GEnumValue hailogallery_file_formats[] = {
+        {GALLERY_FILE_JSON, "JSON gallery file", "json"},
+        {GALLERY_FILE_BINARY, "Binary gallery file, memory mapped on load and appended in the background", "binary"},
+        {0, NULL, NULL},
+    };
+    if (!gallery_file_format)
+    {
+        gallery_file_format =
+            g_enum_register_static("GstHailoGalleryFileFormat", hailogallery_file_formats);
+    }
+    return gallery_file_format;
+}
+
 /* Class initialization */
 static void
 gst_hailo_gallery_class_init(GstHailoGalleryClass *klass)
@@ -112,6 +152,30 @@ gst_hailo_gallery_class_init(GstHailoGalleryClass *klass)
                                                          FALSE,
                                                          (GParamFlags)(GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 
+    g_object_class_install_property(gobject_class, PROP_INDEX_TYPE,
+                                    g_param_spec_enum("index-type", "Index type",
+                                                      "Search index of the gallery. ivf is an approximate index for large galleries.",
+                                                      GST_TYPE_HAILO_GALLERY_INDEX_TYPE, (gint)GALLERY_INDEX_EXACT,
+                                                      (GParamFlags)(GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(gobject_class, PROP_INDEX_NLIST,
+                                    g_param_spec_uint("index-nlist", "Index lists",
+                                                      "Number of lists (centroids) of the ivf index",
+                                                      1, G_MAXINT, 256,
+                                                      (GParamFlags)(GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(gobject_class, PROP_INDEX_NPROBE,
+                                    g_param_spec_uint("index-nprobe", "Index probes",
+                                                      "Number of ivf lists searched per lookup. Higher is more accurate and slower.",
+                                                      1, G_MAXINT, 8,
+                                                      (GParamFlags)(GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(gobject_class, PROP_GALLERY_FILE_FORMAT,
+                                    g_param_spec_enum("gallery-file-format", "Gallery file format",
+                                                      "Format of the saved gallery file. Loading detects the format of the file.",
+                                                      GST_TYPE_HAILO_GALLERY_FILE_FORMAT, (gint)GALLERY_FILE_JSON,
+                                                      (GParamFlags)(GST_PARAM_MUTABLE_READY | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
     // Set virtual functions
     gobject_class->dispose = gst_hailo_gallery_dispose;
     base_transform_class->transform_ip = GST_DEBUG_FUNCPTR(gst_hailo_gallery_transform_ip);
@@ -140,14 +204,22 @@ gst_hailo_gallery_start(GstBaseTransform *trans)
         return FALSE;
     }
 
-    if (hailogallery->load_gallery)
+    try
     {
-        GST_DEBUG_OBJECT(hailogallery, "Loading gallery from file");
-        hailogallery->gallery.load_local_gallery_from_json(hailogallery->local_gallery_file_path);
-    } else if (hailogallery->save_gallery)
+        if (hailogallery->load_gallery)
+        {
+            GST_DEBUG_OBJECT(hailogallery, "Loading gallery from file");
+            hailogallery->gallery.load_local_gallery_from_json(hailogallery->local_gallery_file_path);
+        } else if (hailogallery->save_gallery)
+        {
+            GST_DEBUG_OBJECT(hailogallery, "Saving gallery to file");
+            hailogallery->gallery.init_local_gallery_file(hailogallery->local_gallery_file_path);
+        }
+    }
+    catch (const std::exception &e)
     {
-        GST_DEBUG_OBJECT(hailogallery, "Saving gallery to file");
-        hailogallery->gallery.init_local_gallery_file(hailogallery->local_gallery_file_path);
+        GST_ELEMENT_ERROR(hailogallery, RESOURCE, SETTINGS, ("%s", e.what()), (NULL));
+        return FALSE;
     }
 
     return TRUE;
@@ -184,6 +256,18 @@ void gst_hailo_gallery_set_property(GObject *object, guint property_id,
     case PROP_SAVE_GALLERY:
         hailogallery->save_gallery = g_value_get_boolean(value);
         break;
+    case PROP_INDEX_TYPE:
+        hailogallery->gallery.set_index_type((gallery_index_type_t)g_value_get_enum(value));
+        break;
+    case PROP_INDEX_NLIST:
+        hailogallery->gallery.set_index_nlist(g_value_get_uint(value));
+        break;
+    case PROP_INDEX_NPROBE:
+        hailogallery->gallery.set_index_nprobe(g_value_get_uint(value));
+        break;
+    case PROP_GALLERY_FILE_FORMAT:
+        hailogallery->gallery.set_file_format((gallery_file_format_t)g_value_get_enum(value));
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -218,6 +302,18 @@ void gst_hailo_gallery_get_property(GObject *object, guint property_id,
     case PROP_SAVE_GALLERY:
         g_value_set_boolean(value, hailogallery->save_gallery);
         break;
+    case PROP_INDEX_TYPE:
+        g_value_set_enum(value, hailogallery->gallery.get_index_type());
+        break;
+    case PROP_INDEX_NLIST:
+        g_value_set_uint(value, hailogallery->gallery.get_index_nlist());
+        break;
+    case PROP_INDEX_NPROBE:
+        g_value_set_uint(value, hailogallery->gallery.get_index_nprobe());
+        break;
+    case PROP_GALLERY_FILE_FORMAT:
+        g_value_set_enum(value, hailogallery->gallery.get_file_format());
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -234,6 +330,7 @@ void gst_hailo_gallery_dispose(GObject *object)
     GstHailoGallery *hailogallery = GST_HAILO_GALLERY(object);
 
     GST_DEBUG_OBJECT(hailogallery, "dispose");
+    hailogallery->gallery.close_local_gallery_file();
 
     G_OBJECT_CLASS(gst_hailo_gallery_parent_class)->dispose(object);
 }
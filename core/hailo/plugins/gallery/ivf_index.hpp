@@ -0,0 +1,209 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include "hailo_simd.hpp"
+#include "embeddings_matrix.hpp"
+
+/**
+ * @brief Inverted file (IVF) approximate index over the rows of an EmbeddingsMatrix.
+ *        The index is built incrementally: the first nlist embeddings seed the centroids,
+ *        every following embedding is assigned to the list of its most similar centroid
+ *        which is then moved towards it (online k-means).
+ *        A search scores only the rows of the nprobe lists closest to the query,
+ *        so nprobe is the recall/latency knob (nprobe == nlist is an exact search).
+ *        Until all the centroids are seeded the search falls back to the exact scan.
+ */
+class IvfIndex
+{
+private:
+    static constexpr std::size_t NO_LIST = std::numeric_limits<std::size_t>::max();
+
+    std::size_t m_nlist;
+    std::atomic<std::size_t> m_nprobe; // Set from the property thread while searching
+    std::size_t m_dim;
+    std::vector<float> m_centroids;
+    std::vector<std::size_t> m_centroid_counts;
+    std::vector<std::vector<std::size_t>> m_lists;
+    std::vector<std::size_t> m_row_list;
+    std::vector<std::size_t> m_row_pos;
+
+    // Scratch buffers, reused between searches
+    std::vector<float> m_centroid_scores;
+    std::vector<std::size_t> m_probe_order;
+    std::vector<float> m_id_scores;
+    std::vector<std::size_t> m_touched_ids;
+
+    void remove_from_list(std::size_t row)
+    {
+        std::size_t list = m_row_list[row];
+        if (list == NO_LIST)
+            return;
+        auto &rows = m_lists[list];
+        std::size_t pos = m_row_pos[row];
+        rows[pos] = rows.back();
+        m_row_pos[rows[pos]] = pos;
+        rows.pop_back();
+        m_row_list[row] = NO_LIST;
+    }
+
+    void insert_to_list(std::size_t row, std::size_t list)
+    {
+        m_row_list[row] = list;
+        m_row_pos[row] = m_lists[list].size();
+        m_lists[list].push_back(row);
+    }
+
+    std::size_t closest_centroid(const float *embedding)
+    {
+        std::size_t num_centroids = m_centroid_counts.size();
+        m_centroid_scores.resize(num_centroids);
+        hailo_simd::gemv(m_centroids.data(), num_centroids, m_dim, embedding, m_centroid_scores.data());
+        return std::distance(m_centroid_scores.begin(),
+                             std::max_element(m_centroid_scores.begin(), m_centroid_scores.end()));
+    }
+
+public:
+    IvfIndex(std::size_t nlist = 256, std::size_t nprobe = 8) : m_nlist(std::max<std::size_t>(nlist, 1)),
+                                                                  m_nprobe(std::max<std::size_t>(nprobe, 1)),
+                                                                  m_dim(0){};
+
+    bool trained() const { return m_centroid_counts.size() == m_nlist; }
+    std::size_t nlist() const { return m_nlist; }
+    std::size_t nprobe() const { return m_nprobe.load(std::memory_order_relaxed); }
+    void set_nprobe(std::size_t nprobe) { m_nprobe.store(std::max<std::size_t>(nprobe, 1), std::memory_order_relaxed); }
+
+    void clear()
+    {
+        m_dim = 0;
+        m_centroids.clear();
+        m_centroid_counts.clear();
+        m_lists.clear();
+        m_row_list.clear();
+        m_row_pos.clear();
+    }
+
+    /**
+     * @brief Changes the number of lists, the index has to be rebuilt afterwards.
+     */
+    void set_nlist(std::size_t nlist)
+    {
+        m_nlist = std::max<std::size_t>(nlist, 1);
+        clear();
+    }
+
+    /**
+     * @brief Indexes (or re-indexes) a row of the matrix after it was written.
+     */
+    void update_row(const EmbeddingsMatrix &matrix, std::size_t row)
+    {
+        const float *embedding = matrix.row(row);
+        if (m_dim == 0)
+            m_dim = matrix.dim();
+        if (row >= m_row_list.size())
+        {
+            m_row_list.resize(row + 1, NO_LIST);
+            m_row_pos.resize(row + 1, 0);
+        }
+        remove_from_list(row);
+
+        std::size_t list;
+        if (!trained())
+        {
+            // Seed a new centroid with this embedding
+            m_centroids.insert(m_centroids.end(), embedding, embedding + m_dim);
+            m_centroid_counts.push_back(1);
+            m_lists.emplace_back();
+            list = m_lists.size() - 1;
+        }
+        else
+        {
+            list = closest_centroid(embedding);
+            std::size_t count = ++m_centroid_counts[list];
+            float *centroid = m_centroids.data() + list * m_dim;
+            for (std::size_t i = 0; i < m_dim; i++)
+                centroid[i] += (embedding[i] - centroid[i]) / count;
+        }
+        insert_to_list(row, list);
+    }
+
+    /**
+     * @brief Rebuilds the index from all the rows currently held by the matrix.
+     */
+    void rebuild(const EmbeddingsMatrix &matrix)
+    {
+        clear();
+        for (std::size_t id = 0; id < matrix.num_ids(); id++)
+            for (std::size_t row : matrix.id_rows(id))
+                update_row(matrix, row);
+    }
+
+    /**
+     * @brief Finds the k closest global ids to an embedding among the probed lists.
+     *
+     * @return std::vector<std::pair<std::size_t, float>> Pairs of (global id index, distance),
+     *         sorted by ascending distance. Ties are broken by the lower index.
+     */
+    std::vector<std::pair<std::size_t, float>> top_k(EmbeddingsMatrix &matrix, const float *embedding,
+                                                     std::size_t size, std::size_t k)
+    {
+        // nprobe may change concurrently, so read it once for the whole search
+        std::size_t nprobe = std::min(m_nprobe.load(std::memory_order_relaxed), m_nlist);
+        if (!trained() || nprobe == m_nlist)
+            return matrix.top_k(embedding, size, k);
+        if (size != m_dim)
+            throw std::runtime_error("Arrays are with different shape");
+
+        // Pick the nprobe most similar centroids
+        m_centroid_scores.resize(m_nlist);
+        hailo_simd::gemv(m_centroids.data(), m_nlist, m_dim, embedding, m_centroid_scores.data());
+        m_probe_order.resize(m_nlist);
+        std::iota(m_probe_order.begin(), m_probe_order.end(), 0);
+        std::partial_sort(m_probe_order.begin(), m_probe_order.begin() + nprobe, m_probe_order.end(),
+                          [this](std::size_t a, std::size_t b)
+                          { return m_centroid_scores[a] > m_centroid_scores[b]; });
+
+        // Score only the rows of the probed lists, keeping the best score per global id
+        if (m_id_scores.size() < matrix.num_ids())
+            m_id_scores.resize(matrix.num_ids(), -1.0f);
+        for (std::size_t p = 0; p < nprobe; p++)
+        {
+            for (std::size_t row : m_lists[m_probe_order[p]])
+            {
+                int owner = matrix.row_owner(row);
+                if (owner < 0)
+                    continue;
+                float score = std::max(hailo_simd::dot(matrix.row(row), embedding, m_dim), 0.0f);
+                if (m_id_scores[owner] < 0.0f)
+                    m_touched_ids.push_back(owner);
+                if (score > m_id_scores[owner])
+                    m_id_scores[owner] = score;
+            }
+        }
+        if (m_touched_ids.empty())
+            return matrix.top_k(embedding, size, k);
+
+        std::vector<std::pair<std::size_t, float>> results;
+        results.reserve(m_touched_ids.size());
+        for (std::size_t id : m_touched_ids)
+        {
+            results.emplace_back(id, 1.0f - m_id_scores[id]);
+            m_id_scores[id] = -1.0f;
+        }
+        m_touched_ids.clear();
+
+        k = std::min(k, results.size());
+        std::partial_sort(results.begin(), results.begin() + k, results.end(),
+                          [](const std::pair<std::size_t, float> &a, const std::pair<std::size_t, float> &b)
+                          { return a.second < b.second || (a.second == b.second && a.first < b.first); });
+        results.resize(k);
+        return results;
+    }
+};
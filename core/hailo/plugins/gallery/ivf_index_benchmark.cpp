@@ -0,0 +1,96 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Recall and latency of the ivf gallery index against the exact scan of the EmbeddingsMatrix.
+  The gallery is made of clustered, normalized random embeddings, every query is a noisy copy of a stored one.
+  Usage: ivf_index_benchmark [ids] [queries] [nlist]
+*/
+
+// General cpp includes
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Tappas includes
+#include "embeddings_matrix.hpp"
+#include "ivf_index.hpp"
+
+static const std::size_t DIM = 512;
+static const std::size_t QUEUE_SIZE = 4;
+static const std::size_t K = 1;
+
+static void normalize(std::vector<float> &v)
+{
+    float norm = 0.0f;
+    for (float x : v)
+        norm += x * x;
+    norm = std::sqrt(norm);
+    for (float &x : v)
+        x /= norm;
+}
+
+static std::vector<float> noisy(const std::vector<float> &base, float sigma, std::mt19937 &gen)
+{
+    std::normal_distribution<float> noise(0.0f, sigma);
+    std::vector<float> v(base);
+    for (float &x : v)
+        x += noise(gen);
+    normalize(v);
+    return v;
+}
+
+int main(int argc, char **argv)
+{
+    std::size_t num_ids = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    std::size_t num_queries = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+    std::size_t nlist = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 256;
+
+    std::mt19937 gen(1234);
+    std::vector<std::vector<float>> clusters;
+    for (std::size_t c = 0; c < nlist; c++)
+        clusters.push_back(noisy(std::vector<float>(DIM, 0.0f), 1.0f, gen));
+
+    EmbeddingsMatrix matrix(QUEUE_SIZE);
+    IvfIndex index(nlist);
+    std::vector<std::vector<float>> identities;
+    std::uniform_int_distribution<std::size_t> pick_cluster(0, nlist - 1);
+    for (std::size_t id = 0; id < num_ids; id++)
+    {
+        identities.push_back(noisy(clusters[pick_cluster(gen)], 0.05f, gen));
+        std::size_t id_index = matrix.add_id();
+        std::vector<float> embedding = noisy(identities.back(), 0.01f, gen);
+        std::size_t row = matrix.add_embedding(id_index, embedding.data(), embedding.size());
+        index.update_row(matrix, row);
+    }
+
+    std::uniform_int_distribution<std::size_t> pick_id(0, num_ids - 1);
+    std::vector<std::vector<float>> queries;
+    for (std::size_t q = 0; q < num_queries; q++)
+        queries.push_back(noisy(identities[pick_id(gen)], 0.01f, gen));
+
+    std::vector<std::size_t> truth;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &query : queries)
+        truth.push_back(matrix.top_k(query.data(), query.size(), K)[0].first);
+    double exact_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / num_queries;
+
+    std::printf("ids %zu, dim %zu, nlist %zu, queries %zu\n", num_ids, DIM, nlist, num_queries);
+    std::printf("%-8s %10s %12s\n", "nprobe", "recall@1", "latency us");
+    std::printf("%-8s %10.3f %12.1f\n", "exact", 1.0, exact_us);
+    for (std::size_t nprobe = 1; nprobe < nlist; nprobe *= 2)
+    {
+        index.set_nprobe(nprobe);
+        std::size_t hits = 0;
+        start = std::chrono::steady_clock::now();
+        for (std::size_t q = 0; q < num_queries; q++)
+            hits += index.top_k(matrix, queries[q].data(), queries[q].size(), K)[0].first == truth[q];
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / num_queries;
+        std::printf("%-8zu %10.3f %12.1f\n", nprobe, double(hits) / num_queries, us);
+    }
+    return 0;
+}
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Round trip check of the binary HailoROI encoding: encode_binary.hpp and decode_binary.hpp must agree on the layout.
+*/
+
+// General cpp includes
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Tappas includes
+#include "hailo_common.hpp"
+#include "hailo_objects.hpp"
+#include "export/encode_binary.hpp"
+#include "import/decode_binary.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+static HailoROIPtr build_roi()
+{
+    HailoROIPtr roi = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+    HailoDetectionPtr face = std::make_shared<HailoDetection>(HailoBBox(0.1f, 0.2f, 0.3f, 0.4f), 1, "face", 0.9f);
+    std::vector<HailoPoint> points = {HailoPoint(0.1f, 0.2f, 0.5f), HailoPoint(0.3f, 0.4f, 0.6f), HailoPoint(0.5f, 0.6f, 0.7f)};
+    std::vector<std::pair<int, int>> pairs = {{0, 1}, {1, 2}};
+    face->add_object(std::make_shared<HailoLandmarks>("centerpose", points, 0.3f, pairs));
+    face->add_object(std::make_shared<HailoClassification>("gender", 0, "male", 0.8f));
+    roi->add_object(face);
+    roi->add_object(std::make_shared<HailoDetection>(HailoBBox(0.5f, 0.5f, 0.2f, 0.2f), 2, "person", 0.7f));
+    return roi;
+}
+
+static void check_round_trip()
+{
+    std::vector<uint8_t> data;
+    encode_binary::encode_hailo_roi(data, build_roi(), 1234, 56);
+
+    HailoROIPtr decoded = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+    uint64_t buffer_offset = 0;
+    uint64_t timestamp = 0;
+    decode_binary::decode_hailo_roi(data.data(), data.size(), decoded, &buffer_offset, &timestamp);
+    CHECK(buffer_offset == 56);
+    CHECK(timestamp == 1234);
+
+    std::vector<HailoDetectionPtr> detections = hailo_common::get_hailo_detections(decoded);
+    CHECK(detections.size() == 2);
+    if (detections.size() != 2)
+        return;
+    CHECK(detections[0]->get_label() == "face");
+    CHECK(detections[1]->get_label() == "person");
+
+    std::vector<HailoLandmarksPtr> landmarks = hailo_common::get_hailo_landmarks(detections[0]);
+    CHECK(landmarks.size() == 1);
+    if (landmarks.size() == 1)
+    {
+        std::vector<HailoPoint> points = landmarks[0]->get_points();
+        CHECK(landmarks[0]->get_landmarks_type() == "centerpose");
+        CHECK(points.size() == 3);
+        if (points.size() == 3)
+        {
+            CHECK(points[2].x() == 0.5f && points[2].y() == 0.6f && points[2].confidence() == 0.7f);
+        }
+        CHECK(landmarks[0]->get_pairs().size() == 2);
+    }
+    CHECK(hailo_common::get_hailo_classifications(detections[0]).size() == 1);
+}
+
+static void check_truncated()
+{
+    std::vector<uint8_t> data;
+    encode_binary::encode_hailo_roi(data, build_roi(), 0, 0);
+    data.resize(data.size() - 8);
+
+    HailoROIPtr decoded = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+    bool thrown = false;
+    try
+    {
+        decode_binary::decode_hailo_roi(data.data(), data.size(), decoded);
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(decoded->get_objects().empty());
+}
+
+int main()
+{
+    check_round_trip();
+    check_truncated();
+    if (failures)
+        std::cerr << failures << " check(s) failed" << std::endl;
+    return failures ? 1 : 0;
+}
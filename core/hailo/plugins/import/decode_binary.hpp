@@ -0,0 +1,304 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+
+// General cpp includes
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Tappas includes
+#include "hailo_objects.hpp"
+#include "export/encode_binary.hpp"
+
+/**
+ * Decoding of the binary HailoROI encoding, see export/encode_binary.hpp for the layout.
+ * Every read is bounds checked, a truncated or corrupted message throws std::runtime_error.
+ */
+namespace decode_binary
+{
+    /**
+     * @brief Reads encoded fields from a byte buffer.
+     */
+    class Reader
+    {
+    private:
+        const uint8_t *m_data;
+        size_t m_size;
+        size_t m_position;
+
+    public:
+        Reader(const uint8_t *data, size_t size) : m_data(data), m_size(size), m_position(0){};
+
+        size_t position()
+        {
+            return m_position;
+        }
+
+        size_t remaining()
+        {
+            return m_size - m_position;
+        }
+
+        void get_bytes(void *bytes, size_t size)
+        {
+            if (size > m_size - m_position)
+                throw std::runtime_error("Binary HailoROI message is truncated");
+            std::memcpy(bytes, m_data + m_position, size);
+            m_position += size;
+        }
+
+        void skip(size_t size)
+        {
+            if (size > m_size - m_position)
+                throw std::runtime_error("Binary HailoROI message is truncated");
+            m_position += size;
+        }
+
+        template <typename T>
+        T get()
+        {
+            T value;
+            get_bytes(&value, sizeof(T));
+            return value;
+        }
+
+        std::string get_string()
+        {
+            uint32_t size = get<uint32_t>();
+            if (size > m_size - m_position)
+                throw std::runtime_error("Binary HailoROI message is truncated");
+            std::string str(reinterpret_cast<const char *>(m_data + m_position), size);
+            m_position += size;
+            return str;
+        }
+
+        template <typename T>
+        std::vector<T> get_array()
+        {
+            uint32_t count = get<uint32_t>();
+            if (count > (m_size - m_position) / sizeof(T))
+                throw std::runtime_error("Binary HailoROI message is truncated");
+            std::vector<T> values(count);
+            get_bytes(values.data(), count * sizeof(T));
+            return values;
+        }
+
+        HailoBBox get_bbox()
+        {
+            float fields[4];
+            get_bytes(fields, sizeof(fields));
+            return HailoBBox(fields[0], fields[1], fields[2], fields[3]);
+        }
+    };
+
+    void decode_hailo_objects(Reader &reader, HailoROIPtr roi);
+
+    inline void decode_detection(Reader &reader, HailoROIPtr roi)
+    {
+        HailoBBox bbox = reader.get_bbox();
+        float confidence = reader.get<float>();
+        int class_id = reader.get<int32_t>();
+        std::string label = reader.get_string();
+        HailoDetectionPtr detection = std::make_shared<HailoDetection>(bbox, class_id, label, confidence);
+
+        // Add this detection object to the parent
+        roi->add_object(detection);
+
+        // Recurse this object
+        decode_hailo_objects(reader, detection);
+    }
+
+    inline void decode_classification(Reader &reader, HailoROIPtr roi)
+    {
+        std::string classification_type = reader.get_string();
+        std::string label = reader.get_string();
+        int class_id = reader.get<int32_t>();
+        float confidence = reader.get<float>();
+        roi->add_object(std::make_shared<HailoClassification>(classification_type, class_id, label, confidence));
+    }
+
+    inline void decode_landmarks(Reader &reader, HailoROIPtr roi)
+    {
+        std::string landmarks_type = reader.get_string();
+        float threshold = reader.get<float>();
+
+        // n points of (x, y, confidence)
+        uint32_t num_points = reader.get<uint32_t>();
+        if (num_points > (reader.remaining() / sizeof(float)) / 3)
+            throw std::runtime_error("Binary HailoROI message is truncated");
+        std::vector<HailoPoint> points;
+        points.reserve(num_points);
+        for (uint32_t i = 0; i < num_points; i++)
+        {
+            float x = reader.get<float>();
+            float y = reader.get<float>();
+            float confidence = reader.get<float>();
+            points.emplace_back(x, y, confidence);
+        }
+
+        uint32_t num_pairs = reader.get<uint32_t>();
+        std::vector<std::pair<int, int>> pairs;
+        for (uint32_t i = 0; i < num_pairs; i++)
+        {
+            int first = reader.get<int32_t>();
+            int second = reader.get<int32_t>();
+            pairs.push_back(std::make_pair(first, second));
+        }
+
+        roi->add_object(std::make_shared<HailoLandmarks>(landmarks_type, points, threshold, pairs));
+    }
+
+    inline void decode_tile(Reader &reader, HailoROIPtr roi)
+    {
+        HailoBBox bbox = reader.get_bbox();
+        uint index = reader.get<uint32_t>();
+        uint layer = reader.get<uint32_t>();
+        hailo_tiling_mode_t mode = (hailo_tiling_mode_t)reader.get<uint32_t>();
+        float overlap_x_axis = reader.get<float>();
+        float overlap_y_axis = reader.get<float>();
+        HailoTileROIPtr tile = std::make_shared<HailoTileROI>(bbox, index, overlap_x_axis, overlap_y_axis, layer, mode);
+
+        // Add this tile object to the parent
+        roi->add_object(tile);
+
+        // Recurse this object
+        decode_hailo_objects(reader, tile);
+    }
+
+    inline void decode_unique_id(Reader &reader, HailoROIPtr roi)
+    {
+        int unique_id = reader.get<int32_t>();
+        hailo_unique_id_mode_t mode = (hailo_unique_id_mode_t)reader.get<int32_t>();
+        roi->add_object(std::make_shared<HailoUniqueID>(unique_id, mode));
+    }
+
+    inline void decode_matrix(Reader &reader, HailoROIPtr roi)
+    {
+        uint32_t width = reader.get<uint32_t>();
+        uint32_t height = reader.get<uint32_t>();
+        uint32_t features = reader.get<uint32_t>();
+        roi->add_object(std::make_shared<HailoMatrix>(reader.get_array<float>(), height, width, features));
+    }
+
+    inline void decode_depth_mask(Reader &reader, HailoROIPtr roi)
+    {
+        int width = reader.get<int32_t>();
+        int height = reader.get<int32_t>();
+        float transparency = reader.get<float>();
+        roi->add_object(std::make_shared<HailoDepthMask>(reader.get_array<float>(), width, height, transparency));
+    }
+
+    inline void decode_class_mask(Reader &reader, HailoROIPtr roi)
+    {
+        int width = reader.get<int32_t>();
+        int height = reader.get<int32_t>();
+        float transparency = reader.get<float>();
+        roi->add_object(std::make_shared<HailoClassMask>(reader.get_array<uint8_t>(), width, height, transparency));
+    }
+
+    inline void decode_conf_class_mask(Reader &reader, HailoROIPtr roi)
+    {
+        int width = reader.get<int32_t>();
+        int height = reader.get<int32_t>();
+        float transparency = reader.get<float>();
+        int class_id = reader.get<int32_t>();
+        roi->add_object(std::make_shared<HailoConfClassMask>(reader.get_array<float>(), width, height, transparency, class_id));
+    }
+
+    inline void decode_hailo_objects(Reader &reader, HailoROIPtr roi)
+    {
+        uint32_t count = reader.get<uint32_t>();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint8_t type = reader.get<uint8_t>();
+            uint32_t length = reader.get<uint32_t>();
+            size_t end = reader.position() + length;
+            switch (type)
+            {
+            case HAILO_DETECTION:
+                decode_detection(reader, roi);
+                break;
+            case HAILO_CLASSIFICATION:
+                decode_classification(reader, roi);
+                break;
+            case HAILO_LANDMARKS:
+                decode_landmarks(reader, roi);
+                break;
+            case HAILO_TILE:
+                decode_tile(reader, roi);
+                break;
+            case HAILO_UNIQUE_ID:
+                decode_unique_id(reader, roi);
+                break;
+            case HAILO_MATRIX:
+                decode_matrix(reader, roi);
+                break;
+            case HAILO_DEPTH_MASK:
+                decode_depth_mask(reader, roi);
+                break;
+            case HAILO_CLASS_MASK:
+                decode_class_mask(reader, roi);
+                break;
+            case HAILO_CONF_CLASS_MASK:
+                decode_conf_class_mask(reader, roi);
+                break;
+            default:
+                // Unknown type, skip its body
+                reader.skip(length);
+                break;
+            }
+            if (reader.position() != end)
+                throw std::runtime_error("Binary HailoROI object does not match its length");
+        }
+    }
+
+    /**
+     * @brief Check whether a message is a binary encoded HailoROI (and not JSON).
+     */
+    inline bool is_binary(const void *data, size_t size)
+    {
+        return size >= sizeof(encode_binary::MAGIC) && std::memcmp(data, encode_binary::MAGIC, sizeof(encode_binary::MAGIC)) == 0;
+    }
+
+    /**
+     * @brief Decode a binary encoded HailoROI message and add its sub objects to roi.
+     *        The objects are only added once the whole message decoded, so a message that
+     *        throws leaves roi untouched.
+     *
+     * @param data The message.
+     * @param size The size of the message in bytes.
+     * @param roi The HailoROI to add the objects to.
+     * @param buffer_offset Set to the buffer offset of the message, if not null.
+     * @param timestamp Set to the timestamp (ms) of the message, if not null.
+     */
+    inline void decode_hailo_roi(const void *data, size_t size, HailoROIPtr roi,
+                                 uint64_t *buffer_offset = nullptr, uint64_t *timestamp = nullptr)
+    {
+        if (!is_binary(data, size))
+            throw std::runtime_error("Not a binary HailoROI message");
+        Reader reader(static_cast<const uint8_t *>(data), size);
+        reader.skip(sizeof(encode_binary::MAGIC));
+        uint16_t version = reader.get<uint16_t>();
+        if (version != encode_binary::VERSION)
+            throw std::runtime_error("Unsupported binary HailoROI version " + std::to_string(version));
+        reader.skip(sizeof(uint16_t)); // reserved
+        uint64_t message_timestamp = reader.get<uint64_t>();
+        uint64_t message_offset = reader.get<uint64_t>();
+        if (timestamp)
+            *timestamp = message_timestamp;
+        if (buffer_offset)
+            *buffer_offset = message_offset;
+        reader.get_bbox(); // The bbox of the main roi is set by the receiving buffer
+
+        // Decode into a staging roi, then move the objects over
+        HailoROIPtr decoded = std::make_shared<HailoROI>(roi->get_bbox());
+        decode_hailo_objects(reader, decoded);
+        for (HailoObjectPtr &obj : decoded->get_objects())
+            roi->add_object(obj);
+    }
+}
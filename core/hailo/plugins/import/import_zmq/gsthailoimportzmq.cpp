@@ -12,7 +12,6 @@
 #include <ctime>
 #include <gst/video/video.h>
 #include <gst/gst.h>
-#include <unistd.h>
 
 #define RAPIDJSON_HAS_STDSTRING 1
 #include "rapidjson/document.h"
@@ -34,6 +33,8 @@ static void gst_hailoimportzmq_get_property(GObject *object,
 static void gst_hailoimportzmq_dispose(GObject *object);
 static void gst_hailoimportzmq_finalize(GObject *object);
 
+static GstStateChangeReturn gst_hailoimportzmq_change_state(GstElement *element, GstStateChange transition);
+static gboolean gst_hailoimportzmq_sink_event(GstBaseTransform *trans, GstEvent *event);
 static gboolean gst_hailoimportzmq_start(GstBaseTransform *trans);
 static gboolean gst_hailoimportzmq_stop(GstBaseTransform *trans);
 static GstFlowReturn gst_hailoimportzmq_transform_ip(GstBaseTransform *trans,
@@ -49,21 +50,65 @@ enum
 {
     PROP_0,
     PROP_ADDRESS,
+    PROP_MATCH_MODE,
+    PROP_POLICY,
+    PROP_TIMEOUT,
+    PROP_JITTER_BUFFER_SIZE,
+    PROP_FRAMES_WITHOUT_META,
 };
 
 // Default import node
 const gchar *DEFAULT_ADDRESS = "tcp://localhost:5555";
+// How often (ms) the receiver thread checks whether it should stop
+#define RECEIVE_POLL_INTERVAL_MS (100)
+
+#define GST_TYPE_HAILO_IMPORT_ZMQ_MATCH_MODE (gst_hailoimportzmq_match_mode_get_type())
+static GType
+gst_hailoimportzmq_match_mode_get_type(void)
+{
+    static GType importzmq_match_mode = 0;
+    static const GEnumValue hailoimportzmq_match_modes[] = {
+        {GST_HAILO_IMPORT_ZMQ_MATCH_ARRIVAL, "Oldest received message", "arrival"},
+        {GST_HAILO_IMPORT_ZMQ_MATCH_OFFSET, "Message with the buffer offset of the frame", "offset"},
+        {0, NULL, NULL},
+    };
+    if (!importzmq_match_mode)
+    {
+        importzmq_match_mode =
+            g_enum_register_static("GstHailoImportZMQMatchMode", hailoimportzmq_match_modes);
+    }
+    return importzmq_match_mode;
+}
+
+#define GST_TYPE_HAILO_IMPORT_ZMQ_POLICY (gst_hailoimportzmq_policy_get_type())
+static GType
+gst_hailoimportzmq_policy_get_type(void)
+{
+    static GType importzmq_policy = 0;
+    static const GEnumValue hailoimportzmq_policies[] = {
+        {GST_HAILO_IMPORT_ZMQ_POLICY_WAIT, "Wait for the message of the frame", "wait"},
+        {GST_HAILO_IMPORT_ZMQ_POLICY_DROP, "Pass the frame without meta if its message is not there yet", "drop"},
+        {0, NULL, NULL},
+    };
+    if (!importzmq_policy)
+    {
+        importzmq_policy =
+            g_enum_register_static("GstHailoImportZMQPolicy", hailoimportzmq_policies);
+    }
+    return importzmq_policy;
+}
 
 static void
 gst_hailoimportzmq_class_init(GstHailoImportZMQClass *klass)
 {
     GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
     GstBaseTransformClass *base_transform_class =
         GST_BASE_TRANSFORM_CLASS(klass);
 
-    const char *description = "Imports HailoObjects in JSON format from a ZMQ socket."
+    const char *description = "Imports HailoObjects in JSON or binary format from a ZMQ socket."
                               "\n\t\t\t   "
-                              "Decodes classes contained by JSON to HailoROI objects.";
+                              "Decodes classes contained by JSON or by the binary encoding of hailoexportzmq to HailoROI objects.";
     /* Setting up pads and setting metadata should be moved to
        base_class_init if you intend to subclass this class. */
     gst_element_class_add_pad_template(GST_ELEMENT_CLASS(klass),
@@ -85,9 +130,37 @@ gst_hailoimportzmq_class_init(GstHailoImportZMQClass *klass)
                                     g_param_spec_string("address", "Endpoint address.",
                                                         "Address to bind the socket to.", "tcp://localhost:5555",
                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_MATCH_MODE,
+                                    g_param_spec_enum("match-mode", "Match mode",
+                                                      "How a message is matched to a frame. arrival takes the oldest received message, "
+                                                      "offset follows the buffer offsets (set by hailoexportzmq) from the first received message, one per frame.",
+                                                      GST_TYPE_HAILO_IMPORT_ZMQ_MATCH_MODE, GST_HAILO_IMPORT_ZMQ_MATCH_ARRIVAL,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_POLICY,
+                                    g_param_spec_enum("policy", "Policy",
+                                                      "What to do when the message of a frame was not received yet",
+                                                      GST_TYPE_HAILO_IMPORT_ZMQ_POLICY, GST_HAILO_IMPORT_ZMQ_POLICY_WAIT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_TIMEOUT,
+                                    g_param_spec_uint("timeout", "Timeout",
+                                                      "Wait policy: milliseconds to wait for the message of a frame before passing it without meta, 0 waits forever",
+                                                      0, G_MAXUINT, 0,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_JITTER_BUFFER_SIZE,
+                                    g_param_spec_uint("jitter-buffer-size", "Jitter buffer size",
+                                                      "Maximum number of received messages waiting for their frames, the oldest are dropped beyond it",
+                                                      1, G_MAXUINT, 30,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class, PROP_FRAMES_WITHOUT_META,
+                                    g_param_spec_uint64("frames-without-meta", "Frames without meta",
+                                                        "Number of frames passed without a message so far",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 
     gobject_class->dispose = gst_hailoimportzmq_dispose;
     gobject_class->finalize = gst_hailoimportzmq_finalize;
+    element_class->change_state = GST_DEBUG_FUNCPTR(gst_hailoimportzmq_change_state);
+    base_transform_class->sink_event = GST_DEBUG_FUNCPTR(gst_hailoimportzmq_sink_event);
     base_transform_class->start = GST_DEBUG_FUNCPTR(gst_hailoimportzmq_start);
     base_transform_class->stop = GST_DEBUG_FUNCPTR(gst_hailoimportzmq_stop);
     base_transform_class->transform_ip = GST_DEBUG_FUNCPTR(gst_hailoimportzmq_transform_ip);
@@ -97,6 +170,17 @@ static void
 gst_hailoimportzmq_init(GstHailoImportZMQ *hailoimportzmq)
 {
     hailoimportzmq->address = g_strdup(DEFAULT_ADDRESS);
+    hailoimportzmq->match_mode = GST_HAILO_IMPORT_ZMQ_MATCH_ARRIVAL;
+    hailoimportzmq->policy = GST_HAILO_IMPORT_ZMQ_POLICY_WAIT;
+    hailoimportzmq->timeout = 0;
+    hailoimportzmq->jitter_buffer_size = 30;
+    hailoimportzmq->frames_without_meta = 0;
+    hailoimportzmq->receiver = nullptr;
+    hailoimportzmq->running = false;
+    hailoimportzmq->jitter_buffer = new std::map<guint64, HailoROIPtr>();
+    hailoimportzmq->received_messages = 0;
+    hailoimportzmq->next_offset = GST_BUFFER_OFFSET_NONE;
+    hailoimportzmq->flushing = false;
 }
 
 void gst_hailoimportzmq_set_property(GObject *object, guint property_id,
@@ -111,6 +195,18 @@ void gst_hailoimportzmq_set_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         hailoimportzmq->address = g_strdup(g_value_get_string(value));
         break;
+    case PROP_MATCH_MODE:
+        hailoimportzmq->match_mode = (GstHailoImportZMQMatchMode)g_value_get_enum(value);
+        break;
+    case PROP_POLICY:
+        hailoimportzmq->policy = (GstHailoImportZMQPolicy)g_value_get_enum(value);
+        break;
+    case PROP_TIMEOUT:
+        hailoimportzmq->timeout = g_value_get_uint(value);
+        break;
+    case PROP_JITTER_BUFFER_SIZE:
+        hailoimportzmq->jitter_buffer_size = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -129,6 +225,24 @@ void gst_hailoimportzmq_get_property(GObject *object, guint property_id,
     case PROP_ADDRESS:
         g_value_set_string(value, hailoimportzmq->address);
         break;
+    case PROP_MATCH_MODE:
+        g_value_set_enum(value, (gint)hailoimportzmq->match_mode);
+        break;
+    case PROP_POLICY:
+        g_value_set_enum(value, (gint)hailoimportzmq->policy);
+        break;
+    case PROP_TIMEOUT:
+        g_value_set_uint(value, hailoimportzmq->timeout);
+        break;
+    case PROP_JITTER_BUFFER_SIZE:
+        g_value_set_uint(value, hailoimportzmq->jitter_buffer_size);
+        break;
+    case PROP_FRAMES_WITHOUT_META:
+    {
+        std::lock_guard<std::mutex> lock(hailoimportzmq->mutex);
+        g_value_set_uint64(value, hailoimportzmq->frames_without_meta);
+        break;
+    }
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
         break;
@@ -151,10 +265,152 @@ void gst_hailoimportzmq_finalize(GObject *object)
     GST_DEBUG_OBJECT(hailoimportzmq, "finalize");
 
     /* clean up object here */
+    delete hailoimportzmq->jitter_buffer;
+    hailoimportzmq->jitter_buffer = nullptr;
 
     G_OBJECT_CLASS(gst_hailoimportzmq_parent_class)->finalize(object);
 }
 
+/**
+ * @brief Decode a received message, JSON or binary.
+ *
+ * @param message The message.
+ * @param roi The HailoROI to add the decoded objects to.
+ * @param has_offset Set to whether the message carries a buffer offset.
+ * @param buffer_offset Set to the buffer offset of the message, if it has one.
+ * @return false if the message could not be decoded.
+ */
+static bool
+gst_hailoimportzmq_decode(GstHailoImportZMQ *hailoimportzmq, zmq::message_t &message, HailoROIPtr roi, bool &has_offset, guint64 &buffer_offset)
+{
+    // Binary messages start with a magic, anything else is JSON
+    if (decode_binary::is_binary(message.data(), message.size()))
+    {
+        try
+        {
+            uint64_t message_offset = 0;
+            decode_binary::decode_hailo_roi(message.data(), message.size(), roi, &message_offset);
+            has_offset = true;
+            buffer_offset = message_offset;
+        }
+        catch (const std::runtime_error &err)
+        {
+            GST_ERROR_OBJECT(hailoimportzmq, "hailoimportzmq failed to decode binary message! Error: %s", err.what());
+            return false;
+        }
+        return true;
+    }
+
+    // Decode the recvd JSON
+    std::string rx_str;
+    rx_str.assign(static_cast<char *>(message.data()), message.size());
+    rapidjson::Document decoded_stream;
+    if (decoded_stream.Parse(rx_str).HasParseError() || !decoded_stream.IsObject() || !decoded_stream.HasMember("HailoROI"))
+    {
+        GST_ERROR_OBJECT(hailoimportzmq, "hailoimportzmq failed to parse message to json!");
+        return false;
+    }
+    decode_json::decode_hailo_roi(decoded_stream, roi);
+    has_offset = decoded_stream.HasMember("buffer_offset") && decoded_stream["buffer_offset"].IsUint64();
+    if (has_offset)
+        buffer_offset = decoded_stream["buffer_offset"].GetUint64();
+    return true;
+}
+
+/**
+ * @brief Receiver thread: decodes the messages off the streaming thread into the jitter buffer.
+ *        Blocks in recv (bounded by RECEIVE_POLL_INTERVAL_MS), so it takes no CPU while idle.
+ */
+static void
+gst_hailoimportzmq_receive_loop(GstHailoImportZMQ *hailoimportzmq)
+{
+    while (hailoimportzmq->running)
+    {
+        zmq::message_t recv_message;
+        try
+        {
+            hailoimportzmq->socket->recv(recv_message, zmq::recv_flags::none);
+        }
+        catch (zmq::error_t const &err)
+        {
+            GST_ERROR_OBJECT(hailoimportzmq, "hailoimportzmq failed to receive! Error: %s", err.what());
+            break;
+        }
+        // Nothing within the poll interval
+        if (recv_message.size() == 0)
+            continue;
+
+        HailoROIPtr roi = std::make_shared<HailoROI>(HailoBBox(0.0f, 0.0f, 1.0f, 1.0f));
+        bool has_offset = false;
+        guint64 buffer_offset = 0;
+        if (!gst_hailoimportzmq_decode(hailoimportzmq, recv_message, roi, has_offset, buffer_offset))
+            continue;
+
+        {
+            std::lock_guard<std::mutex> lock(hailoimportzmq->mutex);
+            guint64 key = hailoimportzmq->received_messages++;
+            if (hailoimportzmq->match_mode == GST_HAILO_IMPORT_ZMQ_MATCH_OFFSET && has_offset)
+                key = buffer_offset;
+            (*hailoimportzmq->jitter_buffer)[key] = roi;
+            // Drop the oldest messages, their frames are not coming
+            while (hailoimportzmq->jitter_buffer->size() > hailoimportzmq->jitter_buffer_size)
+                hailoimportzmq->jitter_buffer->erase(hailoimportzmq->jitter_buffer->begin());
+        }
+        hailoimportzmq->cond.notify_all();
+    }
+}
+
+static void
+gst_hailoimportzmq_set_flushing(GstHailoImportZMQ *hailoimportzmq, bool flushing)
+{
+    {
+        std::lock_guard<std::mutex> lock(hailoimportzmq->mutex);
+        hailoimportzmq->flushing = flushing;
+    }
+    hailoimportzmq->cond.notify_all();
+}
+
+static GstStateChangeReturn
+gst_hailoimportzmq_change_state(GstElement *element, GstStateChange transition)
+{
+    GstHailoImportZMQ *hailoimportzmq = GST_HAILO_IMPORT_ZMQ(element);
+
+    switch (transition)
+    {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+        gst_hailoimportzmq_set_flushing(hailoimportzmq, false);
+        break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+        // Release a frame waiting for its message before the pads are deactivated
+        gst_hailoimportzmq_set_flushing(hailoimportzmq, true);
+        break;
+    default:
+        break;
+    }
+
+    return GST_ELEMENT_CLASS(gst_hailoimportzmq_parent_class)->change_state(element, transition);
+}
+
+static gboolean
+gst_hailoimportzmq_sink_event(GstBaseTransform *trans, GstEvent *event)
+{
+    GstHailoImportZMQ *hailoimportzmq = GST_HAILO_IMPORT_ZMQ(trans);
+
+    switch (GST_EVENT_TYPE(event))
+    {
+    case GST_EVENT_FLUSH_START:
+        gst_hailoimportzmq_set_flushing(hailoimportzmq, true);
+        break;
+    case GST_EVENT_FLUSH_STOP:
+        gst_hailoimportzmq_set_flushing(hailoimportzmq, false);
+        break;
+    default:
+        break;
+    }
+
+    return GST_BASE_TRANSFORM_CLASS(gst_hailoimportzmq_parent_class)->sink_event(trans, event);
+}
+
 static gboolean
 gst_hailoimportzmq_start(GstBaseTransform *trans)
 {
@@ -166,6 +422,8 @@ gst_hailoimportzmq_start(GstBaseTransform *trans)
 
     // Bind the socket to the requested address
     hailoimportzmq->socket->setsockopt(ZMQ_SUBSCRIBE, "", 0);
+    // recv returns every poll interval without a message, so the receiver thread can stop
+    hailoimportzmq->socket->setsockopt(ZMQ_RCVTIMEO, RECEIVE_POLL_INTERVAL_MS);
     try {
         hailoimportzmq->socket->connect(hailoimportzmq->address);
     }
@@ -177,6 +435,13 @@ gst_hailoimportzmq_start(GstBaseTransform *trans)
         return FALSE;
     }
 
+    hailoimportzmq->jitter_buffer->clear();
+    hailoimportzmq->received_messages = 0;
+    hailoimportzmq->next_offset = GST_BUFFER_OFFSET_NONE;
+    hailoimportzmq->frames_without_meta = 0;
+    hailoimportzmq->running = true;
+    hailoimportzmq->receiver = new std::thread(gst_hailoimportzmq_receive_loop, hailoimportzmq);
+
     return TRUE;
 }
 
@@ -186,6 +451,19 @@ gst_hailoimportzmq_stop(GstBaseTransform *trans)
     GstHailoImportZMQ *hailoimportzmq = GST_HAILO_IMPORT_ZMQ(trans);
     GST_DEBUG_OBJECT(hailoimportzmq, "stop");
 
+    // Stop the receiver thread, it returns from recv within the poll interval
+    hailoimportzmq->running = false;
+    if (hailoimportzmq->receiver)
+    {
+        hailoimportzmq->receiver->join();
+        delete hailoimportzmq->receiver;
+        hailoimportzmq->receiver = nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(hailoimportzmq->mutex);
+        hailoimportzmq->jitter_buffer->clear();
+    }
+
     // Unbind the socket and close the context
     hailoimportzmq->socket->close();
     hailoimportzmq->context->close();
@@ -193,38 +471,94 @@ gst_hailoimportzmq_stop(GstBaseTransform *trans)
     return TRUE;
 }
 
+/**
+ * @brief Take the message of the next frame out of the jitter buffer. Called with the mutex locked.
+ *
+ * @param frame_offset The offset of the frame in the exporter stream, for match by offset.
+ *                     Anchored to the oldest message while it is GST_BUFFER_OFFSET_NONE (the first
+ *                     frame, e.g. when joining a running exporter), and again when the exporter restarted.
+ * @return The decoded message, null if it is not there (yet).
+ */
+static HailoROIPtr
+gst_hailoimportzmq_take_message(GstHailoImportZMQ *hailoimportzmq, guint64 &frame_offset, bool &lost)
+{
+    std::map<guint64, HailoROIPtr> *jitter_buffer = hailoimportzmq->jitter_buffer;
+    lost = false;
+    if (hailoimportzmq->match_mode == GST_HAILO_IMPORT_ZMQ_MATCH_OFFSET)
+    {
+        // The offsets are those of the exporter, follow them from its oldest message
+        if (!jitter_buffer->empty() &&
+            (frame_offset == GST_BUFFER_OFFSET_NONE ||
+             jitter_buffer->rbegin()->first + hailoimportzmq->jitter_buffer_size < frame_offset))
+        {
+            frame_offset = jitter_buffer->begin()->first;
+            GST_INFO_OBJECT(hailoimportzmq, "Matching frames to messages from offset %" G_GUINT64_FORMAT, frame_offset);
+        }
+        if (frame_offset == GST_BUFFER_OFFSET_NONE)
+            return nullptr;
+        // Messages of earlier frames are stale
+        jitter_buffer->erase(jitter_buffer->begin(), jitter_buffer->lower_bound(frame_offset));
+        if (jitter_buffer->empty())
+            return nullptr;
+        // A message of a later frame arrived first, the message of this frame was lost
+        if (jitter_buffer->begin()->first != frame_offset)
+        {
+            lost = true;
+            return nullptr;
+        }
+    }
+    else if (jitter_buffer->empty())
+    {
+        return nullptr;
+    }
+    HailoROIPtr message = jitter_buffer->begin()->second;
+    jitter_buffer->erase(jitter_buffer->begin());
+    return message;
+}
+
 static GstFlowReturn
 gst_hailoimportzmq_transform_ip(GstBaseTransform *trans,
                                 GstBuffer *buffer)
 {
     GstHailoImportZMQ *hailoimportzmq = GST_HAILO_IMPORT_ZMQ(trans);
+    HailoROIPtr message = nullptr;
 
-    // Get the roi from the current buffer and decode it to a JSON entry
-    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
-
-    // Recv the message
-    zmq::message_t recv_message;
-#if (CPPZMQ_VERSION_MAJOR >= 4 && CPPZMQ_VERSION_MINOR >= 6 && CPPZMQ_VERSION_PATCH >= 0)
-    zmq::recv_result_t recv_succeeded = 0;
-#else
-    zmq::detail::recv_result_t recv_succeeded = 0;
-#endif
-    while (recv_message.size() == 0)
     {
-        recv_succeeded = hailoimportzmq->socket->recv(recv_message, zmq::recv_flags(ZMQ_DONTWAIT));
-        sleep(0);  // yield the scheduler to prevent the thread from spinning the CPU core
+        std::unique_lock<std::mutex> lock(hailoimportzmq->mutex);
+        guint64 frame_offset = hailoimportzmq->next_offset;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(hailoimportzmq->timeout);
+        bool lost = false;
+        while (!hailoimportzmq->flushing)
+        {
+            message = gst_hailoimportzmq_take_message(hailoimportzmq, frame_offset, lost);
+            if (message || lost || hailoimportzmq->policy == GST_HAILO_IMPORT_ZMQ_POLICY_DROP)
+                break;
+            if (hailoimportzmq->timeout == 0)
+                hailoimportzmq->cond.wait(lock);
+            else if (hailoimportzmq->cond.wait_until(lock, deadline) == std::cv_status::timeout)
+            {
+                message = gst_hailoimportzmq_take_message(hailoimportzmq, frame_offset, lost);
+                break;
+            }
+        }
+        if (hailoimportzmq->flushing)
+            return GST_FLOW_FLUSHING;
+        if (frame_offset != GST_BUFFER_OFFSET_NONE)
+            hailoimportzmq->next_offset = frame_offset + 1;
+        if (!message)
+            hailoimportzmq->frames_without_meta++;
     }
-    if (recv_succeeded <= 0)
-        GST_WARNING("hailoimportzmq failed to send buffer!");
 
-    // Decode the recvd JSON
-    std::string rx_str;
-    rx_str.assign(static_cast<char *>(recv_message.data()), recv_message.size());
-    rapidjson::Document decoded_stream;
-    if (decoded_stream.Parse(rx_str).HasParseError()) {
-        GST_ERROR("hailoimportzmq failed to parse message to json!");
+    if (!message)
+    {
+        GST_LOG_OBJECT(hailoimportzmq, "No message for frame, passing it without meta");
+        return GST_FLOW_OK;
     }
-    decode_json::decode_hailo_roi(decoded_stream, hailo_roi);
+
+    // Move the decoded objects to the roi of the current buffer
+    HailoROIPtr hailo_roi = get_hailo_main_roi(buffer, true);
+    for (HailoObjectPtr &obj : message->get_objects())
+        hailo_roi->add_object(obj);
 
     GST_DEBUG_OBJECT(hailoimportzmq, "transform_ip");
     return GST_FLOW_OK;
@@ -7,7 +7,13 @@
 #include <gst/base/gstbasetransform.h>
 #include "hailo_objects.hpp"
 #include "import/decode_json.hpp"
+#include "import/decode_binary.hpp"
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
+#include <map>
+#include <mutex>
+#include <thread>
 #include <zmq.hpp>
 
 G_BEGIN_DECLS
@@ -18,6 +24,18 @@ G_BEGIN_DECLS
 #define GST_IS_HAILO_IMPORT_ZMQ(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), GST_TYPE_HAILO_IMPORT_ZMQ))
 #define GST_IS_HAILO_IMPORT_ZMQ_CLASS(obj) (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_HAILO_IMPORT_ZMQ))
 
+typedef enum
+{
+    GST_HAILO_IMPORT_ZMQ_MATCH_ARRIVAL,
+    GST_HAILO_IMPORT_ZMQ_MATCH_OFFSET,
+} GstHailoImportZMQMatchMode;
+
+typedef enum
+{
+    GST_HAILO_IMPORT_ZMQ_POLICY_WAIT,
+    GST_HAILO_IMPORT_ZMQ_POLICY_DROP,
+} GstHailoImportZMQPolicy;
+
 typedef struct _GstHailoImportZMQ GstHailoImportZMQ;
 typedef struct _GstHailoImportZMQClass GstHailoImportZMQClass;
 
@@ -25,8 +43,22 @@ struct _GstHailoImportZMQ
 {
     GstBaseTransform base_hailoimportzmq;
     gchar *address;
+    GstHailoImportZMQMatchMode match_mode;
+    GstHailoImportZMQPolicy policy;
+    guint timeout;
+    guint jitter_buffer_size;
+    guint64 frames_without_meta;
     zmq::context_t *context;
-    zmq::socket_t *socket;
+    zmq::socket_t *socket; // Only used by the receiver thread once it runs
+
+    std::thread *receiver;
+    std::atomic<bool> running;
+    std::mutex mutex;
+    std::condition_variable cond;          // Signaled when a message is received or when flushing
+    std::map<guint64, HailoROIPtr> *jitter_buffer; // Decoded messages by buffer offset (or arrival order), guarded by mutex
+    guint64 received_messages;              // Key of JSON messages without a buffer offset
+    guint64 next_offset;                    // Offset of the next frame in match by offset mode, GST_BUFFER_OFFSET_NONE until the first message
+    bool flushing;
 };
 
 struct _GstHailoImportZMQClass
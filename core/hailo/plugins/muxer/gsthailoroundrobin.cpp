@@ -8,6 +8,8 @@
  * gsthailoroundrobin.cpp: Simple Input Round Robin funnel (N->1) element, waits on all sinks, passes the first one, with all metadata included.
  */
 
+#include <algorithm>
+#include <deque>
 #include "gsthailoroundrobin.hpp"
 #include "gst_hailo_meta.hpp"
 #include "gst_hailo_stream_meta.hpp"
@@ -32,10 +34,30 @@ GType gst_hailo_round_robin_pad_get_type(void);
 typedef struct _GstHailoRoundRobinPad GstHailoRoundRobinPad;
 typedef struct _GstHailoRoundRobinPadClass GstHailoRoundRobinPadClass;
 
+/**
+ * A buffer waiting in the queue of a sink pad, in deadline mode.
+ */
+struct RoundRobinQueuedBuffer
+{
+    GstBuffer *buffer;
+    gint64 arrival_time; // Monotonic time (us) the buffer was queued at
+};
+
 struct _GstHailoRoundRobinPad
 {
     GstPad parent;
     gboolean got_eos;
+
+    // Deadline mode, guarded by the queue_mutex of the element
+    std::deque<RoundRobinQueuedBuffer> *queue;
+    guint weight;
+    gdouble max_fps;
+    gdouble pass;          // Virtual time of the pad, grows by 1 / weight with every served buffer
+    gint64 next_push_time; // Earliest time the next buffer of the pad can be served, to keep max-fps
+    guint64 frames_pushed;
+    guint64 frames_dropped;
+    gint64 total_latency; // Sum of the time (us) the pushed buffers waited in the queue
+    gint64 max_latency;
 };
 
 struct _GstHailoRoundRobinPadClass
@@ -56,22 +78,197 @@ static size_t get_pad_num(GstPad *pad)
 G_DEFINE_TYPE(GstHailoRoundRobinPad, gst_hailo_round_robin_pad, GST_TYPE_PAD);
 
 #define DEFAULT_FORWARD_STICKY_EVENTS TRUE
+#define DEFAULT_MODE HAILO_ROUND_ROBIN_MODE_STRICT
+#define DEFAULT_QUEUE_SIZE 2
+#define DEFAULT_MAX_LATENCY 0
+#define DEFAULT_BATCH_SIZE 1
+#define DEFAULT_BATCH_TIMEOUT 0
+#define DEFAULT_PAD_WEIGHT 1
+#define DEFAULT_PAD_MAX_FPS 0.0
 
 enum
 {
     PROP_0,
     PROP_FUNNEL_MODE,
+    PROP_MODE,
+    PROP_QUEUE_SIZE,
+    PROP_MAX_LATENCY,
+    PROP_BATCH_SIZE,
+    PROP_BATCH_TIMEOUT,
+};
+
+enum
+{
+    PAD_PROP_0,
+    PAD_PROP_WEIGHT,
+    PAD_PROP_MAX_FPS,
+    PAD_PROP_FRAMES_PUSHED,
+    PAD_PROP_FRAMES_DROPPED,
+    PAD_PROP_AVERAGE_LATENCY,
+    PAD_PROP_MAX_LATENCY,
 };
 
+#define GST_TYPE_HAILO_ROUND_ROBIN_MODE (gst_hailo_round_robin_mode_get_type())
+static GType
+gst_hailo_round_robin_mode_get_type(void)
+{
+    static GType round_robin_mode = 0;
+    static const GEnumValue hailo_round_robin_modes[] = {
+        {HAILO_ROUND_ROBIN_MODE_STRICT, "Strict turn-taking, each pad waits for its turn", "strict"},
+        {HAILO_ROUND_ROBIN_MODE_DEADLINE, "Queue per pad, serve the pads that have data by weight and drop old buffers", "deadline"},
+        {0, NULL, NULL},
+    };
+    if (!round_robin_mode)
+    {
+        round_robin_mode =
+            g_enum_register_static("GstHailoRoundRobinMode", hailo_round_robin_modes);
+    }
+    return round_robin_mode;
+}
+
+static void
+gst_hailo_round_robin_pad_drop_front(GstHailoRoundRobinPad *pad)
+{
+    gst_buffer_unref(pad->queue->front().buffer);
+    pad->queue->pop_front();
+    pad->frames_dropped++;
+}
+
+static void
+gst_hailo_round_robin_pad_flush(GstHailoRoundRobinPad *pad)
+{
+    for (RoundRobinQueuedBuffer &queued : *pad->queue)
+        gst_buffer_unref(queued.buffer);
+    pad->queue->clear();
+}
+
+static void
+gst_hailo_round_robin_pad_set_property(GObject *object, guint prop_id,
+                                       const GValue *value, GParamSpec *pspec)
+{
+    GstHailoRoundRobinPad *pad = GST_HAILO_ROUND_ROBIN_PAD_CAST(object);
+
+    switch (prop_id)
+    {
+    case PAD_PROP_WEIGHT:
+        pad->weight = g_value_get_uint(value);
+        break;
+    case PAD_PROP_MAX_FPS:
+        pad->max_fps = g_value_get_double(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+gst_hailo_round_robin_pad_get_property(GObject *object, guint prop_id, GValue *value,
+                                       GParamSpec *pspec)
+{
+    GstHailoRoundRobinPad *pad = GST_HAILO_ROUND_ROBIN_PAD_CAST(object);
+
+    // The statistics are updated by the src task under the queue mutex of the element.
+    GstObject *parent = gst_object_get_parent(GST_OBJECT_CAST(pad));
+    std::unique_lock<std::mutex> lock;
+    if (parent != NULL)
+        lock = std::unique_lock<std::mutex>(GST_HAILO_ROUND_ROBIN_CAST(parent)->queue_mutex);
+
+    switch (prop_id)
+    {
+    case PAD_PROP_WEIGHT:
+        g_value_set_uint(value, pad->weight);
+        break;
+    case PAD_PROP_MAX_FPS:
+        g_value_set_double(value, pad->max_fps);
+        break;
+    case PAD_PROP_FRAMES_PUSHED:
+        g_value_set_uint64(value, pad->frames_pushed);
+        break;
+    case PAD_PROP_FRAMES_DROPPED:
+        g_value_set_uint64(value, pad->frames_dropped);
+        break;
+    case PAD_PROP_AVERAGE_LATENCY:
+        g_value_set_double(value, pad->frames_pushed ? (gdouble)pad->total_latency / pad->frames_pushed / G_TIME_SPAN_MILLISECOND : 0.0);
+        break;
+    case PAD_PROP_MAX_LATENCY:
+        g_value_set_double(value, (gdouble)pad->max_latency / G_TIME_SPAN_MILLISECOND);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+
+    if (lock.owns_lock())
+        lock.unlock();
+    if (parent != NULL)
+        gst_object_unref(parent);
+}
+
+static void
+gst_hailo_round_robin_pad_finalize(GObject *object)
+{
+    GstHailoRoundRobinPad *pad = GST_HAILO_ROUND_ROBIN_PAD_CAST(object);
+    gst_hailo_round_robin_pad_flush(pad);
+    delete pad->queue;
+    pad->queue = NULL;
+    G_OBJECT_CLASS(gst_hailo_round_robin_pad_parent_class)->finalize(object);
+}
+
 static void
 gst_hailo_round_robin_pad_class_init(GstHailoRoundRobinPadClass *klass)
 {
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+
+    gobject_class->set_property = gst_hailo_round_robin_pad_set_property;
+    gobject_class->get_property = gst_hailo_round_robin_pad_get_property;
+    gobject_class->finalize = gst_hailo_round_robin_pad_finalize;
+
+    g_object_class_install_property(gobject_class, PAD_PROP_WEIGHT,
+                                    g_param_spec_uint("weight", "Weight",
+                                                      "Deadline mode: share of the pushed buffers this pad gets when several pads have data, relative to the other pads",
+                                                      1, G_MAXUINT, DEFAULT_PAD_WEIGHT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PAD_PROP_MAX_FPS,
+                                    g_param_spec_double("max-fps", "Max fps",
+                                                        "Deadline mode: frame rate target of this pad, buffers above it wait in the queue and are dropped when they get old. 0 is unlimited",
+                                                        0.0, G_MAXDOUBLE, DEFAULT_PAD_MAX_FPS,
+                                                        (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PAD_PROP_FRAMES_PUSHED,
+                                    g_param_spec_uint64("frames-pushed", "Frames pushed",
+                                                        "Deadline mode: number of buffers of this pad that were pushed",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PAD_PROP_FRAMES_DROPPED,
+                                    g_param_spec_uint64("frames-dropped", "Frames dropped",
+                                                        "Deadline mode: number of buffers of this pad that were dropped, because the queue was full or they were too old",
+                                                        0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PAD_PROP_AVERAGE_LATENCY,
+                                    g_param_spec_double("average-latency", "Average latency",
+                                                        "Deadline mode: average time in milliseconds the pushed buffers of this pad waited in the queue",
+                                                        0.0, G_MAXDOUBLE, 0.0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class, PAD_PROP_MAX_LATENCY,
+                                    g_param_spec_double("max-latency", "Max latency",
+                                                        "Deadline mode: longest time in milliseconds a pushed buffer of this pad waited in the queue",
+                                                        0.0, G_MAXDOUBLE, 0.0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
 gst_hailo_round_robin_pad_init(GstHailoRoundRobinPad *pad)
 {
     pad->got_eos = FALSE;
+    pad->queue = new std::deque<RoundRobinQueuedBuffer>();
+    pad->weight = DEFAULT_PAD_WEIGHT;
+    pad->max_fps = DEFAULT_PAD_MAX_FPS;
+    pad->pass = 0.0;
+    pad->next_push_time = 0;
+    pad->frames_pushed = 0;
+    pad->frames_dropped = 0;
+    pad->total_latency = 0;
+    pad->max_latency = 0;
 }
 
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink_%u",
@@ -118,6 +315,21 @@ gst_hailo_round_robin_set_property(GObject *object, guint prop_id,
     case PROP_FUNNEL_MODE:
         GST_HAILO_ROUND_ROBIN(object)->funnel_mode = g_value_get_boolean(value);
         break;
+    case PROP_MODE:
+        GST_HAILO_ROUND_ROBIN(object)->mode = (GstHailoRoundRobinMode)g_value_get_enum(value);
+        break;
+    case PROP_QUEUE_SIZE:
+        GST_HAILO_ROUND_ROBIN(object)->queue_size = g_value_get_uint(value);
+        break;
+    case PROP_MAX_LATENCY:
+        GST_HAILO_ROUND_ROBIN(object)->max_latency = g_value_get_uint(value);
+        break;
+    case PROP_BATCH_SIZE:
+        GST_HAILO_ROUND_ROBIN(object)->batch_size = g_value_get_uint(value);
+        break;
+    case PROP_BATCH_TIMEOUT:
+        GST_HAILO_ROUND_ROBIN(object)->batch_timeout = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -133,6 +345,21 @@ gst_hailo_round_robin_get_property(GObject *object, guint prop_id, GValue *value
     case PROP_FUNNEL_MODE:
         g_value_set_boolean(value, GST_HAILO_ROUND_ROBIN(object)->funnel_mode);
         break;
+    case PROP_MODE:
+        g_value_set_enum(value, (gint)GST_HAILO_ROUND_ROBIN(object)->mode);
+        break;
+    case PROP_QUEUE_SIZE:
+        g_value_set_uint(value, GST_HAILO_ROUND_ROBIN(object)->queue_size);
+        break;
+    case PROP_MAX_LATENCY:
+        g_value_set_uint(value, GST_HAILO_ROUND_ROBIN(object)->max_latency);
+        break;
+    case PROP_BATCH_SIZE:
+        g_value_set_uint(value, GST_HAILO_ROUND_ROBIN(object)->batch_size);
+        break;
+    case PROP_BATCH_TIMEOUT:
+        g_value_set_uint(value, GST_HAILO_ROUND_ROBIN(object)->batch_timeout);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -171,6 +398,42 @@ gst_hailo_round_robin_class_init(GstHailoRoundRobinClass *klass)
                                                          "Disables the round robin logic and pushes all buffers when available",
                                                          false,
                                                          (GParamFlags)(GST_PARAM_CONTROLLABLE | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_MODE,
+                                    g_param_spec_enum("mode",
+                                                      "Mode",
+                                                      "Scheduling of the sink pads. strict: pads push in turns, a pad without data blocks the others. "
+                                                      "deadline: each pad has a bounded queue, the pads that have data are served by weight, and buffers that get old are dropped instead of blocking",
+                                                      GST_TYPE_HAILO_ROUND_ROBIN_MODE, (gint)DEFAULT_MODE,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_QUEUE_SIZE,
+                                    g_param_spec_uint("queue-size",
+                                                      "Queue size",
+                                                      "Deadline mode: number of buffers each sink pad queues, the oldest buffer is dropped when a new one arrives to a full queue",
+                                                      1, G_MAXUINT, DEFAULT_QUEUE_SIZE,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_MAX_LATENCY,
+                                    g_param_spec_uint("max-latency",
+                                                      "Max latency",
+                                                      "Deadline mode: time in milliseconds a buffer can wait in its queue before it is dropped, 0 does not drop by age",
+                                                      0, G_MAXUINT, DEFAULT_MAX_LATENCY,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_BATCH_SIZE,
+                                    g_param_spec_uint("batch-size",
+                                                      "Batch size",
+                                                      "Deadline mode: maximal number of buffers, each from a different sink pad, pushed together as one buffer list. 1 pushes single buffers",
+                                                      1, G_MAXUINT, DEFAULT_BATCH_SIZE,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+    g_object_class_install_property(gobject_class,
+                                    PROP_BATCH_TIMEOUT,
+                                    g_param_spec_uint("batch-timeout",
+                                                      "Batch timeout",
+                                                      "Deadline mode: time in milliseconds to wait for more sink pads to get ready before pushing a partial batch, 0 pushes the buffers that are ready",
+                                                      0, G_MAXUINT, DEFAULT_BATCH_TIMEOUT,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
 }
 
 static void
@@ -181,6 +444,14 @@ gst_hailo_round_robin_init(GstHailoRoundRobin *hailo_round_robin)
     hailo_round_robin->condition_vars.clear();
     hailo_round_robin->srcpad = gst_pad_new_from_static_template(&src_template, "src");
     hailo_round_robin->funnel_mode = false;
+    hailo_round_robin->mode = DEFAULT_MODE;
+    hailo_round_robin->queue_size = DEFAULT_QUEUE_SIZE;
+    hailo_round_robin->max_latency = DEFAULT_MAX_LATENCY;
+    hailo_round_robin->batch_size = DEFAULT_BATCH_SIZE;
+    hailo_round_robin->batch_timeout = DEFAULT_BATCH_TIMEOUT;
+    hailo_round_robin->virtual_time = 0.0;
+    hailo_round_robin->flushing = true;
+    hailo_round_robin->src_flow = GST_FLOW_OK;
     gst_pad_use_fixed_caps(hailo_round_robin->srcpad);
 
     gst_element_add_pad(GST_ELEMENT(hailo_round_robin), hailo_round_robin->srcpad);
@@ -273,6 +544,11 @@ gst_hailo_round_robin_release_pad(GstElement *element, GstPad *pad)
     GST_DEBUG_OBJECT(hailo_round_robin, "releasing pad %s:%s", GST_DEBUG_PAD_NAME(pad));
     gst_pad_set_active(pad, FALSE);
 
+    {
+        std::lock_guard<std::mutex> lock(hailo_round_robin->queue_mutex);
+        gst_hailo_round_robin_pad_flush(GST_HAILO_ROUND_ROBIN_PAD_CAST(pad));
+    }
+
     if (hailo_round_robin->condition_vars[get_pad_num(pad)] != NULL)
         hailo_round_robin->condition_vars[get_pad_num(pad)]->notify_all();
     gst_element_remove_pad(GST_ELEMENT_CAST(hailo_round_robin), pad);
@@ -291,12 +567,322 @@ forward_events(GstPad *pad, GstEvent **event, gpointer user_data)
 }
 
 
+/**
+ * Whether two sink pads got the same caps and segment, so their buffers can be pushed in one buffer list
+ * after the sticky events of either pad. The stream start is not compared, the stream meta of every buffer
+ * tells its stream apart.
+ */
+static bool
+gst_hailo_round_robin_same_format(GstPad *pad, GstPad *other_pad)
+{
+    if (pad == other_pad)
+        return true;
+
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    GstCaps *other_caps = gst_pad_get_current_caps(other_pad);
+    bool same = (caps == NULL && other_caps == NULL) ||
+                (caps != NULL && other_caps != NULL && gst_caps_is_equal(caps, other_caps));
+    if (caps != NULL)
+        gst_caps_unref(caps);
+    if (other_caps != NULL)
+        gst_caps_unref(other_caps);
+    if (!same)
+        return false;
+
+    GstEvent *segment_event = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+    GstEvent *other_segment_event = gst_pad_get_sticky_event(other_pad, GST_EVENT_SEGMENT, 0);
+    if (segment_event != NULL && other_segment_event != NULL)
+    {
+        const GstSegment *segment;
+        const GstSegment *other_segment;
+        gst_event_parse_segment(segment_event, &segment);
+        gst_event_parse_segment(other_segment_event, &other_segment);
+        same = gst_segment_is_equal(segment, other_segment);
+    }
+    else
+    {
+        same = segment_event == NULL && other_segment_event == NULL;
+    }
+    if (segment_event != NULL)
+        gst_event_unref(segment_event);
+    if (other_segment_event != NULL)
+        gst_event_unref(other_segment_event);
+    return same;
+}
+
+/**
+ * Deadline mode: pushes buffers [first, last) of a batch after the sticky events of the pad of the first one,
+ * as a single buffer or as a buffer list.
+ */
+static GstFlowReturn
+gst_hailo_round_robin_push_run(GstHailoRoundRobin *hailo_round_robin, std::vector<GstBuffer *> &batch,
+                               std::vector<GstHailoRoundRobinPad *> &batch_pads, size_t first, size_t last)
+{
+    gst_pad_sticky_events_foreach(GST_PAD_CAST(batch_pads[first]), forward_events, hailo_round_robin->srcpad);
+    if (last - first == 1)
+        return gst_pad_push(hailo_round_robin->srcpad, batch[first]);
+
+    GstBufferList *buffer_list = gst_buffer_list_new_sized(last - first);
+    for (size_t i = first; i < last; i++)
+        gst_buffer_list_add(buffer_list, batch[i]);
+    return gst_pad_push_list(hailo_round_robin->srcpad, buffer_list);
+}
+
+/**
+ * Adds the stream meta to a buffer, with the name and the stream id of the pad it was received on.
+ */
+static GstBuffer *
+gst_hailo_round_robin_add_stream_meta(GstPad *pad, GstBuffer *buf)
+{
+    buf = gst_buffer_make_writable(buf);
+
+    gchar *pad_name = gst_pad_get_name(pad);
+    gchar *stream_id = gst_pad_get_stream_id(pad);
+    gst_buffer_add_hailo_stream_meta(buf, pad_name, stream_id);
+    g_free(pad_name);
+    g_free(stream_id);
+
+    return buf;
+}
+
+/**
+ * Deadline mode: queues a buffer on its sink pad for the src task, never waits for other pads.
+ * When the queue of the pad is full its oldest buffer is dropped.
+ */
+static GstFlowReturn
+gst_hailo_round_robin_queue_buffer(GstHailoRoundRobin *hailo_round_robin, GstHailoRoundRobinPad *pad, GstBuffer *buf)
+{
+    buf = gst_hailo_round_robin_add_stream_meta(GST_PAD_CAST(pad), buf);
+
+    std::lock_guard<std::mutex> lock(hailo_round_robin->queue_mutex);
+    if (hailo_round_robin->flushing || (hailo_round_robin->src_flow != GST_FLOW_OK && hailo_round_robin->src_flow != GST_FLOW_NOT_LINKED))
+    {
+        gst_buffer_unref(buf);
+        return hailo_round_robin->flushing ? GST_FLOW_FLUSHING : hailo_round_robin->src_flow;
+    }
+
+    // A pad that had no data does not get credit for the time it was idle.
+    if (pad->queue->empty())
+        pad->pass = MAX(pad->pass, hailo_round_robin->virtual_time);
+
+    while (pad->queue->size() >= hailo_round_robin->queue_size)
+    {
+        GST_DEBUG_OBJECT(pad, "Queue is full, dropping the oldest buffer");
+        gst_hailo_round_robin_pad_drop_front(pad);
+    }
+    pad->queue->push_back({buf, g_get_monotonic_time()});
+    hailo_round_robin->queue_cond.notify_all();
+
+    return hailo_round_robin->src_flow;
+}
+
+/**
+ * Deadline mode: drops the buffers that waited longer than max-latency, and picks the pad to serve next.
+ * That is the pad with the lowest pass among the pads that have data and are not held back by their max-fps,
+ * so with time every pad gets a share of the pushed buffers relative to its weight.
+ * Called with the queue mutex locked.
+ *
+ * @param[in] hailo_round_robin   GstHailoRoundRobin.
+ * @param[in] now                 Monotonic time (us).
+ * @param[out] wakeup_time        Earliest time a pad that is held back by its max-fps gets ready, unchanged if none.
+ * @param[in] batch_pads          Pads that already have a buffer in the current batch, they are not picked again.
+ * @return The pad to serve, NULL if no pad is ready.
+ */
+static GstHailoRoundRobinPad *
+gst_hailo_round_robin_pick_pad(GstHailoRoundRobin *hailo_round_robin, gint64 now, gint64 *wakeup_time,
+                               const std::vector<GstHailoRoundRobinPad *> &batch_pads)
+{
+    GstHailoRoundRobinPad *next_pad = NULL;
+    gint64 max_age = (gint64)hailo_round_robin->max_latency * G_TIME_SPAN_MILLISECOND;
+
+    GST_OBJECT_LOCK(hailo_round_robin);
+    for (GList *item = GST_ELEMENT_CAST(hailo_round_robin)->sinkpads; item != NULL; item = g_list_next(item))
+    {
+        GstHailoRoundRobinPad *pad = GST_HAILO_ROUND_ROBIN_PAD_CAST(item->data);
+
+        while (hailo_round_robin->max_latency != 0 && !pad->queue->empty() &&
+               now - pad->queue->front().arrival_time > max_age)
+        {
+            GST_DEBUG_OBJECT(pad, "Dropping a buffer that waited more than %u ms", hailo_round_robin->max_latency);
+            gst_hailo_round_robin_pad_drop_front(pad);
+        }
+        if (pad->queue->empty() ||
+            std::find(batch_pads.begin(), batch_pads.end(), pad) != batch_pads.end())
+            continue;
+
+        if (pad->next_push_time > now)
+        {
+            *wakeup_time = MIN(*wakeup_time, pad->next_push_time);
+            continue;
+        }
+        if (next_pad == NULL || pad->pass < next_pad->pass)
+            next_pad = pad;
+    }
+    GST_OBJECT_UNLOCK(hailo_round_robin);
+
+    return next_pad;
+}
+
+/**
+ * Deadline mode: pops the next buffer of a pad picked by gst_hailo_round_robin_pick_pad, and updates its statistics and pass.
+ * Called with the queue mutex locked.
+ */
+static GstBuffer *
+gst_hailo_round_robin_serve_pad(GstHailoRoundRobin *hailo_round_robin, GstHailoRoundRobinPad *pad, gint64 now)
+{
+    RoundRobinQueuedBuffer queued = pad->queue->front();
+    pad->queue->pop_front();
+
+    gint64 latency = now - queued.arrival_time;
+    pad->frames_pushed++;
+    pad->total_latency += latency;
+    pad->max_latency = MAX(pad->max_latency, latency);
+    hailo_round_robin->virtual_time = pad->pass;
+    pad->pass += 1.0 / MAX(pad->weight, 1u);
+    if (pad->max_fps > 0.0)
+        pad->next_push_time = now + (gint64)(G_USEC_PER_SEC / pad->max_fps);
+
+    // Release the sink pads waiting for their queue to drain.
+    hailo_round_robin->queue_cond.notify_all();
+    return queued.buffer;
+}
+
+/**
+ * Deadline mode: waits on the queue condition until wakeup_time (G_MAXINT64 waits until signaled).
+ * The task runs with the src pad stream lock held, it is released while waiting so the events
+ * of the sink pads can be forwarded meanwhile. The stream lock is always taken before the queue mutex.
+ */
+static void
+gst_hailo_round_robin_wait(GstHailoRoundRobin *hailo_round_robin, std::unique_lock<std::mutex> &lock, gint64 now, gint64 wakeup_time)
+{
+    GST_PAD_STREAM_UNLOCK(hailo_round_robin->srcpad);
+    if (wakeup_time == G_MAXINT64)
+        hailo_round_robin->queue_cond.wait(lock);
+    else
+        hailo_round_robin->queue_cond.wait_for(lock, std::chrono::microseconds(wakeup_time - now));
+    lock.unlock();
+    GST_PAD_STREAM_LOCK(hailo_round_robin->srcpad);
+    lock.lock();
+}
+
+/**
+ * Deadline mode: the src pad task, pushes the queued buffers of the sink pads.
+ * With batch-size above 1, buffers of up to batch-size different pads are collected (waiting up to batch-timeout
+ * for pads to get ready) and pushed together as one buffer list.
+ */
+static void
+gst_hailo_round_robin_src_loop(GstHailoRoundRobin *hailo_round_robin)
+{
+    std::unique_lock<std::mutex> lock(hailo_round_robin->queue_mutex);
+
+    std::vector<GstBuffer *> batch;
+    std::vector<GstHailoRoundRobinPad *> batch_pads;
+    guint batch_size = MAX(hailo_round_robin->batch_size, 1u);
+    gint64 batch_deadline = 0;
+    while (!hailo_round_robin->flushing)
+    {
+        gint64 wakeup_time = G_MAXINT64;
+        gint64 now = g_get_monotonic_time();
+        GstHailoRoundRobinPad *pad = gst_hailo_round_robin_pick_pad(hailo_round_robin, now, &wakeup_time, batch_pads);
+        if (pad != NULL)
+        {
+            if (batch.empty())
+                batch_deadline = now + (gint64)hailo_round_robin->batch_timeout * G_TIME_SPAN_MILLISECOND;
+            batch.push_back(gst_hailo_round_robin_serve_pad(hailo_round_robin, pad, now));
+            batch_pads.push_back(GST_HAILO_ROUND_ROBIN_PAD_CAST(gst_object_ref(pad)));
+            if (batch.size() >= batch_size)
+                break;
+            continue;
+        }
+
+        if (!batch.empty())
+        {
+            // Push a partial batch once no other pad gets ready in time.
+            if (now >= batch_deadline)
+                break;
+            wakeup_time = MIN(wakeup_time, batch_deadline);
+        }
+        gst_hailo_round_robin_wait(hailo_round_robin, lock, now, wakeup_time);
+    }
+    bool flushing = hailo_round_robin->flushing;
+    lock.unlock();
+
+    if (flushing)
+    {
+        for (GstBuffer *buffer : batch)
+            gst_buffer_unref(buffer);
+        for (GstHailoRoundRobinPad *pad : batch_pads)
+            gst_object_unref(pad);
+        gst_pad_pause_task(hailo_round_robin->srcpad);
+        return;
+    }
+
+    // Forward the sticky events of the pads, so downstream gets the caps and segment of the stream of every buffer.
+    // A batch holds buffers of several streams, it is split where the caps or the segment change.
+    GstFlowReturn ret = GST_FLOW_OK;
+    size_t run_start = 0;
+    for (size_t i = 1; i <= batch.size(); i++)
+    {
+        if (i < batch.size() && gst_hailo_round_robin_same_format(GST_PAD_CAST(batch_pads[run_start]), GST_PAD_CAST(batch_pads[i])))
+            continue;
+        if (ret == GST_FLOW_OK)
+        {
+            ret = gst_hailo_round_robin_push_run(hailo_round_robin, batch, batch_pads, run_start, i);
+        }
+        else
+        {
+            for (size_t j = run_start; j < i; j++)
+                gst_buffer_unref(batch[j]);
+        }
+        run_start = i;
+    }
+    for (GstHailoRoundRobinPad *pad : batch_pads)
+        gst_object_unref(pad);
+
+    if (ret != GST_FLOW_OK)
+    {
+        lock.lock();
+        hailo_round_robin->src_flow = ret;
+        hailo_round_robin->queue_cond.notify_all();
+        lock.unlock();
+        if (ret != GST_FLOW_NOT_LINKED)
+        {
+            GST_DEBUG_OBJECT(hailo_round_robin, "Pausing task, reason %s", gst_flow_get_name(ret));
+            gst_pad_pause_task(hailo_round_robin->srcpad);
+        }
+    }
+}
+
+static void
+gst_hailo_round_robin_set_flushing(GstHailoRoundRobin *hailo_round_robin, bool flushing)
+{
+    std::lock_guard<std::mutex> lock(hailo_round_robin->queue_mutex);
+    hailo_round_robin->flushing = flushing;
+    if (!flushing)
+        hailo_round_robin->src_flow = GST_FLOW_OK;
+    hailo_round_robin->queue_cond.notify_all();
+}
+
+static void
+gst_hailo_round_robin_flush_pads(GstHailoRoundRobin *hailo_round_robin)
+{
+    std::lock_guard<std::mutex> lock(hailo_round_robin->queue_mutex);
+    GST_OBJECT_LOCK(hailo_round_robin);
+    for (GList *item = GST_ELEMENT_CAST(hailo_round_robin)->sinkpads; item != NULL; item = g_list_next(item))
+        gst_hailo_round_robin_pad_flush(GST_HAILO_ROUND_ROBIN_PAD_CAST(item->data));
+    GST_OBJECT_UNLOCK(hailo_round_robin);
+    hailo_round_robin->virtual_time = 0.0;
+}
+
 static GstFlowReturn
 gst_hailo_round_robin_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buf)
 {
     GstFlowReturn ret = GST_FLOW_ERROR;
     GstHailoRoundRobin *hailo_round_robin = GST_HAILO_ROUND_ROBIN_CAST(parent);
 
+    if (!hailo_round_robin->funnel_mode && hailo_round_robin->mode == HAILO_ROUND_ROBIN_MODE_DEADLINE)
+        return gst_hailo_round_robin_queue_buffer(hailo_round_robin, GST_HAILO_ROUND_ROBIN_PAD_CAST(pad), buf);
+
     size_t pad_num = get_pad_num(pad);
     if (!hailo_round_robin->funnel_mode && hailo_round_robin->current_pad_num != pad_num)
     {
@@ -322,13 +908,8 @@ gst_hailo_round_robin_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buf)
         }
     }
 
-    buf = gst_buffer_make_writable(buf);
-
-    gchar *pad_name = gst_pad_get_name(pad);
-    gchar *stream_id = gst_pad_get_stream_id(pad);
-
     // Add stream meta to the buffer including the pad name and stream id.
-    gst_buffer_add_hailo_stream_meta(buf, pad_name, stream_id);
+    buf = gst_hailo_round_robin_add_stream_meta(pad, buf);
 
     // Forward sticky events.
     gst_pad_sticky_events_foreach(pad, forward_events, hailo_round_robin->srcpad);
@@ -336,9 +917,6 @@ gst_hailo_round_robin_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buf)
     // Push out_buffer forward.
     ret = gst_pad_push(hailo_round_robin->srcpad, buf);
 
-    g_free(pad_name);
-    g_free(stream_id);
-
     if (!hailo_round_robin->funnel_mode)
     {
         // Update current pad num.
@@ -370,6 +948,33 @@ gst_hailo_round_robin_sink_event(GstPad *pad, GstObject *parent, GstEvent *event
 
     GST_DEBUG_OBJECT(pad, "received event %" GST_PTR_FORMAT, event);
 
+    bool deadline_mode = hailo_round_robin->mode == HAILO_ROUND_ROBIN_MODE_DEADLINE;
+    if (deadline_mode)
+    {
+        if (GST_EVENT_TYPE(event) == GST_EVENT_EOS)
+        {
+            // Let the src task push the buffers queued on this pad before the eos.
+            std::unique_lock<std::mutex> lock(hailo_round_robin->queue_mutex);
+            hailo_round_robin->queue_cond.wait(lock, [&]
+                                               { return hailo_round_robin->flushing || fpad->queue->empty() ||
+                                                        (hailo_round_robin->src_flow != GST_FLOW_OK && hailo_round_robin->src_flow != GST_FLOW_NOT_LINKED); });
+        }
+        else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_START)
+        {
+            std::lock_guard<std::mutex> lock(hailo_round_robin->queue_mutex);
+            gst_hailo_round_robin_pad_flush(fpad);
+        }
+        else if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP)
+        {
+            // The task pauses when downstream is flushing, start it again.
+            {
+                std::lock_guard<std::mutex> lock(hailo_round_robin->queue_mutex);
+                hailo_round_robin->src_flow = GST_FLOW_OK;
+            }
+            gst_pad_start_task(hailo_round_robin->srcpad, (GstTaskFunction)gst_hailo_round_robin_src_loop, hailo_round_robin, NULL);
+        }
+    }
+
     if (GST_EVENT_IS_STICKY(event))
     {
         unlock = TRUE;
@@ -386,8 +991,9 @@ gst_hailo_round_robin_sink_event(GstPad *pad, GstObject *parent, GstEvent *event
             forward = gst_hailo_round_robin_all_sinkpads_eos_unlocked(hailo_round_robin);
             GST_OBJECT_UNLOCK(hailo_round_robin);
         }
-        else if (pad_num != hailo_round_robin->current_pad_num)
+        else if (deadline_mode || pad_num != hailo_round_robin->current_pad_num)
         {
+            // In deadline mode the sticky events of a pad are forwarded with each of its buffers.
             forward = FALSE;
         }
     }
@@ -436,11 +1042,21 @@ gst_hailo_round_robin_change_state(GstElement *element, GstStateChange transitio
 
     switch (transition)
     {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+    {
+        gst_hailo_round_robin_set_flushing(hailo_round_robin, false);
+        break;
+    }
     case GST_STATE_CHANGE_PAUSED_TO_READY:
     {
         for (uint i=0; i < hailo_round_robin->condition_vars.size(); i++)
             if (hailo_round_robin->condition_vars[i] != NULL)
                 hailo_round_robin->condition_vars[i]->notify_all();
+        if (hailo_round_robin->mode == HAILO_ROUND_ROBIN_MODE_DEADLINE)
+        {
+            gst_hailo_round_robin_set_flushing(hailo_round_robin, true);
+            gst_pad_stop_task(hailo_round_robin->srcpad);
+        }
         break;
     }
     default: 
@@ -448,5 +1064,14 @@ gst_hailo_round_robin_change_state(GstElement *element, GstStateChange transitio
     }
     ret = GST_ELEMENT_CLASS(parent_class)->change_state(element, transition);
 
+    if (ret == GST_STATE_CHANGE_FAILURE)
+        return ret;
+
+    // The src task starts once the pads are active.
+    if (transition == GST_STATE_CHANGE_READY_TO_PAUSED && hailo_round_robin->mode == HAILO_ROUND_ROBIN_MODE_DEADLINE)
+        gst_pad_start_task(hailo_round_robin->srcpad, (GstTaskFunction)gst_hailo_round_robin_src_loop, hailo_round_robin, NULL);
+    else if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+        gst_hailo_round_robin_flush_pads(hailo_round_robin);
+
     return ret;
 }
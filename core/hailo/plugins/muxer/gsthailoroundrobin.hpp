@@ -30,6 +30,12 @@ G_BEGIN_DECLS
     (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_HAILO_ROUND_ROBIN))
 #define GST_HAILO_ROUND_ROBIN_CAST(obj) ((GstHailoRoundRobin *)(obj))
 
+typedef enum
+{
+    HAILO_ROUND_ROBIN_MODE_STRICT,   // Pads push in turns, each pad waits for its turn
+    HAILO_ROUND_ROBIN_MODE_DEADLINE, // Pads queue their buffers, a src task serves the pads that have data
+} GstHailoRoundRobinMode;
+
 typedef struct _GstHailoRoundRobin GstHailoRoundRobin;
 typedef struct _GstHailoRoundRobinClass GstHailoRoundRobinClass;
 
@@ -47,6 +53,18 @@ struct _GstHailoRoundRobin
     gboolean funnel_mode;
     std::vector<std::unique_ptr<std::mutex>> mutexes;
     std::vector<std::unique_ptr<std::condition_variable>> condition_vars;
+
+    // Deadline mode
+    GstHailoRoundRobinMode mode;
+    guint queue_size;
+    guint max_latency;
+    guint batch_size;
+    guint batch_timeout;
+    std::mutex queue_mutex;             // Guards the queues and the scheduling state of the sink pads
+    std::condition_variable queue_cond; // Signaled when buffers are queued or served
+    gdouble virtual_time;               // Pass of the last served pad, for weighted fairness
+    bool flushing;
+    GstFlowReturn src_flow;             // Last flow return of the src task, returned by the sink pads
 };
 
 struct _GstHailoRoundRobinClass
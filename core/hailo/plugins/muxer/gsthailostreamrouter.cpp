@@ -9,6 +9,7 @@
 #include "gsthailostreamrouter.hpp"
 #include "gst_hailo_meta.hpp"
 #include "gst_hailo_stream_meta.hpp"
+#include <algorithm>
 #include <iostream>
 #include <gst/gst.h>
 
@@ -78,6 +79,7 @@ static void gst_hailo_stream_router_release_pad(GstElement *element, GstPad *pad
 
 static GstStateChangeReturn gst_hailo_stream_router_change_state(GstElement *element, GstStateChange transition);
 static GstFlowReturn gst_hailo_stream_router_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer);
+static GstFlowReturn gst_hailo_stream_router_sink_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list);
 
 static void gst_hailo_stream_router_pad_set_property(GObject *object, guint prop_id,
                                                      const GValue *value, GParamSpec *pspec);
@@ -133,13 +135,17 @@ gst_hailo_stream_router_init(GstHailoStreamRouter *hailo_stream_router)
 {
     // Configure sink pad
     hailo_stream_router->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
-    // Initialize hash table (of key -> value: input stream name -> target src_pads)
-    hailo_stream_router->targets_table = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_array_unref);
+    // The routing table (input stream name -> target src_pads) is built once pads are configured
+    hailo_stream_router->routing_table = NULL;
+    hailo_stream_router->routing_readers = 0;
+    hailo_stream_router->retired_tables = std::vector<const StreamRouterTable *>();
+    hailo_stream_router->has_retired_tables = false;
 
     // Initialize element mutex
     g_mutex_init(&hailo_stream_router->lock);
 
     gst_pad_set_chain_function(hailo_stream_router->sinkpad, GST_DEBUG_FUNCPTR(gst_hailo_stream_router_sink_chain));
+    gst_pad_set_chain_list_function(hailo_stream_router->sinkpad, GST_DEBUG_FUNCPTR(gst_hailo_stream_router_sink_chain_list));
     gst_pad_set_event_function(hailo_stream_router->sinkpad, GST_DEBUG_FUNCPTR(gst_hailo_stream_router_sink_event));
     // gst_pad_set_query_function(hailo_stream_router->sinkpad, GST_DEBUG_FUNCPTR(gst_hailo_stream_router_sink_query));
     GST_PAD_SET_PROXY_CAPS(hailo_stream_router->sinkpad);
@@ -154,49 +160,116 @@ gst_hailo_stream_router_dispose(GObject *object)
     G_OBJECT_CLASS(parent_class)->dispose(object);
 }
 
-static gpointer
-gst_pads_lookup(GstHailoStreamRouter *hailo_stream_router, const gchar *input_pad_name)
+static const std::vector<GstPad *> *
+gst_pads_lookup(const StreamRouterTable *table, const gchar *input_pad_name)
 {
-    g_mutex_lock(&hailo_stream_router->lock);
-    gpointer pads_ptr;
-    pads_ptr = g_hash_table_lookup(hailo_stream_router->targets_table, (gpointer)input_pad_name);
-    g_mutex_unlock(&hailo_stream_router->lock);
-    return pads_ptr;
+    if (table == NULL)
+        return NULL;
+    auto target = table->targets.find(std::string_view(input_pad_name));
+    return target != table->targets.end() ? &target->second : NULL;
 }
 
 static void
-insert_new_srcpad_to_target_pads_table(GstHailoStreamRouter *hailo_stream_router, GstHailoStreamRouterPad *router_srcpad)
+gst_hailo_stream_router_free_table(const StreamRouterTable *table)
 {
-    // Iterate over the input stream names configured in the pad's properties
-    guint i;
-    for (i = 0; i < router_srcpad->num_input_streams; i++)
+    for (auto &target : table->targets)
+        for (GstPad *pad : target.second)
+            gst_object_unref(pad);
+    delete table;
+}
+
+/**
+ * Frees the retired routing tables if no chain call is routing. Called with the lock held.
+ * A chain call that starts after the check loads the current table, retired tables were already swapped out.
+ */
+static void
+gst_hailo_stream_router_reclaim_tables(GstHailoStreamRouter *hailo_stream_router)
+{
+    if (hailo_stream_router->routing_readers.load() != 0)
+        return;
+    for (const StreamRouterTable *retired : hailo_stream_router->retired_tables)
+        gst_hailo_stream_router_free_table(retired);
+    hailo_stream_router->retired_tables.clear();
+    hailo_stream_router->has_retired_tables = false;
+}
+
+/**
+ * Starts routing a buffer, the returned table stays valid until gst_hailo_stream_router_end_routing.
+ */
+static const StreamRouterTable *
+gst_hailo_stream_router_begin_routing(GstHailoStreamRouter *hailo_stream_router)
+{
+    hailo_stream_router->routing_readers.fetch_add(1);
+    return hailo_stream_router->routing_table.load();
+}
+
+static void
+gst_hailo_stream_router_end_routing(GstHailoStreamRouter *hailo_stream_router)
+{
+    // The last reader out frees the tables that were retired while it was routing
+    if (hailo_stream_router->routing_readers.fetch_sub(1) == 1 && hailo_stream_router->has_retired_tables.load())
     {
-        // Get the input stream name
-        const char *input_pad_name = router_srcpad->input_streams[i];
-        // Get the array of pads from the hash table
-        gpointer pads_ptr = gst_pads_lookup(hailo_stream_router, input_pad_name);
-        if (pads_ptr)
-        {
-            g_mutex_lock(&hailo_stream_router->lock);
-            // Add router_srcpad to the pads GArray
-            GArray *pads = (GArray *)pads_ptr;
-            g_array_append_val(pads, router_srcpad);
-
-            // Replace the pads GArray in the hash table with the new one
-            g_hash_table_replace(hailo_stream_router->targets_table, (gpointer)input_pad_name, (gpointer)pads);
-            g_mutex_unlock(&hailo_stream_router->lock);
-        }
-        else
+        g_mutex_lock(&hailo_stream_router->lock);
+        gst_hailo_stream_router_reclaim_tables(hailo_stream_router);
+        g_mutex_unlock(&hailo_stream_router->lock);
+    }
+}
+
+/**
+ * Builds a new routing table from the input-streams of the src pads, and publishes it.
+ * The previous table is retired, and freed once no chain call may still be routing with it.
+ *
+ * @param hailo_stream_router The stream_router element
+ * @param removed_pad A src pad that is being released and should not be routed to, or NULL
+ */
+static void
+gst_hailo_stream_router_update_routing_table(GstHailoStreamRouter *hailo_stream_router, GstPad *removed_pad)
+{
+    StreamRouterTable *table = new StreamRouterTable();
+
+    GST_OBJECT_LOCK(hailo_stream_router);
+    // Iterate over the src_pads of the element, and over the input stream names configured in their properties
+    for (GList *item = GST_ELEMENT_CAST(hailo_stream_router)->srcpads; item; item = item->next)
+    {
+        GstHailoStreamRouterPad *router_srcpad = GST_HAILO_STREAM_ROUTER_PAD(item->data);
+        if (GST_PAD_CAST(router_srcpad) == removed_pad)
+            continue;
+
+        g_mutex_lock(&router_srcpad->lock);
+        for (guint i = 0; i < router_srcpad->num_input_streams; i++)
         {
-            // Create a new GArray of pads and add router_srcpad to it
-            GArray *pads = g_array_sized_new(FALSE, FALSE, sizeof(GstHailoStreamRouterPad *), router_srcpad->num_input_streams);
-            g_mutex_lock(&hailo_stream_router->lock);
-            g_array_append_val(pads, router_srcpad);
-            // Add input_pad_name as key and GArray of pads as value to the hash table if both doesn't already exist
-            g_hash_table_insert(hailo_stream_router->targets_table, (gpointer)input_pad_name, (gpointer)pads);
-            g_mutex_unlock(&hailo_stream_router->lock);
+            std::string_view input_pad_name(g_intern_string(router_srcpad->input_streams[i]));
+            table->targets[input_pad_name].push_back(GST_PAD_CAST(gst_object_ref(router_srcpad)));
         }
+        g_mutex_unlock(&router_srcpad->lock);
+    }
+    GST_OBJECT_UNLOCK(hailo_stream_router);
+
+    g_mutex_lock(&hailo_stream_router->lock);
+    // Sequentially consistent with begin_routing: a reader counted after the swap can only load the new table
+    const StreamRouterTable *previous = hailo_stream_router->routing_table.exchange(table);
+    if (previous != NULL)
+    {
+        hailo_stream_router->retired_tables.push_back(previous);
+        hailo_stream_router->has_retired_tables = true;
     }
+    gst_hailo_stream_router_reclaim_tables(hailo_stream_router);
+    g_mutex_unlock(&hailo_stream_router->lock);
+}
+
+/**
+ * Frees the current and the retired routing tables. Called when no streaming thread routes buffers.
+ */
+static void
+gst_hailo_stream_router_free_routing_tables(GstHailoStreamRouter *hailo_stream_router)
+{
+    const StreamRouterTable *table = hailo_stream_router->routing_table.exchange(NULL, std::memory_order_acq_rel);
+    if (table != NULL)
+        gst_hailo_stream_router_free_table(table);
+    for (const StreamRouterTable *retired : hailo_stream_router->retired_tables)
+        gst_hailo_stream_router_free_table(retired);
+    std::vector<const StreamRouterTable *>().swap(hailo_stream_router->retired_tables);
+    hailo_stream_router->has_retired_tables = false;
 }
 
 static void
@@ -220,13 +293,8 @@ gst_hailo_stream_router_reset(GstHailoStreamRouter *hailo_stream_router)
         hailo_stream_router->sinkpad = NULL;
     }
 
-    if (hailo_stream_router->targets_table != NULL)
-    {
-        g_hash_table_remove_all(hailo_stream_router->targets_table);
-        g_hash_table_unref(hailo_stream_router->targets_table);
-        hailo_stream_router->targets_table = NULL;
-    }
     GST_OBJECT_UNLOCK(hailo_stream_router);
+    gst_hailo_stream_router_free_routing_tables(hailo_stream_router);
 
     GstIterator *it = NULL;
     GstIteratorResult itret = GST_ITERATOR_OK;
@@ -270,14 +338,8 @@ gst_hailo_stream_router_change_state(GstElement *element, GstStateChange transit
     {
     case GST_STATE_CHANGE_READY_TO_PAUSED:
     {
-        // Prepare hash table of pads (key -> value: input stream name -> target src_pads)
-        GList *item;
-        // Iterate over the src_pads of the element
-        for (item = element->srcpads; item; item = item->next)
-        {
-            GstHailoStreamRouterPad *router_srcpad = GST_HAILO_STREAM_ROUTER_PAD(item->data);
-            insert_new_srcpad_to_target_pads_table(hailo_stream_router, router_srcpad);
-        }
+        // Prepare the routing table (key -> value: input stream name -> target src_pads)
+        gst_hailo_stream_router_update_routing_table(hailo_stream_router, NULL);
         break;
     }
     case GST_STATE_CHANGE_PAUSED_TO_READY:
@@ -424,17 +486,14 @@ gst_hailo_stream_router_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *bu
     // Get the input stream name from the stream metadata on the buffer
     gchar *input_pad_name = gst_buffer_get_hailo_stream_meta(buffer)->pad_name;
 
-    // Lookup for the input stream name key and get it's value (target pads array) from the hash table
-    gpointer pads_ptr = gst_pads_lookup(stream_router, input_pad_name);
-    if (pads_ptr)
+    // Lookup for the input stream name key and get it's value (target pads array) from the routing table
+    const StreamRouterTable *table = gst_hailo_stream_router_begin_routing(stream_router);
+    const std::vector<GstPad *> *src_pads = gst_pads_lookup(table, input_pad_name);
+    if (src_pads)
     {
-        guint i;
-        GArray *src_pads = (GArray *)pads_ptr;
-        GstHailoStreamRouterPad *src_pad;
         // Iterate over the target src_pads
-        for (i = 0; i < src_pads->len; i++)
+        for (GstPad *src_pad : *src_pads)
         {
-            src_pad = (GstHailoStreamRouterPad *)g_array_index(src_pads, GstHailoStreamRouterPad *, i);
             if (GST_IS_PAD(src_pad))
             {
                 // Forward sticky events.
@@ -447,11 +506,78 @@ gst_hailo_stream_router_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *bu
             }
         }
     }
+    gst_hailo_stream_router_end_routing(stream_router);
 
     gst_buffer_unref(buffer);
     return result;
 }
 
+/**
+ * Chain list method of the sink pad
+ * On incomming batch of buffers (e.g. from hailoroundrobin with batch-size), split it by target src_pad,
+ * and forward to each src_pad the list of its buffers, in their original order.
+ *
+ * @param pad  The sink pad
+ * @param parent GstObject stream_router element
+ * @param list Incomming batch (GstBufferList)
+ * @return GstFlowReturn
+ */
+static GstFlowReturn
+gst_hailo_stream_router_sink_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    GstHailoStreamRouter *stream_router = GST_HAILO_STREAM_ROUTER(parent);
+
+    GstFlowReturn result = GST_FLOW_OK;
+    std::vector<std::pair<GstPad *, GstBufferList *>> targets;
+
+    // The target pads are referenced by the table, it is held until they are pushed to
+    const StreamRouterTable *table = gst_hailo_stream_router_begin_routing(stream_router);
+    guint length = gst_buffer_list_length(list);
+    for (guint i = 0; i < length; i++)
+    {
+        GstBuffer *buffer = gst_buffer_list_get(list, i);
+        GstHailoStreamMeta *stream_meta = gst_buffer_get_hailo_stream_meta(buffer);
+        if (stream_meta == NULL)
+        {
+            GST_WARNING_OBJECT(stream_router, "Buffer without stream meta in a batch, dropping it");
+            continue;
+        }
+
+        // Lookup for the input stream name key and get it's value (target pads array) from the routing table
+        const std::vector<GstPad *> *src_pads = gst_pads_lookup(table, stream_meta->pad_name);
+        if (!src_pads)
+            continue;
+
+        for (GstPad *src_pad : *src_pads)
+        {
+            if (!GST_IS_PAD(src_pad))
+                continue;
+
+            auto target = std::find_if(targets.begin(), targets.end(),
+                                       [src_pad](const std::pair<GstPad *, GstBufferList *> &t)
+                                       { return t.first == src_pad; });
+            if (target == targets.end())
+                target = targets.insert(targets.end(), std::make_pair(src_pad, gst_buffer_list_new_sized(length)));
+            gst_buffer_list_add(target->second, gst_buffer_copy(buffer));
+        }
+    }
+    gst_buffer_list_unref(list);
+
+    for (auto &target : targets)
+    {
+        // Forward sticky events.
+        gst_pad_sticky_events_foreach(pad, forward_events, target.first);
+
+        // Push the buffers of the src_pad
+        GstFlowReturn target_result = gst_pad_push_list(target.first, target.second);
+        if (result == GST_FLOW_OK)
+            result = target_result;
+    }
+    gst_hailo_stream_router_end_routing(stream_router);
+
+    return result;
+}
+
 static void
 gst_hailo_stream_router_pad_set_property(GObject *object, guint prop_id,
                                          const GValue *value, GParamSpec *pspec)
@@ -462,10 +588,20 @@ gst_hailo_stream_router_pad_set_property(GObject *object, guint prop_id,
     switch (prop_id)
     {
     case PROP_PAD_INPUT_STREAMS:
+    {
         g_mutex_lock(&pad->lock);
         set_input_streams(pad, value);
         g_mutex_unlock(&pad->lock);
+
+        // Publish a routing table with the new input streams, streaming may already be running.
+        GstObject *parent = gst_object_get_parent(GST_OBJECT_CAST(pad));
+        if (parent != NULL)
+        {
+            gst_hailo_stream_router_update_routing_table(GST_HAILO_STREAM_ROUTER(parent), NULL);
+            gst_object_unref(parent);
+        }
         break;
+    }
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -526,6 +662,8 @@ gst_hailo_stream_router_release_pad(GstElement *element, GstPad *pad)
 {
     GstHailoStreamRouter *hailo_stream_router = GST_HAILO_STREAM_ROUTER(element);
     GST_DEBUG_OBJECT(hailo_stream_router, "releasing pad %s:%s", GST_DEBUG_PAD_NAME(pad));
+    // Stop routing to the pad before it is deactivated.
+    gst_hailo_stream_router_update_routing_table(hailo_stream_router, pad);
     gst_pad_set_active(pad, FALSE);
     gst_element_remove_pad(GST_ELEMENT_CAST(hailo_stream_router), pad);
 }
@@ -12,6 +12,9 @@
 #pragma once
 
 #include <gst/gst.h>
+#include <atomic>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 G_BEGIN_DECLS
@@ -30,6 +33,15 @@ G_BEGIN_DECLS
   (G_TYPE_CHECK_CLASS_TYPE((klass), GST_TYPE_HAILO_STREAM_ROUTER))
 #define GST_HAILO_STREAM_ROUTER_CAST(obj) ((GstHailoStreamRouter *)(obj))
 
+/**
+ * Immutable routing table: input stream name -> target src pads (referenced).
+ * Keys point to interned strings (g_intern_string), so they stay valid as long as the table.
+ */
+struct StreamRouterTable
+{
+  std::unordered_map<std::string_view, std::vector<GstPad *>> targets;
+};
+
 typedef struct _GstHailoStreamRouter GstHailoStreamRouter;
 typedef struct _GstHailoStreamRouterClass GstHailoStreamRouterClass;
 
@@ -45,7 +57,13 @@ struct _GstHailoStreamRouter
 
   GstPad *sinkpad;
   GMutex lock;
-  GHashTable *targets_table;
+  // Published with an atomic swap whenever the src pads or their input-streams change, read without a lock when routing.
+  std::atomic<const StreamRouterTable *> routing_table;
+  // Number of chain calls routing with a table, a retired table is freed once it drops to zero.
+  std::atomic<guint> routing_readers;
+  // Replaced tables, a chain call may still read them. Guarded by lock, has_retired_tables is set while it is not empty.
+  std::vector<const StreamRouterTable *> retired_tables;
+  std::atomic<bool> has_retired_tables;
 };
 
 struct _GstHailoStreamRouterClass
@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Throughput of the hailoroundrobin deadline src task by batch size.
+  The queues of all the pads are filled while the src pad is blocked, then the time to push all of them downstream is measured.
+  With mixed caps every other pad has different caps, so the batches are split.
+  Usage: hailoroundrobin_benchmark [pads] [buffers per pad]
+*/
+
+// General cpp includes
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Gstreamer includes
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+// Tappas includes
+#include "muxer/gsthailoroundrobin.hpp"
+
+static GstPadProbeReturn block_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    return GST_PAD_PROBE_OK;
+}
+
+static guint64 frames_pushed(GstElement *element)
+{
+    guint64 value;
+    GstPad *sinkpad = gst_element_get_static_pad(element, "sink_0");
+    g_object_get(sinkpad, "frames-pushed", &value, NULL);
+    gst_object_unref(sinkpad);
+    return value;
+}
+
+static double buffers_per_second(guint num_pads, guint buffers_per_pad, guint batch_size, bool mixed_caps)
+{
+    GstElement *element = gst_element_factory_make("hailoroundrobin", NULL);
+    g_object_set(element, "queue-size", buffers_per_pad, "batch-size", batch_size, NULL);
+    gst_util_set_object_arg(G_OBJECT(element), "mode", "deadline");
+    std::vector<GstHarness *> pads;
+    for (guint i = 0; i < num_pads; i++)
+    {
+        gchar *pad_name = g_strdup_printf("sink_%u", i);
+        GstHarness *pad = gst_harness_new_with_element(element, pad_name, i == 0 ? "src" : NULL);
+        gst_harness_set_src_caps_str(pad, mixed_caps && i % 2 ? "video/x-raw,width=320" : "video/x-raw,width=640");
+        pads.push_back(pad);
+        g_free(pad_name);
+    }
+
+    // Hold the src task on a primer buffer while the queues are filled
+    GstPad *srcpad = gst_element_get_static_pad(element, "src");
+    gulong probe = gst_pad_add_probe(srcpad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_DATA_DOWNSTREAM),
+                                     block_probe, NULL, NULL);
+    gst_harness_push(pads[0], gst_buffer_new());
+    while (frames_pushed(element) == 0)
+        g_usleep(1000);
+    for (guint index = 0; index < buffers_per_pad; index++)
+        for (GstHarness *pad : pads)
+            gst_harness_push(pad, gst_buffer_new());
+
+    gint64 start = g_get_monotonic_time();
+    gst_pad_remove_probe(srcpad, probe);
+    guint total = num_pads * buffers_per_pad + 1;
+    while (gst_harness_buffers_received(pads[0]) < total)
+        g_usleep(100);
+    gint64 elapsed = g_get_monotonic_time() - start;
+    gst_object_unref(srcpad);
+
+    for (auto it = pads.rbegin(); it != pads.rend(); ++it)
+        gst_harness_teardown(*it);
+    gst_object_unref(element);
+    return (double)(total - 1) * G_USEC_PER_SEC / elapsed;
+}
+
+int main(int argc, char **argv)
+{
+    gst_init(&argc, &argv);
+    gst_element_register(NULL, "hailoroundrobin", GST_RANK_NONE, GST_TYPE_HAILO_ROUND_ROBIN);
+    guint num_pads = argc > 1 ? std::atoi(argv[1]) : 8;
+    guint buffers_per_pad = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+    std::printf("pads %u, buffers per pad %u\n", num_pads, buffers_per_pad);
+    std::printf("%-12s %18s %18s\n", "batch-size", "same caps buf/s", "mixed caps buf/s");
+    for (guint batch_size : {1u, 2u, 4u, 8u})
+        std::printf("%-12u %18.0f %18.0f\n", batch_size,
+                    buffers_per_second(num_pads, buffers_per_pad, batch_size, false),
+                    buffers_per_second(num_pads, buffers_per_pad, batch_size, true));
+    return 0;
+}
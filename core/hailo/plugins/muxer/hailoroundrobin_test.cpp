@@ -0,0 +1,296 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of hailoroundrobin in deadline mode: while several pads have data they are served relative to their weights,
+  buffers that waited more than max-latency are dropped, and a batch is split where the caps of its streams change.
+  The src pad is blocked while the queues are filled, so the order of the pushes depends only on the scheduling.
+*/
+
+// General cpp includes
+#include <iostream>
+#include <vector>
+
+// Gstreamer includes
+#include <gst/gst.h>
+#include <gst/check/gstharness.h>
+
+// Tappas includes
+#include "muxer/gsthailoroundrobin.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+// Buffers are tagged by offset: pad number * PAD_OFFSET + index
+#define PAD_OFFSET (1000)
+
+struct RoundRobinHarness
+{
+    GstElement *element;
+    std::vector<GstHarness *> pads; // The harness of pad 0 also holds the src pad
+    gulong block_probe;
+};
+
+static RoundRobinHarness round_robin_new(guint num_pads, guint queue_size, guint max_latency, guint batch_size = 1)
+{
+    RoundRobinHarness harness;
+    harness.element = gst_element_factory_make("hailoroundrobin", NULL);
+    g_object_set(harness.element, "queue-size", queue_size, "max-latency", max_latency, "batch-size", batch_size, NULL);
+    gst_util_set_object_arg(G_OBJECT(harness.element), "mode", "deadline");
+    for (guint i = 0; i < num_pads; i++)
+    {
+        gchar *pad_name = g_strdup_printf("sink_%u", i);
+        GstHarness *pad = gst_harness_new_with_element(harness.element, pad_name, i == 0 ? "src" : NULL);
+        gst_harness_set_src_caps_str(pad, "video/x-raw");
+        harness.pads.push_back(pad);
+        g_free(pad_name);
+    }
+    harness.block_probe = 0;
+    return harness;
+}
+
+static void round_robin_free(RoundRobinHarness &harness)
+{
+    for (auto it = harness.pads.rbegin(); it != harness.pads.rend(); ++it)
+        gst_harness_teardown(*it);
+    gst_object_unref(harness.element);
+}
+
+static GstPad *sink_pad(RoundRobinHarness &harness, guint pad)
+{
+    gchar *pad_name = g_strdup_printf("sink_%u", pad);
+    GstPad *sinkpad = gst_element_get_static_pad(harness.element, pad_name);
+    g_free(pad_name);
+    return sinkpad;
+}
+
+static void set_weight(RoundRobinHarness &harness, guint pad, guint weight)
+{
+    GstPad *sinkpad = sink_pad(harness, pad);
+    g_object_set(sinkpad, "weight", weight, NULL);
+    gst_object_unref(sinkpad);
+}
+
+static guint64 pad_counter(RoundRobinHarness &harness, guint pad, const gchar *name)
+{
+    guint64 value;
+    GstPad *sinkpad = sink_pad(harness, pad);
+    g_object_get(sinkpad, name, &value, NULL);
+    gst_object_unref(sinkpad);
+    return value;
+}
+
+static void push(RoundRobinHarness &harness, guint pad, guint index)
+{
+    GstBuffer *buffer = gst_buffer_new();
+    GST_BUFFER_OFFSET(buffer) = pad * PAD_OFFSET + index;
+    CHECK(gst_harness_push(harness.pads[pad], buffer) == GST_FLOW_OK);
+}
+
+static guint pull_pad(RoundRobinHarness &harness)
+{
+    GstBuffer *buffer = gst_harness_pull(harness.pads[0]);
+    if (buffer == NULL)
+        return G_MAXUINT;
+    guint pad = GST_BUFFER_OFFSET(buffer) / PAD_OFFSET;
+    gst_buffer_unref(buffer);
+    return pad;
+}
+
+static GstPadProbeReturn block_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    return GST_PAD_PROBE_OK;
+}
+
+/**
+ * Blocks the src task on its next push: a primer buffer is pushed on pad 0 and served,
+ * so the task waits in the probe while the queues are filled.
+ */
+static void block_src(RoundRobinHarness &harness)
+{
+    GstPad *srcpad = gst_element_get_static_pad(harness.element, "src");
+    harness.block_probe = gst_pad_add_probe(srcpad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_DATA_DOWNSTREAM),
+                                            block_probe, NULL, NULL);
+    gst_object_unref(srcpad);
+    guint64 pushed = pad_counter(harness, 0, "frames-pushed");
+    push(harness, 0, PAD_OFFSET - 1);
+    while (pad_counter(harness, 0, "frames-pushed") == pushed)
+        g_usleep(1000);
+}
+
+static void unblock_src(RoundRobinHarness &harness)
+{
+    GstPad *srcpad = gst_element_get_static_pad(harness.element, "src");
+    gst_pad_remove_probe(srcpad, harness.block_probe);
+    gst_object_unref(srcpad);
+    CHECK(pull_pad(harness) == 0); // The primer
+}
+
+static void test_weights()
+{
+    const guint weights[] = {1, 3, 2};
+    const guint queued = 60;
+    RoundRobinHarness harness = round_robin_new(3, queued, 0);
+    for (guint pad = 0; pad < 3; pad++)
+        set_weight(harness, pad, weights[pad]);
+
+    block_src(harness);
+    for (guint index = 0; index < queued; index++)
+        for (guint pad = 0; pad < 3; pad++)
+            push(harness, pad, index);
+    unblock_src(harness);
+
+    // While all the queues have data, every 6 pushes serve the pads 1, 3 and 2 times.
+    // The primer already put pad 0 one push ahead.
+    guint served[3] = {0, 0, 0};
+    const guint rounds = 10;
+    for (guint i = 0; i < rounds * 6; i++)
+    {
+        guint pad = pull_pad(harness);
+        CHECK(pad < 3);
+        if (pad < 3)
+            served[pad]++;
+    }
+    std::cout << "served by weight 1:3:2 -> " << served[0] << ":" << served[1] << ":" << served[2] << std::endl;
+    for (guint pad = 0; pad < 3; pad++)
+        CHECK(served[pad] + 2 >= rounds * weights[pad] && served[pad] <= rounds * weights[pad] + 2);
+
+    // The rest drains, nothing is dropped
+    for (guint i = rounds * 6; i < 3 * queued; i++)
+        CHECK(pull_pad(harness) < 3);
+    for (guint pad = 0; pad < 3; pad++)
+        CHECK(pad_counter(harness, pad, "frames-dropped") == 0);
+    CHECK(pad_counter(harness, 0, "frames-pushed") == queued + 1);
+    CHECK(pad_counter(harness, 1, "frames-pushed") == queued);
+    round_robin_free(harness);
+}
+
+static void test_late_buffers()
+{
+    const guint max_latency = 20;
+    RoundRobinHarness harness = round_robin_new(2, 8, max_latency);
+
+    block_src(harness);
+    for (guint index = 0; index < 5; index++)
+        push(harness, 0, index);
+    g_usleep(3 * max_latency * 1000);
+    for (guint index = 0; index < 2; index++)
+        push(harness, 1, index);
+    unblock_src(harness);
+
+    // The buffers of pad 0 got older than max-latency while the src was blocked
+    CHECK(pull_pad(harness) == 1);
+    CHECK(pull_pad(harness) == 1);
+    CHECK(gst_harness_try_pull(harness.pads[0]) == NULL);
+    CHECK(pad_counter(harness, 0, "frames-dropped") == 5);
+    CHECK(pad_counter(harness, 1, "frames-dropped") == 0);
+    CHECK(pad_counter(harness, 1, "frames-pushed") == 2);
+
+    // A full queue drops its oldest buffer
+    block_src(harness);
+    for (guint index = 0; index < 10; index++)
+        push(harness, 1, index);
+    unblock_src(harness);
+    for (guint index = 2; index < 10; index++)
+    {
+        GstBuffer *buffer = gst_harness_pull(harness.pads[0]);
+        CHECK(buffer != NULL && GST_BUFFER_OFFSET(buffer) == PAD_OFFSET + index);
+        if (buffer != NULL)
+            gst_buffer_unref(buffer);
+    }
+    CHECK(pad_counter(harness, 1, "frames-dropped") == 2);
+    round_robin_free(harness);
+}
+
+struct PushedRun
+{
+    guint size;
+    gint width;
+};
+
+// Records every push of the src pad with the width of the caps downstream got before it, skipping the primer
+static GstPadProbeReturn record_probe(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    std::vector<PushedRun> *runs = (std::vector<PushedRun> *)user_data;
+    GstBuffer *first;
+    guint size;
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        first = gst_buffer_list_get(list, 0);
+        size = gst_buffer_list_length(list);
+    }
+    else
+    {
+        first = GST_PAD_PROBE_INFO_BUFFER(info);
+        size = 1;
+    }
+    if (GST_BUFFER_OFFSET(first) == PAD_OFFSET - 1)
+        return GST_PAD_PROBE_OK;
+
+    gint width = 0;
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    if (caps != NULL)
+    {
+        gst_structure_get_int(gst_caps_get_structure(caps, 0), "width", &width);
+        gst_caps_unref(caps);
+    }
+    runs->push_back({size, width});
+    return GST_PAD_PROBE_OK;
+}
+
+static void test_batch_caps()
+{
+    RoundRobinHarness harness = round_robin_new(3, 4, 0, 3);
+    gst_harness_set_src_caps_str(harness.pads[0], "video/x-raw,width=320");
+    gst_harness_set_src_caps_str(harness.pads[1], "video/x-raw,width=640");
+    gst_harness_set_src_caps_str(harness.pads[2], "video/x-raw,width=640");
+
+    std::vector<PushedRun> runs;
+    GstPad *srcpad = gst_element_get_static_pad(harness.element, "src");
+    gulong probe = gst_pad_add_probe(srcpad, (GstPadProbeType)(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                                     record_probe, &runs, NULL);
+    block_src(harness);
+    for (guint pad = 0; pad < 3; pad++)
+        push(harness, pad, 0);
+    unblock_src(harness);
+    // The primer put pad 0 behind, the batch is pads 1, 2, 0
+    CHECK(pull_pad(harness) == 1);
+    CHECK(pull_pad(harness) == 2);
+    CHECK(pull_pad(harness) == 0);
+    gst_pad_remove_probe(srcpad, probe);
+    gst_object_unref(srcpad);
+
+    // Pads 1 and 2 share the caps and go in one list, pad 0 follows with its own caps
+    CHECK(runs.size() == 2);
+    if (runs.size() == 2)
+    {
+        CHECK(runs[0].size == 2 && runs[0].width == 640);
+        CHECK(runs[1].size == 1 && runs[1].width == 320);
+    }
+    round_robin_free(harness);
+}
+
+int main(int argc, char **argv)
+{
+    gst_init(&argc, &argv);
+    gst_element_register(NULL, "hailoroundrobin", GST_RANK_NONE, GST_TYPE_HAILO_ROUND_ROBIN);
+
+    test_weights();
+    test_late_buffers();
+    test_batch_caps();
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -4,6 +4,10 @@
  **/
 #include <gst/gst.h>
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include <vector>
 #include "hailo_objects.hpp"
 #include "hailo_common.hpp"
 #include "gst_hailo_meta.hpp"
@@ -21,11 +25,15 @@ enum
     PROP_IOU_THRESHOLD,
     PROP_BORDER_THRESHOLD,
     PROP_REMOVE_LARGE_LANDSCAPE,
+    PROP_FUSE_BOXES,
 };
 
 #define DEFAULT_IOU_THRESHOLD 0.3
 #define DEFAULT_BORDER_THRESHOLD 0.1
 #define DEFAULT_REMOVE_LARGE_LANDSCAPE true
+#define DEFAULT_FUSE_BOXES false
+
+#define NMS_GRID_MAX_CELLS 64
 
 #define LARGE_LANDSCAPE_MASK_WIDTH_HEIGHT_RATIO 1.3
 #define LARGE_LANDSCAPE_MASK_SIZE 0.05
@@ -35,7 +43,7 @@ enum
 G_DEFINE_TYPE_WITH_CODE(GstHailoTileAggregator, gst_hailotileaggregator, GST_TYPE_HAILO_AGGREGATOR, _do_init);
 
 static float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2);
-static void nms(HailoROIPtr hailo_roi, const float iou_thr);
+static void nms(HailoROIPtr hailo_roi, const float iou_thr, bool fuse_boxes);
 static void gst_hailotileaggregator_set_property(GObject *object,
                                                  guint prop_id, const GValue *value, GParamSpec *pspec);
 static void gst_hailotileaggregator_get_property(GObject *object,
@@ -83,6 +91,10 @@ gst_hailotileaggregator_class_init(GstHailoTileAggregatorClass *klass)
     g_object_class_install_property(gobject_class, PROP_REMOVE_LARGE_LANDSCAPE,
                                     g_param_spec_boolean("remove-large-landscape", "Remove large landscape", "remove large landscape objects when running in multi-scale mode", true,
                                                          (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(gobject_class, PROP_FUSE_BOXES,
+                                    g_param_spec_boolean("fuse-boxes", "Fuse boxes", "replace each detection kept by the NMS with the confidence weighted average of the boxes it suppressed (weighted box fusion)", DEFAULT_FUSE_BOXES,
+                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
 }
 
 static void
@@ -91,6 +103,7 @@ gst_hailotileaggregator_init(GstHailoTileAggregator *hailotileaggregator)
     hailotileaggregator->iou_threshold = DEFAULT_IOU_THRESHOLD;
     hailotileaggregator->border_threshold = DEFAULT_BORDER_THRESHOLD;
     hailotileaggregator->remove_large_landscape = DEFAULT_REMOVE_LARGE_LANDSCAPE;
+    hailotileaggregator->fuse_boxes = DEFAULT_FUSE_BOXES;
 }
 
 void gst_hailotileaggregator_dispose(GObject *object)
@@ -121,6 +134,9 @@ static void gst_hailotileaggregator_set_property(GObject *object, guint prop_id,
     case PROP_REMOVE_LARGE_LANDSCAPE:
         hailotileaggregator->remove_large_landscape = g_value_get_boolean(value);
         break;
+    case PROP_FUSE_BOXES:
+        hailotileaggregator->fuse_boxes = g_value_get_boolean(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -141,6 +157,9 @@ static void gst_hailotileaggregator_get_property(GObject *object, guint prop_id,
     case PROP_REMOVE_LARGE_LANDSCAPE:
         g_value_set_boolean(value, hailotileaggregator->remove_large_landscape);
         break;
+    case PROP_FUSE_BOXES:
+        g_value_set_boolean(value, hailotileaggregator->fuse_boxes);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -160,6 +179,7 @@ static void gst_hailotileaggregator_get_property(GObject *object, guint prop_id,
 static void remove_large_landscape(HailoROIPtr hailo_roi, int &frame_width, int &frame_height)
 {
     auto detections = hailo_common::get_hailo_detections(hailo_roi);
+    std::vector<HailoDetectionPtr> large_detections;
     for (const HailoDetectionPtr &detection : detections)
     {
         HailoBBox bbox = detection->get_bbox();
@@ -169,8 +189,9 @@ static void remove_large_landscape(HailoROIPtr hailo_roi, int &frame_width, int
         bool is_landscape_mask = (width >= (height * LARGE_LANDSCAPE_MASK_WIDTH_HEIGHT_RATIO));
         bool is_landscape_size_mask = (((width * height) / (frame_height * frame_width)) > LARGE_LANDSCAPE_MASK_SIZE);
         if (is_landscape_mask && is_landscape_size_mask)
-            hailo_roi->remove_object(detection);
+            large_detections.push_back(detection);
     }
+    hailo_roi->remove_objects(large_detections);
 }
 
 /**
@@ -185,6 +206,7 @@ static void remove_exceeded_bboxes(HailoTileROIPtr hailo_tile_roi, float border_
 {
     auto detections = hailo_common::get_hailo_detections(hailo_tile_roi);
     HailoBBox tile_bbox = hailo_tile_roi->get_bbox();
+    std::vector<HailoDetectionPtr> exceeded_detections;
 
     for (const HailoDetectionPtr &detection : detections)
     {
@@ -195,8 +217,9 @@ static void remove_exceeded_bboxes(HailoTileROIPtr hailo_tile_roi, float border_
         bool exceed_ymax = (tile_bbox.ymax() != 1 && (1 - bbox.ymax()) < border_threshold);
 
         if (exceed_xmin || exceed_xmax || exceed_ymin || exceed_ymax)
-            hailo_tile_roi->remove_object(detection);
+            exceeded_detections.push_back(detection);
     }
+    hailo_tile_roi->remove_objects(exceeded_detections);
 }
 
 static void
@@ -212,11 +235,11 @@ gst_hailotileaggregator_post_aggregation(GstHailoAggregator *hailoaggregator, Ha
     gst_structure_get_int(caps_st, "height", &frame_height);
 
     auto tiles = hailo_common::get_hailo_tiles(hailo_roi);
-    if (tiles[0]->get_mode() == MULTI_SCALE && hailotileaggregator->remove_large_landscape)
+    if (!tiles.empty() && tiles[0]->get_mode() == MULTI_SCALE && hailotileaggregator->remove_large_landscape)
         remove_large_landscape(hailo_roi, frame_width, frame_height);
 
     // Perform NMS on the main frame's detections after aggragation is done
-    nms(hailo_roi, hailotileaggregator->iou_threshold);
+    nms(hailo_roi, hailotileaggregator->iou_threshold, hailotileaggregator->fuse_boxes);
 }
 
 static void
@@ -249,45 +272,160 @@ float iou_calc(const HailoBBox &box_1, const HailoBBox &box_2)
     return area_of_overlap / (box_1_area + box_2_area - area_of_overlap);
 }
 
+/**
+ * @brief Uniform grid over the frame holding the detections kept by the NMS.
+ *        A detection is registered in every cell it covers, so a candidate is only compared
+ *        with kept detections that share a cell with it, boxes that share no cell cannot overlap.
+ */
+class NmsGrid
+{
+private:
+    int m_cols;
+    int m_rows;
+    std::vector<std::vector<uint>> m_cells;
+
+public:
+    NmsGrid(int cols, int rows) : m_cols(cols), m_rows(rows), m_cells(cols * rows){};
+
+    void cell_range(const HailoBBox &bbox, int &x0, int &y0, int &x1, int &y1) const
+    {
+        x0 = CLAMP((int)(bbox.xmin() * m_cols), 0, m_cols - 1);
+        y0 = CLAMP((int)(bbox.ymin() * m_rows), 0, m_rows - 1);
+        x1 = CLAMP((int)(bbox.xmax() * m_cols), 0, m_cols - 1);
+        y1 = CLAMP((int)(bbox.ymax() * m_rows), 0, m_rows - 1);
+    }
+
+    void insert(const HailoBBox &bbox, uint index)
+    {
+        int x0, y0, x1, y1;
+        cell_range(bbox, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; y++)
+            for (int x = x0; x <= x1; x++)
+                m_cells[y * m_cols + x].push_back(index);
+    }
+
+    const std::vector<uint> &cell(int x, int y) const { return m_cells[y * m_cols + x]; }
+};
+
 /**
  * @brief Perform IOU based NMS on detection objects of HailoRoi
+ *        Detections are visited by descending confidence, a detection is kept when no kept detection
+ *        of the same class overlaps it above the threshold (the same result as the pairwise greedy NMS).
+ *        Kept detections are looked up through a grid, so only boxes around the same area are compared,
+ *        and the suppressed detections are removed from the roi in one pass.
  *
  * @param hailo_roi  -  HailoROIPtr
  *        The HailoROI contains detections to perform NMS on.
  *
  * @param iou_thr  -  float
  *        Threshold for IOU filtration
+ *
+ * @param fuse_boxes  -  bool
+ *        Replace every kept box with the confidence weighted average of itself and the boxes it suppressed.
  */
-void nms(HailoROIPtr hailo_roi, const float iou_thr)
+void nms(HailoROIPtr hailo_roi, const float iou_thr, bool fuse_boxes)
 {
     // The network may propose multiple detections of similar size/score,
     // which are actually the same detection. We want to filter out the lesser
     // detections with a simple nms.
-
     std::vector<HailoDetectionPtr> objects = hailo_common::get_hailo_detections(hailo_roi);
-    std::sort(objects.begin(), objects.end(),
-              [](HailoDetectionPtr a, HailoDetectionPtr b)
-              { return a->get_confidence() > b->get_confidence(); });
+    if (objects.size() < 2)
+        return;
+
+    // Snapshot the fields once instead of going through the objects on every comparison
+    std::vector<HailoBBox> boxes;
+    std::vector<float> confidences;
+    std::vector<int> class_ids;
+    boxes.reserve(objects.size());
+    confidences.reserve(objects.size());
+    class_ids.reserve(objects.size());
+    float mean_width = 0.0f, mean_height = 0.0f;
+    for (const HailoDetectionPtr &object : objects)
+    {
+        boxes.push_back(object->get_bbox());
+        confidences.push_back(object->get_confidence());
+        class_ids.push_back(object->get_class_id());
+        mean_width += boxes.back().width();
+        mean_height += boxes.back().height();
+    }
+    mean_width /= objects.size();
+    mean_height /= objects.size();
+
+    std::vector<uint> order(objects.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&confidences](uint a, uint b)
+                     { return confidences[a] > confidences[b]; });
+
+    // Cells about twice the size of an average box, a box usually covers up to 4 cells.
+    // With a threshold of 0 boxes that do not overlap suppress each other too, so a single cell
+    // compares every pair, as the pairwise NMS does.
+    int grid_cols = 1, grid_rows = 1;
+    if (iou_thr > 0.0f)
+    {
+        grid_cols = CLAMP((int)(0.5f / std::max(mean_width, 1e-6f)), 1, NMS_GRID_MAX_CELLS);
+        grid_rows = CLAMP((int)(0.5f / std::max(mean_height, 1e-6f)), 1, NMS_GRID_MAX_CELLS);
+    }
+    NmsGrid grid(grid_cols, grid_rows);
 
-    for (uint index = 0; index < objects.size(); index++)
+    std::vector<uint> visited(objects.size(), UINT_MAX); // Last candidate that was compared with a kept detection
+    std::vector<HailoDetectionPtr> suppressed;
+    std::vector<int> suppressed_by(fuse_boxes ? objects.size() : 0, -1);
+    for (uint candidate : order)
     {
-        for (uint jindex = index + 1; jindex < objects.size(); jindex++)
+        int suppressor = -1;
+        int x0, y0, x1, y1;
+        grid.cell_range(boxes[candidate], x0, y0, x1, y1);
+        for (int y = y0; y <= y1 && suppressor < 0; y++)
         {
-            if (objects[index]->get_class_id() == objects[jindex]->get_class_id())
+            for (int x = x0; x <= x1 && suppressor < 0; x++)
             {
-                // For each detection, calculate the IOU against each following detection.
-                float iou = iou_calc(objects[index]->get_bbox(), objects[jindex]->get_bbox());
-                // If the IOU is above threshold, then we have two similar detections,
-                // and want to delete the one.
-                if (iou >= iou_thr)
+                for (uint kept : grid.cell(x, y))
                 {
-                    // The detections are arranged in highest score order,
-                    // so we want to erase the latter detection.
-                    hailo_roi->remove_object(objects[jindex]);
-                    objects.erase(objects.begin() + jindex);
-                    jindex--; // Step back jindex since we just erased the current detection.
+                    if (visited[kept] == candidate || class_ids[kept] != class_ids[candidate])
+                        continue;
+                    visited[kept] = candidate;
+                    if (iou_calc(boxes[kept], boxes[candidate]) >= iou_thr)
+                    {
+                        suppressor = kept;
+                        break;
+                    }
                 }
             }
         }
+        if (suppressor < 0)
+        {
+            grid.insert(boxes[candidate], candidate);
+            continue;
+        }
+        suppressed.push_back(objects[candidate]);
+        if (fuse_boxes)
+            suppressed_by[candidate] = suppressor;
     }
-}
\ No newline at end of file
+
+    if (fuse_boxes)
+    {
+        // Weighted box fusion: average the corners of each kept box and the boxes it suppressed
+        std::vector<float> sums(objects.size() * 5, 0.0f);
+        for (uint index = 0; index < objects.size(); index++)
+        {
+            int kept = (suppressed_by[index] < 0) ? index : suppressed_by[index];
+            float *sum = &sums[kept * 5];
+            sum[0] += confidences[index] * boxes[index].xmin();
+            sum[1] += confidences[index] * boxes[index].ymin();
+            sum[2] += confidences[index] * boxes[index].xmax();
+            sum[3] += confidences[index] * boxes[index].ymax();
+            sum[4] += confidences[index];
+        }
+        for (uint index = 0; index < objects.size(); index++)
+        {
+            const float *sum = &sums[index * 5];
+            if (suppressed_by[index] >= 0 || sum[4] <= confidences[index] || sum[4] <= 0.0f)
+                continue;
+            float xmin = sum[0] / sum[4], ymin = sum[1] / sum[4];
+            objects[index]->set_bbox(HailoBBox(xmin, ymin, sum[2] / sum[4] - xmin, sum[3] / sum[4] - ymin));
+        }
+    }
+
+    hailo_roi->remove_objects(suppressed);
+}
@@ -31,6 +31,7 @@ struct _GstHailoTileAggregator
     gfloat iou_threshold;
     gfloat border_threshold;
     gboolean remove_large_landscape;
+    gboolean fuse_boxes;
 };
 
 struct _GstHailoTileAggregatorClass
@@ -6,6 +6,7 @@
 #include <opencv2/opencv.hpp>
 
 #include "gst_hailo_meta.hpp"
+#include "hailo_common.hpp"
 #include "gsthailotilecropper.hpp"
 
 GST_DEBUG_CATEGORY_STATIC(gst_hailotilecropper_debug);
@@ -19,6 +20,10 @@ GST_DEBUG_CATEGORY_STATIC(gst_hailotilecropper_debug);
 #define DEFAULT_OVERLAP_X_AXIS 0
 #define DEFAULT_OVERLAP_Y_AXIS 0
 #define DEFAULT_MULTI_SCALE_LEVEL 2
+#define DEFAULT_ADAPTIVE_TILING false
+#define DEFAULT_MOTION_THRESHOLD 3.0
+#define DEFAULT_FULL_SWEEP_INTERVAL 30
+#define DEFAULT_TILE_HOLD_FRAMES 5
 static const uint scales_template[][2]{{1, 1}, {2, 2}, {3, 3}};
 
 enum
@@ -30,6 +35,12 @@ enum
     PROP_OVERLAP_Y_AXIS,
     PROP_TILING_MODE,
     PROP_MULTI_SCALE_LEVEL,
+    PROP_ADAPTIVE_TILING,
+    PROP_MOTION_THRESHOLD,
+    PROP_FULL_SWEEP_INTERVAL,
+    PROP_TILE_HOLD_FRAMES,
+    PROP_TILES_TOTAL,
+    PROP_TILES_SKIPPED,
 };
 
 #define gst_hailotilecropper_parent_class parent_class
@@ -115,6 +126,30 @@ gst_hailotilecropper_class_init(GstHailoTileCropperClass *klass)
     g_object_class_install_property(gobject_class, PROP_MULTI_SCALE_LEVEL,
                                     g_param_spec_uint("scale-level", "Scale level", "Scales (layers of tiles) in addition to the main layer 1: [(1 X 1)] 2: [(1 X 1), (2 X 2)] 3: [(1 X 1), (2 X 2), (3 X 3)]]", 1, 3, 2,
                                                       (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(gobject_class, PROP_ADAPTIVE_TILING,
+                                    g_param_spec_boolean("adaptive-tiling", "Adaptive tiling", "Only crop the tiles with motion or detections on the frame (and the tiles that had them in the last tile-hold-frames frames), all tiles are cropped every full-sweep-interval frames", DEFAULT_ADAPTIVE_TILING,
+                                                         (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(gobject_class, PROP_MOTION_THRESHOLD,
+                                    g_param_spec_float("motion-threshold", "Motion threshold", "Adaptive tiling: change of the mean luma (0 - 255) of an area of the tile since the previous frame, that makes the tile active", 0, 255, DEFAULT_MOTION_THRESHOLD,
+                                                       (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(gobject_class, PROP_FULL_SWEEP_INTERVAL,
+                                    g_param_spec_uint("full-sweep-interval", "Full sweep interval", "Adaptive tiling: crop all the tiles once every this many frames, 0 only sweeps the first frame", 0, G_MAXUINT, DEFAULT_FULL_SWEEP_INTERVAL,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(gobject_class, PROP_TILE_HOLD_FRAMES,
+                                    g_param_spec_uint("tile-hold-frames", "Tile hold frames", "Adaptive tiling: number of frames a tile keeps being cropped after it was active", 0, G_MAXUINT, DEFAULT_TILE_HOLD_FRAMES,
+                                                      (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | GST_PARAM_MUTABLE_READY)));
+
+    g_object_class_install_property(gobject_class, PROP_TILES_TOTAL,
+                                    g_param_spec_uint64("tiles-total", "Tiles total", "Number of tiles of all the frames so far, cropped or skipped", 0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
+
+    g_object_class_install_property(gobject_class, PROP_TILES_SKIPPED,
+                                    g_param_spec_uint64("tiles-skipped", "Tiles skipped", "Number of tiles skipped by adaptive tiling so far", 0, G_MAXUINT64, 0,
+                                                        (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
@@ -126,6 +161,13 @@ gst_hailotilecropper_init(GstHailoTileCropper *hailotilecropper)
     hailotilecropper->overlap_y_axis = DEFAULT_OVERLAP_Y_AXIS;
     hailotilecropper->tiling_mode = SINGLE_SCALE;
     hailotilecropper->multi_scale_level = DEFAULT_MULTI_SCALE_LEVEL;
+    hailotilecropper->adaptive_tiling = DEFAULT_ADAPTIVE_TILING;
+    hailotilecropper->motion_threshold = DEFAULT_MOTION_THRESHOLD;
+    hailotilecropper->full_sweep_interval = DEFAULT_FULL_SWEEP_INTERVAL;
+    hailotilecropper->tile_hold_frames = DEFAULT_TILE_HOLD_FRAMES;
+    hailotilecropper->tiles_total = 0;
+    hailotilecropper->tiles_skipped = 0;
+    hailotilecropper->tile_selector = new TileSelector();
 }
 
 void gst_hailotilecropper_dispose(GObject *object)
@@ -139,6 +181,8 @@ void gst_hailotilecropper_finalize(GObject *object)
 {
     GstHailoTileCropper *hailotilecropper = GST_HAILO_TILE_CROPPER(object);
     GST_DEBUG_OBJECT(hailotilecropper, "finalize");
+    delete hailotilecropper->tile_selector;
+    hailotilecropper->tile_selector = nullptr;
     G_OBJECT_CLASS(gst_hailotilecropper_parent_class)->finalize(object);
 }
 
@@ -169,6 +213,19 @@ gst_hailotilecropper_set_property(GObject *object, guint prop_id,
         hailotilecropper->tiling_mode = (hailo_tiling_mode_t)g_value_get_enum(value);
         GST_OBJECT_UNLOCK(hailotilecropper);
         break;
+    case PROP_ADAPTIVE_TILING:
+        hailotilecropper->adaptive_tiling = g_value_get_boolean(value);
+        hailotilecropper->tile_selector->reset();
+        break;
+    case PROP_MOTION_THRESHOLD:
+        hailotilecropper->motion_threshold = g_value_get_float(value);
+        break;
+    case PROP_FULL_SWEEP_INTERVAL:
+        hailotilecropper->full_sweep_interval = g_value_get_uint(value);
+        break;
+    case PROP_TILE_HOLD_FRAMES:
+        hailotilecropper->tile_hold_frames = g_value_get_uint(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -203,6 +260,28 @@ gst_hailotilecropper_get_property(GObject *object, guint prop_id,
         g_value_set_enum(value, (gint)hailotilecropper->tiling_mode);
         GST_OBJECT_UNLOCK(hailotilecropper);
         break;
+    case PROP_ADAPTIVE_TILING:
+        g_value_set_boolean(value, hailotilecropper->adaptive_tiling);
+        break;
+    case PROP_MOTION_THRESHOLD:
+        g_value_set_float(value, hailotilecropper->motion_threshold);
+        break;
+    case PROP_FULL_SWEEP_INTERVAL:
+        g_value_set_uint(value, hailotilecropper->full_sweep_interval);
+        break;
+    case PROP_TILE_HOLD_FRAMES:
+        g_value_set_uint(value, hailotilecropper->tile_hold_frames);
+        break;
+    case PROP_TILES_TOTAL:
+        GST_OBJECT_LOCK(hailotilecropper);
+        g_value_set_uint64(value, hailotilecropper->tiles_total);
+        GST_OBJECT_UNLOCK(hailotilecropper);
+        break;
+    case PROP_TILES_SKIPPED:
+        GST_OBJECT_LOCK(hailotilecropper);
+        g_value_set_uint64(value, hailotilecropper->tiles_skipped);
+        GST_OBJECT_UNLOCK(hailotilecropper);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -232,7 +311,42 @@ static HailoTileROI create_tile_roi(const uint &index, const float &col_overlap,
     return HailoTileROI(HailoBBox(x, y, width, height), index, col_overlap, row_overlap, layer, tiling_mode);
 }
 
-static void prepare_tiles(HailoROIPtr hailo_roi, std::vector<HailoROIPtr> &crop_rois, float tiles_along_x_axis, float tiles_along_y_axis, float overlap_x_axis, float overlap_y_axis, uint layer, hailo_tiling_mode_t tiling_mode)
+/**
+ * Adaptive tiling state of one frame, used to pick the tiles to crop.
+ */
+struct TileSelection
+{
+    TileSelector *selector;
+    std::vector<HailoBBox> detections; // Detections already on the frame (upstream detector / tracker)
+    float motion_threshold;
+    uint hold_frames;
+    bool full_sweep;
+    guint64 skipped;
+};
+
+static bool boxes_intersect(const HailoBBox &box_1, const HailoBBox &box_2)
+{
+    return box_1.xmin() < box_2.xmax() && box_2.xmin() < box_1.xmax() &&
+           box_1.ymin() < box_2.ymax() && box_2.ymin() < box_1.ymax();
+}
+
+/**
+ * Whether a tile should be cropped on this frame in adaptive tiling.
+ *
+ * @param[in] selection   TileSelection *,   adaptive tiling state of the frame.
+ * @param[in] tile_roi    HailoTileROIPtr,   the tile.
+ * @return bool, true if the tile should be cropped.
+ */
+static bool tile_is_selected(TileSelection *selection, HailoTileROIPtr tile_roi)
+{
+    HailoBBox tile_bbox = tile_roi->get_bbox();
+    bool active = selection->selector->motion(tile_bbox) >= selection->motion_threshold;
+    for (uint i = 0; !active && i < selection->detections.size(); i++)
+        active = boxes_intersect(tile_bbox, selection->detections[i]);
+    return selection->selector->select(tile_roi->get_layer(), tile_roi->get_index(), active, selection->full_sweep, selection->hold_frames);
+}
+
+static void prepare_tiles(HailoROIPtr hailo_roi, std::vector<HailoROIPtr> &crop_rois, float tiles_along_x_axis, float tiles_along_y_axis, float overlap_x_axis, float overlap_y_axis, uint layer, hailo_tiling_mode_t tiling_mode, TileSelection *selection)
 {
     // Calculate the scale for a tile for col and row
     double row_step = 1 / double(tiles_along_y_axis);
@@ -253,9 +367,16 @@ static void prepare_tiles(HailoROIPtr hailo_roi, std::vector<HailoROIPtr> &crop_
             HailoTileROIPtr tile_roi = std::make_shared<HailoTileROI>(create_tile_roi(index, col_overlap, row_overlap,
                                                                                       col_offset, row_offset, (col_offset + col_step), (row_offset + row_step),
                                                                                       layer, tiling_mode));
-            // Add the tile to the result vector and into the main hailo_roi.
-            crop_rois.emplace_back(tile_roi);
-            hailo_roi->add_object(tile_roi);
+            // Add the tile to the result vector and into the main hailo_roi, unless adaptive tiling skips it.
+            if (selection == nullptr || tile_is_selected(selection, tile_roi))
+            {
+                crop_rois.emplace_back(tile_roi);
+                hailo_roi->add_object(tile_roi);
+            }
+            else
+            {
+                selection->skipped++;
+            }
 
             col_offset += col_step;
             index++;
@@ -265,6 +386,28 @@ static void prepare_tiles(HailoROIPtr hailo_roi, std::vector<HailoROIPtr> &crop_
     }
 }
 
+/**
+ * Updates the motion grid of adaptive tiling with the luma (or first component) of the frame.
+ *
+ * @param[in] hailotilecropper    tiling element.
+ * @param[in] buf                 the frame.
+ * @return bool, false if the frame could not be mapped.
+ */
+static bool update_tile_motion(GstHailoTileCropper *hailotilecropper, GstBuffer *buf)
+{
+    GstVideoInfo *info = GST_HAILO_BASE_CROPPER(hailotilecropper)->full_image_info;
+    GstVideoFrame frame;
+    if (GST_VIDEO_INFO_FORMAT(info) == GST_VIDEO_FORMAT_UNKNOWN || !gst_video_frame_map(&frame, info, buf, GST_MAP_READ))
+        return false;
+    hailotilecropper->tile_selector->update_motion((const uint8_t *)GST_VIDEO_FRAME_COMP_DATA(&frame, 0),
+                                                   GST_VIDEO_FRAME_COMP_PSTRIDE(&frame, 0),
+                                                   GST_VIDEO_FRAME_COMP_STRIDE(&frame, 0),
+                                                   GST_VIDEO_FRAME_COMP_WIDTH(&frame, 0),
+                                                   GST_VIDEO_FRAME_COMP_HEIGHT(&frame, 0));
+    gst_video_frame_unmap(&frame);
+    return true;
+}
+
 /**
  * Creates vector of HailoROI as a preparation for the crop scale phase,
  * overrides hailocropper base functionality.
@@ -283,7 +426,7 @@ static std::vector<HailoROIPtr> gst_hailotilecropper_prepare_crops(GstHailoBaseC
     HailoROIPtr hailo_roi = get_hailo_main_roi(buf, true);
 
     // Calculate the total number of tiles
-    uint total_num_of_tiles = hailotilecropper->tiles_along_x_axis * hailotilecropper->tiles_along_x_axis;
+    uint total_num_of_tiles = hailotilecropper->tiles_along_x_axis * hailotilecropper->tiles_along_y_axis;
     uint num_of_scales = hailotilecropper->multi_scale_level;
 
     if (hailotilecropper->tiling_mode == MULTI_SCALE)
@@ -293,17 +436,44 @@ static std::vector<HailoROIPtr> gst_hailotilecropper_prepare_crops(GstHailoBaseC
             total_num_of_tiles += (scales_template[i][0] * scales_template[i][1]);
     }
 
+    // In adaptive tiling, pick the tiles by the motion since the previous frame and the detections on the frame
+    TileSelection selection;
+    TileSelection *tile_selection = nullptr;
+    if (hailotilecropper->adaptive_tiling && update_tile_motion(hailotilecropper, buf))
+    {
+        selection.selector = hailotilecropper->tile_selector;
+        for (HailoDetectionPtr &detection : hailo_common::get_hailo_detections(hailo_roi))
+            selection.detections.push_back(detection->get_bbox());
+        selection.motion_threshold = hailotilecropper->motion_threshold;
+        selection.hold_frames = hailotilecropper->tile_hold_frames;
+        selection.full_sweep = selection.selector->full_sweep(hailotilecropper->full_sweep_interval);
+        selection.skipped = 0;
+        tile_selection = &selection;
+    }
+
     std::vector<HailoROIPtr> crop_rois;
     crop_rois.reserve(total_num_of_tiles);
 
     // Prepare tiles for the main scale
     prepare_tiles(hailo_roi, crop_rois, hailotilecropper->tiles_along_x_axis, hailotilecropper->tiles_along_y_axis,
-                  hailotilecropper->overlap_x_axis, hailotilecropper->overlap_y_axis, 0, hailotilecropper->tiling_mode);
+                  hailotilecropper->overlap_x_axis, hailotilecropper->overlap_y_axis, 0, hailotilecropper->tiling_mode, tile_selection);
 
     // Prepare tiles for every scale requsted as multi scale
     if (hailotilecropper->tiling_mode == MULTI_SCALE)
         for (uint i = 0; i < num_of_scales; i++)
-            prepare_tiles(hailo_roi, crop_rois, scales_template[i][0], scales_template[i][1], hailotilecropper->overlap_x_axis, hailotilecropper->overlap_y_axis, (i + 1), (hailo_tiling_mode_t)hailotilecropper->tiling_mode);
+            prepare_tiles(hailo_roi, crop_rois, scales_template[i][0], scales_template[i][1], hailotilecropper->overlap_x_axis, hailotilecropper->overlap_y_axis, (i + 1), (hailo_tiling_mode_t)hailotilecropper->tiling_mode, tile_selection);
+
+    GST_OBJECT_LOCK(hailotilecropper);
+    hailotilecropper->tiles_total += total_num_of_tiles;
+    if (tile_selection)
+        hailotilecropper->tiles_skipped += tile_selection->skipped;
+    GST_OBJECT_UNLOCK(hailotilecropper);
+    if (tile_selection)
+    {
+        GST_DEBUG_OBJECT(hailotilecropper, "adaptive tiling: %zu of %u tiles cropped%s", crop_rois.size(), total_num_of_tiles,
+                         tile_selection->full_sweep ? " (full sweep)" : "");
+        tile_selection->selector->next_frame();
+    }
 
     return crop_rois;
 }
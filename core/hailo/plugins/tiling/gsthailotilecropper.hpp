@@ -12,6 +12,7 @@
 #include <gst/gst.h>
 #include "cropping/gsthailobasecropper.hpp"
 #include "hailo_objects.hpp"
+#include "tile_selector.hpp"
 
 G_BEGIN_DECLS
 
@@ -34,6 +35,13 @@ struct _GstHailoTileCropper
     gfloat overlap_y_axis;
     guint multi_scale_level;
     hailo_tiling_mode_t tiling_mode;
+    gboolean adaptive_tiling;
+    gfloat motion_threshold;
+    guint full_sweep_interval;
+    guint tile_hold_frames;
+    guint64 tiles_total;
+    guint64 tiles_skipped;
+    TileSelector *tile_selector;
 };
 
 struct _GstHailoTileCropperClass
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+#include "hailo_objects.hpp"
+
+/**
+ * @brief Picks the tiles worth inferring on a frame, for adaptive tiling.
+ *        The frame is summarized by a coarse grid of mean luma values, a tile is active when the
+ *        mean of one of its cells changed since the previous frame, or when the frame already carries
+ *        detections inside it (e.g. from an upstream detector or tracker).
+ *        Active tiles are kept for a few more frames, so objects that stop moving are still followed.
+ */
+class TileSelector
+{
+public:
+    static const int MOTION_GRID_COLS = 64;
+    static const int MOTION_GRID_ROWS = 36;
+    static const int SAMPLES_PER_CELL_AXIS = 8;
+
+private:
+    std::vector<float> m_cells;
+    std::vector<float> m_previous_cells;
+    std::vector<float> m_motion; // Absolute difference of every cell since the previous frame
+    bool m_has_previous;
+    uint64_t m_frame;
+    std::map<std::pair<uint, uint>, uint> m_hold; // (layer, index) -> frames the tile stays selected
+
+public:
+    TileSelector() : m_cells(MOTION_GRID_COLS * MOTION_GRID_ROWS, 0.0f),
+                     m_previous_cells(MOTION_GRID_COLS * MOTION_GRID_ROWS, 0.0f),
+                     m_motion(MOTION_GRID_COLS * MOTION_GRID_ROWS, 0.0f),
+                     m_has_previous(false), m_frame(0){};
+
+    /**
+     * @brief Samples the luma (or first component) of a frame into the motion grid.
+     *
+     * @param data Pointer to the first component of the first pixel.
+     * @param pixel_stride Bytes between two pixels of a row.
+     * @param row_stride Bytes between two rows.
+     */
+    void update_motion(const uint8_t *data, int pixel_stride, int row_stride, int width, int height)
+    {
+        m_previous_cells.swap(m_cells);
+        for (int row = 0; row < MOTION_GRID_ROWS; row++)
+        {
+            int y0 = row * height / MOTION_GRID_ROWS;
+            int y1 = std::max(y0 + 1, (row + 1) * height / MOTION_GRID_ROWS);
+            int y_step = std::max(1, (y1 - y0) / SAMPLES_PER_CELL_AXIS);
+            for (int col = 0; col < MOTION_GRID_COLS; col++)
+            {
+                int x0 = col * width / MOTION_GRID_COLS;
+                int x1 = std::max(x0 + 1, (col + 1) * width / MOTION_GRID_COLS);
+                int x_step = std::max(1, (x1 - x0) / SAMPLES_PER_CELL_AXIS);
+                uint sum = 0, count = 0;
+                for (int y = y0; y < y1 && y < height; y += y_step)
+                {
+                    const uint8_t *line = data + (size_t)y * row_stride;
+                    for (int x = x0; x < x1 && x < width; x += x_step, count++)
+                        sum += line[x * pixel_stride];
+                }
+                int cell = row * MOTION_GRID_COLS + col;
+                m_cells[cell] = count ? float(sum) / count : 0.0f;
+                m_motion[cell] = m_has_previous ? std::fabs(m_cells[cell] - m_previous_cells[cell]) : 0.0f;
+            }
+        }
+        m_has_previous = true;
+    }
+
+    /**
+     * @brief Highest change of a motion grid cell inside a box.
+     */
+    float motion(const HailoBBox &bbox) const
+    {
+        int col0 = CLAMP((int)(bbox.xmin() * MOTION_GRID_COLS), 0, MOTION_GRID_COLS - 1);
+        int col1 = CLAMP((int)std::ceil(bbox.xmax() * MOTION_GRID_COLS) - 1, col0, MOTION_GRID_COLS - 1);
+        int row0 = CLAMP((int)(bbox.ymin() * MOTION_GRID_ROWS), 0, MOTION_GRID_ROWS - 1);
+        int row1 = CLAMP((int)std::ceil(bbox.ymax() * MOTION_GRID_ROWS) - 1, row0, MOTION_GRID_ROWS - 1);
+        float max_motion = 0.0f;
+        for (int row = row0; row <= row1; row++)
+            for (int col = col0; col <= col1; col++)
+                max_motion = std::max(max_motion, m_motion[row * MOTION_GRID_COLS + col]);
+        return max_motion;
+    }
+
+    /**
+     * @brief Whether every tile should be inferred on this frame.
+     *        The first frame (no motion reference yet) is always a full sweep.
+     */
+    bool full_sweep(uint interval) const
+    {
+        return m_frame == 0 || (interval != 0 && m_frame % interval == 0);
+    }
+
+    /**
+     * @brief Decide whether a tile is inferred on this frame.
+     *
+     * @param active Whether the tile has motion or detections on this frame.
+     * @param hold_frames Number of frames a tile stays selected after it was active.
+     */
+    bool select(uint layer, uint index, bool active, bool full_sweep, uint hold_frames)
+    {
+        uint &hold = m_hold[std::make_pair(layer, index)];
+        if (active)
+        {
+            hold = hold_frames;
+            return true;
+        }
+        if (hold > 0)
+        {
+            hold--;
+            return true;
+        }
+        return full_sweep;
+    }
+
+    void next_frame() { m_frame++; }
+
+    /**
+     * @brief Forget the motion reference and the held tiles (e.g. when the tiles layout changes).
+     */
+    void reset()
+    {
+        m_has_previous = false;
+        m_frame = 0;
+        m_hold.clear();
+        std::fill(m_motion.begin(), m_motion.end(), 0.0f);
+    }
+};
@@ -466,6 +466,10 @@ gst_hailo_tracker_stop(GstBaseTransform *trans)
         std::string tracker_name = get_tracker_name(hailotracker, stream_id);
         HailoTracker::GetInstance().remove_jde_tracker(tracker_name);
     }
+    GST_OBJECT_LOCK(hailotracker);
+    hailotracker->active_streams.clear();
+    hailotracker->tracker_handles.clear();
+    GST_OBJECT_UNLOCK(hailotracker);
 
     GST_DEBUG_OBJECT(hailotracker, "stop");
 
@@ -502,13 +506,19 @@ gst_hailo_tracker_transform_frame_ip(GstVideoFilter *filter, GstVideoFrame *fram
         }
     }
 
-    // Swap the detections in the roi with just the online tracked detections
+    // Find the tracker of the stream, the update itself only locks that tracker
+    HailoTrackerHandle tracker;
     GST_OBJECT_LOCK(hailotracker);
-    std::string tracker_name = get_tracker_name(hailotracker, std::string(stream_id));
-    std::vector<HailoDetectionPtr> online_detection_ptrs = HailoTracker::GetInstance().update(tracker_name, detections);
+    auto stream = std::find(hailotracker->active_streams.begin(), hailotracker->active_streams.end(), std::string(stream_id));
+    if (stream != hailotracker->active_streams.end())
+        tracker = hailotracker->tracker_handles[stream - hailotracker->active_streams.begin()];
+    GST_OBJECT_UNLOCK(hailotracker);
+    if (!tracker)
+        tracker = HailoTracker::GetInstance().get_jde_tracker(get_tracker_name(hailotracker, std::string(stream_id)));
 
+    // Swap the detections in the roi with just the online tracked detections
+    std::vector<HailoDetectionPtr> online_detection_ptrs = HailoTracker::GetInstance().update(tracker, detections);
     hailo_common::add_detection_pointers(hailo_roi, online_detection_ptrs);
-    GST_OBJECT_UNLOCK(hailotracker);
 
     GST_DEBUG_OBJECT(hailotracker, "transform_frame_ip");
     return GST_FLOW_OK;
@@ -538,6 +548,7 @@ gst_hailo_tracker_sink_event(GstBaseTransform *trans,
             GST_DEBUG_OBJECT(hailotracker, "filtering stream %s", stream_id);
             hailotracker->current_stream_id = strdup(stream_id);
             // If streamid is new create a new JDETracker
+            GST_OBJECT_LOCK(hailotracker);
             if (std::find(hailotracker->active_streams.begin(),
                           hailotracker->active_streams.end(),
                           std::string(hailotracker->current_stream_id)) == hailotracker->active_streams.end())
@@ -545,7 +556,9 @@ gst_hailo_tracker_sink_event(GstBaseTransform *trans,
                 std::string tracker_name = get_tracker_name(hailotracker, std::string(hailotracker->current_stream_id));
                 HailoTracker::GetInstance().add_jde_tracker(tracker_name, hailotracker->tracker_params);
                 hailotracker->active_streams.emplace_back(std::string(hailotracker->current_stream_id));
+                hailotracker->tracker_handles.emplace_back(HailoTracker::GetInstance().get_jde_tracker(tracker_name));
             }
+            GST_OBJECT_UNLOCK(hailotracker);
         }
     default:
         return GST_BASE_TRANSFORM_CLASS(gst_hailo_tracker_parent_class)->sink_event(trans, event);
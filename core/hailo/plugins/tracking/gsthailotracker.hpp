@@ -46,6 +46,7 @@ struct _GstHailoTracker
     gint class_id;
     HailoTrackerParams tracker_params;
     std::vector<std::string> active_streams;
+    std::vector<HailoTrackerHandle> tracker_handles; // The tracker of each of active_streams, by the same index
 };
 
 struct _GstHailoTrackerClass
@@ -28,7 +28,9 @@
 #include <glib/gstdio.h>
 #include <glib/gprintf.h>
 #include <gio/gio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <atomic>
 
 
 #include "gstctf.hpp"
@@ -49,6 +51,15 @@ typedef guint32 tcp_header_length;
 #define CTF_HEADER_SIZE (sizeof(guint16) + sizeof(guint32))
 #define CTF_AVAILABLE_MEM_SIZE (CTF_MEM_SIZE - TCP_HEADER_SIZE)
 
+/* Events are queued in a ring per thread and written by the flusher thread */
+#define CTF_RING_SIZE     (262144)      //256K, a power of 2
+#define CTF_RING_MASK     (CTF_RING_SIZE - 1)
+#define CTF_RING_PADDING  (0xFFFFFFFF)  // Record size of the unused end of the ring
+#define CTF_RING_RECORD_SIZE(size) (((size) + sizeof (guint32) + 3) & ~(gsize) 3)
+#define CTF_FLUSH_INTERVAL_US (10000)   //10ms
+#define CTF_RING_IDLE      (G_MAXINT64)  // In flight timestamp of a ring without an event being written
+#define CTF_RING_RESERVING (-1)          // In flight timestamp while it is being taken
+
 typedef guint16 ctf_header_id;
 typedef guint32 ctf_header_timestamp;
 
@@ -113,20 +124,14 @@ typedef guint32 ctf_header_timestamp;
     mem += sizeof(gfloat);                   \
   } G_STMT_END
 
-/* *INDENT-OFF* */
-#define CTF_EVENT_WRITE_HEADER(id,mem) \
-  G_STMT_START {                       \
-    /* Write event ID */               \
-    CTF_EVENT_WRITE_INT16(id,mem);     \
-    /* Write timestamp */              \
-    CTF_EVENT_WRITE_INT32(             \
-      GST_CLOCK_DIFF (                 \
-          ctf_descriptor->start_time,  \
-          gst_util_get_timestamp ()    \
-      )/1000,                          \
-    mem);                              \
+/* The timestamp is taken by ctf_event_reserve */
+#define CTF_EVENT_WRITE_HEADER(id,ring,mem)     \
+  G_STMT_START {                                \
+    /* Write event ID */                        \
+    CTF_EVENT_WRITE_INT16(id,mem);              \
+    /* Write timestamp */                       \
+    CTF_EVENT_WRITE_INT32(ring->timestamp,mem); \
   } G_STMT_END
-/* *INDENT-ON* */
 
 static void file_parser_handler (gchar * line);
 static void tcp_parser_handler (gchar * line);
@@ -138,6 +143,27 @@ typedef enum
   BYTE_ORDER_LE,
 } byte_order;
 
+/* Single producer (the thread that owns it), single consumer (the flusher)
+ * ring of events. Each record is a guint32 size followed by the event, records
+ * are 4 bytes aligned and never wrap, the end of the ring is skipped with a
+ * CTF_RING_PADDING record instead.
+ * While an event is written its timestamp is published in in_flight, so the
+ * flusher holds back the events of other rings that are newer than it.
+ */
+typedef struct _GstCtfRing GstCtfRing;
+struct _GstCtfRing
+{
+  std::atomic < guint64 > head; /* Written by the owner thread only */
+  std::atomic < guint64 > tail; /* Written by the flusher only */
+  guint64 reserved;             /* Head after the event being written */
+  guint32 timestamp;            /* Timestamp (us) of the event being written */
+  std::atomic < gint64 > in_flight;     /* Timestamp of the event being written, or CTF_RING_IDLE */
+  std::atomic < guint64 > dropped;
+  std::atomic < gint > owned;   /* 0 once the owner thread exited */
+  GstCtfRing *next;
+  guint8 mem[CTF_RING_SIZE];
+};
+
 
 struct _GstCtfDescriptor
 {
@@ -164,10 +190,21 @@ struct _GstCtfDescriptor
   GSocketConnection *socket_connection;
   GOutputStream *output_stream;
   gboolean tcp_output_disable;
+
+  /* Event rings, new rings are only ever pushed to the front */
+  std::atomic < GstCtfRing * > rings;
+  GArray *cursors;              /* One GstCtfRingCursor per ring, kept between flushes */
+  GThread *flusher;
+  GMutex flusher_mutex;
+  GCond flusher_cond;
+  gboolean closing;
 };
 
 static GstCtfDescriptor *ctf_descriptor = NULL;
 
+static void ctf_ring_release (gpointer data);
+static GPrivate ctf_thread_ring = G_PRIVATE_INIT (ctf_ring_release);
+
 static const parser_handler_desc parser_handler_desc_list[] = {
   {"file://", file_parser_handler},
   {"tcp://", tcp_parser_handler},
@@ -298,6 +335,11 @@ ctf_create_struct (void)
   /* Default TCP connection state Enable */
   ctf->tcp_output_disable = FALSE;
 
+  ctf->rings.store (NULL);
+  ctf->cursors = NULL;
+  ctf->flusher = NULL;
+  ctf->closing = FALSE;
+
   /* Currently a constant UUID value is used */
   memcpy (ctf->uuid, UUID, CTF_UUID_SIZE);
 
@@ -710,6 +752,331 @@ ctf_tcp_init (void)
   ctf_descriptor->output_stream = output_stream;
 }
 
+static void
+ctf_ring_release (gpointer data)
+{
+  GstCtfRing *ring = (GstCtfRing *) data;
+
+  /* The ring is drained by the flusher and reused by the next new thread */
+  ring->owned.store (0, std::memory_order_release);
+}
+
+static GstCtfRing *
+ctf_get_thread_ring (void)
+{
+  GstCtfRing *ring;
+  GstCtfRing *head;
+  gint expected;
+
+  ring = (GstCtfRing *) g_private_get (&ctf_thread_ring);
+  if (G_LIKELY (NULL != ring)) {
+    return ring;
+  }
+
+  /* First event of this thread, take over the ring of a thread that exited */
+  for (ring = ctf_descriptor->rings.load (std::memory_order_acquire);
+      NULL != ring; ring = ring->next) {
+    expected = 0;
+    if (ring->owned.compare_exchange_strong (expected, 1,
+            std::memory_order_acquire)) {
+      break;
+    }
+  }
+
+  if (NULL == ring) {
+    ring = new GstCtfRing ();
+    ring->owned.store (1);
+    ring->in_flight.store (CTF_RING_IDLE);
+    head = ctf_descriptor->rings.load (std::memory_order_relaxed);
+    do {
+      ring->next = head;
+    } while (!ctf_descriptor->rings.compare_exchange_weak (head, ring,
+            std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  g_private_set (&ctf_thread_ring, ring);
+  return ring;
+}
+
+/* Reserve an event of size bytes in the ring of the calling thread and take
+ * its timestamp. Returns NULL (and counts the event as dropped) if the ring is
+ * full, otherwise the event is written to the returned memory and published by
+ * ctf_event_commit.
+ */
+static guint8 *
+ctf_event_reserve (gsize size, GstCtfRing ** ring_out)
+{
+  GstCtfRing *ring;
+  guint64 head;
+  guint64 tail;
+  gsize offset;
+  gsize contiguous;
+  gsize record_size;
+  gsize needed;
+  gint64 timestamp;
+
+  ring = ctf_get_thread_ring ();
+
+  /* Announce the event before taking its timestamp, a flusher that does not
+   * see it yet took its own time first, which is not newer than the event */
+  ring->in_flight.store (CTF_RING_RESERVING);
+  timestamp =
+      GST_CLOCK_DIFF (ctf_descriptor->start_time,
+      gst_util_get_timestamp ()) / 1000;
+  ring->in_flight.store (timestamp, std::memory_order_release);
+  ring->timestamp = (guint32) timestamp;
+
+  head = ring->head.load (std::memory_order_relaxed);
+  tail = ring->tail.load (std::memory_order_acquire);
+
+  record_size = CTF_RING_RECORD_SIZE (size);
+  offset = head & CTF_RING_MASK;
+  contiguous = CTF_RING_SIZE - offset;
+  /* A record that does not fit before the end of the ring starts over */
+  needed = record_size > contiguous ? contiguous + record_size : record_size;
+
+  if (G_UNLIKELY (head + needed - tail > CTF_RING_SIZE)) {
+    ring->dropped.store (ring->dropped.load (std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    ring->in_flight.store (CTF_RING_IDLE, std::memory_order_release);
+    return NULL;
+  }
+
+  if (record_size > contiguous) {
+    *(guint32 *) (ring->mem + offset) = CTF_RING_PADDING;
+    head += contiguous;
+    offset = 0;
+  }
+
+  *(guint32 *) (ring->mem + offset) = size;
+  ring->reserved = head + record_size;
+  *ring_out = ring;
+
+  return ring->mem + offset + sizeof (guint32);
+}
+
+static void
+ctf_event_commit (GstCtfRing * ring)
+{
+  ring->head.store (ring->reserved, std::memory_order_release);
+  ring->in_flight.store (CTF_RING_IDLE, std::memory_order_release);
+}
+
+typedef struct
+{
+  GstCtfRing *ring;
+  guint64 position;
+  guint64 end;
+} GstCtfRingCursor;
+
+/* Skip a padding record, returns the next event or NULL if there is none */
+static guint8 *
+ctf_cursor_peek (GstCtfRingCursor * cursor, guint32 * size)
+{
+  gsize offset;
+
+  while (cursor->position < cursor->end) {
+    offset = cursor->position & CTF_RING_MASK;
+    *size = *(guint32 *) (cursor->ring->mem + offset);
+    if (CTF_RING_PADDING != *size) {
+      return cursor->ring->mem + offset + sizeof (guint32);
+    }
+    cursor->position += CTF_RING_SIZE - offset;
+  }
+
+  return NULL;
+}
+
+static void
+ctf_write_staged (gsize staged)
+{
+  GError *error = NULL;
+
+  if (0 == staged) {
+    return;
+  }
+  if (!g_output_stream_write_all (ctf_descriptor->output_stream,
+          ctf_descriptor->mem, staged, NULL, NULL, &error)) {
+    GST_ERROR ("Failed to write CTF events to the socket: %s", error->message);
+    g_error_free (error);
+  }
+}
+
+/* Write the events of all the rings to the datastream, merged by timestamp,
+ * in a single pass over all the rings. Unless drain is set, only events that
+ * are not newer than the events still being written (and the current time) are
+ * written, the rest are left for the next flush so the datastream stays in order.
+ * Must be called with the descriptor mutex held, which also makes the caller
+ * the only consumer of the rings.
+ */
+static void
+ctf_flush_rings (gboolean drain)
+{
+  GstCtfRingCursor new_cursor;
+  GstCtfRingCursor *cursor;
+  GstCtfRingCursor *next_cursor;
+  GstCtfRing *ring;
+  guint8 *event;
+  guint8 *next_event;
+  guint8 *tcp_mem;
+  guint32 size;
+  guint32 next_size;
+  gsize staged;
+  guint cursor_idx;
+  gint64 watermark;
+  gint64 in_flight;
+
+  if (NULL == ctf_descriptor->cursors) {
+    ctf_descriptor->cursors =
+        g_array_new (FALSE, FALSE, sizeof (GstCtfRingCursor));
+  }
+  g_array_set_size (ctf_descriptor->cursors, 0);
+
+  /* Events that start after this point are not older than the current time */
+  watermark =
+      GST_CLOCK_DIFF (ctf_descriptor->start_time,
+      gst_util_get_timestamp ()) / 1000;
+  for (ring = ctf_descriptor->rings.load (std::memory_order_acquire);
+      NULL != ring; ring = ring->next) {
+    /* Read before the head, an event committed meanwhile is in the snapshot */
+    in_flight = ring->in_flight.load ();
+    if (CTF_RING_RESERVING == in_flight && !drain) {
+      /* Its timestamp is not known yet, try again on the next flush */
+      return;
+    }
+    if (CTF_RING_RESERVING != in_flight && in_flight < watermark) {
+      watermark = in_flight;
+    }
+    new_cursor.ring = ring;
+    new_cursor.position = ring->tail.load (std::memory_order_relaxed);
+    new_cursor.end = ring->head.load (std::memory_order_acquire);
+    if (new_cursor.position != new_cursor.end) {
+      g_array_append_val (ctf_descriptor->cursors, new_cursor);
+    }
+  }
+
+  staged = 0;
+  while (TRUE) {
+    /* Take the oldest event, each ring is in order by itself */
+    next_cursor = NULL;
+    next_event = NULL;
+    next_size = 0;
+    for (cursor_idx = 0; cursor_idx < ctf_descriptor->cursors->len;
+        ++cursor_idx) {
+      cursor =
+          &g_array_index (ctf_descriptor->cursors, GstCtfRingCursor,
+          cursor_idx);
+      event = ctf_cursor_peek (cursor, &size);
+      if (NULL == event) {
+        continue;
+      }
+      /* Timestamps are 32 bits and wrap around, compare their difference */
+      if (NULL == next_event ||
+          (gint32) (GST_READ_UINT32_LE (event + sizeof (ctf_header_id)) -
+              GST_READ_UINT32_LE (next_event + sizeof (ctf_header_id))) <
+          0) {
+        next_cursor = cursor;
+        next_event = event;
+        next_size = size;
+      }
+    }
+    if (NULL == next_cursor) {
+      break;
+    }
+    /* An event still being written may be older than this one */
+    if (!drain &&
+        (gint32) (GST_READ_UINT32_LE (next_event + sizeof (ctf_header_id)) -
+            (guint32) watermark) > 0) {
+      break;
+    }
+
+    if (FALSE == ctf_descriptor->file_output_disable) {
+      fwrite (next_event, sizeof (gchar), next_size,
+          ctf_descriptor->datastream);
+    }
+
+    if (FALSE == ctf_descriptor->tcp_output_disable) {
+      if (staged + TCP_HEADER_SIZE + next_size > CTF_MEM_SIZE) {
+        ctf_write_staged (staged);
+        staged = 0;
+      }
+      /* Write the TCP header */
+      tcp_mem = ctf_descriptor->mem + staged;
+      TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, next_size, tcp_mem);
+      memcpy (ctf_descriptor->mem + staged + TCP_HEADER_SIZE, next_event,
+          next_size);
+      staged += TCP_HEADER_SIZE + next_size;
+    }
+
+    next_cursor->position += CTF_RING_RECORD_SIZE (next_size);
+  }
+
+  if (FALSE == ctf_descriptor->tcp_output_disable) {
+    ctf_write_staged (staged);
+  }
+
+  /* Hand the space back to the producers */
+  for (cursor_idx = 0; cursor_idx < ctf_descriptor->cursors->len; ++cursor_idx) {
+    cursor =
+        &g_array_index (ctf_descriptor->cursors, GstCtfRingCursor, cursor_idx);
+    cursor->ring->tail.store (cursor->position, std::memory_order_release);
+  }
+}
+
+static gpointer
+ctf_flusher_thread (gpointer data)
+{
+  gint64 end_time;
+
+  g_mutex_lock (&ctf_descriptor->flusher_mutex);
+  while (!ctf_descriptor->closing) {
+    end_time = g_get_monotonic_time () + CTF_FLUSH_INTERVAL_US;
+    g_cond_wait_until (&ctf_descriptor->flusher_cond,
+        &ctf_descriptor->flusher_mutex, end_time);
+    g_mutex_unlock (&ctf_descriptor->flusher_mutex);
+
+    g_mutex_lock (&ctf_descriptor->mutex);
+    ctf_flush_rings (FALSE);
+    g_mutex_unlock (&ctf_descriptor->mutex);
+
+    g_mutex_lock (&ctf_descriptor->flusher_mutex);
+  }
+  g_mutex_unlock (&ctf_descriptor->flusher_mutex);
+
+  return NULL;
+}
+
+/* The tracers are never closed, write the events left in the rings before
+ * the process exits.
+ */
+static void
+ctf_flush_at_exit (void)
+{
+  if (NULL == ctf_descriptor) {
+    return;
+  }
+  g_mutex_lock (&ctf_descriptor->mutex);
+  ctf_flush_rings (TRUE);
+  g_mutex_unlock (&ctf_descriptor->mutex);
+}
+
+guint64
+gst_ctf_get_dropped_events (void)
+{
+  GstCtfRing *ring;
+  guint64 dropped = 0;
+
+  if (NULL == ctf_descriptor) {
+    return 0;
+  }
+  for (ring = ctf_descriptor->rings.load (std::memory_order_acquire);
+      NULL != ring; ring = ring->next) {
+    dropped += ring->dropped.load (std::memory_order_relaxed);
+  }
+
+  return dropped;
+}
+
 gboolean
 gst_ctf_init (void)
 {
@@ -731,6 +1098,12 @@ gst_ctf_init (void)
   generate_datastream_header ();
   do_print_ctf_init (INIT_EVENT_ID);
 
+  g_mutex_init (&ctf_descriptor->flusher_mutex);
+  g_cond_init (&ctf_descriptor->flusher_cond);
+  ctf_descriptor->flusher =
+      g_thread_new ("ctf-flusher", ctf_flusher_thread, NULL);
+  atexit (ctf_flush_at_exit);
+
 
   return TRUE;
 }
@@ -749,7 +1122,8 @@ add_metadata_event_struct (const gchar * metadata_event)
     return;
   }
 
-  mem = ctf_descriptor->mem;
+  /* The descriptor memory is used by the flusher thread */
+  mem = (guint8 *) g_malloc (event_size + TCP_HEADER_SIZE);
   event_mem = (gchar *) mem + TCP_HEADER_SIZE;
 
   /* This function only writes the event structure to the metadata file, it
@@ -765,17 +1139,19 @@ add_metadata_event_struct (const gchar * metadata_event)
     TCP_EVENT_HEADER_WRITE (TCP_METADATA_ID, event_size, mem);
 
     g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
+        event_mem - TCP_HEADER_SIZE, event_size + TCP_HEADER_SIZE, NULL,
+        &error);
   }
   g_mutex_unlock (&ctf_descriptor->mutex);
+
+  g_free (event_mem - TCP_HEADER_SIZE);
 }
 
 
 void
 do_print_cpuusage_event (event_id id, guint32 cpu_num, gfloat * cpuload)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
   guint cpu_idx;
@@ -786,40 +1162,26 @@ do_print_cpuusage_event (event_id id, guint32 cpu_num, gfloat * cpuload)
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem, datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Write CPU load for each CPU */
   for (cpu_idx = 0; cpu_idx < cpu_num; ++cpu_idx) {
     /* Write CPU load */
     CTF_EVENT_WRITE_FLOAT (cpuload[cpu_idx], event_mem);
   }
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem = mem + TCP_HEADER_SIZE;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
 do_print_proctime_event (event_id id, gchar * elementname, guint64 time)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
 
@@ -829,39 +1191,25 @@ do_print_proctime_event (event_id id, gchar * elementname, guint64 time)
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Write element name */
   CTF_EVENT_WRITE_STRING (elementname, event_mem);
   /* Write time */
   CTF_EVENT_WRITE_INT64 (time, event_mem);
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem -= event_size;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
 do_print_framerate_event (event_id id, gchar * elementname, guint64 fps)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
 
@@ -871,40 +1219,26 @@ do_print_framerate_event (event_id id, gchar * elementname, guint64 fps)
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Write element name */
   CTF_EVENT_WRITE_STRING (elementname, event_mem);
   /* Write fps */
   CTF_EVENT_WRITE_INT64 (fps, event_mem);
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem = mem + TCP_HEADER_SIZE;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
 do_print_interlatency_event (event_id id,
     gchar * originpad, gchar * destinationpad, guint64 time)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
 
@@ -916,13 +1250,13 @@ do_print_interlatency_event (event_id id,
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Add event payload */
   /* Write origin pad name */
   CTF_EVENT_WRITE_STRING (originpad, event_mem);
@@ -931,26 +1265,13 @@ do_print_interlatency_event (event_id id,
   /* Write time */
   CTF_EVENT_WRITE_INT64 (time, event_mem);
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem = mem + TCP_HEADER_SIZE;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
 do_print_scheduling_event (event_id id, gchar * elementname, guint64 time)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
 
@@ -960,33 +1281,20 @@ do_print_scheduling_event (event_id id, gchar * elementname, guint64 time)
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Add event payload */
   /* Write element name */
   CTF_EVENT_WRITE_STRING (elementname, event_mem);
   /* Write time */
   CTF_EVENT_WRITE_INT64 (time, event_mem);
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem = mem + TCP_HEADER_SIZE;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
@@ -994,8 +1302,7 @@ do_print_queue_level_event (event_id id, const gchar * elementname,
     guint32 bytes, guint32 max_bytes, guint32 buffers, guint32 max_buffers,
     guint64 time, guint64 max_time)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
 
@@ -1007,13 +1314,13 @@ do_print_queue_level_event (event_id id, const gchar * elementname,
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Add event payload */
   /* Write element name */
   CTF_EVENT_WRITE_STRING (elementname, event_mem);
@@ -1036,27 +1343,13 @@ do_print_queue_level_event (event_id id, const gchar * elementname,
   /* Write time */
   CTF_EVENT_WRITE_INT64 (max_time, event_mem);
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem = mem + TCP_HEADER_SIZE;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
 do_print_bitrate_event (event_id id, gchar * elementname, guint64 bps)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
 
@@ -1066,32 +1359,19 @@ do_print_bitrate_event (event_id id, gchar * elementname, guint64 bps)
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Write element name */
   CTF_EVENT_WRITE_STRING (elementname, event_mem);
   /* Write bitrate */
   CTF_EVENT_WRITE_INT64 (bps, event_mem);
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem = mem + TCP_HEADER_SIZE;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
@@ -1099,8 +1379,7 @@ do_print_buffer_event (event_id id, const gchar * pad, GstClockTime pts,
     GstClockTime dts, GstClockTime duration, guint64 offset,
     guint64 offset_end, guint64 size, GstBufferFlags flags, guint32 refcount)
 {
-  GError *error;
-  guint8 *mem;
+  GstCtfRing *ring;
   guint8 *event_mem;
   gsize event_size;
 
@@ -1112,13 +1391,13 @@ do_print_buffer_event (event_id id, const gchar * pad, GstClockTime pts,
     return;
   }
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
-
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
 
   /* Write event specific fields */
   CTF_EVENT_WRITE_STRING (pad, event_mem);
@@ -1131,58 +1410,30 @@ do_print_buffer_event (event_id id, const gchar * pad, GstClockTime pts,
   CTF_EVENT_WRITE_INT32 (flags, event_mem);
   CTF_EVENT_WRITE_INT32 (refcount, event_mem);
 
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem -= event_size;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
 do_print_ctf_init (event_id id)
 {
-  GError *error;
+  GstCtfRing *ring;
   guint32 unknown = 0;
-  guint8 *mem;
   guint8 *event_mem;
   gsize event_size;
 
-  mem = ctf_descriptor->mem;
-  event_mem = mem + TCP_HEADER_SIZE;
+  event_size = sizeof (unknown) + CTF_HEADER_SIZE;
 
-  /* Lock mem and datastream and output_stream resources */
-  g_mutex_lock (&ctf_descriptor->mutex);
+  /* Events are written to the ring of this thread, without a lock */
+  event_mem = ctf_event_reserve (event_size, &ring);
+  if (NULL == event_mem) {
+    return;
+  }
   /* Add CTF header */
-  CTF_EVENT_WRITE_HEADER (id, event_mem);
+  CTF_EVENT_WRITE_HEADER (id, ring, event_mem);
   /* Write padding */
   CTF_EVENT_WRITE_INT32 (unknown, event_mem);
 
-  /* Computer event size */
-  event_size = event_mem - (mem + TCP_HEADER_SIZE);
-
-  if (FALSE == ctf_descriptor->file_output_disable) {
-    event_mem = mem + TCP_HEADER_SIZE;
-    fwrite (event_mem, sizeof (gchar), event_size, ctf_descriptor->datastream);
-  }
-
-  if (FALSE == ctf_descriptor->tcp_output_disable) {
-    /* Write the TCP header */
-    TCP_EVENT_HEADER_WRITE (TCP_DATASTREAM_ID, event_size, mem);
-
-    g_output_stream_write (ctf_descriptor->output_stream,
-        ctf_descriptor->mem, event_size + TCP_HEADER_SIZE, NULL, &error);
-  }
-
-  g_mutex_unlock (&ctf_descriptor->mutex);
+  ctf_event_commit (ring);
 }
 
 void
@@ -1190,6 +1441,41 @@ gst_ctf_close (void)
 {
   GError *error;
   gboolean res;
+  GstCtfRing *ring;
+  GstCtfRing *next;
+  guint64 dropped;
+
+  /* Stop the flusher and write the events left in the rings */
+  g_mutex_lock (&ctf_descriptor->flusher_mutex);
+  ctf_descriptor->closing = TRUE;
+  g_cond_signal (&ctf_descriptor->flusher_cond);
+  g_mutex_unlock (&ctf_descriptor->flusher_mutex);
+  g_thread_join (ctf_descriptor->flusher);
+  g_mutex_clear (&ctf_descriptor->flusher_mutex);
+  g_cond_clear (&ctf_descriptor->flusher_cond);
+
+  g_mutex_lock (&ctf_descriptor->mutex);
+  ctf_flush_rings (TRUE);
+  g_mutex_unlock (&ctf_descriptor->mutex);
+
+  dropped = gst_ctf_get_dropped_events ();
+  if (0 != dropped) {
+    GST_WARNING ("%" G_GUINT64_FORMAT " CTF events were dropped since their "
+        "ring was full", dropped);
+  }
+
+  /* Rings of threads that are still alive are left to them */
+  for (ring = ctf_descriptor->rings.load (); NULL != ring; ring = next) {
+    next = ring->next;
+    if (0 == ring->owned.load ()) {
+      delete ring;
+    }
+  }
+
+  if (NULL != ctf_descriptor->cursors) {
+    g_array_free (ctf_descriptor->cursors, TRUE);
+  }
+
   fclose (ctf_descriptor->metadata);
   fclose (ctf_descriptor->datastream);
   g_mutex_clear (&ctf_descriptor->mutex);
@@ -1213,4 +1499,5 @@ gst_ctf_close (void)
   }
 
   g_free (ctf_descriptor);
+  ctf_descriptor = NULL;
 }
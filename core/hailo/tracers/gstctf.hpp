@@ -53,4 +53,6 @@ void do_print_buffer_event (event_id id, const gchar * pad, GstClockTime pts,
     guint64 offset_end, guint64 size, GstBufferFlags flags,
     guint32 refcount);
 void do_print_ctf_init (event_id id);
+/* Number of events dropped so far because the ring of their thread was full */
+guint64 gst_ctf_get_dropped_events (void);
 G_END_DECLS
\ No newline at end of file
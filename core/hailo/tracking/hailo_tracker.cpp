@@ -9,67 +9,104 @@
 #include "hailo_tracker.hpp"
 #include "hailo_common.hpp"
 
-std::mutex HailoTracker::mutex_;
+#include <shared_mutex>
+#include <unordered_map>
+
+struct HailoTrackerShard
+{
+    std::mutex mutex; // Guards tracker
+    JDETracker tracker;
+
+    template <typename... Args>
+    HailoTrackerShard(Args &&...args) : tracker(std::forward<Args>(args)...){};
+};
 
 class HailoTracker::HailoTrackerPrivate
 {
 public:
-    std::map<std::string, JDETracker> trackers;
+    // The registry lock is only taken to find, add or remove a tracker, never while a tracker is updated
+    std::shared_mutex registry_mutex;
+    std::unordered_map<std::string, HailoTrackerHandle> trackers;
 };
 
 HailoTracker::HailoTracker() : priv(std::make_unique<HailoTrackerPrivate>()){};
 HailoTracker::~HailoTracker(){};
 HailoTracker &HailoTracker::GetInstance()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    // Initialization of a function local static is thread safe
     static HailoTracker instance;
     return instance;
 }
 
+HailoTrackerHandle HailoTracker::get_jde_tracker(const std::string &name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(priv->registry_mutex);
+        auto it = priv->trackers.find(name);
+        if (it != priv->trackers.end())
+            return it->second;
+    }
+    // Not found, create a tracker with the default parameters (another thread may have done so meanwhile)
+    std::unique_lock<std::shared_mutex> lock(priv->registry_mutex);
+    auto &tracker = priv->trackers[name];
+    if (!tracker)
+        tracker = std::make_shared<HailoTrackerShard>();
+    return tracker;
+}
+
 void HailoTracker::remove_jde_tracker(const std::string &name)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::shared_mutex> lock(priv->registry_mutex);
     priv->trackers.erase(name);
 }
 
 void HailoTracker::add_jde_tracker(const std::string &name, HailoTrackerParams tracker_params)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::shared_mutex> lock(priv->registry_mutex);
+    if (priv->trackers.count(name))
+        return;
 
-    priv->trackers.emplace(std::piecewise_construct, std::forward_as_tuple(name),
-                           std::forward_as_tuple(tracker_params.kalman_distance,
-                                                 tracker_params.iou_threshold,
-                                                 tracker_params.init_iou_threshold,
-                                                 tracker_params.keep_tracked_frames,
-                                                 tracker_params.keep_new_frames,
-                                                 tracker_params.keep_lost_frames,
-                                                 tracker_params.keep_past_metadata,
-                                                 tracker_params.std_weight_position,
-                                                 tracker_params.std_weight_position_box,
-                                                 tracker_params.std_weight_velocity,
-                                                 tracker_params.std_weight_velocity_box,
-                                                 tracker_params.debug,
-                                                 tracker_params.hailo_objects_blacklist));
+    priv->trackers.emplace(name, std::make_shared<HailoTrackerShard>(tracker_params.kalman_distance,
+                                                                     tracker_params.iou_threshold,
+                                                                     tracker_params.init_iou_threshold,
+                                                                     tracker_params.keep_tracked_frames,
+                                                                     tracker_params.keep_new_frames,
+                                                                     tracker_params.keep_lost_frames,
+                                                                     tracker_params.keep_past_metadata,
+                                                                     tracker_params.std_weight_position,
+                                                                     tracker_params.std_weight_position_box,
+                                                                     tracker_params.std_weight_velocity,
+                                                                     tracker_params.std_weight_velocity_box,
+                                                                     tracker_params.debug,
+                                                                     tracker_params.hailo_objects_blacklist));
 }
 
 void HailoTracker::add_jde_tracker(const std::string &name)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers.emplace(name, JDETracker());
+    std::unique_lock<std::shared_mutex> lock(priv->registry_mutex);
+    if (!priv->trackers.count(name))
+        priv->trackers.emplace(name, std::make_shared<HailoTrackerShard>());
 }
 
 std::vector<HailoDetectionPtr> HailoTracker::update(const std::string &name, std::vector<HailoDetectionPtr> &inputs)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    auto online_stracks = priv->trackers[name].update(inputs);
-    bool debug = priv->trackers[name].get_debug();
+    return update(get_jde_tracker(name), inputs);
+}
+
+std::vector<HailoDetectionPtr> HailoTracker::update(const HailoTrackerHandle &tracker, std::vector<HailoDetectionPtr> &inputs)
+{
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    auto online_stracks = tracker->tracker.update(inputs);
+    bool debug = tracker->tracker.get_debug();
+    // The stracks point into the tracker, convert them before releasing its lock
     return JDETracker::stracks_to_hailo_detections(online_stracks, debug);
 }
 
 void HailoTracker::add_object_to_track(const std::string &name, int track_id, HailoObjectPtr obj)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    STrack *tracked_detection = priv->trackers[name].get_detection_with_id(track_id);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    STrack *tracked_detection = tracker->tracker.get_detection_with_id(track_id);
     if (nullptr != tracked_detection)
     {
         tracked_detection->add_object(obj);
@@ -78,8 +115,9 @@ void HailoTracker::add_object_to_track(const std::string &name, int track_id, Ha
 
 void HailoTracker::remove_matrices_from_track(const std::string &name, int track_id)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    STrack *tracked_detection = priv->trackers[name].get_detection_with_id(track_id);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    STrack *tracked_detection = tracker->tracker.get_detection_with_id(track_id);
     if (tracked_detection)
     {
         std::vector<HailoObjectPtr> matrices;
@@ -95,8 +133,9 @@ void HailoTracker::remove_matrices_from_track(const std::string &name, int track
 
 void HailoTracker::remove_classifications_from_track(const std::string &name, int track_id, std::string classifier_type)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    STrack *tracked_detection = priv->trackers[name].get_detection_with_id(track_id);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    STrack *tracked_detection = tracker->tracker.get_detection_with_id(track_id);
     if (tracked_detection)
     {
         hailo_common::remove_classifications(tracked_detection->get_hailo_detection(), classifier_type);
@@ -106,67 +145,80 @@ void HailoTracker::remove_classifications_from_track(const std::string &name, in
 // Setters for members accessible at element-property level
 void HailoTracker::set_kalman_distance(const std::string &name, float new_distance)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_kalman_distance(new_distance);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_kalman_distance(new_distance);
 }
 void HailoTracker::set_iou_threshold(const std::string &name, float new_iou_thr)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_iou_threshold(new_iou_thr);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_iou_threshold(new_iou_thr);
 }
 void HailoTracker::set_init_iou_threshold(const std::string &name, float new_init_iou_thr)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_init_iou_threshold(new_init_iou_thr);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_init_iou_threshold(new_init_iou_thr);
 }
 void HailoTracker::set_keep_tracked_frames(const std::string &name, int new_keep_tracked)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_keep_tracked_frames(new_keep_tracked);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_keep_tracked_frames(new_keep_tracked);
 }
 void HailoTracker::set_keep_new_frames(const std::string &name, int new_keep_new)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_keep_new_frames(new_keep_new);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_keep_new_frames(new_keep_new);
 }
 void HailoTracker::set_keep_lost_frames(const std::string &name, int new_keep_lost)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_keep_lost_frames(new_keep_lost);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_keep_lost_frames(new_keep_lost);
 }
 void HailoTracker::set_keep_past_metadata(const std::string &name, bool new_keep_past)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_keep_past_metadata(new_keep_past);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_keep_past_metadata(new_keep_past);
 }
 void HailoTracker::set_std_weight_position(const std::string &name, float new_std_weight_pos)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_std_weight_position(new_std_weight_pos);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_std_weight_position(new_std_weight_pos);
 }
 void HailoTracker::set_std_weight_position_box(const std::string &name, float new_std_weight_position_box)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_std_weight_position_box(new_std_weight_position_box);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_std_weight_position_box(new_std_weight_position_box);
 }
 void HailoTracker::set_std_weight_velocity(const std::string &name, float new_std_weight_vel)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_std_weight_velocity(new_std_weight_vel);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_std_weight_velocity(new_std_weight_vel);
 }
 void HailoTracker::set_std_weight_velocity_box(const std::string &name, float new_std_weight_velocity_box)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_std_weight_velocity_box(new_std_weight_velocity_box);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_std_weight_velocity_box(new_std_weight_velocity_box);
 }
 void HailoTracker::set_debug(const std::string &name, bool new_debug)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_debug(new_debug);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_debug(new_debug);
 }
 
 void HailoTracker::set_hailo_objects_blacklist(const std::string &name, std::vector<hailo_object_t> hailo_objects_blacklist_vec)
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    priv->trackers[name].set_hailo_objects_blacklist(hailo_objects_blacklist_vec);
+    HailoTrackerHandle tracker = get_jde_tracker(name);
+    std::lock_guard<std::mutex> lock(tracker->mutex);
+    tracker->tracker.set_hailo_objects_blacklist(hailo_objects_blacklist_vec);
 }
\ No newline at end of file
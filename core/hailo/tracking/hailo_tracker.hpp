@@ -10,6 +10,7 @@
 #include <mutex>
 #include <thread>
 #include <map>
+#include <memory>
 
 #include "hailo_objects.hpp"
 
@@ -45,6 +46,13 @@ struct HailoTrackerParams
     std::vector<hailo_object_t> hailo_objects_blacklist;
 };
 
+/**
+ * A JDETracker and the lock that guards it. Trackers share no state, so each one is locked on its own
+ * and trackers of different streams run in parallel.
+ */
+struct HailoTrackerShard;
+using HailoTrackerHandle = std::shared_ptr<HailoTrackerShard>;
+
 class HailoTracker
 {
 private:
@@ -54,14 +62,19 @@ private:
     HailoTracker &operator=(const HailoTracker &) = delete;
     ~HailoTracker();
     HailoTracker();
-    static std::mutex mutex_;
 
 public:
     static HailoTracker &GetInstance();
     void add_jde_tracker(const std::string &name, HailoTrackerParams params);
     void add_jde_tracker(const std::string &name);
     void remove_jde_tracker(const std::string &name);
+    /**
+     * @brief Get a stable handle of a tracker (created with the default parameters if there is none by this name).
+     *        The handle skips the lookup by name, and stays valid after the tracker is removed.
+     */
+    HailoTrackerHandle get_jde_tracker(const std::string &name);
     std::vector<HailoDetectionPtr> update(const std::string &name, std::vector<HailoDetectionPtr> &inputs);
+    std::vector<HailoDetectionPtr> update(const HailoTrackerHandle &tracker, std::vector<HailoDetectionPtr> &inputs);
     void add_object_to_track(const std::string &name, int id, HailoObjectPtr obj);
     void remove_classifications_from_track(const std::string &name, int track_id, std::string classifier_type);
     void remove_matrices_from_track(const std::string &name, int track_id);
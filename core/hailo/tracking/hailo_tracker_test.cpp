@@ -0,0 +1,193 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Concurrency check of the HailoTracker singleton: 16 threads each update a tracker of their own,
+  by name and through a handle, while another thread keeps adding, getting and removing trackers.
+  Every stream must track exactly as it does alone, and a handle must outlive the removal of its tracker.
+  The updates per second of 1 and 16 threads are printed, trackers of different streams should not wait for each other.
+  Usage: hailo_tracker_test [frames per stream]
+*/
+
+// General cpp includes
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tappas includes
+#include "hailo_tracker.hpp"
+
+static std::atomic<int> failures(0);
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+#define NUM_STREAMS (16)
+#define NUM_OBJECTS (20)
+
+struct MovingObject
+{
+    float x, y, w, h, vx, vy;
+};
+
+/**
+ * Detections of a stream: objects moving across the frame, some of them missed on a frame.
+ * The same seed gives the same frames.
+ */
+static std::vector<std::vector<HailoDetectionPtr>> stream_frames(unsigned int seed, int frames)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<MovingObject> objects(NUM_OBJECTS);
+    for (MovingObject &object : objects)
+        object = {uniform(rng) * 0.8f, uniform(rng) * 0.8f, 0.05f + uniform(rng) * 0.1f, 0.05f + uniform(rng) * 0.1f,
+                  (uniform(rng) - 0.5f) * 0.01f, (uniform(rng) - 0.5f) * 0.01f};
+
+    std::vector<std::vector<HailoDetectionPtr>> stream(frames);
+    for (auto &detections : stream)
+    {
+        for (MovingObject &object : objects)
+        {
+            object.x += object.vx;
+            object.y += object.vy;
+            if (object.x < 0.0f || object.x > 0.8f)
+                object.vx = -object.vx;
+            if (object.y < 0.0f || object.y > 0.8f)
+                object.vy = -object.vy;
+            if (uniform(rng) < 0.1f)
+                continue;
+            detections.push_back(std::make_shared<HailoDetection>(HailoBBox(object.x, object.y, object.w, object.h), "person", 0.9f));
+        }
+    }
+    return stream;
+}
+
+// Boxes reported for every frame, track ids are left out since the id counter is shared by all the trackers
+using TrackedBoxes = std::vector<std::vector<std::array<float, 4>>>;
+
+static void add_frame(TrackedBoxes &tracked, const std::vector<HailoDetectionPtr> &outputs)
+{
+    tracked.emplace_back();
+    for (const HailoDetectionPtr &output : outputs)
+    {
+        HailoBBox bbox = output->get_bbox();
+        tracked.back().push_back({bbox.xmin(), bbox.ymin(), bbox.width(), bbox.height()});
+    }
+}
+
+// Copies of the detections, the tracker keeps and updates the detections it is given
+static std::vector<HailoDetectionPtr> copy_frame(const std::vector<HailoDetectionPtr> &detections)
+{
+    std::vector<HailoDetectionPtr> copy;
+    for (const HailoDetectionPtr &detection : detections)
+        copy.push_back(std::make_shared<HailoDetection>(detection->get_bbox(), detection->get_label(), detection->get_confidence()));
+    return copy;
+}
+
+/**
+ * Runs a stream on the tracker of name, alternating between the update by name and by handle.
+ * The handle is fetched again now and then, as an element does when its properties change.
+ */
+static TrackedBoxes run_stream(const std::string &name, const std::vector<std::vector<HailoDetectionPtr>> &stream)
+{
+    HailoTracker &hailo_tracker = HailoTracker::GetInstance();
+    HailoTrackerHandle handle = hailo_tracker.get_jde_tracker(name);
+    TrackedBoxes tracked;
+    for (size_t frame = 0; frame < stream.size(); frame++)
+    {
+        std::vector<HailoDetectionPtr> detections = copy_frame(stream[frame]);
+        if (frame % 16 == 0)
+            handle = hailo_tracker.get_jde_tracker(name);
+        add_frame(tracked, frame % 2 ? hailo_tracker.update(name, detections) : hailo_tracker.update(handle, detections));
+    }
+    return tracked;
+}
+
+static double updates_per_second(int threads, int frames, const std::vector<std::vector<std::vector<HailoDetectionPtr>>> &streams)
+{
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back([i, &streams]
+                             { run_stream("bench_" + std::to_string(i), streams[i]); });
+    for (std::thread &worker : workers)
+        worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for (int i = 0; i < threads; i++)
+        HailoTracker::GetInstance().remove_jde_tracker("bench_" + std::to_string(i));
+    return threads * frames / seconds;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 300;
+    HailoTracker &hailo_tracker = HailoTracker::GetInstance();
+
+    std::vector<std::vector<std::vector<HailoDetectionPtr>>> streams;
+    for (int i = 0; i < NUM_STREAMS; i++)
+        streams.push_back(stream_frames(i + 1, frames));
+
+    // Reference: every stream alone
+    std::vector<TrackedBoxes> expected;
+    for (int i = 0; i < NUM_STREAMS; i++)
+    {
+        expected.push_back(run_stream("reference", streams[i]));
+        hailo_tracker.remove_jde_tracker("reference");
+    }
+
+    // All the streams at once, while trackers of other names come and go
+    std::atomic<bool> done(false);
+    std::thread churn([&done, &hailo_tracker]
+                      {
+                          for (int i = 0; !done; i++)
+                          {
+                              std::string name = "churn_" + std::to_string(i % 8);
+                              hailo_tracker.add_jde_tracker(name);
+                              HailoTrackerHandle handle = hailo_tracker.get_jde_tracker(name);
+                              hailo_tracker.set_keep_lost_frames(name, 3);
+                              hailo_tracker.remove_jde_tracker(name);
+                              // The handle still holds the removed tracker
+                              std::vector<HailoDetectionPtr> detections{std::make_shared<HailoDetection>(HailoBBox(0.1f, 0.1f, 0.2f, 0.2f), "person", 0.9f)};
+                              hailo_tracker.update(handle, detections);
+                          } });
+    std::vector<TrackedBoxes> results(NUM_STREAMS);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < NUM_STREAMS; i++)
+        workers.emplace_back([i, &streams, &results]
+                             { results[i] = run_stream("stream_" + std::to_string(i), streams[i]); });
+    for (std::thread &worker : workers)
+        worker.join();
+    done = true;
+    churn.join();
+
+    for (int i = 0; i < NUM_STREAMS; i++)
+    {
+        CHECK(!expected[i].back().empty());
+        CHECK(results[i] == expected[i]);
+        hailo_tracker.remove_jde_tracker("stream_" + std::to_string(i));
+    }
+
+    double single = updates_per_second(1, frames, streams);
+    double parallel = updates_per_second(NUM_STREAMS, frames, streams);
+    std::printf("updates/s: 1 thread %.0f, %d threads %.0f (%.1fx, %u hardware threads)\n",
+                single, NUM_STREAMS, parallel, parallel / single, std::thread::hardware_concurrency());
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
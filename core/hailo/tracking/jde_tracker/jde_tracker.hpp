@@ -10,6 +10,7 @@
 
 // General cpp includes
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
@@ -34,9 +35,33 @@
 #define DEFAULT_STD_WEIGHT_VELOCITY_BOX (0.00000001)
 #define DEFAULT_DEBUG (false)
 
+/**
+ * @brief Scratch storage of JDETracker::linear_assignment, reused from frame to frame.
+ *        The cost matrix is split into independent components, these arrays describe the
+ *        components and hold the padded cost matrix of the component that is being solved.
+ */
+struct LinearAssignmentArena
+{
+    std::vector<int> parent;             // Union-find forest over the rows and columns (rows first)
+    std::vector<int> component;          // Component of each row and column
+    std::vector<int> row_offsets;        // Start of the rows of each component in component_rows
+    std::vector<int> col_offsets;        // Start of the columns of each component in component_cols
+    std::vector<int> component_rows;     // Rows, grouped by component
+    std::vector<int> component_cols;     // Columns, grouped by component
+    std::vector<cost_t> component_cost;  // Padded square cost matrix of a component
+    std::vector<int_t> x;                // Column assigned to each row of a component by lapjv
+    std::vector<int_t> y;                // Row assigned to each column of a component by lapjv
+    std::vector<int> rowsol;             // Column matched to each row, -1 if unmatched
+    std::vector<int> colsol;             // Row matched to each column, -1 if unmatched
+    lapjv_workspace workspace;           // Work arrays of lapjv
+};
+
 __BEGIN_DECLS
 class JDETracker
 {
+    // Reaches linear_assignment, see jde_tracker_lapjv_test.cpp
+    friend class JDETrackerLapjvTest;
+
     //******************************************************************
     // CLASS MEMBERS
     //******************************************************************
@@ -51,12 +76,38 @@ private:
     int m_frame_id{0};         // the current frame id
     bool m_debug;              // debug flag to ebable output new and lost tracks
 
-    std::vector<STrack> m_tracked_stracks;                 // Currently tracked STracks
-    std::vector<STrack> m_lost_stracks;                    // Currently lost STracks
-    std::vector<STrack> m_new_stracks;                     // Currently new STracks
+    // All STracks live in m_stracks and are referred to by their slot (index) in it. The lists of
+    // tracked/lost/new STracks hold slots, so moving an STrack between lists never copies it.
+    // Slots of dropped STracks are reused, so m_stracks stops growing once the scene is populated.
+    std::vector<STrack> m_stracks;                         // STrack storage, indexed by slot
+    std::vector<int> m_free_slots;                         // Slots of m_stracks that hold no STrack
+    std::vector<int> m_tracked_stracks;                    // Slots of the currently tracked STracks
+    std::vector<int> m_lost_stracks;                       // Slots of the currently lost STracks
+    std::vector<int> m_new_stracks;                        // Slots of the currently new STracks
     KalmanFilter m_kalman_filter;                          // Kalman Filter
     std::vector<hailo_object_t> m_hailo_objects_blacklist; // Objects that will never be kept track of
 
+    // Scratch lists of update(), members so that their capacity is reused from frame to frame
+    std::vector<int> m_detections;                       // Slots of the new detections in this update
+    std::vector<int> m_strack_pool;                      // Slots of the tracked/lost stracks to find matches for
+    std::vector<int> m_unconfirmed_pool;                 // Slots of the new stracks to find matches for
+    std::vector<int> m_activated_stracks;                // Slots of the stracks that are tracked after this update
+    std::vector<int> m_updated_lost_stracks;             // Slots of the stracks that are lost after this update
+    std::vector<int> m_updated_new_stracks;              // Slots of the stracks that are new after this update
+    std::vector<std::pair<int, int>> m_matches;          // Pairs of matches between sets of stracks
+    std::vector<int> m_unmatched_tracked;                // Unmatched tracked stracks
+    std::vector<int> m_unmatched_detections;             // Unmatched new detections
+    std::vector<int> m_track_ids;                        // Sorted track ids, used to join lists of stracks
+    std::vector<char> m_slot_marks;                      // Slots that are in use, used to find the free slots
+    TrackerTypes::CostMatrix m_distances;                // A distance cost matrix for linear assignment
+    std::vector<std::array<float, 4>> m_atlbrs;          // Boxes of the rows of an iou distance
+    std::vector<std::array<float, 4>> m_btlbrs;          // Boxes of the columns of an iou distance
+    std::vector<float> m_track_features;                 // Smoothed features of the tracks, one row per track
+    std::vector<float> m_detection_features;             // Current features of the detections, one row per detection
+    std::vector<TrackerTypes::DETECTBOX> m_measurements; // Detections as measurements for the gating distance
+    std::vector<float> m_gating_distance;                // Gating distances of a track to the measurements
+    LinearAssignmentArena m_assignment_arena;            // Scratch storage of linear_assignment
+
     //******************************************************************
     // CLASS RESOURCE MANAGEMENT
     //******************************************************************
@@ -118,29 +169,28 @@ public:
     //******************************************************************
     /******************** PUBLIC FUNCTIONS ****************************/
 public:
-    static std::vector<STrack> hailo_detections_to_stracks(std::vector<HailoDetectionPtr> &inputs, int frame_id, std::vector<hailo_object_t> hailo_objects_blacklist);
-    static std::vector<HailoDetectionPtr> stracks_to_hailo_detections(std::vector<STrack> &stracks, bool debug);
+    static std::vector<HailoDetectionPtr> stracks_to_hailo_detections(std::vector<STrack *> &stracks, bool debug);
     STrack *get_detection_with_id(int track_id);
-    std::vector<STrack> get_tracked_stracks();
-    std::vector<STrack> update(std::vector<HailoDetectionPtr> &inputs, bool report_unconfirmed, bool report_lost);
+    std::vector<STrack *> get_tracked_stracks();
+    std::vector<STrack *> update(std::vector<HailoDetectionPtr> &inputs, bool report_unconfirmed, bool report_lost);
 
     /******************** PRIVATE FUNCTIONS ****************************/
 private:
-    void update_unmatches(std::vector<STrack *> strack_pool, std::vector<STrack> &tracked_stracks, std::vector<STrack> &lost_stracks, std::vector<STrack> &new_stracks);
-    void update_matches(std::vector<std::pair<int, int>> matches, std::vector<STrack *> tracked_stracks, std::vector<STrack> &detections, std::vector<STrack> &activated_stracks);
-    void linear_assignment(std::vector<std::vector<float>> &cost_matrix, int cost_matrix_rows, int cost_matrix_cols, float thresh, std::vector<std::pair<int, int>> &matches, std::vector<int> &unmatched_a, std::vector<int> &unmatched_b);
+    int acquire_slot(STrack &&strack);
+    void release_unused_slots();
+    void hailo_detections_to_stracks(std::vector<HailoDetectionPtr> &inputs, std::vector<int> &detections);
+
+    void update_unmatches(const std::vector<int> &strack_pool, std::vector<int> &tracked_stracks, std::vector<int> &lost_stracks, std::vector<int> &new_stracks);
+    void update_matches(const std::vector<std::pair<int, int>> &matches, const std::vector<int> &tracked_stracks, const std::vector<int> &detections, std::vector<int> &activated_stracks);
+    void linear_assignment(const TrackerTypes::CostMatrix &cost_matrix, float thresh, std::vector<std::pair<int, int>> &matches, std::vector<int> &unmatched_a, std::vector<int> &unmatched_b);
+    void solve_component(const TrackerTypes::CostMatrix &cost_matrix, float thresh, int component);
 
-    std::vector<std::vector<float>> iou_distance(std::vector<STrack *> &atracks, std::vector<STrack> &btracks);
-    std::vector<std::vector<float>> iou_distance(std::vector<STrack> &atracks, std::vector<STrack> &btracks);
+    void iou_distance(const std::vector<int> &atracks, const std::vector<int> &btracks, TrackerTypes::CostMatrix &cost_matrix);
 
-    std::vector<STrack *> joint_strack_pointers(std::vector<STrack *> &tlista, std::vector<STrack *> &tlistb);
-    std::vector<STrack *> joint_strack_pointers(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
-    std::vector<STrack> joint_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
-    std::vector<STrack> sub_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb);
-    void remove_duplicate_stracks(std::vector<STrack> &stracksa, std::vector<STrack> &stracksb);
+    void joint_stracks(const std::vector<int> &tlista, const std::vector<int> &tlistb, std::vector<int> &joint);
 
-    void embedding_distance(std::vector<STrack *> &tracks, std::vector<STrack> &detections, std::vector<std::vector<float>> &cost_matrix);
-    void fuse_motion(std::vector<std::vector<float>> &cost_matrix, std::vector<STrack *> &tracks, std::vector<STrack> &detections, float lambda_);
+    void embedding_distance(const std::vector<int> &tracks, const std::vector<int> &detections, TrackerTypes::CostMatrix &cost_matrix);
+    void fuse_motion(TrackerTypes::CostMatrix &cost_matrix, const std::vector<int> &tracks, const std::vector<int> &detections, float lambda_);
 };
 __END_DECLS
 
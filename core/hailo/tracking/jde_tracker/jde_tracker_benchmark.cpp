@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Frames per second of the JDE tracker by number of tracks: a scene of moving objects, some of them
+  missed on a frame, is tracked and the time of update() is measured.
+  Usage: jde_tracker_benchmark [frames] [objects...]
+*/
+
+// General cpp includes
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Tappas includes
+#include "jde_tracker.hpp"
+
+struct MovingObject
+{
+    float x, y, w, h, vx, vy;
+};
+
+static std::vector<std::vector<HailoDetectionPtr>> scene_frames(int num_objects, int frames)
+{
+    std::mt19937 rng(num_objects);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::vector<MovingObject> objects(num_objects);
+    for (MovingObject &object : objects)
+        object = {uniform(rng) * 0.9f, uniform(rng) * 0.9f, 0.01f + uniform(rng) * 0.05f, 0.01f + uniform(rng) * 0.05f,
+                  (uniform(rng) - 0.5f) * 0.005f, (uniform(rng) - 0.5f) * 0.005f};
+
+    std::vector<std::vector<HailoDetectionPtr>> scene(frames);
+    for (auto &detections : scene)
+    {
+        for (MovingObject &object : objects)
+        {
+            object.x += object.vx;
+            object.y += object.vy;
+            if (object.x < 0.0f || object.x > 0.9f)
+                object.vx = -object.vx;
+            if (object.y < 0.0f || object.y > 0.9f)
+                object.vy = -object.vy;
+            if (uniform(rng) < 0.1f)
+                continue;
+            detections.push_back(std::make_shared<HailoDetection>(HailoBBox(object.x, object.y, object.w, object.h), "person", 0.9f));
+        }
+    }
+    return scene;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? std::atoi(argv[1]) : 300;
+    std::vector<int> object_counts;
+    for (int i = 2; i < argc; i++)
+        object_counts.push_back(std::atoi(argv[i]));
+    if (object_counts.empty())
+        object_counts = {10, 25, 50, 100, 200, 400};
+
+    std::printf("%-8s %12s %12s %12s\n", "objects", "mean tracks", "us/frame", "fps");
+    for (int num_objects : object_counts)
+    {
+        // Detections are built up front, the tracker keeps the ones it is given
+        std::vector<std::vector<HailoDetectionPtr>> scene = scene_frames(num_objects, frames);
+        JDETracker tracker(0.7f, 0.8f, 0.9f, 2, 2, 3, true, 0.01, 1e-8, 0.001, 1e-8, false);
+        size_t tracks = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (auto &detections : scene)
+            tracks += tracker.update(detections, false, false).size();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%-8d %12.1f %12.1f %12.0f\n", num_objects, (double)tracks / frames, seconds * 1e6 / frames, frames / seconds);
+    }
+    return 0;
+}
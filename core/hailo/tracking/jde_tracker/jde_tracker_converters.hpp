@@ -20,45 +20,43 @@
 #include "tracker_macros.hpp"
 
 /**
- * @brief Convert HailoDetectionPtr into STracks
+ * @brief Convert HailoDetectionPtr into STracks, stored in free slots of the tracker
  *
  * @param inputs  -  std::vector<HailoDetectionPtr>
  *        A vector of new detections.
  *
- * @return std::vector<STrack>
- *         The translated Stracks.
+ * @param detections  -  std::vector<int>
+ *        Filled with the slots of the translated Stracks.
  */
-inline std::vector<STrack> JDETracker::hailo_detections_to_stracks(std::vector<HailoDetectionPtr> &inputs, int frame_id, std::vector<hailo_object_t> hailo_objects_blacklist)
+inline void JDETracker::hailo_detections_to_stracks(std::vector<HailoDetectionPtr> &inputs, std::vector<int> &detections)
 {
-    std::vector<STrack> detections(inputs.size());
+    uint32_t hailo_objects_blacklist = STrack::blacklist_mask(m_hailo_objects_blacklist);
+    detections.clear();
     for (uint i = 0; i < inputs.size(); i++)
     {
         HailoBBox bbox = inputs[i]->get_bbox();
-        std::vector<float> detection_box = {bbox.xmin(), bbox.ymin(), bbox.width(), bbox.height()};
-        STrack strack(detection_box, inputs[i]->get_confidence(), {}, inputs[i], frame_id, hailo_objects_blacklist);
-        detections[i] = strack;
+        std::array<float, 4> detection_box = {bbox.xmin(), bbox.ymin(), bbox.width(), bbox.height()};
+        detections.push_back(acquire_slot(STrack(detection_box, inputs[i]->get_confidence(), {}, inputs[i], m_frame_id, hailo_objects_blacklist)));
     }
-
-    return detections;
 }
 
 /**
  * @brief Convert a vector of Stracks to a vector of HailoDetectionPtr
  *
- * @param stracks  -  std::vector<STrack>
- *        A vector of stracks.
+ * @param stracks  -  std::vector<STrack *>
+ *        A vector of stracks (by pointer).
  *
  * @return std::vector<HailoDetectionPtr>
  *         The translated HailoDetectionPtr.
  *
  */
-inline std::vector<HailoDetectionPtr> JDETracker::stracks_to_hailo_detections(std::vector<STrack> &stracks, bool debug = false)
+inline std::vector<HailoDetectionPtr> JDETracker::stracks_to_hailo_detections(std::vector<STrack *> &stracks, bool debug = false)
 {
     std::vector<HailoDetectionPtr> objects;
     objects.reserve(stracks.size());
     for (uint i = 0; i < stracks.size(); i++)
     {
-        HailoDetectionPtr detection_ptr = stracks[i].get_hailo_detection();
+        HailoDetectionPtr detection_ptr = stracks[i]->get_hailo_detection();
         if (nullptr != detection_ptr)
         {
             if (debug)
@@ -66,7 +64,7 @@ inline std::vector<HailoDetectionPtr> JDETracker::stracks_to_hailo_detections(st
                 // remove stale classifications
                 hailo_common::remove_classifications(detection_ptr, "tracking");
                 // add "tracking" classification
-                switch (static_cast<TrackState>(stracks[i].get_state()))
+                switch (static_cast<TrackState>(stracks[i]->get_state()))
                 {
                 case TrackState::New:
                     hailo_common::add_classification(detection_ptr, "tracking", "new", 0.0);
@@ -86,9 +84,9 @@ inline std::vector<HailoDetectionPtr> JDETracker::stracks_to_hailo_detections(st
         else
         {
             // Strack tlwh is stored as top-left, width-height: xmin,ymin,width,height
-            HailoBBox bbox(stracks[i].m_tlwh[0], stracks[i].m_tlwh[1], stracks[i].m_tlwh[2], stracks[i].m_tlwh[3]);
+            HailoBBox bbox(stracks[i]->m_tlwh[0], stracks[i]->m_tlwh[1], stracks[i]->m_tlwh[2], stracks[i]->m_tlwh[3]);
             // HailoDetection is constructed as HailoDetection(HailoBBox, label, confidence)
-            objects.emplace_back(std::make_shared<HailoDetection>(HailoDetection(bbox, "tracked", stracks[i].m_confidence)));
+            objects.emplace_back(std::make_shared<HailoDetection>(HailoDetection(bbox, "tracked", stracks[i]->m_confidence)));
         }
     }
 
@@ -97,17 +95,21 @@ inline std::vector<HailoDetectionPtr> JDETracker::stracks_to_hailo_detections(st
 
 inline STrack *JDETracker::get_detection_with_id(int target_track_id)
 {
-    for (uint i = 0; i < m_tracked_stracks.size(); i++)
+    for (int slot : m_tracked_stracks)
     {
-        if (target_track_id == m_tracked_stracks[i].m_track_id)
+        if (target_track_id == m_stracks[slot].m_track_id)
         {
-            return &m_tracked_stracks[i];
+            return &m_stracks[slot];
         }
     }
     return nullptr;
 }
 
-inline std::vector<STrack> JDETracker::get_tracked_stracks()
+inline std::vector<STrack *> JDETracker::get_tracked_stracks()
 {
-    return m_tracked_stracks;
+    std::vector<STrack *> tracked_stracks;
+    tracked_stracks.reserve(m_tracked_stracks.size());
+    for (int slot : m_tracked_stracks)
+        tracked_stracks.push_back(&m_stracks[slot]);
+    return tracked_stracks;
 }
@@ -6,6 +6,8 @@
 
 // General cpp includes
 #include <algorithm>
+#include <array>
+#include <cfloat>
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
@@ -13,6 +15,7 @@
 #include <vector>
 
 // Tappas includes
+#include "hailo_simd.hpp"
 #include "strack.hpp"
 #include "tracker_macros.hpp"
 
@@ -22,45 +25,47 @@
  *        in each STrack. No return, is made, the matrix is
  *        filled in place.
  * 
- * @param tracks  -  std::vector<STrack*>
- *        Pointers to tracked STracks
+ * @param tracks  -  std::vector<int>
+ *        Slots of tracked STracks
  *
- * @param detections  -  std::vector<STrack>
- *        The newly detected STracks
+ * @param detections  -  std::vector<int>
+ *        Slots of the newly detected STracks
  *
- * @param cost_matrix  -  std::vector<std::vector<float>>
- *        The cost matrix to fill in.
- *
- * @param cost_matrix_rows  -  int *
- *        To fill in with number of cost matrix rows.
- *
- * @param cost_matrix_cols  -  int *
- *        To fill in with number of cost matrix columns.
+ * @param cost_matrix  -  TrackerTypes::CostMatrix
+ *        The cost matrix to fill in, of shape tracks.size() x detections.size()
  */
-inline void JDETracker::embedding_distance(std::vector<STrack*> &tracks,
-                                           std::vector<STrack> &detections,
-                                           std::vector<std::vector<float>> &cost_matrix)
+inline void JDETracker::embedding_distance(const std::vector<int> &tracks,
+                                           const std::vector<int> &detections,
+                                           TrackerTypes::CostMatrix &cost_matrix)
 {
+    cost_matrix.resize(tracks.size(), detections.size());
     if (tracks.size() * detections.size() == 0)
     {
         return;
     }
 
+    // Pack the features into contiguous matrices, one row per STrack
+    std::size_t feature_size = m_stracks[detections[0]].m_curr_feat.size();
+    m_track_features.assign(tracks.size() * feature_size, 0.0f);
+    m_detection_features.assign(detections.size() * feature_size, 0.0f);
     for (uint i = 0; i < tracks.size(); i++)
     {
-        std::vector<float> cost_matrix_tmp(detections.size());
-        std::vector<float> track_feature = tracks[i]->m_smooth_feat;
-        for (uint j = 0; j < detections.size(); j++)
-        {
-            std::vector<float> det_feature = detections[j].m_curr_feat;
-            float feat_square = 0.0;
-            for (uint k = 0; k < det_feature.size(); k++)
-            {
-                feat_square += (track_feature[k] - det_feature[k])*(track_feature[k] - det_feature[k]);
-            }
-            cost_matrix_tmp[j] = std::sqrt(feat_square);
-        }
-        cost_matrix.push_back(cost_matrix_tmp);
+        const std::vector<float> &track_feature = m_stracks[tracks[i]].m_smooth_feat;
+        std::copy_n(track_feature.begin(), std::min(track_feature.size(), feature_size), m_track_features.begin() + i * feature_size);
+    }
+    for (uint j = 0; j < detections.size(); j++)
+    {
+        const std::vector<float> &det_feature = m_stracks[detections[j]].m_curr_feat;
+        std::copy_n(det_feature.begin(), std::min(det_feature.size(), feature_size), m_detection_features.begin() + j * feature_size);
+    }
+
+    // Compute all the squared distances at once, then take their roots
+    hailo_simd::squared_distances(m_track_features.data(), tracks.size(),
+                                  m_detection_features.data(), detections.size(),
+                                  feature_size, cost_matrix.data.data());
+    for (float &cost : cost_matrix.data)
+    {
+        cost = std::sqrt(cost);
     }
 }
 
@@ -69,49 +74,53 @@ inline void JDETracker::embedding_distance(std::vector<STrack*> &tracks,
  * @brief Update a cost matrix with the gating distance of all STracks.
  *        No returns are made 
  * 
- * @param cost_matrix  -  std::vector<std::vector<float>>
+ * @param cost_matrix  -  TrackerTypes::CostMatrix
  *        A preliminary cost matrix made by embedding_distance
  *
- * @param tracks  -  std::vector<STrack*>
- *        Pointers to tracked STracks.
+ * @param tracks  -  std::vector<int>
+ *        Slots of tracked STracks.
  *
- * @param detections  -  std::vector<STrack>
- *        The newly detected STracks.
+ * @param detections  -  std::vector<int>
+ *        Slots of the newly detected STracks.
  *
  * @param lambda_  -  float
  *        How much weight to give the gating distance.
  */
-inline void JDETracker::fuse_motion(std::vector<std::vector<float>> &cost_matrix,
-                                    std::vector<STrack*> &tracks,
-                                    std::vector<STrack> &detections,
+inline void JDETracker::fuse_motion(TrackerTypes::CostMatrix &cost_matrix,
+                                    const std::vector<int> &tracks,
+                                    const std::vector<int> &detections,
                                     float lambda_ = 0.98)
 {
-    if (cost_matrix.size() == 0)
+    if (cost_matrix.rows * cost_matrix.cols == 0)
         return;
 
     int gating_dim = 4;
     float gating_threshold = this->m_kalman_filter.chi2inv95[gating_dim];
 
-    std::vector<TrackerTypes::DETECTBOX> measurements(detections.size());
+    std::vector<TrackerTypes::DETECTBOX> &measurements = this->m_measurements;
+    measurements.resize(detections.size());
     for (uint i = 0; i < detections.size(); i++)
     {
-        std::vector<float> tlwh_ = detections[i].to_xyah();
+        std::array<float, 4> tlwh_ = m_stracks[detections[i]].to_xyah();
         TrackerTypes::DETECTBOX measurement = {{tlwh_[0], tlwh_[1], tlwh_[2], tlwh_[3]}};
         measurements[i] = measurement;
     }
 
+    std::vector<float> &gating_distance = this->m_gating_distance;
     for (uint i = 0; i < tracks.size(); i++)
     {
-        xt::xarray<float, xt::layout_type::row_major> gating_distance = m_kalman_filter.gating_distance(tracks[i]->m_mean,
-                                                                                                        tracks[i]->m_covariance,
-                                                                                                        measurements);
-        for (uint j = 0; j < cost_matrix[i].size(); j++)
+        m_kalman_filter.gating_distance(m_stracks[tracks[i]].m_mean,
+                                        m_stracks[tracks[i]].m_covariance,
+                                        measurements,
+                                        gating_distance);
+        float *cost_matrix_row = cost_matrix.row(i);
+        for (int j = 0; j < cost_matrix.cols; j++)
         {
             if (gating_distance[j] > gating_threshold)
             {
-                cost_matrix[i][j] = FLT_MAX;
+                cost_matrix_row[j] = FLT_MAX;
             }
-            cost_matrix[i][j] = lambda_ * cost_matrix[i][j] + (1 - lambda_)*gating_distance[j];
+            cost_matrix_row[j] = lambda_ * cost_matrix_row[j] + (1 - lambda_)*gating_distance[j];
         }
     }
 }
\ No newline at end of file
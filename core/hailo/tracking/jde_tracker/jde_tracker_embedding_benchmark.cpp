@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Time of the embedding distance matrix of the JDE tracker: hailo_simd::squared_distances against the
+  scalar loop over track and detection features it replaced, for a few track x detection x feature sizes.
+  Usage: jde_tracker_embedding_benchmark [iterations]
+*/
+
+// General cpp includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+// Tappas includes
+#include "hailo_simd.hpp"
+
+struct Size
+{
+    std::size_t tracks;
+    std::size_t detections;
+    std::size_t features;
+};
+
+// The loop of JDETracker::embedding_distance before the kernel, one feature vector per STrack
+static void scalar_distances(const std::vector<std::vector<float>> &track_features, const std::vector<std::vector<float>> &det_features,
+                             std::vector<float> &cost_matrix)
+{
+    for (std::size_t i = 0; i < track_features.size(); i++)
+    {
+        float *cost_matrix_row = cost_matrix.data() + i * det_features.size();
+        const std::vector<float> &track_feature = track_features[i];
+        for (std::size_t j = 0; j < det_features.size(); j++)
+        {
+            const std::vector<float> &det_feature = det_features[j];
+            float feat_square = 0.0;
+            for (std::size_t k = 0; k < det_feature.size(); k++)
+            {
+                feat_square += (track_feature[k] - det_feature[k]) * (track_feature[k] - det_feature[k]);
+            }
+            cost_matrix_row[j] = std::sqrt(feat_square);
+        }
+    }
+}
+
+// The packing into contiguous matrices is timed too, as embedding_distance does it every frame
+static void simd_distances(const std::vector<std::vector<float>> &track_features, const std::vector<std::vector<float>> &det_features,
+                           std::vector<float> &packed_tracks, std::vector<float> &packed_detections, std::vector<float> &cost_matrix)
+{
+    std::size_t n = track_features[0].size();
+    packed_tracks.resize(track_features.size() * n);
+    packed_detections.resize(det_features.size() * n);
+    for (std::size_t i = 0; i < track_features.size(); i++)
+        std::copy(track_features[i].begin(), track_features[i].end(), packed_tracks.begin() + i * n);
+    for (std::size_t j = 0; j < det_features.size(); j++)
+        std::copy(det_features[j].begin(), det_features[j].end(), packed_detections.begin() + j * n);
+    hailo_simd::squared_distances(packed_tracks.data(), track_features.size(), packed_detections.data(), det_features.size(), n, cost_matrix.data());
+    for (float &cost : cost_matrix)
+        cost = std::sqrt(cost);
+}
+
+static double time_us(int iterations, const std::function<void()> &distances)
+{
+    distances(); // Warm up the caches and the packed matrices
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+        distances();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static std::vector<std::vector<float>> random_features(std::mt19937 &rng, std::size_t rows, std::size_t n)
+{
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<std::vector<float>> features(rows, std::vector<float>(n));
+    for (auto &feature : features)
+        for (float &value : feature)
+            value = uniform(rng);
+    return features;
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200;
+    std::mt19937 rng(1234);
+    const Size sizes[] = {{10, 10, 128}, {37, 53, 130}, {50, 50, 512}, {100, 100, 512}, {200, 200, 512}};
+
+    std::printf("simd lanes %zu\n", hailo_simd::VFLOAT_WIDTH);
+    std::printf("%-18s %10s %10s %9s %12s\n", "tracks x dets x n", "scalar us", "simd us", "speedup", "max error");
+    for (const Size &size : sizes)
+    {
+        std::vector<std::vector<float>> track_features = random_features(rng, size.tracks, size.features);
+        std::vector<std::vector<float>> det_features = random_features(rng, size.detections, size.features);
+        std::vector<float> scalar_cost(size.tracks * size.detections), simd_cost(size.tracks * size.detections);
+        std::vector<float> packed_tracks, packed_detections;
+
+        double scalar_us = time_us(iterations, [&]
+                                   { scalar_distances(track_features, det_features, scalar_cost); });
+        double simd_us = time_us(iterations, [&]
+                                 { simd_distances(track_features, det_features, packed_tracks, packed_detections, simd_cost); });
+        float max_error = 0.0f;
+        for (std::size_t i = 0; i < scalar_cost.size(); i++)
+            max_error = std::max(max_error, std::fabs(scalar_cost[i] - simd_cost[i]));
+
+        char name[32];
+        std::snprintf(name, sizeof(name), "%zux%zux%zu", size.tracks, size.detections, size.features);
+        std::printf("%-18s %10.1f %10.1f %8.2fx %12.2g\n", name, scalar_us, simd_us, scalar_us / simd_us, max_error);
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of hailo_simd::squared_distances, the embedding distance kernel of the JDE tracker, against a scalar
+  reference summed in double: feature sizes that are not a multiple of VFLOAT_WIDTH, row counts that are not
+  a multiple of the 4x2 tiles and detection counts around the 64 rows block.
+  Identical rows must give exactly 0, and nothing past the a_rows x b_rows output may be written.
+*/
+
+// General cpp includes
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Tappas includes
+#include "hailo_simd.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+// Written past the output, must be left untouched
+#define GUARD_VALUE (-1.0f)
+#define GUARD_SIZE (16)
+
+static double reference_distance(const float *a, const float *b, std::size_t n)
+{
+    double sum = 0.0;
+    for (std::size_t k = 0; k < n; k++)
+    {
+        double diff = (double)a[k] - (double)b[k];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+static void check_case(std::mt19937 &rng, std::size_t a_rows, std::size_t b_rows, std::size_t n)
+{
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    std::vector<float> a(a_rows * n), b(b_rows * n);
+    for (float &value : a)
+        value = uniform(rng);
+    for (float &value : b)
+        value = uniform(rng);
+    // Some detections are copies of a track, or close to one, like a track that did not move
+    for (std::size_t j = 0; j < b_rows && a_rows > 0; j += 3)
+    {
+        const float *track = a.data() + (j % a_rows) * n;
+        for (std::size_t k = 0; k < n; k++)
+            b[j * n + k] = j % 2 ? track[k] + 1e-4f * uniform(rng) : track[k];
+    }
+
+    std::vector<float> out(a_rows * b_rows + GUARD_SIZE, GUARD_VALUE);
+    hailo_simd::squared_distances(a.data(), a_rows, b.data(), b_rows, n, out.data());
+
+    int case_failures = failures;
+    for (std::size_t i = 0; i < a_rows; i++)
+    {
+        for (std::size_t j = 0; j < b_rows; j++)
+        {
+            double expected = reference_distance(a.data() + i * n, b.data() + j * n, n);
+            float distance = out[i * b_rows + j];
+            // Float rounding of the differences, their squares and the sums of n non negative terms
+            CHECK(std::fabs(distance - expected) <= (n + 2) * FLT_EPSILON * expected);
+            if (expected == 0.0)
+                CHECK(distance == 0.0f);
+        }
+    }
+    for (std::size_t i = a_rows * b_rows; i < out.size(); i++)
+        CHECK(out[i] == GUARD_VALUE);
+    if (failures != case_failures)
+        std::cerr << a_rows << "x" << b_rows << " n " << n << " failed" << std::endl;
+}
+
+int main()
+{
+    std::mt19937 rng(1234);
+    // Sizes around the lane widths (1, 4, 8) and the usual embedding sizes
+    const std::size_t feature_sizes[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 17, 128, 130, 511, 512};
+    // Around the 4 rows and 2 columns of the tiles, and the 64 rows of a block of detections
+    const std::size_t track_counts[] = {0, 1, 2, 3, 4, 5, 6, 7, 9, 13};
+    const std::size_t detection_counts[] = {0, 1, 2, 3, 5, 63, 64, 65, 66, 129};
+
+    for (std::size_t n : feature_sizes)
+        for (std::size_t a_rows : track_counts)
+            for (std::size_t b_rows : detection_counts)
+                check_case(rng, a_rows, b_rows, n);
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -6,6 +6,7 @@
 
 // General cpp includes
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
@@ -21,24 +22,24 @@
  * @brief Calculate the ious between two sets of bounding boxes.
  *        Iou is calculated and filled into a dense graph.
  * 
- * @param atlbrs  -  std::vector<std::vector<float>>
+ * @param atlbrs  -  std::vector<std::array<float, 4>>
  *        A vector of bounding boxes <xmin,ymin,xmax,ymax>
  *
- * @param btlbrs  -  std::vector<std::vector<float>>
+ * @param btlbrs  -  std::vector<std::array<float, 4>>
  *        A vector of bounding boxes <xmin,ymin,xmax,ymax>
  *
- * @return std::vector<std::vector<float>> 
- *         A dense graph of of ious of shape atlbrs.size() x btlbrs.size()
- *         For interpreting distances - 0 is far, 1 is close
+ * @param ious  -  TrackerTypes::CostMatrix
+ *        Filled with a dense graph of ious of shape atlbrs.size() x btlbrs.size()
+ *        For interpreting distances - 0 is far, 1 is close
  */
-inline std::vector<std::vector<float>> ious(std::vector<std::vector<float>> &atlbrs, std::vector<std::vector<float>> &btlbrs)
+inline void ious(const std::vector<std::array<float, 4>> &atlbrs, const std::vector<std::array<float, 4>> &btlbrs, TrackerTypes::CostMatrix &ious)
 {
     // The iou graph will be of shape atlbrs.size() x btlbrs.size()
-    std::vector<std::vector<float>> ious( atlbrs.size() , std::vector<float> (btlbrs.size()));
+    ious.resize(atlbrs.size(), btlbrs.size());
 
     // If there are no box, then return
     if (atlbrs.size() * btlbrs.size() == 0)
-        return ious;
+        return;
 
     //Calculate the ious between each possible pair of boxes from set A and set B
     for (uint k = 0; k < btlbrs.size(); k++)
@@ -53,126 +54,55 @@ inline std::vector<std::vector<float>> ious(std::vector<std::vector<float>> &atl
                 if (ih > 0.0f)
                 {
                     float ua = (atlbrs[n][2] - atlbrs[n][0]) * (atlbrs[n][3] - atlbrs[n][1]) + box_area - iw * ih;
-                    ious[n][k] = iw * ih / ua;
+                    ious(n, k) = iw * ih / ua;
                 }
                 else
                 {
-                    ious[n][k] = 0.0;
+                    ious(n, k) = 0.0;
                 }
             }
             else
             {
-                ious[n][k] = 0.0;
+                ious(n, k) = 0.0;
             }
         }
     }
-
-    return ious;
 }
 
 /**
  * @brief Calculates the iou distances (1 - iou) between two sets of STracks
- *        Distances are returned as a dense graph.
+ *        Distances are filled into a dense graph.
  * 
- * @param atracks  -  std::vector<STrack *>
- *        A set of STracks (by pointer)
- *
- * @param btracks   -  std::vector<STrack>
- *        A set of STracks
- *
- * @param dist_rows   -  int &
- *        int & to fill with the # of rows of the distance graph
+ * @param atracks  -  std::vector<int>
+ *        A set of STracks (by slot)
  *
- * @param dist_cols   -  int &
- *        int & to fill with the # of columns of the distance graph
+ * @param btracks  -  std::vector<int>
+ *        A set of STracks (by slot)
  *
- * @return std::vector<std::vector<float>> 
- *         A dense graph of iou distances (1 - iou), of shape atracks.size() x btracks.size()
- *         For interpreting distances - 1 is far, 0 is close
+ * @param cost_matrix  -  TrackerTypes::CostMatrix
+ *        Filled with a dense graph of iou distances (1 - iou), of shape atracks.size() x btracks.size()
+ *        For interpreting distances - 1 is far, 0 is close
  */
-inline std::vector<std::vector<float>> JDETracker::iou_distance(std::vector<STrack *> &atracks, std::vector<STrack> &btracks)
+inline void JDETracker::iou_distance(const std::vector<int> &atracks, const std::vector<int> &btracks, TrackerTypes::CostMatrix &cost_matrix)
 {
-    if ( (atracks.size() == 0) | (btracks.size() == 0) )
-    {
-        std::vector<std::vector<float>> cost_matrix;
-        return cost_matrix;
-    }
-
     // Prepare a set of bounding boxes from each of the two sets of STracks
-    std::vector<std::vector<float>> atlbrs( atracks.size() , std::vector<float> (4));
-    std::vector<std::vector<float>> btlbrs( btracks.size() , std::vector<float> (4));
+    m_atlbrs.resize(atracks.size());
+    m_btlbrs.resize(btracks.size());
     for (uint i = 0; i < atracks.size(); i++)
     {
-        atlbrs[i] = atracks[i]->tlbr();
+        m_atlbrs[i] = m_stracks[atracks[i]].tlbr();
     }
     for (uint i = 0; i < btracks.size(); i++)
     {
-        btlbrs[i] = btracks[i].tlbr();
+        m_btlbrs[i] = m_stracks[btracks[i]].tlbr();
     }
 
-    // Get a dense graph of the ious between all pairs of boxes fromt he two sets
-    std::vector<std::vector<float>> _ious = ious(atlbrs, btlbrs);
+    // Get a dense graph of the ious between all pairs of boxes from the two sets
+    ious(m_atlbrs, m_btlbrs, cost_matrix);
 
-    // The cost matrix will have the same shape as the ious graph
-    std::vector<std::vector<float>> cost_matrix( atracks.size() , std::vector<float> (btracks.size()));
     //The cost matrix = 1 - ious
-    for (uint i = 0; i < _ious.size(); i++)
+    for (float &cost : cost_matrix.data)
     {
-        for (uint j = 0; j < _ious[i].size(); j++)
-        {
-            cost_matrix[i][j] = 1 - _ious[i][j];
-        }
+        cost = 1 - cost;
     }
-
-    return cost_matrix;
-}
-
-/**
- * @brief Calculates the iou distances (1 - iou) between two sets of STracks
- *        Distances are returned as a dense graph.
- * 
- * @param atracks  -  std::vector<STrack *>
- *        A set of STracks
- *
- * @param btracks  -  std::vector<STrack>
- *        A set of STracks
- *
- * @return std::vector<std::vector<float>> 
- *         A dense graph of iou distances (1 - iou), of shape atracks.size() x btracks.size()
- *         For interpreting distances - 1 is far, 0 is close
- */
-inline std::vector<std::vector<float>> JDETracker::iou_distance(std::vector<STrack> &atracks, std::vector<STrack> &btracks)
-{
-    if ( (atracks.size() == 0) | (btracks.size() == 0) )
-    {
-        std::vector<std::vector<float>> cost_matrix;
-        return cost_matrix;
-    }
-
-    // Prepare a set of bounding boxes from each of the two sets of STracks
-    std::vector<std::vector<float>> atlbrs( atracks.size() , std::vector<float> (4));
-    std::vector<std::vector<float>> btlbrs( btracks.size() , std::vector<float> (4));
-    for (uint i = 0; i < atracks.size(); i++)
-    {
-        atlbrs[i] = atracks[i].tlbr();
-    }
-    for (uint i = 0; i < btracks.size(); i++)
-    {
-        btlbrs[i] = btracks[i].tlbr();
-    }
-
-    // Get a dense graph of the ious between all pairs of boxes fromt he two sets
-    std::vector<std::vector<float>> _ious = ious(atlbrs, btlbrs);
-    // The cost matrix will have the same shape as the ious graph
-    std::vector<std::vector<float>> cost_matrix( atracks.size() , std::vector<float> (btracks.size()));
-    //The cost matrix = 1 - ious
-    for (uint i = 0; i < _ious.size(); i++)
-    {
-        for (uint j = 0; j < _ious[i].size(); j++)
-        {
-            cost_matrix[i][j] = 1 - _ious[i][j];
-        }
-    }
-
-    return cost_matrix;
 }
@@ -6,8 +6,10 @@
 
 // General cpp includes
 #include <algorithm>
+#include <climits>
 #include <cmath>
 #include <iostream>
+#include <numeric>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -19,148 +21,152 @@
 
 
 /**
- * @brief Performs linear assignment on a given cost matrix.
- *        No return is made, instead vectors are filled with
- *        matching indices for row and column items.
- * 
- * @param cost  -  std::vector<std::vector<float>>
- *        A 2D cost matrix of distances between 2 sets of objects
+ * @brief Performs linear assignment on a cost matrix padded for unmatched items.
+ *        The n_rows x n_cols block at the top left of the matrix holds the costs,
+ *        the rest is filled here so that every item can stay unmatched for cost_limit / 2.
+ *        No return is made, instead vectors are filled with matching indices for row and column items.
+ *
+ * @param cost  -  std::vector<cost_t>
+ *        A flat, row major, n x n cost matrix where n = n_rows + n_cols
+ *
+ * @param n_rows  -  int
+ *        Number of row items
+ *
+ * @param n_cols  -  int
+ *        Number of column items
  *
- * @param rowsol  -  std::vector<int>
- *        A vector to fill with matching indices of items in the columns
+ * @param rowsol  -  std::vector<int_t>
+ *        A vector to fill with matching indices of items in the columns, -1 if unmatched
  *        ex: rowsol[0] = 2 means item 0 in the rows matches item 2 in the columns
  *
- * @param colsol  -  std::vector<int>
- *        A vector to fill with matching indices of items in the rows
+ * @param colsol  -  std::vector<int_t>
+ *        A vector to fill with matching indices of items in the rows, -1 if unmatched
  *        ex: colsol[0] = 2 means item 0 in the cols matches item 2 in the rows
  *
+ * @param workspace  -  lapjv_workspace
+ *        Work arrays of lapjv
+ *
  * @param cost_limit  -  float
  *        The cost limit for lapjv
- *
- * @param return_cost  -  bool
- *        If true, then return the total cost, default true.
  */
-inline double lapjv_external(const std::vector<std::vector<float>> &cost,
-                             std::vector<int> &rowsol,
-                             std::vector<int> &colsol,
-                             float cost_limit = LONG_MAX, bool return_cost = true)
+inline void lapjv_external(std::vector<cost_t> &cost,
+                           int n_rows,
+                           int n_cols,
+                           std::vector<int_t> &rowsol,
+                           std::vector<int_t> &colsol,
+                           lapjv_workspace &workspace,
+                           float cost_limit = LONG_MAX)
 {
-    std::vector<std::vector<float>> cost_c;
-    cost_c.assign(cost.begin(), cost.end());
-
-    std::vector<std::vector<float>> cost_c_extended;
-
-    int n_rows = cost.size();
-    int n_cols = cost[0].size();
-    rowsol.resize(n_rows);
-    colsol.resize(n_cols);
-
-    int n = 0;
-    if (n_rows == n_cols)
-    {
-        n = n_rows;
-    }
-
-    n = n_rows + n_cols;
-    cost_c_extended.resize(n);
-    for (uint i = 0; i < cost_c_extended.size(); i++) {
-        cost_c_extended[i].resize(n);
-    }
-
-    for (uint i = 0; i < cost_c_extended.size(); i++)
+    int n = n_rows + n_cols;
+    cost.resize(n * n);
+    for (int i = 0; i < n; i++)
     {
-        for (uint j = 0; j < cost_c_extended[i].size(); j++)
+        cost_t *cost_row = cost.data() + i * n;
+        if (i < n_rows)
         {
-            cost_c_extended[i][j] = cost_limit / 2.0;
+            std::fill(cost_row + n_cols, cost_row + n, cost_limit / 2.0);
         }
-    }
-
-    for (uint i = n_rows; i < cost_c_extended.size(); i++)
-    {
-        for (uint j = n_cols; j < cost_c_extended[i].size(); j++)
+        else
         {
-            cost_c_extended[i][j] = 0;
+            std::fill(cost_row, cost_row + n_cols, cost_limit / 2.0);
+            std::fill(cost_row + n_cols, cost_row + n, 0);
         }
     }
-    for (int i = 0; i < n_rows; i++)
+
+    rowsol.resize(n);
+    colsol.resize(n);
+    int ret = lapjv_internal(n, cost.data(), rowsol.data(), colsol.data(), workspace);
+    if (ret != 0)
     {
-        for (int j = 0; j < n_cols; j++)
-        {
-            cost_c_extended[i][j] = cost_c[i][j];
-        }
+        throw std::runtime_error("JDETracker error: incorrect lapjv calculation!");
     }
 
-    cost_c.clear();
-    cost_c.assign(cost_c_extended.begin(), cost_c_extended.end());
-
-    double **cost_ptr;
-    cost_ptr = new double *[sizeof(double *) * n];
-    for (int i = 0; i < n; i++)
-        cost_ptr[i] = new double[sizeof(double) * n];
-
     for (int i = 0; i < n; i++)
     {
-        for (int j = 0; j < n; j++)
-        {
-            cost_ptr[i][j] = cost_c[i][j];
-        }
+        if (rowsol[i] >= n_cols)
+            rowsol[i] = -1;
+        if (colsol[i] >= n_rows)
+            colsol[i] = -1;
     }
+}
 
-    int x_c[n];
-    int y_c[n];
 
-    int ret = lapjv_internal(n, cost_ptr, x_c, y_c);
-    if (ret != 0)
-    {
-        throw std::runtime_error("JDETracker error: incorrect lapjv calculation!");
-    }
+/**
+ * @brief Solve the assignment of one component of the cost matrix (see linear_assignment).
+ *        A component with a single row or a single column is solved greedily,
+ *        by matching the pair with the lowest cost. Other components are solved by lapjv
+ *        on a cost matrix of just the component. The result is written to the rowsol and
+ *        colsol of the arena.
+ *
+ * @param cost_matrix  -  TrackerTypes::CostMatrix
+ *        A 2D cost matrix of distances between 2 sets of objects
+ *
+ * @param thresh  -  float
+ *        The cost limit for lapjv
+ *
+ * @param component  -  int
+ *        The component to solve
+ */
+inline void JDETracker::solve_component(const TrackerTypes::CostMatrix &cost_matrix, float thresh, int component)
+{
+    LinearAssignmentArena &arena = this->m_assignment_arena;
+    const int *rows = arena.component_rows.data() + arena.row_offsets[component];
+    const int *cols = arena.component_cols.data() + arena.col_offsets[component];
+    int n_rows = arena.row_offsets[component + 1] - arena.row_offsets[component];
+    int n_cols = arena.col_offsets[component + 1] - arena.col_offsets[component];
 
-    double opt = 0.0;
+    // A lone row or column has nothing to be matched with
+    if (n_rows == 0 || n_cols == 0)
+        return;
 
-    if (n != n_rows)
+    // With a single row (or column) every pair of the component is below the threshold,
+    // so the cheapest pair is the best match
+    if (n_rows == 1 || n_cols == 1)
     {
-        for (int i = 0; i < n; i++)
-        {
-            if (x_c[i] >= n_cols)
-                x_c[i] = -1;
-            if (y_c[i] >= n_rows)
-                y_c[i] = -1;
-        }
+        int best_row = rows[0];
+        int best_col = cols[0];
         for (int i = 0; i < n_rows; i++)
         {
-            rowsol[i] = x_c[i];
-        }
-        for (int i = 0; i < n_cols; i++)
-        {
-            colsol[i] = y_c[i];
-        }
-
-        if (return_cost)
-        {
-            for (uint i = 0; i < rowsol.size(); i++)
+            for (int j = 0; j < n_cols; j++)
             {
-                if (rowsol[i] != -1)
+                if (cost_matrix(rows[i], cols[j]) < cost_matrix(best_row, best_col))
                 {
-                    opt += cost_ptr[i][rowsol[i]];
+                    best_row = rows[i];
+                    best_col = cols[j];
                 }
             }
         }
+        arena.rowsol[best_row] = best_col;
+        arena.colsol[best_col] = best_row;
+        return;
     }
-    else if (return_cost)
+
+    // Pairs at or above the threshold are never worth matching, give them a fixed cost above it
+    // so that the gated costs (up to FLT_MAX) stay out of lapjv's arithmetic
+    const cost_t gated_cost = 2 * thresh + 1;
+    int n = n_rows + n_cols;
+    arena.component_cost.resize(n * n);
+    for (int i = 0; i < n_rows; i++)
     {
-        for (uint i = 0; i < rowsol.size(); i++)
+        const float *cost_matrix_row = cost_matrix.row(rows[i]);
+        cost_t *component_cost_row = arena.component_cost.data() + i * n;
+        for (int j = 0; j < n_cols; j++)
         {
-            opt += cost_ptr[i][rowsol[i]];
+            float cost = cost_matrix_row[cols[j]];
+            component_cost_row[j] = (cost < thresh) ? cost : gated_cost;
         }
     }
 
-    for (int i = 0; i < n; i++)
+    lapjv_external(arena.component_cost, n_rows, n_cols, arena.x, arena.y, arena.workspace, thresh);
+
+    for (int i = 0; i < n_rows; i++)
     {
-        delete[] cost_ptr[i];
+        if (arena.x[i] >= 0)
+        {
+            arena.rowsol[rows[i]] = cols[arena.x[i]];
+            arena.colsol[cols[arena.x[i]]] = rows[i];
+        }
     }
-    delete[] cost_ptr;
-
-    return opt;
 }
 
 
@@ -168,8 +174,11 @@ inline double lapjv_external(const std::vector<std::vector<float>> &cost,
  * @brief Performs linear assignment on a given cost matrix.
  *        No return is made, instead a given matrix of matches is filled,
  *        and vectors are filled for unmatched members of each list.
+ *        Pairs with a cost below the threshold link their row and column. The rows and columns
+ *        fall into independent components that are solved separately, most of them are
+ *        a single pair or a lone item, which do not need lapjv at all.
  * 
- * @param cost_matrix  -  std::vector<std::vector<float>>
+ * @param cost_matrix  -  TrackerTypes::CostMatrix
  *        A 2D cost matrix of distances between 2 sets of objects
  *
  * @param thresh  -  float
@@ -184,9 +193,7 @@ inline double lapjv_external(const std::vector<std::vector<float>> &cost,
  * @param unmatched_b  - std::vector<int>
  *        Indices of unmatched objects from the column items
  */
-inline void JDETracker::linear_assignment(std::vector<std::vector<float>> &cost_matrix,
-                                          int cost_matrix_rows,
-                                          int cost_matrix_cols,
+inline void JDETracker::linear_assignment(const TrackerTypes::CostMatrix &cost_matrix,
                                           float thresh,
                                           std::vector<std::pair<int,int>> &matches,
                                           std::vector<int> &unmatched_a,
@@ -197,28 +204,78 @@ inline void JDETracker::linear_assignment(std::vector<std::vector<float>> &cost_
     unmatched_a.clear();
     unmatched_b.clear();
 
-	if (cost_matrix.size() == 0)
-	{
-		for (int i = 0; i < cost_matrix_rows; i++)
-		{
-			unmatched_a.push_back(i);
-		}
-		for (int i = 0; i < cost_matrix_cols; i++)
-		{
-			unmatched_b.push_back(i);
-		}
-		return;
-	}
-
-    std::vector<int> rowsol;
-    std::vector<int> colsol;
-    lapjv_external(cost_matrix, rowsol, colsol, thresh);
-
-    for (uint i = 0; i < rowsol.size(); i++)
+    LinearAssignmentArena &arena = this->m_assignment_arena;
+    int n_rows = cost_matrix.rows;
+    int n_cols = cost_matrix.cols;
+    arena.rowsol.assign(n_rows, -1);
+    arena.colsol.assign(n_cols, -1);
+
+    if (n_rows * n_cols > 0)
+    {
+        // Union the row and column of every pair below the threshold, columns follow the rows in the forest
+        int n = n_rows + n_cols;
+        std::vector<int> &parent = arena.parent;
+        parent.resize(n);
+        std::iota(parent.begin(), parent.end(), 0);
+        auto find = [&parent](int node)
+        {
+            while (parent[node] != node)
+            {
+                parent[node] = parent[parent[node]];
+                node = parent[node];
+            }
+            return node;
+        };
+        for (int i = 0; i < n_rows; i++)
+        {
+            const float *cost_matrix_row = cost_matrix.row(i);
+            for (int j = 0; j < n_cols; j++)
+            {
+                if (cost_matrix_row[j] < thresh)
+                {
+                    int row_root = find(i);
+                    int col_root = find(n_rows + j);
+                    if (row_root != col_root)
+                        parent[std::max(row_root, col_root)] = std::min(row_root, col_root);
+                }
+            }
+        }
+
+        // Number the components and group their rows and columns, in ascending order
+        std::vector<int> &component = arena.component;
+        component.assign(n, -1);
+        int n_components = 0;
+        for (int node = 0; node < n; node++)
+        {
+            int root = find(node);
+            if (component[root] < 0)
+                component[root] = n_components++;
+            component[node] = component[root];
+        }
+        arena.row_offsets.assign(n_components + 1, 0);
+        arena.col_offsets.assign(n_components + 1, 0);
+        for (int i = 0; i < n_rows; i++)
+            arena.row_offsets[component[i]]++;
+        for (int j = 0; j < n_cols; j++)
+            arena.col_offsets[component[n_rows + j]]++;
+        std::partial_sum(arena.row_offsets.begin(), arena.row_offsets.end(), arena.row_offsets.begin());
+        std::partial_sum(arena.col_offsets.begin(), arena.col_offsets.end(), arena.col_offsets.begin());
+        arena.component_rows.resize(n_rows);
+        arena.component_cols.resize(n_cols);
+        for (int i = n_rows - 1; i >= 0; i--)
+            arena.component_rows[--arena.row_offsets[component[i]]] = i;
+        for (int j = n_cols - 1; j >= 0; j--)
+            arena.component_cols[--arena.col_offsets[component[n_rows + j]]] = j;
+
+        for (int c = 0; c < n_components; c++)
+            solve_component(cost_matrix, thresh, c);
+    }
+
+    for (int i = 0; i < n_rows; i++)
     {
-        if (rowsol[i] >= 0)
+        if (arena.rowsol[i] >= 0)
         {
-            matches.push_back(std::make_pair(i, rowsol[i]));
+            matches.push_back(std::make_pair(i, arena.rowsol[i]));
         }
         else
         {
@@ -226,9 +283,9 @@ inline void JDETracker::linear_assignment(std::vector<std::vector<float>> &cost_
         }
     }
 
-    for (uint i = 0; i < colsol.size(); i++)
+    for (int i = 0; i < n_cols; i++)
     {
-        if (colsol[i] < 0)
+        if (arena.colsol[i] < 0)
         {
             unmatched_b.push_back(i);
         }
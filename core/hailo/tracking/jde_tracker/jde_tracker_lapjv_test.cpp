@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Check of JDETracker::linear_assignment, which splits the gated cost matrix into components,
+  against lapjv on the full padded matrix (how the assignment was solved before) and against
+  an exhaustive search of the optimum, on random matrices with FLT_MAX entries, costs above the
+  threshold, ties and empty sides.
+  Leaving a row or a column unmatched costs thresh / 2, the solution must reach the optimum of
+  matched costs plus unmatched items, and match only pairs below the threshold.
+*/
+
+// General cpp includes
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Tappas includes
+#include "jde_tracker.hpp"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(cond))                                                             \
+        {                                                                        \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": " << #cond << std::endl; \
+            failures++;                                                          \
+        }                                                                        \
+    } while (0)
+
+// Largest side solved by exhaustive search
+#define MAX_EXHAUSTIVE (10)
+
+class JDETrackerLapjvTest
+{
+public:
+    static void linear_assignment(JDETracker &tracker, const TrackerTypes::CostMatrix &cost_matrix, float thresh,
+                                  std::vector<std::pair<int, int>> &matches, std::vector<int> &unmatched_a, std::vector<int> &unmatched_b)
+    {
+        tracker.linear_assignment(cost_matrix, thresh, matches, unmatched_a, unmatched_b);
+    }
+};
+
+struct MatrixCase
+{
+    int rows;
+    int cols;
+    float gated;     // Share of FLT_MAX entries
+    bool ties;       // Costs on a coarse grid, the threshold among them
+    int components;  // Blocks of rows and columns that only have finite costs inside their block
+};
+
+static TrackerTypes::CostMatrix random_matrix(std::mt19937 &rng, const MatrixCase &matrix_case, float thresh)
+{
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    TrackerTypes::CostMatrix cost_matrix;
+    cost_matrix.resize(matrix_case.rows, matrix_case.cols);
+    for (int i = 0; i < matrix_case.rows; i++)
+    {
+        for (int j = 0; j < matrix_case.cols; j++)
+        {
+            bool same_block = (i % matrix_case.components) == (j % matrix_case.components);
+            float cost = 1.5f * thresh * uniform(rng);
+            if (matrix_case.ties)
+                cost = std::round(cost / (thresh / 4)) * (thresh / 4);
+            cost_matrix(i, j) = (!same_block || uniform(rng) < matrix_case.gated) ? FLT_MAX : cost;
+        }
+    }
+    return cost_matrix;
+}
+
+static double assignment_cost(const TrackerTypes::CostMatrix &cost_matrix, float thresh, const std::vector<std::pair<int, int>> &matches)
+{
+    double cost = (double)thresh / 2 * (cost_matrix.rows + cost_matrix.cols - 2 * (int)matches.size());
+    for (const auto &match : matches)
+        cost += cost_matrix(match.first, match.second);
+    return cost;
+}
+
+// Optimum over all the assignments, by rows with a mask of the columns taken so far
+static double exhaustive_cost(const TrackerTypes::CostMatrix &cost_matrix, float thresh)
+{
+    int masks = 1 << cost_matrix.cols;
+    std::vector<double> best(masks, HUGE_VAL);
+    best[0] = 0.0;
+    for (int i = 0; i < cost_matrix.rows; i++)
+    {
+        std::vector<double> next(masks, HUGE_VAL);
+        for (int mask = 0; mask < masks; mask++)
+        {
+            if (best[mask] == HUGE_VAL)
+                continue;
+            next[mask] = std::min(next[mask], best[mask] + thresh / 2.0);
+            for (int j = 0; j < cost_matrix.cols; j++)
+                if (!(mask & (1 << j)))
+                    next[mask | (1 << j)] = std::min(next[mask | (1 << j)], best[mask] + cost_matrix(i, j));
+        }
+        best.swap(next);
+    }
+    double optimum = HUGE_VAL;
+    for (int mask = 0; mask < masks; mask++)
+        optimum = std::min(optimum, best[mask] + thresh / 2.0 * (cost_matrix.cols - __builtin_popcount(mask)));
+    return optimum;
+}
+
+// lapjv on the whole matrix, FLT_MAX entries included, padded with the unmatched costs
+static std::vector<std::pair<int, int>> full_lapjv_matches(const TrackerTypes::CostMatrix &cost_matrix, float thresh)
+{
+    std::vector<std::pair<int, int>> matches;
+    if (cost_matrix.rows == 0 || cost_matrix.cols == 0)
+        return matches;
+    int n = cost_matrix.rows + cost_matrix.cols;
+    std::vector<cost_t> cost(n * n);
+    for (int i = 0; i < cost_matrix.rows; i++)
+        for (int j = 0; j < cost_matrix.cols; j++)
+            cost[i * n + j] = cost_matrix(i, j);
+    std::vector<int_t> rowsol, colsol;
+    lapjv_workspace workspace;
+    lapjv_external(cost, cost_matrix.rows, cost_matrix.cols, rowsol, colsol, workspace, thresh);
+    for (int i = 0; i < cost_matrix.rows; i++)
+        if (rowsol[i] >= 0)
+            matches.push_back(std::make_pair(i, rowsol[i]));
+    return matches;
+}
+
+static bool check_solution(const TrackerTypes::CostMatrix &cost_matrix, float thresh, const std::vector<std::pair<int, int>> &matches,
+                           const std::vector<int> &unmatched_a, const std::vector<int> &unmatched_b)
+{
+    bool valid = true;
+    std::vector<int> row_uses(cost_matrix.rows, 0), col_uses(cost_matrix.cols, 0);
+    for (const auto &match : matches)
+    {
+        valid &= cost_matrix(match.first, match.second) < thresh;
+        row_uses[match.first]++;
+        col_uses[match.second]++;
+    }
+    for (int i : unmatched_a)
+        row_uses[i]++;
+    for (int j : unmatched_b)
+        col_uses[j]++;
+    // Every row and column is either matched once or unmatched
+    for (int uses : row_uses)
+        valid &= uses == 1;
+    for (int uses : col_uses)
+        valid &= uses == 1;
+    return valid;
+}
+
+static void check_case(std::mt19937 &rng, JDETracker &tracker, const MatrixCase &matrix_case, float thresh)
+{
+    TrackerTypes::CostMatrix cost_matrix = random_matrix(rng, matrix_case, thresh);
+    std::vector<std::pair<int, int>> matches;
+    std::vector<int> unmatched_a, unmatched_b;
+    JDETrackerLapjvTest::linear_assignment(tracker, cost_matrix, thresh, matches, unmatched_a, unmatched_b);
+    CHECK(check_solution(cost_matrix, thresh, matches, unmatched_a, unmatched_b));
+
+    double cost = assignment_cost(cost_matrix, thresh, matches);
+    std::vector<std::pair<int, int>> full_matches = full_lapjv_matches(cost_matrix, thresh);
+    double full_cost = assignment_cost(cost_matrix, thresh, full_matches);
+    double tolerance = 1e-4 * (1.0 + std::fabs(full_cost));
+    if (std::fabs(cost - full_cost) > tolerance)
+        std::cerr << matrix_case.rows << "x" << matrix_case.cols << " gated " << matrix_case.gated << " ties " << matrix_case.ties
+                  << ": components " << cost << ", full lapjv " << full_cost << std::endl;
+    CHECK(std::fabs(cost - full_cost) <= tolerance);
+    // Without ties the optimum is unique, so the very same pairs are matched
+    if (!matrix_case.ties)
+        CHECK(matches == full_matches);
+    if (matrix_case.rows <= MAX_EXHAUSTIVE && matrix_case.cols <= MAX_EXHAUSTIVE)
+        CHECK(std::fabs(cost - exhaustive_cost(cost_matrix, thresh)) <= tolerance);
+}
+
+int main()
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> small_side(0, MAX_EXHAUSTIVE);
+    // One tracker for all the cases, so that the arena is reused across sizes like from frame to frame
+    JDETracker tracker;
+
+    for (float thresh : {0.5f, 0.8f})
+    {
+        for (bool ties : {false, true})
+        {
+            for (float gated : {0.0f, 0.3f, 0.7f, 1.0f})
+            {
+                for (int components : {1, 3})
+                {
+                    for (int repeat = 0; repeat < 40; repeat++)
+                        check_case(rng, tracker, {small_side(rng), small_side(rng), gated, ties, components}, thresh);
+                    // Larger matrices, like a crowded frame, checked against the full lapjv only
+                    check_case(rng, tracker, {60, 45, gated, ties, components * 4}, thresh);
+                    check_case(rng, tracker, {30, 80, gated, ties, components * 4}, thresh);
+                }
+            }
+        }
+    }
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -9,7 +9,6 @@
 #include <cmath>
 #include <iostream>
 #include <stdexcept>
-#include <set>
 #include <string>
 #include <vector>
 
@@ -17,199 +16,86 @@
 #include "strack.hpp"
 #include "tracker_macros.hpp"
 
-// Macros
-const float IOU_THRESHOLD = 0.15;
-
-
-/**
- * @brief Returns a union of two vectors of STracks
- * 
- * @param tlista  -  std::vector<STrack *>
- *        A set of STracks to join (by pointer)
- *
- * @param tlistb  -  std::vector<STrack *>
- *        A set of STracks to join (by pointer)
- *
- * @return std::vector<STrack *> 
- *         Pointers to the union of the two sets
- */
-inline std::vector<STrack *> JDETracker::joint_strack_pointers(std::vector<STrack *> &tlista, std::vector<STrack *> &tlistb)
-{
-    std::vector<STrack *> new_pool;
-    new_pool.reserve( tlista.size() + tlistb.size() ); // preallocate memory
-    new_pool.insert( new_pool.end(), tlista.begin(), tlista.end() );
-    new_pool.insert( new_pool.end(), tlistb.begin(), tlistb.end() );
-    return new_pool;
-}
-
 
 /**
- * @brief Returns a union of two vectors of STracks
- * 
- * @param tlista  -  std::vector<STrack>
- *        A set of STracks to join
+ * @brief Store an STrack in a free slot of the tracker's storage.
  *
- * @param tlistb  -  std::vector<STrack>
- *        A set of STracks to join
+ * @param strack  -  STrack
+ *        The STrack to store.
  *
- * @return std::vector<STrack *> 
- *         Pointers to the union of the two sets
+ * @return int
+ *         The slot the STrack is stored in.
  */
-inline std::vector<STrack *> JDETracker::joint_strack_pointers(std::vector<STrack> &tlista, std::vector<STrack> &tlistb)
+inline int JDETracker::acquire_slot(STrack &&strack)
 {
-    std::set<int> existing_stracks_set;
-    std::vector<STrack *> res;
-    for (uint i = 0; i < tlista.size(); i++)
+    if (m_free_slots.empty())
     {
-        existing_stracks_set.insert(tlista[i].m_track_id);
-        res.push_back(&tlista[i]);
+        m_stracks.emplace_back(std::move(strack));
+        return m_stracks.size() - 1;
     }
-    for (uint i = 0; i < tlistb.size(); i++)
-    {
-        int tid = tlistb[i].m_track_id;
-        if (existing_stracks_set.count(tid) == 0)
-        {
-            existing_stracks_set.insert(tid);
-            res.push_back(&tlistb[i]);
-        }
-    }
-    return res;
+    int slot = m_free_slots.back();
+    m_free_slots.pop_back();
+    m_stracks[slot] = std::move(strack);
+    return slot;
 }
 
 /**
- * @brief Returns a union of two vectors of STracks
- * 
- * @param tlista  -  std::vector<STrack *>
- *        A set of STracks to join
- *
- * @param tlistb  -  std::vector<STrack>
- *        A set of STracks to join
- *
- * @return std::vector<STrack *> 
- *         A vector union of the two sets
+ * @brief Free every slot that is not in the tracked, lost or new lists,
+ *        these hold STracks that were matched into another STrack or removed.
  */
-inline std::vector<STrack> JDETracker::joint_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb)
+inline void JDETracker::release_unused_slots()
 {
-    std::set<int> existing_stracks_set;
-    std::vector<STrack> res;
-    for (uint i = 0; i < tlista.size(); i++)
-    {
-        existing_stracks_set.insert(tlista[i].m_track_id);
-        res.push_back(tlista[i]);
-    }
-    for (uint i = 0; i < tlistb.size(); i++)
-    {
-        int tid = tlistb[i].m_track_id;
-        if (existing_stracks_set.count(tid) == 0)
-        {
-            existing_stracks_set.insert(tid);
-            res.push_back(tlistb[i]);
-        }
-    }
-    return res;
-}
+    m_slot_marks.assign(m_stracks.size(), false);
+    for (int slot : m_tracked_stracks)
+        m_slot_marks[slot] = true;
+    for (int slot : m_lost_stracks)
+        m_slot_marks[slot] = true;
+    for (int slot : m_new_stracks)
+        m_slot_marks[slot] = true;
 
-/**
- * @brief Subtract one set of Stracks from another
- * 
- * @param tlista  -  std::vector<STrack>
- *        The STracks to subtract from
- *
- * @param tlistb  -  std::vector<STrack>
- *        The STracks to subtract from tlista
- *
- * @return std::vector<STrack> 
- *         A vector of STracks in tlista that don't appear tlistb.
- */
-inline std::vector<STrack> JDETracker::sub_stracks(std::vector<STrack> &tlista, std::vector<STrack> &tlistb)
-{
-    std::map<int, STrack> stracks;
-    for (uint i = 0; i < tlista.size(); i++)
-    {
-        stracks.insert(std::pair<int, STrack>(tlista[i].m_track_id, tlista[i]));
-    }
-    for (uint i = 0; i < tlistb.size(); i++)
+    // Rebuild the free list so that the lowest slots are reused first
+    m_free_slots.clear();
+    for (int slot = m_stracks.size() - 1; slot >= 0; slot--)
     {
-        int tid = tlistb[i].m_track_id;
-        if (stracks.count(tid) != 0)
+        if (!m_slot_marks[slot])
         {
-            stracks.erase(tid);
+            m_stracks[slot].release_hailo_detection();
+            m_free_slots.push_back(slot);
         }
     }
-
-    std::vector<STrack> res;
-    for (auto &it : stracks)
-    {
-        res.push_back(it.second);
-    }
-    return res;
 }
 
 /**
- * @brief Perform a difference between two sets of STracks,
- *        Ending up with two sets of exclusive instances.
- *        No return is made, the vestors are changed in place.
- * 
- * @param resa  -  std::vector<STrack>
- *        A vector to fill in with STracks that are exclusive to stracksa
+ * @brief Returns a union of two lists of STracks.
+ *        STracks of tlistb whose track id already appears are left out.
  *
- * @param resb  -  std::vector<STrack>
- *        A vector to fill in with STracks that are exclusive to stracksb
+ * @param tlista  -  std::vector<int>
+ *        A set of STracks (by slot) to join
  *
- * @param stracksa  -  std::vector<STrack>
- *        A set of STracks, exclusive instances will end up in resa
+ * @param tlistb  -  std::vector<int>
+ *        A set of STracks (by slot) to join
  *
- * @param stracksb  -  std::vector<STrack>
- *        A set of STracks, exclusive instances will end up in resb
+ * @param joint  -  std::vector<int>
+ *        Filled with the slots of the union of the two sets
  */
-inline void JDETracker::remove_duplicate_stracks(std::vector<STrack> &stracksa, std::vector<STrack> &stracksb)
+inline void JDETracker::joint_stracks(const std::vector<int> &tlista, const std::vector<int> &tlistb, std::vector<int> &joint)
 {
-    std::vector<STrack> resa, resb;
-    std::vector<std::vector<float>> pdist = iou_distance(stracksa, stracksb);
-    std::vector<std::pair<int, int>> pairs;
-    for (uint i = 0; i < pdist.size(); i++)
-    {
-        for (uint j = 0; j < pdist[i].size(); j++)
-        {
-            if (pdist[i][j] < IOU_THRESHOLD)
-            {
-                pairs.push_back(std::pair<int, int>(i, j));
-            }
-        }
-    }
+    joint.assign(tlista.begin(), tlista.end());
 
-    std::vector<int> dupa, dupb;
-    for (uint i = 0; i < pairs.size(); i++)
-    {
-        int timep = stracksa[pairs[i].first].m_frame_id - stracksa[pairs[i].first].m_start_frame;
-        int timeq = stracksb[pairs[i].second].m_frame_id - stracksb[pairs[i].second].m_start_frame;
-        if (timep > timeq)
-            dupb.push_back(pairs[i].second);
-        else
-            dupa.push_back(pairs[i].first);
-    }
+    // Sorted track ids that are already in the union
+    m_track_ids.clear();
+    for (int slot : tlista)
+        m_track_ids.push_back(m_stracks[slot].m_track_id);
+    std::sort(m_track_ids.begin(), m_track_ids.end());
 
-    for (uint i = 0; i < stracksa.size(); i++)
+    for (int slot : tlistb)
     {
-        std::vector<int>::iterator iter = find(dupa.begin(), dupa.end(), i);
-        if (iter == dupa.end())
+        int tid = m_stracks[slot].m_track_id;
+        auto it = std::lower_bound(m_track_ids.begin(), m_track_ids.end(), tid);
+        if (it == m_track_ids.end() || *it != tid)
         {
-            resa.push_back(stracksa[i]);
+            m_track_ids.insert(it, tid);
+            joint.push_back(slot);
         }
     }
-
-    for (uint i = 0; i < stracksb.size(); i++)
-    {
-        std::vector<int>::iterator iter = find(dupb.begin(), dupb.end(), i);
-        if (iter == dupb.end())
-        {
-            resb.push_back(stracksb[i]);
-        }
-    }
-
-    // Remove the duplicates
-    stracksa.clear();
-    stracksa.assign(resa.begin(), resa.end());
-    stracksb.clear();
-    stracksb.assign(resb.begin(), resb.end());
-}
\ No newline at end of file
+}
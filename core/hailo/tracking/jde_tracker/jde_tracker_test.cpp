@@ -0,0 +1,181 @@
+/**
+ * Copyright (c) 2021-2022 Hailo Technologies Ltd. All rights reserved.
+ * Distributed under the LGPL license (https://www.gnu.org/licenses/old-licenses/lgpl-2.1.txt)
+ **/
+/*
+  Equivalence check of the JDE tracker against reference outputs: seeded scenes of moving objects,
+  with missed detections, objects that leave and come back, and shuffled inputs, are tracked and
+  every reported track (id, state, box, Kalman velocities, objects of its detection) must match the checked-in reference.
+  The reference was recorded with the tracker before the track slots and fixed-size Kalman math.
+  Usage: jde_tracker_test <reference file> [--write]
+*/
+
+// General cpp includes
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Tappas includes
+#include "jde_tracker.hpp"
+
+struct Scene
+{
+    unsigned int seed;
+    int objects;
+    int frames;
+    bool debug;
+};
+
+static const Scene SCENES[] = {
+    {1, 8, 50, false},
+    {2, 8, 50, true},
+    {3, 16, 20, false},
+};
+
+struct MovingObject
+{
+    float x, y, w, h, vx, vy;
+    bool visible;
+};
+
+static std::string format_track(int frame, int id, STrack &strack, HailoDetectionPtr detection)
+{
+    char line[512];
+    int length = std::snprintf(line, sizeof(line), "%d %d %d %.9g %.9g %.9g %.9g", frame, id, strack.get_state(),
+                               strack.m_tlwh[0], strack.m_tlwh[1], strack.m_tlwh[2], strack.m_tlwh[3]);
+    // The box is the position part of the mean, the velocities are printed on their own
+    for (int i = 4; i < 8; i++)
+        length += std::snprintf(line + length, sizeof(line) - length, " %.9g", strack.m_mean(i));
+    if (detection)
+        std::snprintf(line + length, sizeof(line) - length, " | %zu", detection->get_objects().size());
+    return line;
+}
+
+/**
+ * Tracks a scene and returns a line per reported track per frame.
+ * Track ids are numbered by first appearance, the id counter is shared by all the trackers of the process.
+ */
+static std::vector<std::string> track_scene(const Scene &scene)
+{
+    std::mt19937 rng(scene.seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> noise(0.0f, 0.002f);
+    std::vector<MovingObject> objects(scene.objects);
+    for (MovingObject &object : objects)
+        object = {uniform(rng) * 0.8f, uniform(rng) * 0.8f, 0.02f + uniform(rng) * 0.1f, 0.02f + uniform(rng) * 0.1f,
+                  (uniform(rng) - 0.5f) * 0.01f, (uniform(rng) - 0.5f) * 0.01f, true};
+
+    JDETracker tracker(0.7f, 0.8f, 0.9f, 2, 2, 3, true, 0.01, 1e-8, 0.001, 1e-8, scene.debug);
+    std::map<int, int> ids;
+    std::vector<std::string> lines;
+    for (int frame = 0; frame < scene.frames; frame++)
+    {
+        std::vector<HailoDetectionPtr> detections;
+        for (MovingObject &object : objects)
+        {
+            object.x += object.vx;
+            object.y += object.vy;
+            if (object.x < 0.0f || object.x > 0.85f)
+                object.vx = -object.vx;
+            if (object.y < 0.0f || object.y > 0.85f)
+                object.vy = -object.vy;
+            if (uniform(rng) < 0.03f)
+                object.visible = !object.visible;
+            if (!object.visible || uniform(rng) < 0.1f)
+                continue;
+            float x = std::min(std::max(object.x + noise(rng), 0.0f), 0.85f);
+            float y = std::min(std::max(object.y + noise(rng), 0.0f), 0.85f);
+            detections.push_back(std::make_shared<HailoDetection>(HailoBBox(x, y, object.w, object.h), "person", 0.5f + 0.5f * uniform(rng)));
+        }
+        std::shuffle(detections.begin(), detections.end(), rng);
+
+        for (STrack *strack : tracker.update(detections, false, false))
+        {
+            int id = ids.emplace(strack->m_track_id, ids.size()).first->second;
+            lines.push_back(format_track(frame, id, *strack, strack->get_hailo_detection()));
+        }
+    }
+    return lines;
+}
+
+// Numbers may differ in the last bits where the compiler fuses multiply-adds (e.g. on aarch64), anything else must match
+#define MAX_ERROR (1e-5)
+
+static bool same_line(const std::string &line, const std::string &expected_line)
+{
+    std::istringstream tokens(line), expected_tokens(expected_line);
+    std::string token, expected_token;
+    while (expected_tokens >> expected_token)
+    {
+        if (!(tokens >> token))
+            return false;
+        if (token == expected_token)
+            continue;
+        char *end, *expected_end;
+        double value = std::strtod(token.c_str(), &end);
+        double expected_value = std::strtod(expected_token.c_str(), &expected_end);
+        if (*end != '\0' || *expected_end != '\0' || std::fabs(value - expected_value) > MAX_ERROR)
+            return false;
+    }
+    return !(tokens >> token);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <reference file> [--write]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> lines;
+    for (const Scene &scene : SCENES)
+    {
+        lines.push_back("scene " + std::to_string(scene.seed));
+        std::vector<std::string> scene_lines = track_scene(scene);
+        lines.insert(lines.end(), scene_lines.begin(), scene_lines.end());
+    }
+
+    if (argc > 2 && std::string(argv[2]) == "--write")
+    {
+        std::ofstream reference(argv[1]);
+        for (const std::string &line : lines)
+            reference << line << "\n";
+        return reference ? 0 : 1;
+    }
+
+    std::ifstream reference(argv[1]);
+    if (!reference)
+    {
+        std::cerr << "Could not open " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<std::string> expected;
+    for (std::string line; std::getline(reference, line);)
+        expected.push_back(line);
+
+    int failures = 0;
+    for (size_t i = 0; i < std::max(lines.size(), expected.size()); i++)
+    {
+        const std::string &line = i < lines.size() ? lines[i] : "<missing>";
+        const std::string &expected_line = i < expected.size() ? expected[i] : "<missing>";
+        if (same_line(line, expected_line))
+            continue;
+        // The first mismatches are enough to see where the tracking diverged
+        if (failures++ < 5)
+            std::cerr << "line " << i + 1 << ":\n  expected " << expected_line << "\n  got      " << line << std::endl;
+    }
+    std::cout << lines.size() << " lines, " << expected.size() << " expected" << std::endl;
+
+    if (failures)
+        std::cerr << failures << " checks failed" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -19,45 +19,24 @@
 #include "tracker_macros.hpp"
 
 /**
- * @brief Keep specific indices from an input vector of stracks.
+ * @brief Keep specific indices from an input list of stracks.
  *
- * @param stracks  -  std::vector<STrack>
- *        The stracks to keep from.
+ * @param stracks  -  std::vector<int>
+ *        The stracks (by slot) to keep from.
  *
  * @param indices  -  std::vector<int>
- *        The indices to keep.
+ *        The indices to keep, in ascending order (as linear_assignment fills them).
  */
-inline void keep_indices(std::vector<STrack> &stracks, const std::vector<int> &indices)
+inline void keep_indices(std::vector<int> &stracks, const std::vector<int> &indices)
 {
-    std::vector<STrack> stracks_swap;
-    stracks_swap.reserve(indices.size());
+    // The indices are ascending, so the kept stracks can be compacted in place
+    uint kept = 0;
     for (uint i = 0; i < indices.size(); i++)
     {
         if (indices[i] < (int)stracks.size())
-            stracks_swap.emplace_back(stracks[indices[i]]);
+            stracks[kept++] = stracks[indices[i]];
     }
-    stracks = stracks_swap;
-}
-
-/**
- * @brief Keep specific indices from an input vector of stracks.
- *
- * @param stracks  -  std::vector<STrack *>
- *        The stracks (by pointer) to keep from.
- *
- * @param indices  -  std::vector<int>
- *        The indices to keep.
- */
-inline void keep_indices(std::vector<STrack *> &stracks, const std::vector<int> &indices)
-{
-    std::vector<STrack *> stracks_swap;
-    stracks_swap.reserve(indices.size());
-    for (uint i = 0; i < indices.size(); i++)
-    {
-        if (indices[i] < (int)stracks.size())
-            stracks_swap.emplace_back(stracks[indices[i]]);
-    }
-    stracks = stracks_swap;
+    stracks.resize(kept);
 }
 
 /**
@@ -67,27 +46,28 @@ inline void keep_indices(std::vector<STrack *> &stracks, const std::vector<int>
  * @param matches  -  std::vector<std::pair<int,int>>
  *        Pairs of matches, generated by linear assignment.
  *
- * @param tracked_stracks  -  std::vector<STrack *>
- *        The tracked stracks (by pointer).
+ * @param tracked_stracks  -  std::vector<int>
+ *        The tracked stracks (by slot).
  *
- * @param detections  -  std::vector<STrack>
- *        The detected objects.
+ * @param detections  -  std::vector<int>
+ *        The detected objects (by slot).
  *
- * @param activated_stracks  - std::vector<STrack>
- *        The currently active stracks. All matched stracks
+ * @param activated_stracks  - std::vector<int>
+ *        The currently active stracks (by slot). All matched stracks
  *        will be added here.
  */
-inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
-                                       std::vector<STrack *> tracked_stracks,
-                                       std::vector<STrack> &detections,
-                                       std::vector<STrack> &activated_stracks)
+inline void JDETracker::update_matches(const std::vector<std::pair<int, int>> &matches,
+                                       const std::vector<int> &tracked_stracks,
+                                       const std::vector<int> &detections,
+                                       std::vector<int> &activated_stracks)
 {
     for (uint i = 0; i < matches.size(); i++)
     {
         if ((tracked_stracks.size() == 0) || (detections.size() == 0))
             continue;
-        STrack *track = tracked_stracks[matches[i].first];
-        STrack *det = &detections[matches[i].second];
+        int track_slot = tracked_stracks[matches[i].first];
+        STrack *track = &m_stracks[track_slot];
+        STrack *det = &m_stracks[detections[matches[i].second]];
         switch (track->get_state())
         {
         case TrackState::Tracked: // The tracklet was already tracked, so update
@@ -100,7 +80,7 @@ inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
             track->activate(&this->m_kalman_filter, this->m_frame_id);
             break;
         }
-        activated_stracks.push_back(*track);
+        activated_stracks.push_back(track_slot);
     }
 }
 
@@ -113,44 +93,45 @@ inline void JDETracker::update_matches(std::vector<std::pair<int, int>> matches,
  *                 m_keep_tracked_frames, then it will be marked lost
  *                 and moved to the list of lost_stracks
  *
- * @param strack_pool  -  std::vector<STrack *>
- *        The pool of unmatched stracks.
+ * @param strack_pool  -  std::vector<int>
+ *        The pool of unmatched stracks (by slot).
  *
- * @param tracked_stracks  -  std::vector<STrack>
- *        The list of tracked stracks.
+ * @param tracked_stracks  -  std::vector<int>
+ *        The list of tracked stracks (by slot).
  *
- * @param lost_stracks  -  std::vector<STrack>
- *        The list of lost stracks.
+ * @param lost_stracks  -  std::vector<int>
+ *        The list of lost stracks (by slot).
  *
- * @param new_stracks  -  std::vector<STrack>
- *        The list of new stracks.
+ * @param new_stracks  -  std::vector<int>
+ *        The list of new stracks (by slot).
  *
  */
-inline void JDETracker::update_unmatches(std::vector<STrack *> strack_pool,
-                                         std::vector<STrack> &tracked_stracks,
-                                         std::vector<STrack> &lost_stracks,
-                                         std::vector<STrack> &new_stracks)
+inline void JDETracker::update_unmatches(const std::vector<int> &strack_pool,
+                                         std::vector<int> &tracked_stracks,
+                                         std::vector<int> &lost_stracks,
+                                         std::vector<int> &new_stracks)
 {
     for (uint i = 0; i < strack_pool.size(); i++)
     {
-        STrack *track = strack_pool[i];
+        int slot = strack_pool[i];
+        STrack *track = &m_stracks[slot];
         switch (track->get_state())
         {
         case TrackState::Tracked:
             if (this->m_frame_id - track->end_frame() < this->m_keep_tracked_frames)
             {
-                tracked_stracks.push_back(*track); // Not over threshold, so still tracked
+                tracked_stracks.push_back(slot); // Not over threshold, so still tracked
             }
             else
             {
                 track->mark_lost();
-                lost_stracks.push_back(*track); // Over keep threshold, now lost
+                lost_stracks.push_back(slot); // Over keep threshold, now lost
             }
             break;
         case TrackState::Lost:
             if (this->m_frame_id - track->end_frame() < this->m_keep_lost_frames)
             {
-                lost_stracks.push_back(*track); // Not over threshold, so still lost
+                lost_stracks.push_back(slot); // Not over threshold, so still lost
             }
             else
             {
@@ -160,7 +141,7 @@ inline void JDETracker::update_unmatches(std::vector<STrack *> strack_pool,
         case TrackState::New:
             if (this->m_frame_id - track->end_frame() < this->m_keep_new_frames)
             {
-                new_stracks.push_back(*track); // Not over threshold, so still new
+                new_stracks.push_back(slot); // Not over threshold, so still new
             }
             else
             {
@@ -198,31 +179,37 @@ inline void JDETracker::update_unmatches(std::vector<STrack *> strack_pool,
  * @param report_unconfirmed  -  bool
  *        If true, then output unconfirmed stracks as well.
  *
- * @return std::vector<STrack>
+ * @return std::vector<STrack *>
  *         The currently tracked (and unconfirmed if report_unconfirmed) objects.
+ *         The pointers are valid until the next update.
  */
-inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &inputs, bool report_unconfirmed = false, bool report_lost = false)
+inline std::vector<STrack *> JDETracker::update(std::vector<HailoDetectionPtr> &inputs, bool report_unconfirmed = false, bool report_lost = false)
 {
     this->m_frame_id++;
-    std::vector<STrack> detections;        // New detections in this update
-    std::vector<STrack> activated_stracks; // Currently active stracks
-    std::vector<STrack> lost_stracks;      // Currently lost stracks
-    std::vector<STrack> new_stracks;       // Currently new stracks
+    // The lists of this update are scratch members, all of them hold slots of m_stracks
+    std::vector<int> &detections = this->m_detections;               // New detections in this update
+    std::vector<int> &activated_stracks = this->m_activated_stracks; // Currently active stracks
+    std::vector<int> &lost_stracks = this->m_updated_lost_stracks;   // Currently lost stracks
+    std::vector<int> &new_stracks = this->m_updated_new_stracks;     // Currently new stracks
+    activated_stracks.clear();
+    lost_stracks.clear();
+    new_stracks.clear();
 
-    std::vector<STrack *> strack_pool; // A pool of tracked/lost stracks to find matches for
+    std::vector<int> &strack_pool = this->m_strack_pool; // A pool of tracked/lost stracks to find matches for
 
-    std::vector<std::vector<float>> distances; // A distance cost matrix for linear assignment
-    std::vector<std::pair<int, int>> matches;  // Pairs of matches between sets of stracks
-    std::vector<int> unmatched_tracked;        // Unmatched tracked stracks
-    std::vector<int> unmatched_detections;     // Unmatched new detections
+    TrackerTypes::CostMatrix &distances = this->m_distances;         // A distance cost matrix for linear assignment
+    std::vector<std::pair<int, int>> &matches = this->m_matches;     // Pairs of matches between sets of stracks
+    std::vector<int> &unmatched_tracked = this->m_unmatched_tracked; // Unmatched tracked stracks
+    std::vector<int> &unmatched_detections = this->m_unmatched_detections; // Unmatched new detections
 
     //******************************************************************
     // Step 1: Prepare tracks for new detections
     //******************************************************************
-    detections = JDETracker::hailo_detections_to_stracks(inputs, this->m_frame_id, this->m_hailo_objects_blacklist); // Convert the new detections into STracks
+    hailo_detections_to_stracks(inputs, detections); // Convert the new detections into STracks
 
-    strack_pool = joint_strack_pointers(this->m_tracked_stracks, this->m_lost_stracks); // Pool together the tracked and lost stracks
-    STrack::multi_predict(strack_pool, this->m_kalman_filter);                          // Run Kalman Filter prediction step
+    joint_stracks(this->m_tracked_stracks, this->m_lost_stracks, strack_pool); // Pool together the tracked and lost stracks
+    for (int slot : strack_pool)                                               // Run Kalman Filter prediction step
+        m_stracks[slot].predict(this->m_kalman_filter);
 
     //******************************************************************
     // Step 2: First association, tracked with embedding
@@ -232,7 +219,7 @@ inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &in
     fuse_motion(distances, strack_pool, detections);        // Create the cost matrix
 
     // Use linear assignment to find matches
-    linear_assignment(distances, strack_pool.size(), detections.size(), this->m_kalman_dist_thr, matches, unmatched_tracked, unmatched_detections);
+    linear_assignment(distances, this->m_kalman_dist_thr, matches, unmatched_tracked, unmatched_detections);
 
     // Update the matches
     update_matches(matches, strack_pool, detections, activated_stracks);
@@ -248,10 +235,10 @@ inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &in
 
     // Instead of embedding distance, this time we will associate based on iou,
     // so calculate the iou distance of what's left
-    distances = iou_distance(strack_pool, detections);
+    iou_distance(strack_pool, detections, distances);
 
     // Recalculate the linear assignment, this time use the iou threshold
-    linear_assignment(distances, strack_pool.size(), detections.size(), this->m_iou_thr, matches, unmatched_tracked, unmatched_detections);
+    linear_assignment(distances, this->m_iou_thr, matches, unmatched_tracked, unmatched_detections);
 
     // Update the matches
     update_matches(matches, strack_pool, detections, activated_stracks);
@@ -268,14 +255,14 @@ inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &in
     // Deal with the unconfirmed stracks, these are usually stracks with only one beginning frame
     // Use the unmatched_detections indices to get a vector of just the unmatched new detections again
     keep_indices(detections, unmatched_detections);
-    std::vector<STrack> blank;
-    std::vector<STrack *> unconfirmed_pool = joint_strack_pointers(this->m_new_stracks, blank); // Prepare a pool of unconfirmed stracks
+    std::vector<int> &unconfirmed_pool = this->m_unconfirmed_pool;
+    joint_stracks(this->m_new_stracks, {}, unconfirmed_pool); // Prepare a pool of unconfirmed stracks
 
     // Recalculate the iou distance, this time between unconfirmed stracks and the remaining detections
-    distances = iou_distance(unconfirmed_pool, detections);
+    iou_distance(unconfirmed_pool, detections, distances);
 
     // Recalculate the linear assignment, this time with the lower m_init_iou_thr threshold
-    linear_assignment(distances, unconfirmed_pool.size(), detections.size(), this->m_init_iou_thr, matches, unmatched_tracked, unmatched_detections);
+    linear_assignment(distances, this->m_init_iou_thr, matches, unmatched_tracked, unmatched_detections);
 
     // Update the matches
     update_matches(matches, unconfirmed_pool, detections, activated_stracks);
@@ -296,29 +283,32 @@ inline std::vector<STrack> JDETracker::update(std::vector<HailoDetectionPtr> &in
     //******************************************************************
     // Step 6: Update Database
     //******************************************************************
-    // Update the tracker database members with the results of this update
-    this->m_tracked_stracks = activated_stracks;
-    this->m_lost_stracks = lost_stracks;
-    this->m_new_stracks = new_stracks;
+    // Update the tracker database members with the results of this update,
+    // the previous lists are kept in the scratch members for their capacity
+    this->m_tracked_stracks.swap(activated_stracks);
+    this->m_lost_stracks.swap(lost_stracks);
+    this->m_new_stracks.swap(new_stracks);
+    // Matched detections and removed stracks are no longer in any list, free their slots
+    release_unused_slots();
 
     //******************************************************************
     // Step 7: Set the output stracks
     //******************************************************************
-    std::vector<STrack> output_stracks;
+    std::vector<STrack *> output_stracks;
     output_stracks.reserve(this->m_tracked_stracks.size());
-    for (uint i = 0; i < this->m_tracked_stracks.size(); i++)
-        output_stracks.emplace_back(this->m_tracked_stracks[i]);
+    for (int slot : this->m_tracked_stracks)
+        output_stracks.emplace_back(&m_stracks[slot]);
 
     // Include unconfirmed detections if requested
     if (report_unconfirmed or this->m_debug)
     {
-        for (uint i = 0; i < this->m_new_stracks.size(); i++)
-            output_stracks.emplace_back(this->m_new_stracks[i]);
+        for (int slot : this->m_new_stracks)
+            output_stracks.emplace_back(&m_stracks[slot]);
     }
     if (report_lost or this->m_debug)
     {
-        for (uint i = 0; i < this->m_lost_stracks.size(); i++)
-            output_stracks.emplace_back(this->m_lost_stracks[i]);
+        for (int slot : this->m_lost_stracks)
+            output_stracks.emplace_back(&m_stracks[slot]);
     }
     return output_stracks;
 }
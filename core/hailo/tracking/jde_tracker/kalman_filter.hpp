@@ -31,14 +31,6 @@
 #include "hailo_common.hpp"
 #include "tracker_macros.hpp"
 
-// Open source includes
-#include "xtensor/xadapt.hpp"
-#include "xtensor/xarray.hpp"
-#include "xtensor/xio.hpp"
-#include "xtensor/xmath.hpp"
-#include "xtensor/xview.hpp"
-
-using namespace xt::placeholders;
 
 __BEGIN_DECLS
 class KalmanFilter
@@ -64,8 +56,8 @@ class KalmanFilter
 
     private:
     // Identity matrices by which to multiply later means and covariances, initialized in the constructor and unchanged later
-    xt::xtensor_fixed<float, xt::xshape<8, 8>, xt::layout_type::row_major> m_motion_matrix;
-    xt::xtensor_fixed<float, xt::xshape<4, 8>, xt::layout_type::row_major> m_update_matrix;
+    TrackerTypes::FixedMatrix<8, 8> m_motion_matrix;
+    TrackerTypes::FixedMatrix<4, 8> m_update_matrix;
     float m_std_weight_position;  // weight of standard deviation for x and y
     float m_std_weight_position_box;  // weight of standard deviation for a and h
     float m_std_weight_velocity;  // weight of standard deviation for vx and vy
@@ -83,12 +75,22 @@ class KalmanFilter
         int ndim = 4;
         float dt = 1.;
 
-        m_motion_matrix = xt::eye<float>({8, 8}, 0); // Identity matrix of shape 8 x 8
+        // Identity matrix of shape 8 x 8
+        m_motion_matrix.fill(0.0f);
+        for (int i = 0; i < 2 * ndim; i++)
+        {
+            m_motion_matrix(i, i) = 1.0f;
+        }
         for (int i = 0; i < ndim; i++)
         {
             m_motion_matrix(i, ndim + i) = dt;
         }
-        m_update_matrix = xt::eye<float>({4, 8}, 0); // Identity matrix of shape 4 x 8
+        // Identity matrix of shape 4 x 8
+        m_update_matrix.fill(0.0f);
+        for (int i = 0; i < ndim; i++)
+        {
+            m_update_matrix(i, i) = 1.0f;
+        }
     }
 
     // Params setters
@@ -106,6 +108,8 @@ class KalmanFilter
     //******************************************************************
     // LINEAR ALGEBRA HELPER FUNCTIONS
     //******************************************************************
+    // All shapes are known at compile time (see TrackerTypes::FixedMatrix), so the loops are
+    // unrolled by the compiler and no intermediate matrix is ever heap allocated.
     private:
     /**
      * @brief Performs a LL^T Cholesky decomposition of a symmetric, positive definite 
@@ -117,13 +121,14 @@ class KalmanFilter
      * @return TrackerTypes::KAL_HCOVA  : <4x4>
      *         The lower triamgular matrix of the cholesky decomposition.
      */
-    TrackerTypes::KAL_HCOVA cholesky_decomposition(TrackerTypes::KAL_HCOVA &matrix)
+    static TrackerTypes::KAL_HCOVA cholesky_decomposition(const TrackerTypes::KAL_HCOVA &matrix)
     {
-        TrackerTypes::KAL_HCOVA lower_matrix = xt::zeros<float>({(int)matrix.shape(0), (int)matrix.shape(0)});
+        TrackerTypes::KAL_HCOVA lower_matrix;
+        lower_matrix.fill(0.0f);
 
         int sum = 0;
         // Decomposing a matrix into Lower Triangular
-        for (uint i = 0; i < matrix.shape(0); i++) {
+        for (uint i = 0; i < TrackerTypes::KAL_HCOVA::rows; i++) {
             for (uint j = 0; j <= i; j++) {
                 sum = 0;
                 if (j == i) // summation for diagonals
@@ -143,205 +148,66 @@ class KalmanFilter
     }
 
     /**
-     * @brief Solves the system of linear equations Ax=B
-     *        where A is a lower triangular matrix L.
+     * @brief Solves the system of linear equations Lx=b for a single column b,
+     *        where L is a lower triangular matrix.
      *        In short, performs forward-substitution.
      * 
-     * @param L  -  xt::xarray<float>
+     * @param L  -  TrackerTypes::KAL_HCOVA : <4x4>
      *        A lower trangular matrix.
      *
-     * @param B  -  xt::xarray<float>
-     *        The right-hand-side of the system Ax=B, the number of rows
-     *        must match the rows of L.
+     * @param b  -  const float *
+     *        The right-hand-side of the system (4 values).
      *
-     * @return xt::xarray<float> 
-     *         The solution x to the system Ax=B.
+     * @param x  -  float *
+     *        Filled with the solution of the system (4 values).
      */
-    xt::xarray<float> forward_substitution(xt::xarray<float> L, xt::xarray<float> B)
+    static void forward_substitution(const TrackerTypes::KAL_HCOVA &L, const float *b, float *x)
     {
-        // Check dimensionality
-        if (L.dimension() != 2 || B.dimension() != 2)
-            throw std::invalid_argument("forward_substitution broadcast error: only 2D matrices supported!");
-
-        // Get the rows and cols
-        int L_rows = L.shape(0);
-        int L_cols = L.shape(1);
-        int B_rows = B.shape(0);
-        int B_cols = B.shape(1);
-
-        // Check broadcasting rules
-        if (L_rows != B_rows)
-            throw std::invalid_argument("forward_substitution broadcast error: rows don't match!");
-
-        // Prepare x matrix
-        float partial_sum = 0.0;
-        xt::xarray<float>::shape_type shape = {(long unsigned int)L_cols, (long unsigned int)B_cols};
-        xt::xarray<float, xt::layout_type::row_major> x = xt::zeros<float>(shape);
-
-        // For each column of x (=B_cols)
-        for (int i = 0; i < B_cols; ++i)
+        // For each row of x (and row of L, since symmetric)
+        for (uint j = 0; j < TrackerTypes::KAL_HCOVA::rows; ++j)
         {
-            // For each row of x (and row of L, since symmetric)
-            for (int j = 0; j < L_rows; ++j)
+            float partial_sum = 0;
+            // For each column of L up to the current diagonal (the j current row in L)
+            for (uint k = 0; k < j; ++k)
             {
-                partial_sum = 0;  // Reset the partial sum
-                // For each column of L up to the current diagonal (the j current row in L)
-                // This process is forward substitution
-                for (int k = 0; k < j; ++k)
-                {
-                    // Sum the dot product of the L_row*x_col up to the missing diagonal 
-                    partial_sum += L(j, k) * x(k, i);
-                }
-                // x at the missing diagonal is (B - the known sum)/the known L
-                x(j, i) = (B(j, i) - partial_sum) / L(j, j);
+                // Sum the dot product of the L_row*x_col up to the missing diagonal 
+                partial_sum += L(j, k) * x[k];
             }
+            // x at the missing diagonal is (b - the known sum)/the known L
+            x[j] = (b[j] - partial_sum) / L(j, j);
         }
-        return x;
     }
 
     /**
-     * @brief Solves the system of linear equations Ax=B
-     *        where A is an upper triangular matrix U.
+     * @brief Solves the system of linear equations LTx=b for a single column b,
+     *        where L is a lower triangular matrix (so LT, it's transpose, is upper triangular).
      *        In short, performs back-substitution.
      * 
-     * @param U  -  xt::xarray<float>
-     *        An upper trangular matrix.
+     * @param L  -  TrackerTypes::KAL_HCOVA : <4x4>
+     *        A lower trangular matrix.
      *
-     * @param B  -  xt::xarray<float>
-     *        The right-hand-side of the system Ax=B, the number of rows
-     *        must match the rows of U.
+     * @param b  -  const float *
+     *        The right-hand-side of the system (4 values).
      *
-     * @return xt::xarray<float> 
-     *         The solution x to the system Ax=B.
+     * @param x  -  float *
+     *        Filled with the solution of the system (4 values).
      */
-    xt::xarray<float> back_substitution(xt::xarray<float> U, xt::xarray<float> B)
+    static void back_substitution_transposed(const TrackerTypes::KAL_HCOVA &L, const float *b, float *x)
     {
-        // Check dimensionality
-        if (U.dimension() != 2 || B.dimension() != 2)
-            throw std::invalid_argument("forward_substitution broadcast error: only 2D matrices supported!");
-
-        // Get the rows and cols
-        int U_rows = U.shape(0);
-        int U_cols = U.shape(1);
-        int B_rows = B.shape(0);
-        int B_cols = B.shape(1);
-
-        // Check broadcasting rules
-        if (U_rows != B_rows)
-            throw std::invalid_argument("forward_substitution broadcast error: rows don't match!");
-
-        // Prepare x matrix
-        float partial_sum = 0.0;
-        xt::xarray<float>::shape_type shape = {(long unsigned int)U_cols, (long unsigned int)B_cols};
-        xt::xarray<float, xt::layout_type::row_major> x = xt::zeros<float>(shape);
-
-        // For each column of x (=y_cols=B_cols)
-        for (int i = 0; i < B_cols; ++i)
+        const int rows = TrackerTypes::KAL_HCOVA::rows;
+        // Since LT is an upper matrix, we have to iterate in ascending order (starting from the bottom rows)
+        for (int j = rows - 1; j >= 0; j--)
         {
-            // For each row of U
-            // Since U is an upper matrix, we have to iterate in ascending order (starting from the bottom rows)
-            for (int j = U_rows - 1; j >= 0; j--)
+            float partial_sum = 0;
+            // For each column of LT up to the current diagonal, iterating backwards
+            for (int k = rows - 1; k > j; k--)
             {
-                partial_sum = 0;  // Reset the partial sum
-                // For each column of U up to the current diagonal
-                // Since U is an upper matrix, we have to iterate backwards
-                // This process is back substitution
-                for (int k = U_rows - 1; k > j; k--)
-                {
-                    // Sum the dot product of the U_row*x_col up to the missing diagonal 
-                    partial_sum += U(j, k) * x(k, i);
-                }
-                // x at the missing diagonal is (B - the known sum)/the known U
-                x(j, i) = (B(j, i) - partial_sum) / U(j, j);
+                // Sum the dot product of the LT_row*x_col up to the missing diagonal 
+                partial_sum += L(k, j) * x[k];
             }
+            // x at the missing diagonal is (b - the known sum)/the known LT
+            x[j] = (b[j] - partial_sum) / L(j, j);
         }
-        return x;
-    }
-
-    /**
-     * @brief Solves the system of linear equations Ax=B
-     *        using the cholesky decomposition of A.
-     *        Parameters are auto and then adapted to 
-     *        support all types of xcontainers.
-     *
-     *        Given the cholesky A=LLT (where LT = L transposed),
-     *        we can turn Ax=B into LLTx=B, and split this into
-     *        the equations Ly=B, LTx=y. We first solve for y in 
-     *        Ly=B using forward-substitution, then solve for x in
-     *        LTx=y using back-substitution.
-     * 
-     * @param L_  -  any xcontainer
-     *        The cholesky decomposition of A, where A=LLT
-     *
-     * @param B_  -  any xcontainer
-     *        The right-hand-side of the system Ax=B, the number of rows
-     *        must match the sides of L_
-     *
-     * @return xt::xarray<float>
-     *         The solution x to the system Ax=B.
-     */
-    xt::xarray<float> solve_linear_eq_with_cholesky(auto L_, auto B_)
-    {
-        // Adapt the auto inputs to ensure xarrays
-        xt::xarray<float> L = L_;
-        xt::xarray<float> LT = xt::transpose(L);
-        xt::xarray<float> B = B_;
-
-        // Check dimensionality
-        if (L.dimension() != 2 || B.dimension() != 2)
-            throw std::invalid_argument("solve_cholesky broadcast error: only 2D matrices supported!");
-
-        // Check broadcasting rules: the rows of L and B should match
-        if (L.shape(0) != B.shape(0))
-            throw std::invalid_argument("solve_cholesky broadcast error: rows don't match!");
-
-        // First solve Ly=B with forward-substitution
-        xt::xarray<float, xt::layout_type::row_major> y = forward_substitution(L, B);
-
-        // Then solve LTx=y with back-substitution
-        xt::xarray<float, xt::layout_type::row_major> x = back_substitution(LT, y);
-
-        return x;
-    }
-
-    /**
-     * @brief Compute matrix multiplication between two 2 dimensional matrices .
-     * 
-     * @param matrix_1  -  xt::xarray<float, xt::layout_type::row_major>
-     *        The LHS matrix, columns must match rows in RHS matrix.
-     * 
-     * @param matrix_2  -  xt::xarray<float, xt::layout_type::row_major>
-     *        The RHS matrix, rows must match columns in LHS matrix.
-     * 
-     * @return xt::xarray<float, xt::layout_type::row_major>
-     *         The matrix multiplication of the two matrices.
-     *         Normal matrix broadcasting rules apply.
-     */
-    xt::xarray<float, xt::layout_type::row_major> mat_mul_2D(xt::xarray<float, xt::layout_type::row_major> matrix_1,
-                                                             xt::xarray<float, xt::layout_type::row_major> matrix_2)
-    {
-        uint axis_length = matrix_1.shape(1);
-        if (axis_length != matrix_2.shape(0))
-        {
-            throw std::invalid_argument("mat_mul_2D broadcast error: axis don't match!");
-        }
-
-        float row_sum;
-        xt::xarray<float>::shape_type shape = {matrix_1.shape(0), matrix_2.shape(1)};
-        xt::xarray<float, xt::layout_type::row_major> product_matrix(shape);
-        for (uint i = 0; i < matrix_1.shape(0); ++i)
-        {
-            for (uint j = 0; j < matrix_2.shape(1); ++j)
-            {
-                row_sum = 0.0;
-                for (uint k = 0; k < matrix_1.shape(1); ++k)
-                {
-                    row_sum += matrix_1(i, k) * matrix_2(k, j);
-                }
-                product_matrix(i, j) = row_sum;
-            }
-        }
-        return product_matrix;
     }
 
     //******************************************************************
@@ -363,8 +229,11 @@ class KalmanFilter
     TrackerTypes::KAL_DATA initiate(const TrackerTypes::DETECTBOX &measurement)
     {
         TrackerTypes::KAL_MEAN mean;
-        xt::view(mean, xt::all(), xt::range(_, 4)) = xt::squeeze(measurement);
-        xt::view(mean, xt::all(), xt::range(4, _)) = xt::zeros<float>({4});
+        for (int i = 0; i < 4; i++)
+        {
+            mean(i) = measurement(i);
+            mean(4 + i) = 0.0f;
+        }
 
         float measured_height = measurement(3);
         TrackerTypes::KAL_MEAN standard_deviation;
@@ -380,7 +249,12 @@ class KalmanFilter
         standard_deviation(7) = 5 * m_std_weight_velocity_box * measured_height;
 
         // The standard deviations form the diagonal of the new covariance
-        TrackerTypes::KAL_COVA var = xt::diag(xt::squeeze(xt::square(standard_deviation)));
+        TrackerTypes::KAL_COVA var;
+        var.fill(0.0f);
+        for (int i = 0; i < 8; i++)
+        {
+            var(i, i) = standard_deviation(i) * standard_deviation(i);
+        }
         return std::make_pair(mean, var);
     }
 
@@ -410,15 +284,25 @@ class KalmanFilter
         standard_deviation(5) = m_std_weight_velocity * mean_height;
         standard_deviation(6) = m_std_weight_velocity_box * mean_height;
         standard_deviation(7) = m_std_weight_velocity_box * mean_height;
-        // Square and reshape the deviations to match the covariance space
-        TrackerTypes::KAL_COVA motion_covariance = xt::diag(xt::squeeze(xt::square(standard_deviation)));
 
-        TrackerTypes::KAL_MEAN predicted_mean = mat_mul_2D(this->m_motion_matrix, xt::transpose(mean));
-        TrackerTypes::KAL_COVA predicted_covariance = mat_mul_2D(this->m_motion_matrix, mat_mul_2D(covariance, xt::transpose(m_motion_matrix)));
-        predicted_covariance += motion_covariance;  // Apply the standard deviation of motion to the covariance
+        // The mean is a row vector, so motion_matrix * mean^T is a product with its transpose
+        TrackerTypes::FixedMatrix<8, 1> predicted_mean;
+        TrackerTypes::mat_mul_transposed(this->m_motion_matrix, mean, predicted_mean);
+        TrackerTypes::KAL_COVA covariance_motion;
+        TrackerTypes::mat_mul_transposed(covariance, this->m_motion_matrix, covariance_motion);
+        TrackerTypes::KAL_COVA predicted_covariance;
+        TrackerTypes::mat_mul(this->m_motion_matrix, covariance_motion, predicted_covariance);
+        // Apply the standard deviation of motion (squared, on the diagonal) to the covariance
+        for (int i = 0; i < 8; i++)
+        {
+            predicted_covariance(i, i) += standard_deviation(i) * standard_deviation(i);
+        }
 
         // Update the input mean / covariance 
-        mean = predicted_mean;
+        for (int i = 0; i < 8; i++)
+        {
+            mean(i) = predicted_mean(i);
+        }
         covariance = predicted_covariance;
     }
 
@@ -437,20 +321,9 @@ class KalmanFilter
      */
     TrackerTypes::KAL_HDATA project(const TrackerTypes::KAL_MEAN &mean, const TrackerTypes::KAL_COVA &covariance)
     {
-        float mean_height = mean(3);
-        TrackerTypes::DETECTBOX standard_deviation;
-        // Build standard deviation for the position (x, y, a, h)
-        standard_deviation(0) = m_std_weight_position * mean_height;
-        standard_deviation(1) = m_std_weight_position * mean_height;
-        standard_deviation(2) = m_std_weight_position_box * mean_height;
-        standard_deviation(3) = m_std_weight_position_box * mean_height;
-        // Square and reshape the deviations to match the covariance space
-        TrackerTypes::KAL_HCOVA innovation_covariance = xt::diag(xt::square(xt::squeeze(standard_deviation)));
-
-        TrackerTypes::KAL_HMEAN mean1 = mat_mul_2D(this->m_update_matrix, xt::transpose(mean));
-        TrackerTypes::KAL_HCOVA covariance1 = mat_mul_2D(this->m_update_matrix, mat_mul_2D(covariance, xt::transpose(this->m_update_matrix)));
-        covariance1 += innovation_covariance;
-        return std::make_pair(mean1, covariance1);
+        TrackerTypes::FixedMatrix<8, 4> covariance_update;
+        TrackerTypes::mat_mul_transposed(covariance, this->m_update_matrix, covariance_update);
+        return project(mean, covariance_update);
     }
 
     /**
@@ -477,20 +350,48 @@ class KalmanFilter
                                   const TrackerTypes::KAL_COVA &covariance,
                                   const TrackerTypes::DETECTBOX &measurement)
     {
-        TrackerTypes::KAL_HDATA projection_results = project(mean, covariance);
-        TrackerTypes::KAL_HMEAN projected_mean = projection_results.first;
-        TrackerTypes::KAL_HCOVA projected_covariance = projection_results.second;
-
-        // Solve Ax=B using cholesky decomposition
-        xt::xtensor_fixed<float, xt::xshape<4, 8>> B = xt::transpose(mat_mul_2D(covariance, xt::transpose(this->m_update_matrix)));
-        auto cholesky_factor = cholesky_decomposition(projected_covariance);
-        xt::xtensor_fixed<float, xt::xshape<8, 4>> kalman_gain = xt::transpose(solve_linear_eq_with_cholesky(cholesky_factor, B));
-        xt::xtensor_fixed<float, xt::xshape<1, 4>> innovation = measurement - projected_mean;
-        auto tmp = mat_mul_2D(innovation, xt::transpose(kalman_gain));
-
-        TrackerTypes::KAL_MEAN new_mean = mean + tmp;
-        TrackerTypes::KAL_COVA new_covariance = covariance - mat_mul_2D(kalman_gain, mat_mul_2D(projected_covariance, xt::transpose(kalman_gain)));
-        return std::make_pair(new_mean, new_covariance);
+        // covariance * update_matrix^T is needed by both the projection and the gain
+        TrackerTypes::FixedMatrix<8, 4> covariance_update;
+        TrackerTypes::mat_mul_transposed(covariance, this->m_update_matrix, covariance_update);
+        TrackerTypes::KAL_HDATA projection_results = project(mean, covariance_update);
+        const TrackerTypes::KAL_HMEAN &projected_mean = projection_results.first;
+        const TrackerTypes::KAL_HCOVA &projected_covariance = projection_results.second;
+
+        // Solve Ax=B using cholesky decomposition, where A is the projected covariance and B = (covariance * update_matrix^T)^T.
+        // Given the cholesky A=LLT, first solve Ly=B with forward-substitution, then LTx=y with back-substitution,
+        // one column of B at a time. The kalman gain is the transposed solution, so each column becomes a row of the gain.
+        TrackerTypes::KAL_HCOVA cholesky_factor = cholesky_decomposition(projected_covariance);
+        TrackerTypes::FixedMatrix<8, 4> kalman_gain;
+        for (int i = 0; i < 8; i++)
+        {
+            float y[4];
+            forward_substitution(cholesky_factor, &covariance_update(i, 0), y);
+            back_substitution_transposed(cholesky_factor, y, &kalman_gain(i, 0));
+        }
+
+        TrackerTypes::FixedMatrix<1, 4> innovation;
+        for (int i = 0; i < 4; i++)
+        {
+            innovation(i) = measurement(i) - projected_mean(i);
+        }
+        TrackerTypes::FixedMatrix<1, 8> mean_correction;
+        TrackerTypes::mat_mul_transposed(innovation, kalman_gain, mean_correction);
+
+        TrackerTypes::FixedMatrix<4, 8> covariance_gain;
+        TrackerTypes::mat_mul_transposed(projected_covariance, kalman_gain, covariance_gain);
+        TrackerTypes::KAL_COVA covariance_correction;
+        TrackerTypes::mat_mul(kalman_gain, covariance_gain, covariance_correction);
+
+        TrackerTypes::KAL_DATA corrected;
+        for (int i = 0; i < 8; i++)
+        {
+            corrected.first(i) = mean(i) + mean_correction(i);
+        }
+        for (int i = 0; i < 8 * 8; i++)
+        {
+            corrected.second(i) = covariance(i) - covariance_correction(i);
+        }
+        return corrected;
     }
 
     /**
@@ -508,31 +409,71 @@ class KalmanFilter
      *        format (x, y, a, h) where (x, y) is the bounding box center
      *        position, a the aspect ratio, and h the height.
      * 
-     * @return xt::xarray<float>: <1, -1>
-     *         Returns an array of length N, where the i-th element contains the
-     *         squared Mahalanobis distance between (mean, covariance) and 
-     *         `measurements[i]`.
+     * @param square_mahalanobis  -  std::vector<float>
+     *        Filled with N distances, where the i-th element contains the
+     *        squared Mahalanobis distance between (mean, covariance) and 
+     *        `measurements[i]`. Passed in so that its capacity is reused.
      */
-    xt::xarray<float> gating_distance(const TrackerTypes::KAL_MEAN &mean,
-                                      const TrackerTypes::KAL_COVA &covariance,
-                                      const std::vector<TrackerTypes::DETECTBOX> &measurements)
+    void gating_distance(const TrackerTypes::KAL_MEAN &mean,
+                         const TrackerTypes::KAL_COVA &covariance,
+                         const std::vector<TrackerTypes::DETECTBOX> &measurements,
+                         std::vector<float> &square_mahalanobis)
     {
         TrackerTypes::KAL_HDATA projection_results = project(mean, covariance);
-        TrackerTypes::KAL_HMEAN mean1 = projection_results.first;
-        TrackerTypes::KAL_HCOVA covariance1 = projection_results.second;
+        const TrackerTypes::KAL_HMEAN &mean1 = projection_results.first;
         
-        // DETECTBOXSS differs from DETECTBOX in that DETECTBOXSS is Nx4 instead of 1x4
-        TrackerTypes::DETECTBOXSS d = xt::zeros<float>({(int)measurements.size(), 4});
+        // Extract lower triangular matrix from cholesky decomposition
+        TrackerTypes::KAL_HCOVA cholesky_factor = cholesky_decomposition(projection_results.second);
+        square_mahalanobis.resize(measurements.size());
         for (uint i = 0; i < measurements.size(); ++i)
         {
-            xt::row(d, i) = xt::squeeze(measurements[i] - mean1);
+            float d[4];
+            float z[4];
+            for (int j = 0; j < 4; j++)
+            {
+                d[j] = measurements[i](j) - mean1(j);
+            }
+            forward_substitution(cholesky_factor, d, z);
+            // The squares are summed in double precision
+            double square_sum = 0.0;
+            for (int j = 0; j < 4; j++)
+            {
+                square_sum += z[j] * z[j];
+            }
+            square_mahalanobis[i] = square_sum;
         }
-        // Extract lower triangular matrix from cholesky decomposition
-        xt::xarray<float, xt::layout_type::row_major> cholesky_factor = cholesky_decomposition(covariance1);
-        xt::xarray<float, xt::layout_type::row_major> z = xt::transpose(forward_substitution(cholesky_factor, xt::transpose(d)));
-        auto zz = z * z;  // Element-wise multiplication
-        xt::xarray<float> square_mahalanobis = xt::sum(zz, {1});
-        return square_mahalanobis;
+    }
+
+    private:
+    /**
+     * @brief Project state distribution to measurement space,
+     *        given the already computed covariance * update_matrix^T (8x4).
+     */
+    TrackerTypes::KAL_HDATA project(const TrackerTypes::KAL_MEAN &mean, const TrackerTypes::FixedMatrix<8, 4> &covariance_update)
+    {
+        float mean_height = mean(3);
+        TrackerTypes::DETECTBOX standard_deviation;
+        // Build standard deviation for the position (x, y, a, h)
+        standard_deviation(0) = m_std_weight_position * mean_height;
+        standard_deviation(1) = m_std_weight_position * mean_height;
+        standard_deviation(2) = m_std_weight_position_box * mean_height;
+        standard_deviation(3) = m_std_weight_position_box * mean_height;
+
+        // The mean is a row vector, so update_matrix * mean^T is a product with its transpose
+        TrackerTypes::FixedMatrix<4, 1> projected_mean;
+        TrackerTypes::mat_mul_transposed(this->m_update_matrix, mean, projected_mean);
+        TrackerTypes::KAL_HDATA projection;
+        for (int i = 0; i < 4; i++)
+        {
+            projection.first(i) = projected_mean(i);
+        }
+        TrackerTypes::mat_mul(this->m_update_matrix, covariance_update, projection.second);
+        // Apply the squared standard deviations (the innovation covariance) on the diagonal
+        for (int i = 0; i < 4; i++)
+        {
+            projection.second(i, i) += standard_deviation(i) * standard_deviation(i);
+        }
+        return projection;
     }
 };
 __END_DECLS
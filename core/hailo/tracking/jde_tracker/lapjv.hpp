@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <vector>
 
 #define LARGE 1000000
 
@@ -24,28 +25,54 @@
 #define FALSE 0
 #endif
 
-#define NEW(x, t, n) if ((x = (t *)malloc(sizeof(t) * (n))) == 0) { return -1; }
-#define FREE(x) if (x != 0) { free(x); x = 0; }
 #define SWAP_INDICES(a, b) { int_t _temp_index = a; a = b; b = _temp_index; }
 #define ASSERT(cond)
 
 typedef signed int int_t;
 typedef unsigned int uint_t;
-typedef double cost_t;
+typedef float cost_t;
 typedef char boolean;
 typedef enum fp_t { FP_1 = 1, FP_2 = 2, FP_DYNAMIC = 3 } fp_t;
 
-extern int_t lapjv_internal(const uint_t n, cost_t *cost[], int_t *x, int_t *y);
+/*
+    The cost matrix is a flat, row major n x n array.
+*/
+#define COST(i, j) cost[(i) * n + (j)]
+
+/*
+    Work arrays of the solver. Kept by the caller and reused, so that solving does not allocate
+    once the arrays have grown to the largest n seen.
+*/
+struct lapjv_workspace
+{
+	std::vector<int_t> free_rows;
+	std::vector<int_t> cols;
+	std::vector<int_t> pred;
+	std::vector<cost_t> v;
+	std::vector<cost_t> d;
+	std::vector<boolean> unique;
+
+	void resize(const uint_t n)
+	{
+		free_rows.resize(n);
+		cols.resize(n);
+		pred.resize(n);
+		v.resize(n);
+		d.resize(n);
+		unique.resize(n);
+	}
+};
+
+extern int_t lapjv_internal(const uint_t n, const cost_t *cost, int_t *x, int_t *y, lapjv_workspace &workspace);
 
 
 /*
     Column-reduction and reduction transfer for a dense cost matrix.
 */
-inline int_t _ccrrt_dense(const uint_t n, cost_t *cost[],
-	int_t *free_rows, int_t *x, int_t *y, cost_t *v)
+inline int_t _ccrrt_dense(const uint_t n, const cost_t *cost,
+	int_t *free_rows, int_t *x, int_t *y, cost_t *v, boolean *unique)
 {
 	int_t n_free_rows;
-	boolean *unique;
 
 	for (uint_t i = 0; i < n; i++) {
 		x[i] = -1;
@@ -54,14 +81,13 @@ inline int_t _ccrrt_dense(const uint_t n, cost_t *cost[],
 	}
 	for (uint_t i = 0; i < n; i++) {
 		for (uint_t j = 0; j < n; j++) {
-			const cost_t c = cost[i][j];
+			const cost_t c = COST(i, j);
 			if (c < v[j]) {
 				v[j] = c;
 				y[j] = i;
 			}
 		}
 	}
-	NEW(unique, boolean, n);
 	memset(unique, TRUE, n);
 	{
 		int_t j = n;
@@ -89,7 +115,7 @@ inline int_t _ccrrt_dense(const uint_t n, cost_t *cost[],
 				if (j2 == (uint_t)j) {
 					continue;
 				}
-				const cost_t c = cost[i][j2] - v[j2];
+				const cost_t c = COST(i, j2) - v[j2];
 				if (c < min) {
 					min = c;
 				}
@@ -97,14 +123,13 @@ inline int_t _ccrrt_dense(const uint_t n, cost_t *cost[],
 			v[j] -= min;
 		}
 	}
-	FREE(unique);
 	return n_free_rows;
 }
 
 /*
     Augmenting row reduction for a dense cost matrix.
 */
-inline int_t _carr_dense(const uint_t n, cost_t *cost[],
+inline int_t _carr_dense(const uint_t n, const cost_t *cost,
 	                     const uint_t n_free_rows,
 	                     int_t *free_rows, int_t *x, int_t *y, cost_t *v)
 {
@@ -120,11 +145,11 @@ inline int_t _carr_dense(const uint_t n, cost_t *cost[],
 		rr_cnt++;
 		const int_t free_i = free_rows[current++];
 		j1 = 0;
-		v1 = cost[free_i][0] - v[0];
+		v1 = COST(free_i, 0) - v[0];
 		j2 = -1;
 		v2 = LARGE;
 		for (uint_t j = 1; j < n; j++) {
-			const cost_t c = cost[free_i][j] - v[j];
+			const cost_t c = COST(free_i, j) - v[j];
 			if (c < v2) {
 				if (c >= v1) {
 					v2 = c;
@@ -194,7 +219,7 @@ inline uint_t _find_dense(const uint_t n, uint_t lo, cost_t *d, int_t *cols, int
     Scan all columns starting from arbitrary column in SCAN
     and try to decrease d of the columns using the SCAN column.
 */
-inline int_t _scan_dense(const uint_t n, cost_t *cost[],
+inline int_t _scan_dense(const uint_t n, const cost_t *cost,
                          uint_t *plo, uint_t*phi,
                          cost_t *d, int_t *cols, int_t *pred,
                          int_t *y, cost_t *v)
@@ -207,10 +232,10 @@ inline int_t _scan_dense(const uint_t n, cost_t *cost[],
 		int_t j = cols[lo++];
 		const int_t i = y[j];
 		const cost_t mind = d[j];
-		h = cost[i][j] - v[j] - mind;
+		h = COST(i, j) - v[j] - mind;
 		for (uint_t k = hi; k < n; k++) {
 			j = cols[k];
-			cred_ij = cost[i][j] - v[j] - h;
+			cred_ij = COST(i, j) - v[j] - h;
 			if (cred_ij < d[j]) {
 				d[j] = cred_ij;
 				pred[j] = i;
@@ -234,24 +259,19 @@ inline int_t _scan_dense(const uint_t n, cost_t *cost[],
     This is a dense matrix version.
     return The closest free column index.
 */
-inline int_t find_path_dense(const uint_t n, cost_t *cost[],
+inline int_t find_path_dense(const uint_t n, const cost_t *cost,
                              const int_t start_i,
                              int_t *y, cost_t *v,
-                             int_t *pred)
+                             int_t *pred, int_t *cols, cost_t *d)
 {
 	uint_t lo = 0, hi = 0;
 	int_t final_j = -1;
 	uint_t n_ready = 0;
-	int_t *cols;
-	cost_t *d;
-
-	NEW(cols, int_t, n);
-	NEW(d, cost_t, n);
 
 	for (uint_t i = 0; i < n; i++) {
 		cols[i] = i;
 		pred[i] = start_i;
-		d[i] = cost[start_i][i] - v[i];
+		d[i] = COST(start_i, i) - v[i];
 	}
 	while (final_j == -1) {
 		// No columns left on the SCAN list.
@@ -279,28 +299,22 @@ inline int_t find_path_dense(const uint_t n, cost_t *cost[],
 		}
 	}
 
-	FREE(cols);
-	FREE(d);
-
 	return final_j;
 }
 
 /*
     Augment for a dense cost matrix.
 */
-inline int_t _ca_dense(const uint_t n, cost_t *cost[],
+inline int_t _ca_dense(const uint_t n, const cost_t *cost,
                        const uint_t n_free_rows,
-                       int_t *free_rows, int_t *x, int_t *y, cost_t *v)
+                       int_t *free_rows, int_t *x, int_t *y, cost_t *v,
+                       int_t *pred, int_t *cols, cost_t *d)
 {
-	int_t *pred;
-
-	NEW(pred, int_t, n);
-
 	for (int_t *pfree_i = free_rows; pfree_i < free_rows + n_free_rows; pfree_i++) {
 		int_t i = -1, j;
 		uint_t k = 0;
 
-		j = find_path_dense(n, cost, *pfree_i, y, v, pred);
+		j = find_path_dense(n, cost, *pfree_i, y, v, pred, cols, d);
 		ASSERT(j >= 0);
 		ASSERT(j < (int)n);
 		while (i != *pfree_i) {
@@ -313,32 +327,29 @@ inline int_t _ca_dense(const uint_t n, cost_t *cost[],
 			}
 		}
 	}
-	FREE(pred);
 	return 0;
 }
 
 /*
     Solve dense sparse LAP.
 */
-inline int lapjv_internal(const uint_t n, cost_t *cost[],
-	                      int_t *x, int_t *y)
+inline int lapjv_internal(const uint_t n, const cost_t *cost,
+	                      int_t *x, int_t *y, lapjv_workspace &workspace)
 {
 	int ret;
-	int_t *free_rows;
-	cost_t *v;
+	workspace.resize(n);
+	int_t *free_rows = workspace.free_rows.data();
+	cost_t *v = workspace.v.data();
 
-	NEW(free_rows, int_t, n);
-	NEW(v, cost_t, n);
-	ret = _ccrrt_dense(n, cost, free_rows, x, y, v);
+	ret = _ccrrt_dense(n, cost, free_rows, x, y, v, workspace.unique.data());
 	int i = 0;
 	while (ret > 0 && i < 2) {
 		ret = _carr_dense(n, cost, ret, free_rows, x, y, v);
 		i++;
 	}
 	if (ret > 0) {
-		ret = _ca_dense(n, cost, ret, free_rows, x, y, v);
+		ret = _ca_dense(n, cost, ret, free_rows, x, y, v,
+		                workspace.pred.data(), workspace.cols.data(), workspace.d.data());
 	}
-	FREE(v);
-	FREE(free_rows);
 	return ret;
 }
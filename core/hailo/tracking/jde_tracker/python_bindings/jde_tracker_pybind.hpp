@@ -93,11 +93,11 @@ class JDETrackerWrapper {
     py::list update(py::array_t<float, py::array::c_style | py::array::forcecast> input_detections, bool report_unconfirmed)
     {
         std::vector<HailoDetectionPtr> converted_detections = numpy_to_detections(input_detections);
-        std::vector<STrack> online_stracks = m_jde_tracker->update(converted_detections, report_unconfirmed);
+        std::vector<STrack *> online_stracks = m_jde_tracker->update(converted_detections, report_unconfirmed);
         std::vector<STrackWrapper> output_pystracks(online_stracks.size());
         for (uint i = 0; i < online_stracks.size(); i++)
         {
-            auto strack = std::make_unique<STrack>(online_stracks[i]);
+            auto strack = std::make_unique<STrack>(*online_stracks[i]);
             output_pystracks[i] = STrackWrapper(std::move(strack));
         }
         return py::cast(std::move(output_pystracks));
@@ -9,6 +9,7 @@
 #pragma once
 
 // General cpp includes
+#include <array>
 #include <cmath>
 #include <iostream>
 #include <memory>
@@ -52,7 +53,12 @@ class STrackWrapper {
                   const float input_confidence,
                   const py::array_t<float, py::array::c_style | py::array::forcecast> input_features)
     {
-        std::vector<float> tlwh = numpy_to_float_vector(input_tlwh);
+        std::vector<float> tlwh_vector = numpy_to_float_vector(input_tlwh);
+        if (tlwh_vector.size() != 4)
+        {
+            throw std::runtime_error("tlwh must hold 4 values!");
+        }
+        std::array<float, 4> tlwh = {tlwh_vector[0], tlwh_vector[1], tlwh_vector[2], tlwh_vector[3]};
         std::vector<float> features = numpy_to_float_vector(input_features);
         auto strack = std::make_unique<STrack>(STrack(tlwh, 0.9, features));
         return STrackWrapper(std::move(strack));
@@ -12,7 +12,10 @@
 
 // General cpp includes
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -27,10 +30,6 @@
 
 // Open source includes
 #include <opencv2/opencv.hpp>
-#include "xtensor/xadapt.hpp"
-#include "xtensor/xarray.hpp"
-#include "xtensor/xio.hpp"
-#include "xtensor/xmath.hpp"
 
 __BEGIN_DECLS
 enum TrackState
@@ -46,7 +45,9 @@ There are some objects that cannot be consistently scaled to match the new locat
 (Like landmarks, mask , matrix).
 For example, if a face is rotated 90 degrees, the landmarks will not be in the correct location.
 These metadata types will never be kept, even if keep_past_metadata is set to true.
+The blacklist is held as a bitmask of hailo_object_t values, see STrack::blacklist_mask.
 */
+#define DEFAULT_HAILO_OBJECTS_BLACKLIST ((1u << HAILO_LANDMARKS) | (1u << HAILO_DEPTH_MASK) | (1u << HAILO_CLASS_MASK))
 
 class STrack
 {
@@ -63,42 +64,52 @@ public:
     int m_start_frame;   // Last activated frame id
     float m_alpha;       // Alpha blending for smoothing features
 
-    std::vector<float> tmp_location_tlwh; // Momentary location (top left, width, height)
-    std::vector<float> m_tlwh;            // Rolling top-left, width-height: xmin,ymin,width,height
-    std::vector<float> m_curr_feat;       // The current features
-    std::vector<float> m_smooth_feat;     // The smoothed features
+    std::array<float, 4> tmp_location_tlwh; // Momentary location (top left, width, height)
+    std::array<float, 4> m_tlwh;            // Rolling top-left, width-height: xmin,ymin,width,height
+    std::vector<float> m_curr_feat;         // The current features
+    std::vector<float> m_smooth_feat;       // The smoothed features
 
     TrackerTypes::KAL_MEAN m_mean;
     TrackerTypes::KAL_COVA m_covariance;
 
 private:
     int m_times_seen;
-    int m_state;                                           // Current state: can be New, Tracked, or Lost
-    KalmanFilter *m_kalman_filter;                         // A Kalman Filter instance to make predictions
-    HailoDetectionPtr m_hailo_detection;                   // A shared pointer to the detection object in the pipeline
-    std::vector<hailo_object_t> m_hailo_objects_blacklist; // Objects that will never be kept
-    bool m_debug;                                          // Debug flag
+    int m_state;                          // Current state: can be New, Tracked, or Lost
+    KalmanFilter *m_kalman_filter;        // A Kalman Filter instance to make predictions
+    HailoDetectionPtr m_hailo_detection;  // A shared pointer to the detection object in the pipeline
+    uint32_t m_hailo_objects_blacklist;   // Objects that will never be kept, a bitmask of hailo_object_t
+    bool m_debug;                         // Debug flag
     //******************************************************************
     // CLASS RESOURCE MANAGEMENT
     //******************************************************************
 public:
     // Constructors
-    STrack(std::vector<float> tlwh_ = {0., 0., 0., 0.}, float score_ = 0.0, std::vector<float> temp_feat = {0.0},
+    STrack(std::array<float, 4> tlwh_ = {0., 0., 0., 0.}, float score_ = 0.0, std::vector<float> temp_feat = {0.0},
            HailoDetectionPtr detection_ptr = nullptr, int frame_id = 0,
-           std::vector<hailo_object_t> hailo_objects_blacklist = {HAILO_LANDMARKS, HAILO_DEPTH_MASK, HAILO_CLASS_MASK}, bool debug = false) : m_is_activated(false), m_track_id(0), m_frame_id(frame_id), m_tracklet_len(0), m_confidence(score_),
-                                                                                                                                              m_start_frame(0), m_alpha(0.9), tmp_location_tlwh(tlwh_), m_state(TrackState::New),
-                                                                                                                                              m_hailo_detection(detection_ptr), m_debug(debug)
+           uint32_t hailo_objects_blacklist = DEFAULT_HAILO_OBJECTS_BLACKLIST, bool debug = false) : m_is_activated(false), m_track_id(0), m_frame_id(frame_id), m_tracklet_len(0), m_confidence(score_),
+                                                                                                     m_start_frame(0), m_alpha(0.9), tmp_location_tlwh(tlwh_), m_state(TrackState::New),
+                                                                                                     m_kalman_filter(nullptr), m_hailo_detection(detection_ptr),
+                                                                                                     m_hailo_objects_blacklist(hailo_objects_blacklist), m_debug(debug)
     {
         m_times_seen = 0;
         // Initialize mean/covariance to zero
-        m_mean = xt::zeros<float>({1, 8});
-        m_covariance = xt::zeros<float>({8, 8});
+        m_mean.fill(0.0f);
+        m_covariance.fill(0.0f);
         // Initialize the rolling m_tlwh
-        m_tlwh.resize(4);
         update_tlwh();
         // Update the features
         update_features(temp_feat);
-        m_hailo_objects_blacklist = std::move(hailo_objects_blacklist);
+    }
+
+    /**
+     * @brief Convert a list of hailo object types into the bitmask an STrack holds its blacklist as.
+     */
+    static uint32_t blacklist_mask(const std::vector<hailo_object_t> &hailo_objects_blacklist)
+    {
+        uint32_t mask = 0;
+        for (hailo_object_t object_type : hailo_objects_blacklist)
+            mask |= 1u << object_type;
+        return mask;
     }
 
     //******************************************************************
@@ -135,7 +146,7 @@ public:
             else if (keep_past_metadata)
             {
                 // Add the sub object only if its type is not under hailo_objects_blacklist
-                if (std::find(m_hailo_objects_blacklist.begin(), m_hailo_objects_blacklist.end(), object_type) == m_hailo_objects_blacklist.end())
+                if (!(m_hailo_objects_blacklist & (1u << object_type)))
                 {
                     new_detection->add_unscaled_object(object);
                 }
@@ -158,12 +169,12 @@ public:
     void update_tlwh()
     {
         // If this is the first update, then roling tlwh = momentary tlwh
-        if ((float)xt::sum(this->m_mean)() == 0.0f)
+        double mean_sum = 0.0;
+        for (int i = 0; i < 8; i++)
+            mean_sum += this->m_mean(i);
+        if ((float)mean_sum == 0.0f)
         {
-            m_tlwh[0] = tmp_location_tlwh[0];
-            m_tlwh[1] = tmp_location_tlwh[1];
-            m_tlwh[2] = tmp_location_tlwh[2];
-            m_tlwh[3] = tmp_location_tlwh[3];
+            m_tlwh = tmp_location_tlwh;
             return;
         }
 
@@ -177,12 +188,12 @@ public:
     /**
      * @brief Get the rolling tlbr (xmin,ymin,xmax,ymax)
      *
-     * @return std::vector<float>
+     * @return std::array<float, 4>
      *         The xmin,ymin,xmax,ymax of this STrack
      */
-    std::vector<float> tlbr()
+    std::array<float, 4> tlbr() const
     {
-        std::vector<float> tlbr(4);
+        std::array<float, 4> tlbr;
         tlbr[0] = m_tlwh[0];             // xmin
         tlbr[1] = m_tlwh[1];             // ymin
         tlbr[2] = m_tlwh[0] + m_tlwh[2]; // xmax = xmin + width
@@ -194,15 +205,15 @@ public:
      * @brief Convert tlwh (xmin,ymin,width,height) to (center x, center y, aspect ratio, height),
      *        where aspect ratio is width / height
      *
-     * @param tlwh_tmp  -  std::vector<float>
+     * @param tlwh_tmp  -  std::array<float, 4>
      *        The tlwh to convert.
      *
-     * @return std::vector<float>
+     * @return std::array<float, 4>
      *         The center x, center y, aspect ratio, height.
      */
-    static std::vector<float> tlwh_to_xyah(std::vector<float> tlwh_tmp)
+    static std::array<float, 4> tlwh_to_xyah(std::array<float, 4> tlwh_tmp)
     {
-        std::vector<float> tlwh_output = tlwh_tmp;
+        std::array<float, 4> tlwh_output = tlwh_tmp;
         tlwh_output[0] += tlwh_output[2] / 2;
         tlwh_output[1] += tlwh_output[3] / 2;
         tlwh_output[2] /= tlwh_output[3];
@@ -212,10 +223,10 @@ public:
     /**
      * @brief Get bounding box in (center x, center y, aspect ratio, height) format
      *
-     * @return std::vector<float>
+     * @return std::array<float, 4>
      *         The center x, center y, aspect ratio, height.
      */
-    std::vector<float> to_xyah()
+    std::array<float, 4> to_xyah() const
     {
         return STrack::tlwh_to_xyah(m_tlwh);
     }
@@ -223,12 +234,12 @@ public:
     /**
      * @brief Convert tlbr(xmin,ymin,xmax,ymax) to tlwh(xmin,ymin,width,height)
      *
-     * @param tlbr  -  std::vector<float>
+     * @param tlbr  -  std::array<float, 4>
      *        The tlbr to convert
      *
-     * @return std::vector<float>
+     * @return std::array<float, 4>
      */
-    static std::vector<float> tlbr_to_tlwh(std::vector<float> &tlbr)
+    static std::array<float, 4> tlbr_to_tlwh(std::array<float, 4> &tlbr)
     {
         tlbr[2] -= tlbr[0];
         tlbr[3] -= tlbr[1];
@@ -238,15 +249,15 @@ public:
     /**
      * @brief Get the detectbox from tlwh object
      *
-     * @param tlwh_tmp  -  std::vector<float>
+     * @param tlwh_tmp  -  std::array<float, 4>
      *        The tlwh (xmin,ymin,width,height)
      *
      * @return TrackerTypes::DETECTBOX
      *         The converted xyah (center x, center y, aspect ratio, height)
      */
-    static TrackerTypes::DETECTBOX get_detectbox_from_tlwh(std::vector<float> tlwh)
+    static TrackerTypes::DETECTBOX get_detectbox_from_tlwh(const std::array<float, 4> &tlwh)
     {
-        std::vector<float> xyah = STrack::tlwh_to_xyah(tlwh);
+        std::array<float, 4> xyah = STrack::tlwh_to_xyah(tlwh);
         TrackerTypes::DETECTBOX xyah_box = {{xyah[0], xyah[1], xyah[2], xyah[3]}};
         return xyah_box;
     }
@@ -269,18 +280,26 @@ public:
     // Get the hailo detection object
     HailoDetectionPtr get_hailo_detection() { return this->m_hailo_detection; }
 
+    // Drop the reference to the hailo detection object, when the STrack is no longer used
+    void release_hailo_detection() { this->m_hailo_detection = nullptr; }
+
     /**
      * @brief Get the next available id
+     *        The counter is shared by all trackers, which may update in parallel.
      *
      * @return int
      *         The id
      */
     int next_id()
     {
-        static int _count = 0;
-        _count++;
-        _count = _count % 100000; // Cycle ids after 100000
-        return _count;
+        static std::atomic<int> _count{0};
+        int current = _count.load(std::memory_order_relaxed);
+        int next;
+        do
+        {
+            next = (current + 1) % 100000; // Cycle ids after 100000
+        } while (!_count.compare_exchange_weak(current, next, std::memory_order_relaxed));
+        return next;
     }
 
     /**
@@ -307,12 +326,23 @@ public:
     {
         for (uint i = 0; i < stracks.size(); i++)
         {
-            if (stracks[i]->m_state != TrackState::Tracked)
-            {
-                stracks[i]->m_mean(7) = 0;
-            }
-            kalman_filter.predict(stracks[i]->m_mean, stracks[i]->m_covariance);
+            stracks[i]->predict(kalman_filter);
+        }
+    }
+
+    /**
+     * @brief Run Kalman filter prediction step on this STrack
+     *
+     * @param kalman_filter  -  KalmanFilter
+     *        The kalman filter with which to make the prediction.
+     */
+    void predict(KalmanFilter &kalman_filter)
+    {
+        if (m_state != TrackState::Tracked)
+        {
+            m_mean(7) = 0;
         }
+        kalman_filter.predict(m_mean, m_covariance);
     }
 
     /**
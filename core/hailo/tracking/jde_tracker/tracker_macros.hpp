@@ -8,22 +8,109 @@
 
 #pragma once
 
+#include <cstddef>
 #include <utility>
-#include "xtensor/xarray.hpp"
-#include "xtensor/xfixed.hpp"
-#include "xtensor/xtensor.hpp"
+#include <vector>
 
 namespace TrackerTypes
 {
-    typedef xt::xtensor_fixed<float, xt::xshape<1, 4>, xt::layout_type::row_major> DETECTBOX;
-    typedef xt::xarray<float, xt::layout_type::row_major> DETECTBOXSS;
-    typedef xt::xtensor_fixed<float, xt::xshape<1, 128>, xt::layout_type::row_major> FEATURE;
+    /**
+     * @brief A fixed size, row major matrix of floats.
+     *        Lives on the stack (or inline in its owner), so the tracker math never allocates.
+     *        A single index addresses the flat storage, which is how vectors (1xN matrices) are used.
+     */
+    template <size_t ROWS, size_t COLS>
+    struct FixedMatrix
+    {
+        static constexpr size_t rows = ROWS;
+        static constexpr size_t cols = COLS;
+        float data[ROWS * COLS];
+
+        float &operator()(size_t row, size_t col) { return data[row * COLS + col]; }
+        float operator()(size_t row, size_t col) const { return data[row * COLS + col]; }
+        float &operator()(size_t index) { return data[index]; }
+        float operator()(size_t index) const { return data[index]; }
+        float &operator[](size_t index) { return data[index]; }
+        float operator[](size_t index) const { return data[index]; }
+
+        void fill(float value)
+        {
+            for (size_t i = 0; i < ROWS * COLS; i++)
+                data[i] = value;
+        }
+    };
+
+    /**
+     * @brief Compute the matrix multiplication lhs * rhs.
+     */
+    template <size_t ROWS, size_t INNER, size_t COLS>
+    inline void mat_mul(const FixedMatrix<ROWS, INNER> &lhs, const FixedMatrix<INNER, COLS> &rhs, FixedMatrix<ROWS, COLS> &product)
+    {
+        for (size_t i = 0; i < ROWS; ++i)
+        {
+            for (size_t j = 0; j < COLS; ++j)
+            {
+                float row_sum = 0.0;
+                for (size_t k = 0; k < INNER; ++k)
+                {
+                    row_sum += lhs(i, k) * rhs(k, j);
+                }
+                product(i, j) = row_sum;
+            }
+        }
+    }
+
+    /**
+     * @brief Compute the matrix multiplication lhs * transpose(rhs), without building the transpose.
+     */
+    template <size_t ROWS, size_t INNER, size_t COLS>
+    inline void mat_mul_transposed(const FixedMatrix<ROWS, INNER> &lhs, const FixedMatrix<COLS, INNER> &rhs, FixedMatrix<ROWS, COLS> &product)
+    {
+        for (size_t i = 0; i < ROWS; ++i)
+        {
+            for (size_t j = 0; j < COLS; ++j)
+            {
+                float row_sum = 0.0;
+                for (size_t k = 0; k < INNER; ++k)
+                {
+                    row_sum += lhs(i, k) * rhs(j, k);
+                }
+                product(i, j) = row_sum;
+            }
+        }
+    }
+
+    /**
+     * @brief A rows x cols matrix of floats, stored flat in row major order.
+     *        Used for the cost matrices of the linear assignment. Resizing keeps the capacity,
+     *        so a matrix that is reused from frame to frame stops allocating.
+     */
+    struct CostMatrix
+    {
+        int rows = 0;
+        int cols = 0;
+        std::vector<float> data;
+
+        void resize(int new_rows, int new_cols)
+        {
+            rows = new_rows;
+            cols = new_cols;
+            data.resize(rows * cols);
+        }
+
+        float &operator()(int row, int col) { return data[row * cols + col]; }
+        float operator()(int row, int col) const { return data[row * cols + col]; }
+        float *row(int row) { return data.data() + row * cols; }
+        const float *row(int row) const { return data.data() + row * cols; }
+    };
+
+    typedef FixedMatrix<1, 4> DETECTBOX;
 
     //Kalman Filter Macros
-    typedef xt::xtensor_fixed<float, xt::xshape<1, 8>, xt::layout_type::row_major> KAL_MEAN;
-    typedef xt::xtensor_fixed<float, xt::xshape<8, 8>, xt::layout_type::row_major> KAL_COVA;
-    typedef xt::xtensor_fixed<float, xt::xshape<1, 4>, xt::layout_type::row_major> KAL_HMEAN;
-    typedef xt::xtensor_fixed<float, xt::xshape<4, 4>, xt::layout_type::row_major> KAL_HCOVA;
+    typedef FixedMatrix<1, 8> KAL_MEAN;
+    typedef FixedMatrix<8, 8> KAL_COVA;
+    typedef FixedMatrix<1, 4> KAL_HMEAN;
+    typedef FixedMatrix<4, 4> KAL_HCOVA;
     typedef std::pair<KAL_MEAN, KAL_COVA> KAL_DATA;
     typedef std::pair<KAL_HMEAN, KAL_HCOVA> KAL_HDATA;
-}
\ No newline at end of file
+}